@@ -1,19 +1,65 @@
 #include "acelerometro_modulo.h"
 #include <stdbool.h>
+#include <string.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "nvs.h"
 
 #define TAG "MPU6050"
 
 #define I2C_MASTER_SCL_IO 22      // Pino SCL
 #define I2C_MASTER_SDA_IO 21      // Pino SDA
 #define I2C_MASTER_PORT I2C_NUM_0 // Porta I2C 0
-#define I2C_MASTER_FREQ_HZ 100000 // 100 kHz
-#define I2C_MASTER_TIMEOUT_MS 1000
+#define I2C_MASTER_FREQ_PADRAO_HZ 100000 // Modo padrão; também o recuo do fast mode
+#define I2C_FILA_TRANSACOES 4             // Profundidade da fila no modo assíncrono
+#define I2C_TIMEOUT_FOLGA_MS 10
+#define I2C_TESTE_LEITURAS 16             // Leituras de WHO_AM_I para validar o barramento
+#define I2C_TRANSACAO_MAX_ESCRITA 2       // Registrador + valor
+#define I2C_TRANSACAO_MAX_LEITURA 14      // Um frame completo (accel, temperatura, gyro)
 
 #define MPU6050_ADDR 0x68
-#define MPU6050_PWR_MGMT_1 0x6B
+#define MPU6050_SMPLRT_DIV 0x19
+#define MPU6050_CONFIG 0x1A
+#define MPU6050_GYRO_CONFIG 0x1B
+#define MPU6050_ACCEL_CONFIG 0x1C
+#define MPU6050_MOT_THR 0x1F
+#define MPU6050_MOT_DUR 0x20
+#define MPU6050_FIFO_EN 0x23
+#define MPU6050_INT_PIN_CFG 0x37
+#define MPU6050_INT_ENABLE 0x38
+#define MPU6050_INT_STATUS 0x3A
 #define MPU6050_ACCEL_XOUT_H 0x3B
+#define MPU6050_USER_CTRL 0x6A
+#define MPU6050_PWR_MGMT_1 0x6B
+#define MPU6050_PWR_MGMT_2 0x6C
+#define MPU6050_WHO_AM_I 0x75
+#define MPU6050_FIFO_COUNTH 0x72
+#define MPU6050_FIFO_R_W 0x74
+
+#define MPU6050_FIFO_EN_TEMP 0x80
+#define MPU6050_FIFO_EN_GYRO 0x70  // XG | YG | ZG
+#define MPU6050_FIFO_EN_ACCEL 0x08
+#define MPU6050_USER_CTRL_FIFO_EN 0x40
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04
+#define MPU6050_INT_DATA_RDY_EN 0x01
+#define MPU6050_INT_MOT_EN 0x40
+#define MPU6050_INT_LATCH_EN 0x20         // INT fica alto até ler INT_STATUS
+#define MPU6050_ACCEL_HPF_5HZ 0x01
+#define MPU6050_PWR1_CYCLE_TEMP_DIS 0x28  // CYCLE | TEMP_DIS
+#define MPU6050_PWR2_STBY_GYRO 0x07       // STBY_XG | STBY_YG | STBY_ZG
+#define MPU6050_MOT_THR_MG_LSB 2
+#define MPU6050_FS_SEL_SHIFT 3 // AFS_SEL / FS_SEL nos bits 4:3
+
+#define MPU6050_FIFO_TAMANHO 1024 // Bytes de FIFO no chip
+#define MPU6050_FRAME_BYTES 14    // Accel(6) + Temp(2) + Gyro(6), mesma ordem dos registradores
+#define MPU6050_FIFO_MAX_FRAMES (MPU6050_FIFO_TAMANHO / MPU6050_FRAME_BYTES) // No perfil mais largo
+#define MPU6050_TAXA_GIROSCOPIO_HZ 1000 // Taxa interna com DLPF habilitado
+#define MPU6050_DIVISOR_MAX (MPU6050_TAXA_GIROSCOPIO_HZ / MPU6050_TAXA_MIN_HZ - 1)
+
+#define MPU6050_NVS_NAMESPACE "imu"
+#define MPU6050_NVS_CHAVE_CALIBRACAO "accel_cal"
 
 /* --------------------------------------------------------------------------
  *  Handles globais
@@ -24,6 +70,88 @@
 static i2c_master_bus_handle_t s_i2c_bus_handle = NULL;
 static i2c_master_dev_handle_t s_mpu6050_handle = NULL;
 
+/* --------------------------------------------------------------------------
+ *  Estado do modo FIFO
+ *   - s_tarefa_notificada: tarefa acordada pela ISR a cada lote completo
+ *   - s_isr_contagem: pulsos de DATA_RDY desde a última notificação
+ *   - s_t0_us / s_amostras_total: base de tempo das amostras. O instante de
+ *     cada amostra é t0 + n * periodo, sem depender de quando a tarefa acordou.
+ *     t0 é reancorado no esp_timer a cada leitura do contador da FIFO: o
+ *     oscilador do MPU erra alguns %, e contar períodos desde o boot
+ *     acumularia segundos de deriva por hora
+ *   - s_ultimo_timestamp_us: garante timestamps crescentes entre lotes
+ * -------------------------------------------------------------------------- */
+static TaskHandle_t s_tarefa_notificada = NULL;
+static volatile uint32_t s_isr_contagem = 0;
+static uint32_t s_amostras_por_lote = 1;
+static int64_t s_t0_us = 0;
+static int64_t s_periodo_us = 0;
+static uint64_t s_amostras_total = 0;
+static int64_t s_ultimo_timestamp_us = 0;
+static uint32_t s_fifo_overflows = 0;
+static uint8_t s_divisor = 0;
+static uint8_t s_dlpf_cfg = 0;
+static int s_pino_int = -1;
+
+/* --------------------------------------------------------------------------
+ *  Faixas e calibração
+ *   - s_faixa_*: gravadas no chip e copiadas em cada amostra
+ *   - s_calibracao: aplicada na decodificação; trocada por outra task sob
+ *     s_cal_mux, copiada uma vez por leitura
+ * -------------------------------------------------------------------------- */
+static Mpu6050FaixaAccel s_faixa_accel = MPU6050_ACCEL_2G;
+static Mpu6050FaixaGyro s_faixa_gyro = MPU6050_GYRO_250DPS;
+static portMUX_TYPE s_cal_mux = portMUX_INITIALIZER_UNLOCKED;
+static Mpu6050Calibracao s_calibracao;
+static bool s_calibrado = false;
+
+/* Em modo movimento a ISR não conta lotes: o primeiro INT já acorda a tarefa */
+static volatile bool s_modo_movimento = false;
+static uint8_t s_fifo_buffer[MPU6050_FIFO_TAMANHO];
+
+/* --------------------------------------------------------------------------
+ *  Perfil de leitura: o que entra na FIFO e quantos bytes por frame.
+ *  A FIFO guarda os campos na ordem dos registradores (accel, temp, gyro).
+ * -------------------------------------------------------------------------- */
+static const struct
+{
+    uint8_t fifo_en;
+    uint8_t frame_bytes;
+} s_perfis[] = {
+    [MPU6050_PERFIL_ACCEL] = {MPU6050_FIFO_EN_ACCEL, 6},
+    [MPU6050_PERFIL_ACCEL_GYRO] = {MPU6050_FIFO_EN_ACCEL | MPU6050_FIFO_EN_GYRO, 12},
+    [MPU6050_PERFIL_COMPLETO] = {MPU6050_FIFO_EN_ACCEL | MPU6050_FIFO_EN_TEMP | MPU6050_FIFO_EN_GYRO, 14},
+};
+static Mpu6050PerfilLeitura s_perfil = MPU6050_PERFIL_COMPLETO;
+
+/* --------------------------------------------------------------------------
+ *  Barramento e transações
+ *   - s_assincrono: fila de transações do i2c_master; o fim de cada uma vem
+ *     pelo callback mpu6050_i2c_concluida (ISR)
+ *   - s_burst_*: leitura da FIFO em andamento; o buffer é s_fifo_buffer e
+ *     não pode ser tocado até o callback. Transações bloqueantes esperam a
+ *     fila esvaziar, então o burst é sempre o primeiro a terminar.
+ *   - s_transacao_*: no assíncrono a fila guarda ponteiros, não cópias; as
+ *     transações bloqueantes passam por estes buffers do módulo para que
+ *     uma transação que estourou o prazo e ainda está na fila nunca escreva
+ *     na pilha de quem já retornou
+ *   - s_est_i2c: contadores por transação, protegidos por s_i2c_mux
+ * -------------------------------------------------------------------------- */
+static uint32_t s_freq_hz = I2C_MASTER_FREQ_PADRAO_HZ;
+static bool s_assincrono = false;
+static volatile i2c_master_event_t s_evento_i2c = I2C_EVENT_DONE;
+static volatile bool s_burst_pendente = false;
+static volatile bool s_burst_concluido = false;
+static volatile i2c_master_event_t s_burst_evento = I2C_EVENT_DONE;
+static size_t s_burst_frames = 0;
+static size_t s_burst_bytes = 0;
+static int64_t s_burst_inicio_us = 0;
+static const uint8_t s_reg_fifo = MPU6050_FIFO_R_W;
+static uint8_t s_transacao_escrita[I2C_TRANSACAO_MAX_ESCRITA];
+static uint8_t s_transacao_leitura[I2C_TRANSACAO_MAX_LEITURA];
+static portMUX_TYPE s_i2c_mux = portMUX_INITIALIZER_UNLOCKED;
+static Mpu6050EstatisticasI2c s_est_i2c;
+
 /* --------------------------------------------------------------------------
  *  Inicializa o barramento I2C usando a API nova (i2c_new_master_bus)
  * -------------------------------------------------------------------------- */
@@ -42,6 +170,7 @@ static esp_err_t i2c_master_init(void)
         .scl_io_num = I2C_MASTER_SCL_IO,   // Pino SCL
         .sda_io_num = I2C_MASTER_SDA_IO,   // Pino SDA
         .glitch_ignore_cnt = 7,            // Filtro de ruídos (valor típico sugerido)
+        .trans_queue_depth = s_assincrono ? I2C_FILA_TRANSACOES : 0, // > 0 liga o modo assíncrono
         .flags = {
             /* Habilita pull-up interno – para protótipo ajuda, mas o ideal é resistor externo */
             .enable_internal_pullup = true,
@@ -61,53 +190,292 @@ static esp_err_t i2c_master_init(void)
 }
 
 /* --------------------------------------------------------------------------
- *  Inicialização do MPU6050
+ *  Contadores por transação. Chamado da tarefa e do callback (ISR).
+ * -------------------------------------------------------------------------- */
+static void IRAM_ATTR mpu6050_i2c_registra(size_t bytes, int64_t duracao_us, bool erro)
+{
+    portENTER_CRITICAL_SAFE(&s_i2c_mux);
+    s_est_i2c.transacoes++;
+    s_est_i2c.bytes += bytes;
+    s_est_i2c.tempo_total_us += (uint64_t)duracao_us;
+    if ((uint32_t)duracao_us > s_est_i2c.tempo_max_us)
+    {
+        s_est_i2c.tempo_max_us = (uint32_t)duracao_us;
+    }
+    if (erro)
+    {
+        s_est_i2c.erros++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_i2c_mux);
+}
+
+/* Fim de transação no modo assíncrono; acorda a tarefa só no fim de um burst */
+static bool IRAM_ATTR mpu6050_i2c_concluida(i2c_master_dev_handle_t dev, const i2c_master_event_data_t *evento,
+                                            void *arg)
+{
+    BaseType_t acordar_tarefa = pdFALSE;
+
+    if (!s_burst_pendente || s_burst_concluido)
+    {
+        /* Transação bloqueante: quem espera confere o evento */
+        s_evento_i2c = evento->event;
+        return false;
+    }
+
+    s_burst_evento = evento->event;
+    s_burst_concluido = true;
+    mpu6050_i2c_registra(s_burst_bytes + 1, esp_timer_get_time() - s_burst_inicio_us,
+                         evento->event != I2C_EVENT_DONE);
+    if (s_tarefa_notificada != NULL)
+    {
+        vTaskNotifyGiveFromISR(s_tarefa_notificada, &acordar_tarefa);
+    }
+    return acordar_tarefa == pdTRUE;
+}
+
+/* Prazo de uma transação: o dobro do tempo no fio (9 bits por byte) mais folga */
+static int mpu6050_timeout_ms(size_t bytes)
+{
+    uint32_t bits = (uint32_t)(bytes + 3) * 9;
+    return (int)(bits * 2000 / s_freq_hz) + I2C_TIMEOUT_FOLGA_MS;
+}
+
+/* --------------------------------------------------------------------------
+ *  Transação bloqueante nos dois modos. No assíncrono espera a fila esvaziar
+ *  (inclui um burst pendente) e confere o evento do callback; os dados vão
+ *  e voltam pelos buffers do módulo (s_transacao_*), nunca pelos de quem
+ *  chama, porque no estouro do prazo a transação continua na fila.
  * -------------------------------------------------------------------------- */
-esp_err_t mpu6050_init(void)
+static esp_err_t mpu6050_transacao(const uint8_t *escrita, size_t tam_escrita, uint8_t *leitura, size_t tam_leitura)
 {
+    int timeout = mpu6050_timeout_ms(tam_escrita + tam_leitura);
+    int64_t inicio = esp_timer_get_time();
+    uint8_t *destino = leitura;
     esp_err_t err;
 
-    /* 1) Garante que o barramento I2C está inicializado */
-    err = i2c_master_init();
-    if (err != ESP_OK)
+    if (s_assincrono)
     {
-        ESP_LOGE(TAG, "Falha ao inicializar barramento I2C");
-        return err;
+        if (tam_escrita > sizeof(s_transacao_escrita) || tam_leitura > sizeof(s_transacao_leitura))
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(s_transacao_escrita, escrita, tam_escrita);
+        escrita = s_transacao_escrita;
+        destino = s_transacao_leitura;
+    }
+
+    s_evento_i2c = I2C_EVENT_DONE;
+    if (leitura != NULL)
+    {
+        err = i2c_master_transmit_receive(s_mpu6050_handle, escrita, tam_escrita, destino, tam_leitura, timeout);
+    }
+    else
+    {
+        err = i2c_master_transmit(s_mpu6050_handle, escrita, tam_escrita, timeout);
+    }
+
+    if (err == ESP_OK && s_assincrono)
+    {
+        err = i2c_master_bus_wait_all_done(s_i2c_bus_handle, timeout);
+        if (err == ESP_OK && s_evento_i2c != I2C_EVENT_DONE)
+        {
+            err = s_evento_i2c == I2C_EVENT_TIMEOUT ? ESP_ERR_TIMEOUT : ESP_FAIL;
+        }
+        if (err == ESP_OK && leitura != NULL)
+        {
+            memcpy(leitura, s_transacao_leitura, tam_leitura);
+        }
+    }
+
+    mpu6050_i2c_registra(tam_escrita + tam_leitura, esp_timer_get_time() - inicio, err != ESP_OK);
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  Helpers de acesso a registradores
+ * -------------------------------------------------------------------------- */
+static esp_err_t mpu6050_escreve_registro(uint8_t reg, uint8_t valor)
+{
+    uint8_t cmd[2] = {reg, valor};
+    return mpu6050_transacao(cmd, sizeof(cmd), NULL, 0);
+}
+
+static esp_err_t mpu6050_le_registros(uint8_t reg, uint8_t *dados, size_t tamanho)
+{
+    return mpu6050_transacao(&reg, 1, dados, tamanho);
+}
+
+/*
+ * Converte um frame no layout do perfil. COMPLETO é também o layout dos
+ * registradores 0x3B..0x48; o que o perfil não lê fica zerado.
+ */
+static void mpu6050_decodifica_frame(const uint8_t *raw_data, Mpu6050PerfilLeitura perfil, Mpu6050Data *data)
+{
+    /* Monta os valores 16 bits (high << 8 | low) para cada eixo */
+
+    data->accel_x = (int16_t)((raw_data[0] << 8) | raw_data[1]);
+    data->accel_y = (int16_t)((raw_data[2] << 8) | raw_data[3]);
+    data->accel_z = (int16_t)((raw_data[4] << 8) | raw_data[5]);
+
+    const uint8_t *gyro = NULL;
+    data->temp_centi_c = 0;
+    if (perfil == MPU6050_PERFIL_COMPLETO)
+    {
+        int32_t temp_raw = (int16_t)((raw_data[6] << 8) | raw_data[7]);
+        /* Fórmula do datasheet: Temp(°C) = temp_raw / 340 + 36.53, aqui em centésimos */
+        data->temp_centi_c = (int16_t)(temp_raw * 100 / 340 + 3653);
+        gyro = &raw_data[8];
+    }
+    else if (perfil == MPU6050_PERFIL_ACCEL_GYRO)
+    {
+        gyro = &raw_data[6];
+    }
+
+    if (gyro != NULL)
+    {
+        data->gyro_x = (int16_t)((gyro[0] << 8) | gyro[1]);
+        data->gyro_y = (int16_t)((gyro[2] << 8) | gyro[3]);
+        data->gyro_z = (int16_t)((gyro[4] << 8) | gyro[5]);
+    }
+    else
+    {
+        data->gyro_x = data->gyro_y = data->gyro_z = 0;
+    }
+
+    data->faixa_accel = (uint8_t)s_faixa_accel;
+    data->faixa_gyro = (uint8_t)s_faixa_gyro;
+}
+
+/* Cópia da calibração em vigor; false se não há calibração */
+static bool mpu6050_copia_calibracao(Mpu6050Calibracao *cal)
+{
+    portENTER_CRITICAL(&s_cal_mux);
+    bool calibrado = s_calibrado;
+    *cal = s_calibracao;
+    portEXIT_CRITICAL(&s_cal_mux);
+    return calibrado;
+}
+
+static esp_err_t mpu6050_escreve_faixas(void)
+{
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_ACCEL_CONFIG, (uint8_t)(s_faixa_accel << MPU6050_FS_SEL_SHIFT));
+    if (err == ESP_OK)
+    {
+        err = mpu6050_escreve_registro(MPU6050_GYRO_CONFIG, (uint8_t)(s_faixa_gyro << MPU6050_FS_SEL_SHIFT));
+    }
+    return err;
+}
+
+/* Adiciona o MPU6050 ao barramento na frequência pedida (e o callback, se assíncrono) */
+static esp_err_t mpu6050_adiciona_dispositivo(uint32_t freq_hz)
+{
+    if (s_mpu6050_handle != NULL)
+    {
+        i2c_master_bus_rm_device(s_mpu6050_handle);
+        s_mpu6050_handle = NULL;
     }
 
-    /* 2) Configura os parâmetros do dispositivo MPU6050 no barramento */
     i2c_device_config_t dev_cfg = {
         .dev_addr_length = I2C_ADDR_BIT_LEN_7, // Endereço de 7 bits
         .device_address = MPU6050_ADDR,        // Endereço do MPU6050 (0x68)
-        .scl_speed_hz = I2C_MASTER_FREQ_HZ,    // Velocidade do clock para este device
+        .scl_speed_hz = freq_hz,               // Velocidade do clock para este device
         .scl_wait_us = 0,                      // 0 = valor padrão de espera
     };
 
-    /* 3) Adiciona o MPU6050 ao barramento e obtém um handle para ele */
-    err = i2c_master_bus_add_device(s_i2c_bus_handle, &dev_cfg, &s_mpu6050_handle);
+    esp_err_t err = i2c_master_bus_add_device(s_i2c_bus_handle, &dev_cfg, &s_mpu6050_handle);
+    if (err == ESP_OK && s_assincrono)
+    {
+        i2c_master_event_callbacks_t cbs = {
+            .on_trans_done = mpu6050_i2c_concluida,
+        };
+        err = i2c_master_register_event_callbacks(s_mpu6050_handle, &cbs, NULL);
+    }
+    if (err == ESP_OK)
+    {
+        s_freq_hz = freq_hz;
+    }
+    return err;
+}
+
+/*
+ * Fast mode depende do tempo de subida das linhas: com pull-up fraco (só o
+ * interno, ~45 kΩ) os bits chegam corrompidos ou com NACK. A validação lê o
+ * WHO_AM_I várias vezes e exige sempre o mesmo valor, sem erro.
+ */
+static bool mpu6050_barramento_valido(void)
+{
+    uint8_t primeiro = 0;
+    for (int i = 0; i < I2C_TESTE_LEITURAS; i++)
+    {
+        uint8_t valor;
+        if (mpu6050_le_registros(MPU6050_WHO_AM_I, &valor, 1) != ESP_OK)
+        {
+            return false;
+        }
+        if (i == 0)
+        {
+            primeiro = valor;
+        }
+        else if (valor != primeiro)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* --------------------------------------------------------------------------
+ *  Inicialização do MPU6050
+ *   `cfg` NULL: 100 kHz, transações bloqueantes
+ * -------------------------------------------------------------------------- */
+esp_err_t mpu6050_init(const Mpu6050BarramentoConfig *cfg)
+{
+    esp_err_t err;
+    uint32_t freq_hz = cfg != NULL ? cfg->freq_hz : I2C_MASTER_FREQ_PADRAO_HZ;
+    s_assincrono = cfg != NULL && cfg->assincrono;
+
+    /* 1) Garante que o barramento I2C está inicializado */
+    err = i2c_master_init();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao inicializar barramento I2C");
+        return err;
+    }
+
+    /* 2) Adiciona o MPU6050 ao barramento e obtém um handle para ele */
+    err = mpu6050_adiciona_dispositivo(freq_hz);
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Falha ao adicionar MPU6050 ao barramento I2C (err=0x%x)", err);
         return err;
     }
 
-    /* 4) Escreve no registrador PWR_MGMT_1 para “acordar” o sensor
-       Protocolo: [ endereço_registro | valor ] */
-    uint8_t cmd[2];
-    cmd[0] = MPU6050_PWR_MGMT_1; // Registrador de controle de energia
-    cmd[1] = 0x00;               // 0x00 = acorda o MPU6050 (usa clock interno)
+    /* 3) Acima do modo padrão, só fica se o barramento aguentar */
+    if (freq_hz > I2C_MASTER_FREQ_PADRAO_HZ && !mpu6050_barramento_valido())
+    {
+        ESP_LOGW(TAG, "Barramento instavel a %lu Hz (pull-ups?), voltando para %d Hz",
+                 (unsigned long) freq_hz, I2C_MASTER_FREQ_PADRAO_HZ);
+        err = mpu6050_adiciona_dispositivo(I2C_MASTER_FREQ_PADRAO_HZ);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Falha ao readicionar MPU6050 (err=0x%x)", err);
+            return err;
+        }
+    }
+
+    /* 4) PWR_MGMT_1 = 0x00 acorda o MPU6050 (usa clock interno) */
+    err = mpu6050_escreve_registro(MPU6050_PWR_MGMT_1, 0x00);
 
-    /* i2c_master_transmit envia esse buffer para o slave selecionado */
-    err = i2c_master_transmit(
-        s_mpu6050_handle,     // Handle do dispositivo MPU6050
-        cmd,                  // Buffer com registro + dado
-        sizeof(cmd),          // Tamanho do buffer (2 bytes)
-        I2C_MASTER_TIMEOUT_MS // Timeout em milissegundos
-    );
+    /* 5) Faixas atuais (±2 g / ±250 graus/s até mpu6050_configura_faixa) */
+    if (err == ESP_OK)
+    {
+        err = mpu6050_escreve_faixas();
+    }
 
     if (err == ESP_OK)
     {
-        ESP_LOGI(TAG, "MPU6050 inicializado com sucesso (API nova i2c_master)");
+        ESP_LOGI(TAG, "MPU6050 inicializado: I2C a %lu Hz, transacoes %s",
+                 (unsigned long) s_freq_hz, s_assincrono ? "assincronas" : "bloqueantes");
     }
     else
     {
@@ -118,7 +486,8 @@ esp_err_t mpu6050_init(void)
 }
 
 /* --------------------------------------------------------------------------
- *  Leitura dos dados do MPU6050 usando i2c_master_transmit_receive
+ *  Leitura direta dos registradores de dados (0x3B em diante). No perfil só
+ *  accel são 6 bytes; nos outros o bloco inteiro, que inclui a temperatura.
  * -------------------------------------------------------------------------- */
 esp_err_t mpu6050_read(Mpu6050Data *data)
 {
@@ -128,39 +497,592 @@ esp_err_t mpu6050_read(Mpu6050Data *data)
         return ESP_ERR_INVALID_STATE;
     }
 
-    uint8_t reg_addr = MPU6050_ACCEL_XOUT_H;
-    uint8_t raw_data[14];
-
-    /* i2c_master_transmit_receive faz exatamente o padrão "escreve o endereço
-       do registrador e em seguida lê N bytes" em uma única transação I2C. */
-    esp_err_t err = i2c_master_transmit_receive(
-        s_mpu6050_handle,     // Dispositivo MPU6050
-        &reg_addr,            // Buffer de escrita: endereço do registrador
-        1,                    // Tamanho da escrita (1 byte)
-        raw_data,             // Buffer de leitura
-        sizeof(raw_data),     // Quantidade de bytes a ler (14)
-        I2C_MASTER_TIMEOUT_MS // Timeout
-    );
+    Mpu6050PerfilLeitura perfil = s_perfil == MPU6050_PERFIL_ACCEL ? MPU6050_PERFIL_ACCEL : MPU6050_PERFIL_COMPLETO;
+    uint8_t raw_data[MPU6050_FRAME_BYTES];
 
+    esp_err_t err = mpu6050_le_registros(MPU6050_ACCEL_XOUT_H, raw_data, s_perfis[perfil].frame_bytes);
     if (err != ESP_OK)
     {
         ESP_LOGE(TAG, "Erro ao ler dados do MPU6050 (err=0x%x)", err);
         return err;
     }
 
-    /* Monta os valores 16 bits (high << 8 | low) para cada eixo */
+    mpu6050_decodifica_frame(raw_data, perfil, data);
+    data->timestamp_us = esp_timer_get_time();
 
-    data->accel_x = (int16_t)((raw_data[0] << 8) | raw_data[1]);
-    data->accel_y = (int16_t)((raw_data[2] << 8) | raw_data[3]);
-    data->accel_z = (int16_t)((raw_data[4] << 8) | raw_data[5]);
+    Mpu6050Calibracao cal;
+    if (mpu6050_copia_calibracao(&cal))
+    {
+        mpu6050_calibracao_aplica(&cal, mpu6050_lsb_por_g(data->faixa_accel), data);
+    }
+
+    return ESP_OK;
+}
+
+/* --------------------------------------------------------------------------
+ *  ISR do pino INT (DATA_RDY)
+ *   Só conta pulsos e acorda a tarefa quando um lote inteiro está na FIFO,
+ *   assim o custo de CPU por lote é fixo e não depende da taxa.
+ * -------------------------------------------------------------------------- */
+static void IRAM_ATTR mpu6050_isr_handler(void *arg)
+{
+    BaseType_t acordar_tarefa = pdFALSE;
+
+    if (s_modo_movimento)
+    {
+        /* INT em nível e travado: desliga até a tarefa limpar o INT_STATUS */
+        gpio_intr_disable(s_pino_int);
+        vTaskNotifyGiveFromISR(s_tarefa_notificada, &acordar_tarefa);
+    }
+    else if (++s_isr_contagem >= s_amostras_por_lote)
+    {
+        s_isr_contagem = 0;
+        vTaskNotifyGiveFromISR(s_tarefa_notificada, &acordar_tarefa);
+    }
+
+    portYIELD_FROM_ISR(acordar_tarefa);
+}
+
+/* Espera um burst em andamento terminar e joga fora o que ele leu */
+static void mpu6050_burst_descarta(void)
+{
+    if (s_burst_pendente && s_assincrono)
+    {
+        i2c_master_bus_wait_all_done(s_i2c_bus_handle, mpu6050_timeout_ms(s_burst_bytes + 1));
+    }
+    s_burst_pendente = false;
+    s_burst_concluido = false;
+}
+
+/* Zera a FIFO e reancora a base de tempo das amostras */
+static esp_err_t mpu6050_fifo_reset(void)
+{
+    mpu6050_burst_descarta();
+
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    if (err == ESP_OK)
+    {
+        err = mpu6050_escreve_registro(MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN);
+    }
+
+    s_t0_us = esp_timer_get_time();
+    s_amostras_total = 0;
+    s_isr_contagem = 0;
+
+    return err;
+}
+
+/* SMPLRT_DIV, DLPF, faixas e INT (nível alto, push-pull, pulso de 50 us) do modo FIFO */
+static esp_err_t mpu6050_configura_taxa(void)
+{
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_SMPLRT_DIV, s_divisor);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_CONFIG, s_dlpf_cfg);
+    if (err == ESP_OK) err = mpu6050_escreve_faixas();
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_INT_PIN_CFG, 0x00);
+    return err;
+}
+
+/* Liga na FIFO os campos do perfil, zera e habilita o DATA_RDY */
+static esp_err_t mpu6050_fifo_habilita(void)
+{
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_FIFO_EN, s_perfis[s_perfil].fifo_en);
+    if (err == ESP_OK) err = mpu6050_fifo_reset();
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_INT_ENABLE, MPU6050_INT_DATA_RDY_EN);
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  Modo de amostragem por FIFO + interrupção
+ *   1) SMPLRT_DIV e DLPF definem a taxa (1 kHz / (1 + div))
+ *   2) FIFO recebe os campos do perfil a cada amostra
+ *   3) INT pulsa a cada DATA_RDY; a ISR acorda `tarefa` a cada lote
+ * -------------------------------------------------------------------------- */
+esp_err_t mpu6050_fifo_iniciar(const Mpu6050FifoConfig *cfg, TaskHandle_t tarefa)
+{
+    if (s_mpu6050_handle == NULL)
+    {
+        ESP_LOGE(TAG, "MPU6050 nao foi inicializado antes do modo FIFO");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (cfg == NULL || tarefa == NULL ||
+        cfg->taxa_hz < MPU6050_TAXA_MIN_HZ || cfg->taxa_hz > MPU6050_TAXA_MAX_HZ ||
+        cfg->dlpf_cfg < 1 || cfg->dlpf_cfg > 6 ||
+        cfg->amostras_por_lote == 0 || cfg->amostras_por_lote > MPU6050_FIFO_MAX_FRAMES / 2 ||
+        cfg->perfil > MPU6050_PERFIL_COMPLETO)
+    {
+        ESP_LOGE(TAG, "Configuracao de FIFO invalida");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t divisor = (uint8_t)(MPU6050_TAXA_GIROSCOPIO_HZ / cfg->taxa_hz - 1);
+
+    s_tarefa_notificada = tarefa;
+    s_amostras_por_lote = cfg->amostras_por_lote;
+    s_periodo_us = (int64_t)(divisor + 1) * 1000000 / MPU6050_TAXA_GIROSCOPIO_HZ;
+    s_divisor = divisor;
+    s_dlpf_cfg = cfg->dlpf_cfg;
+    s_pino_int = cfg->pino_int;
+    s_perfil = cfg->perfil;
+
+    /* Desliga interrupção e FIFO enquanto reconfigura */
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_INT_ENABLE, 0x00);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_FIFO_EN, 0x00);
+    if (err == ESP_OK) err = mpu6050_configura_taxa();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao configurar taxa/DLPF do MPU6050 (err=0x%x)", err);
+        return err;
+    }
+
+    gpio_config_t io_cfg = {
+        .pin_bit_mask = 1ULL << cfg->pino_int,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    err = gpio_config(&io_cfg);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao configurar GPIO %d da interrupcao (err=0x%x)", cfg->pino_int, err);
+        return err;
+    }
+
+    /* O serviço de ISR pode já ter sido instalado por outro módulo */
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGE(TAG, "Falha ao instalar servico de ISR (err=0x%x)", err);
+        return err;
+    }
+
+    err = gpio_isr_handler_add(cfg->pino_int, mpu6050_isr_handler, NULL);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao registrar ISR do MPU6050 (err=0x%x)", err);
+        return err;
+    }
+
+    err = mpu6050_fifo_habilita();
+
+    if (err == ESP_OK)
+    {
+        ESP_LOGI(TAG, "FIFO ativa: %d Hz, DLPF %d, lote de %d amostras de %d bytes",
+                 MPU6050_TAXA_GIROSCOPIO_HZ / (divisor + 1), cfg->dlpf_cfg, cfg->amostras_por_lote,
+                 s_perfis[s_perfil].frame_bytes);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Falha ao habilitar FIFO do MPU6050 (err=0x%x)", err);
+    }
+
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  Drena a FIFO: lê o contador e enfileira todos os frames completos em uma
+ *  única transação I2C (burst no registrador FIFO_R_W). O contador é só
+ *  2 bytes e continua bloqueante; o burst é o que ocupa o barramento.
+ * -------------------------------------------------------------------------- */
+esp_err_t mpu6050_fifo_inicia_lote(size_t max_amostras)
+{
+    if (s_mpu6050_handle == NULL || s_periodo_us == 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_burst_pendente)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t contagem_raw[2];
+    esp_err_t err = mpu6050_le_registros(MPU6050_FIFO_COUNTH, contagem_raw, sizeof(contagem_raw));
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Erro ao ler contador da FIFO (err=0x%x)", err);
+        return err;
+    }
+
+    uint16_t contagem = (uint16_t)((contagem_raw[0] << 8) | contagem_raw[1]);
+    size_t frame_bytes = s_perfis[s_perfil].frame_bytes;
+
+    /* 1024 não é múltiplo do frame: FIFO cheia significa frames desalinhados */
+    if (contagem > MPU6050_FIFO_TAMANHO - frame_bytes)
+    {
+        s_fifo_overflows++;
+        ESP_LOGW(TAG, "Overflow na FIFO (%d bytes), reiniciando", contagem);
+        return mpu6050_fifo_reset();
+    }
+
+    size_t frames = contagem / frame_bytes;
+
+    /* O frame mais novo da FIFO foi amostrado há menos de um período: ancora
+     * nele, e os anteriores ficam um período atrás de cada um */
+    s_t0_us = esp_timer_get_time() - (int64_t)frames * s_periodo_us;
+    s_amostras_total = 0;
+
+    if (frames > max_amostras)
+    {
+        frames = max_amostras;
+    }
+    if (frames == 0)
+    {
+        return ESP_OK;
+    }
+
+    s_burst_frames = frames;
+    s_burst_bytes = frames * frame_bytes;
+    s_burst_concluido = false;
+    s_burst_inicio_us = esp_timer_get_time();
+    s_burst_pendente = true;
+
+    err = i2c_master_transmit_receive(s_mpu6050_handle, &s_reg_fifo, 1, s_fifo_buffer, s_burst_bytes,
+                                      mpu6050_timeout_ms(s_burst_bytes + 1));
+    if (!s_assincrono)
+    {
+        /* Bloqueante: o burst já terminou aqui */
+        mpu6050_i2c_registra(s_burst_bytes + 1, esp_timer_get_time() - s_burst_inicio_us, err != ESP_OK);
+        s_burst_evento = err == ESP_OK ? I2C_EVENT_DONE : I2C_EVENT_TIMEOUT;
+        s_burst_concluido = true;
+    }
+    if (err != ESP_OK)
+    {
+        s_burst_pendente = false;
+        ESP_LOGE(TAG, "Erro ao drenar FIFO (err=0x%x)", err);
+    }
+    return err;
+}
+
+esp_err_t mpu6050_fifo_conclui_lote(Mpu6050Data *amostras, size_t *lidas)
+{
+    *lidas = 0;
 
-    int16_t temp_raw = (int16_t)((raw_data[6] << 8) | raw_data[7]);
-    /* Fórmula do datasheet: Temp(°C) = temp_raw / 340 + 36.53 */
-    data->temp = (temp_raw / 340.0f) + 36.53f;
+    if (!s_burst_pendente)
+    {
+        return ESP_OK;
+    }
+    if (!s_burst_concluido)
+    {
+        return ESP_ERR_NOT_FINISHED;
+    }
+
+    s_burst_pendente = false;
+    s_burst_concluido = false;
+    if (s_burst_evento != I2C_EVENT_DONE)
+    {
+        ESP_LOGE(TAG, "Erro no burst da FIFO (evento %d)", (int) s_burst_evento);
+        return s_burst_evento == I2C_EVENT_TIMEOUT ? ESP_ERR_TIMEOUT : ESP_FAIL;
+    }
+
+    Mpu6050Calibracao cal;
+    bool calibrado = mpu6050_copia_calibracao(&cal);
+    float lsb_por_g = mpu6050_lsb_por_g(s_faixa_accel);
+    size_t frame_bytes = s_perfis[s_perfil].frame_bytes;
+
+    for (size_t i = 0; i < s_burst_frames; i++)
+    {
+        mpu6050_decodifica_frame(&s_fifo_buffer[i * frame_bytes], s_perfil, &amostras[i]);
+        if (calibrado)
+        {
+            mpu6050_calibracao_aplica(&cal, lsb_por_g, &amostras[i]);
+        }
+        s_amostras_total++;
+        int64_t timestamp_us = s_t0_us + (int64_t)s_amostras_total * s_periodo_us;
+        /* A âncora tem jitter de até um período; o tempo nunca volta */
+        if (timestamp_us <= s_ultimo_timestamp_us)
+        {
+            timestamp_us = s_ultimo_timestamp_us + 1;
+        }
+        s_ultimo_timestamp_us = timestamp_us;
+        amostras[i].timestamp_us = timestamp_us;
+    }
+
+    *lidas = s_burst_frames;
+    return ESP_OK;
+}
+
+esp_err_t mpu6050_fifo_ler_lote(Mpu6050Data *amostras, size_t max_amostras, size_t *lidas)
+{
+    *lidas = 0;
+
+    esp_err_t err = mpu6050_fifo_inicia_lote(max_amostras);
+    if (err == ESP_OK && s_burst_pendente && s_assincrono)
+    {
+        err = i2c_master_bus_wait_all_done(s_i2c_bus_handle, mpu6050_timeout_ms(s_burst_bytes + 1));
+        if (err != ESP_OK)
+        {
+            mpu6050_burst_descarta();
+        }
+    }
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    return mpu6050_fifo_conclui_lote(amostras, lidas);
+}
+
+Mpu6050EstatisticasI2c mpu6050_i2c_estatisticas(void)
+{
+    Mpu6050EstatisticasI2c est;
+    portENTER_CRITICAL(&s_i2c_mux);
+    est = s_est_i2c;
+    portEXIT_CRITICAL(&s_i2c_mux);
+    est.freq_hz = s_freq_hz;
+    return est;
+}
+
+uint32_t mpu6050_fifo_overflows(void)
+{
+    return s_fifo_overflows;
+}
+
+/* --------------------------------------------------------------------------
+ *  Modo de baixo consumo: acelerômetro em ciclo + interrupção de movimento
+ *   1) Para FIFO e DATA_RDY e limpa notificações pendentes da tarefa
+ *   2) Giroscópio em standby, HPF de 5 Hz, limiar/duração de movimento
+ *   3) INT travado em nível alto; o pino vira fonte de wakeup do light sleep
+ *   4) CYCLE: o chip acorda em `frequencia_wake`, mede e volta a dormir
+ *  Deve ser chamada pela própria tarefa passada a mpu6050_fifo_iniciar().
+ * -------------------------------------------------------------------------- */
+esp_err_t mpu6050_modo_movimento(const Mpu6050MovimentoConfig *cfg)
+{
+    if (s_mpu6050_handle == NULL || s_pino_int < 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (cfg == NULL || cfg->frequencia_wake > MPU6050_WAKE_40HZ)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t limiar = cfg->limiar_mg / MPU6050_MOT_THR_MG_LSB;
+    if (limiar < 1) limiar = 1;
+    if (limiar > 255) limiar = 255;
+    uint8_t duracao = cfg->duracao_ms < 1 ? 1 : (cfg->duracao_ms > 255 ? 255 : (uint8_t)cfg->duracao_ms);
+
+    mpu6050_burst_descarta();
+
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_INT_ENABLE, 0x00);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_FIFO_EN, 0x00);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_USER_CTRL, 0x00);
 
-    data->gyro_x = (int16_t)((raw_data[8] << 8) | raw_data[9]);
-    data->gyro_y = (int16_t)((raw_data[10] << 8) | raw_data[11]);
-    data->gyro_z = (int16_t)((raw_data[12] << 8) | raw_data[13]);
+    gpio_intr_disable(s_pino_int);
+    xTaskNotifyStateClear(NULL);
+    ulTaskNotifyValueClear(NULL, UINT32_MAX);
 
+    uint8_t status;
+    if (err == ESP_OK) err = mpu6050_le_registros(MPU6050_INT_STATUS, &status, 1);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_CONFIG, 0x00);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_ACCEL_CONFIG,
+                                                      (uint8_t)(s_faixa_accel << MPU6050_FS_SEL_SHIFT) |
+                                                          MPU6050_ACCEL_HPF_5HZ);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_MOT_THR, (uint8_t)limiar);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_MOT_DUR, duracao);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_INT_PIN_CFG, MPU6050_INT_LATCH_EN);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_PWR_MGMT_2,
+                                                      (uint8_t)(cfg->frequencia_wake << 6) | MPU6050_PWR2_STBY_GYRO);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_INT_ENABLE, MPU6050_INT_MOT_EN);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_PWR_MGMT_1, MPU6050_PWR1_CYCLE_TEMP_DIS);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao entrar no modo movimento (err=0x%x)", err);
+        return err;
+    }
+
+    /* Em nível: um INT que chegue antes do sleep dispara a ISR na hora */
+    s_modo_movimento = true;
+    gpio_wakeup_enable(s_pino_int, GPIO_INTR_HIGH_LEVEL);
+    gpio_intr_enable(s_pino_int);
+
+    ESP_LOGI(TAG, "Modo movimento: limiar %lu mg, duracao %d ms",
+             (unsigned long) (limiar * MPU6050_MOT_THR_MG_LSB), duracao);
     return ESP_OK;
 }
+
+/* --------------------------------------------------------------------------
+ *  Volta do modo movimento para a FIFO em taxa cheia, com a configuração
+ *  de mpu6050_fifo_iniciar(). A base de tempo das amostras é reancorada.
+ * -------------------------------------------------------------------------- */
+esp_err_t mpu6050_fifo_retoma(void)
+{
+    if (s_mpu6050_handle == NULL || s_pino_int < 0)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    gpio_intr_disable(s_pino_int);
+    gpio_wakeup_disable(s_pino_int);
+    s_modo_movimento = false;
+
+    uint8_t status;
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_PWR_MGMT_1, 0x00);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_PWR_MGMT_2, 0x00);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_INT_ENABLE, 0x00);
+    if (err == ESP_OK) err = mpu6050_le_registros(MPU6050_INT_STATUS, &status, 1);
+    if (err == ESP_OK) err = mpu6050_configura_taxa();
+
+    gpio_set_intr_type(s_pino_int, GPIO_INTR_POSEDGE);
+    gpio_intr_enable(s_pino_int);
+
+    if (err == ESP_OK) err = mpu6050_fifo_habilita();
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao retomar a FIFO (err=0x%x)", err);
+    }
+
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  Faixas, DLPF e divisor em tempo de execução
+ *   Podem ser chamadas antes ou depois de mpu6050_fifo_iniciar(), pela
+ *   tarefa que controla o MPU6050. Com a FIFO ativa ela é zerada: amostras
+ *   de faixas ou taxas diferentes nunca se misturam num lote.
+ * -------------------------------------------------------------------------- */
+esp_err_t mpu6050_configura_faixa(Mpu6050FaixaAccel faixa_accel, Mpu6050FaixaGyro faixa_gyro)
+{
+    if (faixa_accel > MPU6050_ACCEL_16G || faixa_gyro > MPU6050_GYRO_2000DPS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_faixa_accel = faixa_accel;
+    s_faixa_gyro = faixa_gyro;
+
+    if (s_mpu6050_handle == NULL)
+    {
+        return ESP_OK; // Gravadas no mpu6050_init()
+    }
+
+    esp_err_t err = mpu6050_escreve_faixas();
+    if (err == ESP_OK && s_periodo_us != 0 && !s_modo_movimento)
+    {
+        err = mpu6050_fifo_reset();
+    }
+
+    if (err == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Faixas: ±%d g, ±%d graus/s", 2 << faixa_accel, 250 << faixa_gyro);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Falha ao configurar faixas do MPU6050 (err=0x%x)", err);
+    }
+    return err;
+}
+
+esp_err_t mpu6050_configura_filtro(uint8_t dlpf_cfg, uint8_t divisor)
+{
+    /* O DLPF mantém a taxa interna em 1 kHz; o divisor fica dentro da faixa da FIFO */
+    if (dlpf_cfg < 1 || dlpf_cfg > 6 || divisor > MPU6050_DIVISOR_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_dlpf_cfg = dlpf_cfg;
+    s_divisor = divisor;
+
+    if (s_mpu6050_handle == NULL || s_periodo_us == 0)
+    {
+        return ESP_OK; // Aplicados por mpu6050_fifo_iniciar()
+    }
+
+    s_periodo_us = (int64_t)(divisor + 1) * 1000000 / MPU6050_TAXA_GIROSCOPIO_HZ;
+    if (s_modo_movimento)
+    {
+        return ESP_OK; // Aplicados por mpu6050_fifo_retoma()
+    }
+
+    esp_err_t err = mpu6050_escreve_registro(MPU6050_SMPLRT_DIV, s_divisor);
+    if (err == ESP_OK) err = mpu6050_escreve_registro(MPU6050_CONFIG, s_dlpf_cfg);
+    if (err == ESP_OK) err = mpu6050_fifo_reset();
+
+    if (err == ESP_OK)
+    {
+        ESP_LOGI(TAG, "Filtro: %d Hz, DLPF %d", MPU6050_TAXA_GIROSCOPIO_HZ / (divisor + 1), dlpf_cfg);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Falha ao configurar DLPF/divisor do MPU6050 (err=0x%x)", err);
+    }
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  Calibração do acelerômetro
+ *   A troca vale a partir da próxima leitura; pode vir de qualquer task.
+ * -------------------------------------------------------------------------- */
+void mpu6050_define_calibracao(const Mpu6050Calibracao *cal)
+{
+    portENTER_CRITICAL(&s_cal_mux);
+    if (cal != NULL)
+    {
+        s_calibracao = *cal;
+    }
+    else
+    {
+        mpu6050_calibracao_identidade(&s_calibracao);
+    }
+    s_calibrado = cal != NULL;
+    portEXIT_CRITICAL(&s_cal_mux);
+}
+
+void mpu6050_calibracao_atual(Mpu6050Calibracao *cal)
+{
+    if (!mpu6050_copia_calibracao(cal))
+    {
+        mpu6050_calibracao_identidade(cal);
+    }
+}
+
+esp_err_t mpu6050_calibracao_carrega(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(MPU6050_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    Mpu6050Calibracao cal;
+    size_t tamanho = sizeof(cal);
+    err = nvs_get_blob(nvs, MPU6050_NVS_CHAVE_CALIBRACAO, &cal, &tamanho);
+    nvs_close(nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    if (tamanho != sizeof(cal) || !mpu6050_calibracao_valida(&cal))
+    {
+        ESP_LOGW(TAG, "Calibracao na NVS invalida, ignorada");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    mpu6050_define_calibracao(&cal);
+    ESP_LOGI(TAG, "Calibracao: offset %.3f %.3f %.3f g, ganho %.4f %.4f %.4f",
+             cal.offset_g[0], cal.offset_g[1], cal.offset_g[2], cal.ganho[0], cal.ganho[1], cal.ganho[2]);
+    return ESP_OK;
+}
+
+esp_err_t mpu6050_calibracao_salva(const Mpu6050Calibracao *cal)
+{
+    if (!mpu6050_calibracao_valida(cal))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(MPU6050_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+    err = nvs_set_blob(nvs, MPU6050_NVS_CHAVE_CALIBRACAO, cal, sizeof(*cal));
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
@@ -2,20 +2,110 @@
 #define ACELEROMETRO_MODULO_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mpu6050_dados.h"
+#include "mpu6050_calibracao.h"
+
+#define MPU6050_TAXA_MIN_HZ 200
+#define MPU6050_TAXA_MAX_HZ 1000
+
+/* O que cada amostra traz do sensor; menos bytes, menos tempo de barramento */
+typedef enum
+{
+    MPU6050_PERFIL_ACCEL = 0,      // 6 bytes; giroscópio e temperatura zerados
+    MPU6050_PERFIL_ACCEL_GYRO = 1, // 12 bytes; temperatura zerada
+    MPU6050_PERFIL_COMPLETO = 2,   // 14 bytes
+} Mpu6050PerfilLeitura;
+
+typedef struct
+{
+    uint32_t freq_hz; // 100000 ou 400000; acima de 100 kHz é validado no init
+    bool assincrono;  // Transações na fila do i2c_master, fim avisado por callback
+} Mpu6050BarramentoConfig;
 
 typedef struct
 {
-    int16_t accel_x;
-    int16_t accel_y;
-    int16_t accel_z;
-    int16_t gyro_x;
-    int16_t gyro_y;
-    int16_t gyro_z;
-    float temp;
-} Mpu6050Data;
-
-esp_err_t mpu6050_init(void);
+    uint16_t taxa_hz;             // Taxa de amostragem (200 a 1000 Hz)
+    uint8_t dlpf_cfg;             // DLPF_CFG do registrador CONFIG (1 a 6)
+    uint8_t amostras_por_lote;    // Amostras acumuladas na FIFO por notificação
+    int pino_int;                 // GPIO ligado ao pino INT do MPU6050
+    Mpu6050PerfilLeitura perfil;  // Campos gravados na FIFO
+} Mpu6050FifoConfig;
+
+/* Acumulado desde o init, por transação I2C (inclui as de configuração) */
+typedef struct
+{
+    uint32_t transacoes;
+    uint32_t erros;
+    uint64_t bytes;          // Escritos + lidos, sem endereço
+    uint64_t tempo_total_us; // Do envio ao fim (callback no modo assíncrono)
+    uint32_t tempo_max_us;
+    uint32_t freq_hz;        // Frequência em uso (após a validação)
+} Mpu6050EstatisticasI2c;
+
+/* LP_WAKE_CTRL: frequência de medição do acelerômetro no modo ciclo */
+typedef enum
+{
+    MPU6050_WAKE_1_25HZ = 0,
+    MPU6050_WAKE_5HZ = 1,
+    MPU6050_WAKE_20HZ = 2,
+    MPU6050_WAKE_40HZ = 3,
+} Mpu6050FrequenciaWake;
+
+typedef struct
+{
+    uint16_t limiar_mg;                    // Variação (após HPF) que conta como movimento
+    uint16_t duracao_ms;                   // Tempo acima do limiar para gerar o INT
+    Mpu6050FrequenciaWake frequencia_wake; // Giroscópio fica em standby
+} Mpu6050MovimentoConfig;
+
+/*
+ * Acorda o sensor e grava as faixas atuais (padrão ±2 g / ±250 graus/s).
+ * `cfg` NULL: 100 kHz e transações bloqueantes. Se o barramento não
+ * aguenta a frequência pedida, volta para 100 kHz com um aviso.
+ */
+esp_err_t mpu6050_init(const Mpu6050BarramentoConfig *cfg);
+/* Registradores de dados no perfil da FIFO (COMPLETO antes dela) */
 esp_err_t mpu6050_read(Mpu6050Data *data);
 
-#endif
\ No newline at end of file
+esp_err_t mpu6050_fifo_iniciar(const Mpu6050FifoConfig *cfg, TaskHandle_t tarefa);
+/* Bloqueante: equivale a inicia + espera + conclui */
+esp_err_t mpu6050_fifo_ler_lote(Mpu6050Data *amostras, size_t max_amostras, size_t *lidas);
+
+/*
+ * Leitura em duas etapas para não bloquear a tarefa de aquisição:
+ *  - inicia: lê o contador da FIFO e enfileira o burst (até `max_amostras`)
+ *  - conclui: ESP_ERR_NOT_FINISHED enquanto o burst está no barramento;
+ *    depois decodifica em `amostras`. Sem burst pendente, *lidas = 0.
+ * No modo assíncrono o fim do burst também notifica a tarefa da FIFO.
+ */
+esp_err_t mpu6050_fifo_inicia_lote(size_t max_amostras);
+esp_err_t mpu6050_fifo_conclui_lote(Mpu6050Data *amostras, size_t *lidas);
+uint32_t mpu6050_fifo_overflows(void);
+
+Mpu6050EstatisticasI2c mpu6050_i2c_estatisticas(void);
+
+/* Baixo consumo: troca a FIFO pela interrupção de movimento e volta */
+esp_err_t mpu6050_modo_movimento(const Mpu6050MovimentoConfig *cfg);
+esp_err_t mpu6050_fifo_retoma(void);
+
+/*
+ * Faixas, DLPF (1 a 6) e divisor (taxa = 1 kHz / (1 + divisor)); chamadas
+ * pela tarefa do MPU6050. Com a FIFO ativa ela é zerada na troca.
+ */
+esp_err_t mpu6050_configura_faixa(Mpu6050FaixaAccel faixa_accel, Mpu6050FaixaGyro faixa_gyro);
+esp_err_t mpu6050_configura_filtro(uint8_t dlpf_cfg, uint8_t divisor);
+
+/* Calibração do acelerômetro aplicada em toda leitura; NULL desliga */
+void mpu6050_define_calibracao(const Mpu6050Calibracao *cal);
+/* Identidade se não há calibração */
+void mpu6050_calibracao_atual(Mpu6050Calibracao *cal);
+/* NVS (namespace "imu"): carrega e já aplica; ESP_ERR_NVS_NOT_FOUND se nunca calibrou */
+esp_err_t mpu6050_calibracao_carrega(void);
+esp_err_t mpu6050_calibracao_salva(const Mpu6050Calibracao *cal);
+
+#endif
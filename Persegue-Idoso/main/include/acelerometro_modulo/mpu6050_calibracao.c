@@ -0,0 +1,165 @@
+#include "mpu6050_calibracao.h"
+#include <string.h>
+
+#define CAL_FACE_MIN_G 0.75f     // Eixo "para cima": leitura acima disto em módulo
+#define CAL_FAIXA_PARADO_G 0.2f  // |a| dentro de 1 g ± isto (cobre o offset de fábrica)
+#define CAL_VARIACAO_MAX_G 0.03f // Pico-a-pico por eixo aceito como parado
+#define CAL_GANHO_MIN 0.9f
+#define CAL_GANHO_MAX 1.1f
+#define CAL_OFFSET_MAX_G 0.25f
+
+void mpu6050_calibracao_identidade(Mpu6050Calibracao *cal)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        cal->offset_g[i] = 0.0f;
+        cal->ganho[i] = 1.0f;
+    }
+}
+
+static int16_t satura_i16(float valor)
+{
+    if (valor >= 32767.0f) return INT16_MAX;
+    if (valor <= -32768.0f) return INT16_MIN;
+    return (int16_t)(valor >= 0.0f ? valor + 0.5f : valor - 0.5f);
+}
+
+void mpu6050_calibracao_aplica(const Mpu6050Calibracao *cal, float lsb_por_g, Mpu6050Data *amostra)
+{
+    amostra->accel_x = satura_i16((amostra->accel_x - cal->offset_g[0] * lsb_por_g) * cal->ganho[0]);
+    amostra->accel_y = satura_i16((amostra->accel_y - cal->offset_g[1] * lsb_por_g) * cal->ganho[1]);
+    amostra->accel_z = satura_i16((amostra->accel_z - cal->offset_g[2] * lsb_por_g) * cal->ganho[2]);
+}
+
+/* ((b - o1) * g1 - o2) * g2 = (b - (o1 + o2 / g1)) * g1 * g2 */
+void mpu6050_calibracao_compoe(const Mpu6050Calibracao *atual, const Mpu6050Calibracao *nova,
+                               Mpu6050Calibracao *resultado)
+{
+    Mpu6050Calibracao r;
+    for (int i = 0; i < 3; i++)
+    {
+        r.offset_g[i] = atual->offset_g[i] + nova->offset_g[i] / atual->ganho[i];
+        r.ganho[i] = atual->ganho[i] * nova->ganho[i];
+    }
+    *resultado = r;
+}
+
+bool mpu6050_calibracao_valida(const Mpu6050Calibracao *cal)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        /* Também pega NaN: comparações com NaN são falsas */
+        if (!(cal->ganho[i] >= CAL_GANHO_MIN && cal->ganho[i] <= CAL_GANHO_MAX) ||
+            !(cal->offset_g[i] >= -CAL_OFFSET_MAX_G && cal->offset_g[i] <= CAL_OFFSET_MAX_G))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* --------------------------------------------------------------------------
+ *  Seis posições
+ *   Cada amostra parada é atribuída à face cujo eixo está quase vertical.
+ *   `alvo` amostras seguidas na mesma face e sem movimento capturam a média
+ *   dela; faces já capturadas são ignoradas.
+ * -------------------------------------------------------------------------- */
+static void seis_posicoes_recomeca(Mpu6050CalibracaoSeisPosicoes *s, Mpu6050Face face)
+{
+    s->face_atual = face;
+    s->amostras = 0;
+    memset(s->soma, 0, sizeof(s->soma));
+}
+
+void mpu6050_seis_posicoes_init(Mpu6050CalibracaoSeisPosicoes *s, uint32_t amostras_por_face)
+{
+    memset(s, 0, sizeof(*s));
+    s->alvo = amostras_por_face;
+    s->face_atual = MPU6050_FACE_NENHUMA;
+}
+
+static Mpu6050Face face_para_cima(const float a[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        if (a[i] > CAL_FACE_MIN_G) return (Mpu6050Face)(2 * i);
+        if (a[i] < -CAL_FACE_MIN_G) return (Mpu6050Face)(2 * i + 1);
+    }
+    return MPU6050_FACE_NENHUMA;
+}
+
+Mpu6050CalibracaoEstado mpu6050_seis_posicoes_adiciona(Mpu6050CalibracaoSeisPosicoes *s,
+                                                       const Mpu6050Data *amostra)
+{
+    float lsb = mpu6050_lsb_por_g(amostra->faixa_accel);
+    int16_t bruto[3] = {amostra->accel_x, amostra->accel_y, amostra->accel_z};
+    float a[3] = {bruto[0] / lsb, bruto[1] / lsb, bruto[2] / lsb};
+    float mag2 = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+    float min = 1.0f - CAL_FAIXA_PARADO_G, max = 1.0f + CAL_FAIXA_PARADO_G;
+
+    Mpu6050Face face = (mag2 >= min * min && mag2 <= max * max) ? face_para_cima(a) : MPU6050_FACE_NENHUMA;
+    if (face == MPU6050_FACE_NENHUMA || mpu6050_seis_posicoes_tem_face(s, face))
+    {
+        seis_posicoes_recomeca(s, MPU6050_FACE_NENHUMA);
+        return MPU6050_CAL_ACUMULANDO;
+    }
+
+    if (face != s->face_atual || amostra->faixa_accel != s->faixa_accel)
+    {
+        seis_posicoes_recomeca(s, face);
+        s->faixa_accel = amostra->faixa_accel;
+    }
+
+    int32_t variacao_max = (int32_t)(CAL_VARIACAO_MAX_G * lsb);
+    for (int i = 0; i < 3; i++)
+    {
+        if (s->amostras == 0)
+        {
+            s->min[i] = s->max[i] = bruto[i];
+            continue;
+        }
+        if (bruto[i] < s->min[i]) s->min[i] = bruto[i];
+        if (bruto[i] > s->max[i]) s->max[i] = bruto[i];
+        if ((int32_t)s->max[i] - s->min[i] > variacao_max)
+        {
+            /* Mexeu: recomeça a face a partir desta amostra */
+            seis_posicoes_recomeca(s, face);
+            for (int j = 0; j < 3; j++)
+            {
+                s->min[j] = s->max[j] = bruto[j];
+            }
+            break;
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        s->soma[i] += bruto[i];
+    }
+    s->amostras++;
+
+    if (s->amostras < s->alvo)
+    {
+        return MPU6050_CAL_ACUMULANDO;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        s->media_g[face][i] = (float)s->soma[i] / (float)s->amostras / lsb;
+    }
+    s->faces_capturadas |= (uint8_t)(1u << face);
+    seis_posicoes_recomeca(s, MPU6050_FACE_NENHUMA);
+
+    return s->faces_capturadas == (1u << MPU6050_NUM_FACES) - 1 ? MPU6050_CAL_COMPLETA : MPU6050_CAL_FACE_CAPTURADA;
+}
+
+void mpu6050_seis_posicoes_resultado(const Mpu6050CalibracaoSeisPosicoes *s, Mpu6050Calibracao *cal)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        float positivo = s->media_g[2 * i][i];
+        float negativo = s->media_g[2 * i + 1][i];
+        cal->offset_g[i] = (positivo + negativo) / 2.0f;
+        cal->ganho[i] = 2.0f / (positivo - negativo);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef MPU6050_CALIBRACAO_H
+#define MPU6050_CALIBRACAO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu6050_dados.h"
+
+/*
+ * Calibração do acelerômetro em seis posições: o aparelho fica parado com
+ * cada semieixo (+X, -X, +Y, -Y, +Z, -Z) apontando para cima, em qualquer
+ * ordem. Em cada eixo, a média das duas leituras opostas dá o offset e a
+ * diferença dá o ganho:
+ *
+ *   offset = (a+ + a-) / 2        ganho = 2 g / (a+ - a-)
+ *   corrigido = (bruto - offset) * ganho
+ *
+ * O offset é guardado em g, então a mesma calibração vale em qualquer faixa.
+ * C puro: o acúmulo roda na task do detector e também no PC.
+ */
+
+typedef struct
+{
+    float offset_g[3];
+    float ganho[3];
+} Mpu6050Calibracao;
+
+typedef enum
+{
+    MPU6050_FACE_X_POS,
+    MPU6050_FACE_X_NEG,
+    MPU6050_FACE_Y_POS,
+    MPU6050_FACE_Y_NEG,
+    MPU6050_FACE_Z_POS,
+    MPU6050_FACE_Z_NEG,
+    MPU6050_NUM_FACES,
+    MPU6050_FACE_NENHUMA = -1,
+} Mpu6050Face;
+
+typedef enum
+{
+    MPU6050_CAL_ACUMULANDO,
+    MPU6050_CAL_FACE_CAPTURADA,
+    MPU6050_CAL_COMPLETA,
+} Mpu6050CalibracaoEstado;
+
+typedef struct
+{
+    float media_g[MPU6050_NUM_FACES][3];
+    uint8_t faces_capturadas; // Bit por Mpu6050Face
+    Mpu6050Face face_atual;
+    uint8_t faixa_accel; // Faixa da face em andamento; troca recomeça
+    int64_t soma[3];
+    int16_t min[3];
+    int16_t max[3];
+    uint32_t amostras;
+    uint32_t alvo;
+} Mpu6050CalibracaoSeisPosicoes;
+
+void mpu6050_calibracao_identidade(Mpu6050Calibracao *cal);
+
+/* (bruto - offset) * ganho, saturado em int16; `lsb_por_g` da faixa da amostra */
+void mpu6050_calibracao_aplica(const Mpu6050Calibracao *cal, float lsb_por_g, Mpu6050Data *amostra);
+
+/*
+ * Calibração medida sobre amostras já corrigidas por `atual`: devolve a
+ * equivalente aplicada direto no bruto (permite recalibrar sem desligar a atual)
+ */
+void mpu6050_calibracao_compoe(const Mpu6050Calibracao *atual, const Mpu6050Calibracao *nova,
+                               Mpu6050Calibracao *resultado);
+
+/* Rejeita ganhos absurdos (posição errada, aparelho mexido) */
+bool mpu6050_calibracao_valida(const Mpu6050Calibracao *cal);
+
+void mpu6050_seis_posicoes_init(Mpu6050CalibracaoSeisPosicoes *s, uint32_t amostras_por_face);
+Mpu6050CalibracaoEstado mpu6050_seis_posicoes_adiciona(Mpu6050CalibracaoSeisPosicoes *s,
+                                                       const Mpu6050Data *amostra);
+/* Só depois de MPU6050_CAL_COMPLETA */
+void mpu6050_seis_posicoes_resultado(const Mpu6050CalibracaoSeisPosicoes *s, Mpu6050Calibracao *cal);
+
+static inline bool mpu6050_seis_posicoes_tem_face(const Mpu6050CalibracaoSeisPosicoes *s, Mpu6050Face face)
+{
+    return (s->faces_capturadas & (1u << face)) != 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef MPU6050_DADOS_H
+#define MPU6050_DADOS_H
+
+#include <stdint.h>
+
+/* AFS_SEL do ACCEL_CONFIG: fundo de escala do acelerômetro */
+typedef enum
+{
+    MPU6050_ACCEL_2G = 0,
+    MPU6050_ACCEL_4G = 1,
+    MPU6050_ACCEL_8G = 2,
+    MPU6050_ACCEL_16G = 3,
+} Mpu6050FaixaAccel;
+
+/* FS_SEL do GYRO_CONFIG: fundo de escala do giroscópio */
+typedef enum
+{
+    MPU6050_GYRO_250DPS = 0,
+    MPU6050_GYRO_500DPS = 1,
+    MPU6050_GYRO_1000DPS = 2,
+    MPU6050_GYRO_2000DPS = 3,
+} Mpu6050FaixaGyro;
+
+/*
+ * Amostra bruta do MPU6050. Só C padrão: usada também fora do firmware.
+ * As faixas vão junto de cada amostra para quem converte para g e graus/s;
+ * uma amostra zerada corresponde a ±2 g / ±250 graus/s.
+ */
+typedef struct
+{
+    int16_t accel_x;
+    int16_t accel_y;
+    int16_t accel_z;
+    int16_t gyro_x;
+    int16_t gyro_y;
+    int16_t gyro_z;
+    int16_t temp_centi_c;  // Temperatura em centésimos de °C
+    uint8_t faixa_accel;   // Mpu6050FaixaAccel em vigor na amostra
+    uint8_t faixa_gyro;    // Mpu6050FaixaGyro em vigor na amostra
+    int64_t timestamp_us;  // Instante da amostra (base esp_timer)
+} Mpu6050Data;
+
+/* LSB/g: 16384 em ±2 g, metade a cada faixa acima */
+static inline float mpu6050_lsb_por_g(uint8_t faixa_accel)
+{
+    return (float)(16384 >> (faixa_accel & 0x03));
+}
+
+/* LSB/(graus/s): 131 em ±250 graus/s, metade a cada faixa acima */
+static inline float mpu6050_lsb_por_dps(uint8_t faixa_gyro)
+{
+    return 131.0f / (float)(1 << (faixa_gyro & 0x03));
+}
+
+#endif
@@ -0,0 +1,258 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+
+#include "conexao_modulo.h"
+#include "wifi_modulo.h"
+#include "mqtt_modulo.h"
+#include "perfil_boot_modulo.h"
+
+#define TAG "Conexao"
+
+#define CONEXAO_FILA_TAMANHO 16
+#define CONEXAO_SEM_ACAO (-1)
+// Tentativas seguidas no AP salvo antes de voltar à varredura completa
+#define CONEXAO_TENTATIVAS_RAPIDAS 2
+
+typedef enum {
+    WIFI_PARADO,
+    WIFI_CONECTANDO,
+    WIFI_COM_IP
+} EstadoWifi;
+
+typedef enum {
+    MQTT_PARADO,
+    MQTT_CONECTANDO,
+    MQTT_CONECTADO
+} EstadoMqtt;
+
+static QueueHandle_t s_fila;
+static SemaphoreHandle_t s_metricas_mutex;
+
+static EstadoWifi s_wifi = WIFI_PARADO;
+static EstadoMqtt s_mqtt = MQTT_PARADO;
+static uint32_t s_falhas_wifi = 0;
+static uint32_t s_falhas_mqtt = 0;
+static int64_t s_prox_wifi_us = CONEXAO_SEM_ACAO;
+static int64_t s_prox_mqtt_us = CONEXAO_SEM_ACAO;
+static bool s_tentativa_rapida = false;
+
+static int64_t s_queda_inicio_us = 0;   // 0 = sem queda em andamento
+static bool s_primeira_conexao = true;
+static ConexaoMetricas s_metricas;
+
+/* Backoff exponencial com jitter: metade fixa, metade aleatória */
+static int64_t conexao_backoff_us(uint32_t falhas)
+{
+    if (falhas == 0) {
+        return 0;
+    }
+
+    uint32_t espera_ms = CONFIG_CONEXAO_BACKOFF_INICIAL_MS;
+    for (uint32_t i = 1; i < falhas && espera_ms < CONFIG_CONEXAO_BACKOFF_MAX_MS; i++) {
+        espera_ms *= 2;
+    }
+    if (espera_ms > CONFIG_CONEXAO_BACKOFF_MAX_MS) {
+        espera_ms = CONFIG_CONEXAO_BACKOFF_MAX_MS;
+    }
+
+    uint32_t metade = espera_ms / 2;
+    return (int64_t)(metade + esp_random() % (metade + 1)) * 1000;
+}
+
+static void conexao_marca_queda(int64_t agora)
+{
+    if (s_queda_inicio_us == 0 && !s_primeira_conexao) {
+        s_queda_inicio_us = agora;
+        xSemaphoreTake(s_metricas_mutex, portMAX_DELAY);
+        s_metricas.quedas++;
+        xSemaphoreGive(s_metricas_mutex);
+    }
+}
+
+static void conexao_fecha_queda(int64_t agora)
+{
+    xSemaphoreTake(s_metricas_mutex, portMAX_DELAY);
+    if (s_primeira_conexao) {
+        s_metricas.primeira_conexao_us = agora;
+        s_primeira_conexao = false;
+        ESP_LOGI(TAG, "Conectado em %lld ms desde o boot", (long long)(agora / 1000));
+    } else if (s_queda_inicio_us != 0) {
+        int64_t duracao = agora - s_queda_inicio_us;
+        s_metricas.reconexoes++;
+        s_metricas.ultima_reconexao_us = duracao;
+        s_metricas.soma_reconexao_us += duracao;
+        if (duracao > s_metricas.maior_reconexao_us) {
+            s_metricas.maior_reconexao_us = duracao;
+        }
+        ESP_LOGI(TAG, "Reconectado em %lld ms (Wi-Fi %lld ms), maior %lld ms",
+                 (long long)(duracao / 1000), (long long)(s_metricas.ultima_reconexao_wifi_us / 1000),
+                 (long long)(s_metricas.maior_reconexao_us / 1000));
+    }
+    s_queda_inicio_us = 0;
+    xSemaphoreGive(s_metricas_mutex);
+}
+
+static void conexao_trata_evento(ConexaoEvento evento, int64_t agora)
+{
+    switch (evento) {
+        case CONEXAO_EVT_WIFI_INICIADO:
+            s_wifi = WIFI_CONECTANDO;
+            s_prox_wifi_us = agora;
+            break;
+
+        case CONEXAO_EVT_WIFI_DESCONECTADO:
+            if (s_wifi == WIFI_COM_IP) {
+                // Queda depois de conectado: tenta de novo já, no AP salvo
+                conexao_marca_queda(agora);
+                s_falhas_wifi = 0;
+            } else {
+                s_falhas_wifi++;
+            }
+            s_wifi = WIFI_CONECTANDO;
+            s_prox_wifi_us = agora + conexao_backoff_us(s_falhas_wifi);
+            // Sem IP não adianta tentar o broker
+            s_prox_mqtt_us = CONEXAO_SEM_ACAO;
+            break;
+
+        case CONEXAO_EVT_IP_OBTIDO:
+            perfil_boot_marca(BOOT_IP_OBTIDO);
+            s_wifi = WIFI_COM_IP;
+            s_falhas_wifi = 0;
+            s_prox_wifi_us = CONEXAO_SEM_ACAO;
+            wifi_salva_ap_atual();
+
+            xSemaphoreTake(s_metricas_mutex, portMAX_DELAY);
+            if (s_tentativa_rapida) {
+                s_metricas.reconexoes_rapidas++;
+            }
+            if (s_queda_inicio_us != 0) {
+                s_metricas.ultima_reconexao_wifi_us = agora - s_queda_inicio_us;
+            }
+            xSemaphoreGive(s_metricas_mutex);
+
+            if (s_mqtt == MQTT_CONECTADO) {
+                // A sessão TCP sobreviveu à queda curta do AP
+                conexao_fecha_queda(agora);
+            } else {
+                s_falhas_mqtt = 0;
+                s_prox_mqtt_us = agora;
+            }
+            break;
+
+        case CONEXAO_EVT_IP_PERDIDO:
+            ESP_LOGW(TAG, "IP perdido");
+            break;
+
+        case CONEXAO_EVT_MQTT_CONECTADO:
+            perfil_boot_marca(BOOT_MQTT_CONECTADO);
+            s_mqtt = MQTT_CONECTADO;
+            s_falhas_mqtt = 0;
+            s_prox_mqtt_us = CONEXAO_SEM_ACAO;
+            conexao_fecha_queda(agora);
+            break;
+
+        case CONEXAO_EVT_MQTT_DESCONECTADO:
+            if (s_mqtt == MQTT_CONECTADO) {
+                conexao_marca_queda(agora);
+                s_falhas_mqtt = 0;
+            } else {
+                s_falhas_mqtt++;
+            }
+            s_mqtt = MQTT_PARADO;
+            if (s_wifi == WIFI_COM_IP) {
+                s_prox_mqtt_us = agora + conexao_backoff_us(s_falhas_mqtt);
+            }
+            break;
+    }
+}
+
+static void conexao_executa_acoes(int64_t agora)
+{
+    if (s_prox_wifi_us != CONEXAO_SEM_ACAO && agora >= s_prox_wifi_us) {
+        s_prox_wifi_us = CONEXAO_SEM_ACAO;
+        s_tentativa_rapida = wifi_tem_ap_salvo() && s_falhas_wifi < CONEXAO_TENTATIVAS_RAPIDAS;
+        ESP_LOGI(TAG, "Conectando ao Wi-Fi (tentativa %lu%s)", (unsigned long)(s_falhas_wifi + 1),
+                 s_tentativa_rapida ? ", AP salvo" : "");
+        xSemaphoreTake(s_metricas_mutex, portMAX_DELAY);
+        s_metricas.tentativas_wifi++;
+        xSemaphoreGive(s_metricas_mutex);
+        wifi_conecta(s_tentativa_rapida);
+    }
+
+    if (s_prox_mqtt_us != CONEXAO_SEM_ACAO && agora >= s_prox_mqtt_us) {
+        s_prox_mqtt_us = CONEXAO_SEM_ACAO;
+        if (s_wifi != WIFI_COM_IP) {
+            return;
+        }
+        s_mqtt = MQTT_CONECTANDO;
+        xSemaphoreTake(s_metricas_mutex, portMAX_DELAY);
+        s_metricas.tentativas_mqtt++;
+        xSemaphoreGive(s_metricas_mutex);
+        if (mqtt_conecta() != ESP_OK) {
+            // Cliente ainda não pronto para reconectar: tenta de novo mais tarde
+            s_mqtt = MQTT_PARADO;
+            s_falhas_mqtt++;
+            s_prox_mqtt_us = agora + conexao_backoff_us(s_falhas_mqtt);
+        }
+    }
+}
+
+static TickType_t conexao_espera(int64_t agora)
+{
+    int64_t proxima = INT64_MAX;
+    if (s_prox_wifi_us != CONEXAO_SEM_ACAO && s_prox_wifi_us < proxima) proxima = s_prox_wifi_us;
+    if (s_prox_mqtt_us != CONEXAO_SEM_ACAO && s_prox_mqtt_us < proxima) proxima = s_prox_mqtt_us;
+
+    if (proxima == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    if (proxima <= agora) {
+        return 0;
+    }
+    // Arredonda para cima para não acordar um tick antes do prazo
+    return pdMS_TO_TICKS((proxima - agora + 999) / 1000) + 1;
+}
+
+static void conexao_task(void *params)
+{
+    ConexaoEvento evento;
+
+    while (true) {
+        if (xQueueReceive(s_fila, &evento, conexao_espera(esp_timer_get_time())) == pdTRUE) {
+            conexao_trata_evento(evento, esp_timer_get_time());
+        }
+        conexao_executa_acoes(esp_timer_get_time());
+    }
+}
+
+void conexao_inicia(void)
+{
+    s_fila = xQueueCreate(CONEXAO_FILA_TAMANHO, sizeof(ConexaoEvento));
+    s_metricas_mutex = xSemaphoreCreateMutex();
+    xTaskCreate(conexao_task, "ConnManager", 4096, NULL, 5, NULL);
+}
+
+void conexao_notifica(ConexaoEvento evento)
+{
+    if (xQueueSend(s_fila, &evento, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Fila do supervisor cheia, evento %d perdido", evento);
+    }
+}
+
+bool conexao_mqtt_ativa(void)
+{
+    return s_mqtt == MQTT_CONECTADO;
+}
+
+void conexao_metricas(ConexaoMetricas *metricas)
+{
+    xSemaphoreTake(s_metricas_mutex, portMAX_DELAY);
+    *metricas = s_metricas;
+    xSemaphoreGive(s_metricas_mutex);
+}
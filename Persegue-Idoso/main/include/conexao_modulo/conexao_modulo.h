@@ -0,0 +1,42 @@
+#ifndef CONEXAO_MODULO_H
+#define CONEXAO_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Supervisor de conectividade: uma única máquina de estados para Wi-Fi e
+ * MQTT, alimentada pelos handlers de evento. Reconecta sem limite de
+ * tentativas, com backoff exponencial e jitter; a primeira tentativa após
+ * uma queda é imediata e vai direto ao AP salvo (BSSID/canal no NVS).
+ */
+typedef enum {
+    CONEXAO_EVT_WIFI_INICIADO,
+    CONEXAO_EVT_WIFI_DESCONECTADO,
+    CONEXAO_EVT_IP_OBTIDO,
+    CONEXAO_EVT_IP_PERDIDO,
+    CONEXAO_EVT_MQTT_CONECTADO,
+    CONEXAO_EVT_MQTT_DESCONECTADO,
+} ConexaoEvento;
+
+typedef struct {
+    uint32_t quedas;              // Perdas de Wi-Fi ou MQTT depois de conectado
+    uint32_t reconexoes;
+    uint32_t reconexoes_rapidas;  // IP obtido usando o AP salvo
+    uint32_t tentativas_wifi;
+    uint32_t tentativas_mqtt;
+    int64_t primeira_conexao_us;  // Do boot ao primeiro MQTT conectado
+    int64_t ultima_reconexao_us;  // Da queda até o MQTT conectado de novo
+    int64_t ultima_reconexao_wifi_us;  // Parcela até obter IP
+    int64_t maior_reconexao_us;
+    int64_t soma_reconexao_us;    // Média = soma / reconexoes
+} ConexaoMetricas;
+
+/* Cria a fila e a task do supervisor; chamar antes de wifi_start() */
+void conexao_inicia(void);
+/* Seguro para os handlers do event loop; não bloqueia */
+void conexao_notifica(ConexaoEvento evento);
+bool conexao_mqtt_ativa(void);
+void conexao_metricas(ConexaoMetricas *metricas);
+
+#endif
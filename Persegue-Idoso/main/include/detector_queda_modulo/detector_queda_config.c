@@ -0,0 +1,24 @@
+#include "detector_queda_modulo.h"
+#include "sdkconfig.h"
+
+/* Separado do classificador para que ele compile fora do ESP-IDF */
+void detector_config_padrao(DetectorConfig *config)
+{
+    *config = (DetectorConfig){
+        .regras = {
+            [DETECTOR_CRIT_QUEDA_LIVRE] = {CONFIG_DETECTOR_QUEDA_LIVRE_MIN_MS, CONFIG_DETECTOR_PESO_QUEDA_LIVRE},
+            [DETECTOR_CRIT_IMPACTO] = {CONFIG_DETECTOR_IMPACTO_MG, CONFIG_DETECTOR_PESO_IMPACTO},
+            [DETECTOR_CRIT_ROTACAO] = {CONFIG_DETECTOR_ROTACAO_DPS, CONFIG_DETECTOR_PESO_ROTACAO},
+            [DETECTOR_CRIT_ORIENTACAO] = {CONFIG_DETECTOR_ORIENTACAO_GRAUS, CONFIG_DETECTOR_PESO_ORIENTACAO},
+            [DETECTOR_CRIT_IMOBILIDADE] = {CONFIG_DETECTOR_IMOBILIDADE_MS, CONFIG_DETECTOR_PESO_IMOBILIDADE},
+        },
+        .pontuacao_minima = CONFIG_DETECTOR_PONTUACAO_MINIMA,
+        .queda_livre_mg = CONFIG_DETECTOR_QUEDA_LIVRE_MG,
+        .gatilho_impacto_mg = CONFIG_DETECTOR_GATILHO_IMPACTO_MG,
+        .janela_impacto_ms = CONFIG_DETECTOR_JANELA_IMPACTO_MS,
+        .repouso_faixa_mg = CONFIG_DETECTOR_REPOUSO_FAIXA_MG,
+        .repouso_dps = CONFIG_DETECTOR_REPOUSO_DPS,
+        .janela_pos_impacto_ms = CONFIG_DETECTOR_JANELA_POS_IMPACTO_MS,
+        .bloqueio_pos_alerta_ms = CONFIG_DETECTOR_BLOQUEIO_POS_ALERTA_MS,
+    };
+}
@@ -0,0 +1,314 @@
+#include "detector_queda_modulo.h"
+#include <math.h>
+#include <string.h>
+
+/* Satura em vez de estourar: acima de 65535 LSB o quadrado não cabe em 32 bits */
+static uint32_t quadrado_lsb(float valor, float sensibilidade)
+{
+    if (valor <= 0.0f) return 0;
+    float lsb = valor * sensibilidade;
+    float quadrado = lsb * lsb;
+    if (quadrado >= 4294967295.0f) return UINT32_MAX;
+    return (uint32_t)quadrado;
+}
+
+/* Um limiar além do fundo de escala nunca seria lido do sensor: fica no fundo */
+static float limita_fundo(float valor, float sensibilidade, uint8_t limiar, uint8_t *saturados)
+{
+    float fundo = 32767.0f / sensibilidade;
+    if (valor > fundo)
+    {
+        *saturados |= limiar;
+        return fundo;
+    }
+    return valor;
+}
+
+static uint16_t satura_u16(float valor)
+{
+    if (valor <= 0.0f) return 0;
+    if (valor >= 65535.0f) return UINT16_MAX;
+    return (uint16_t)(valor + 0.5f);
+}
+
+/* --------------------------------------------------------------------------
+ *  Converte a configuração em g/graus/ms para o domínio inteiro do kernel.
+ *  Chamado na inicialização e ao trocar a configuração.
+ * -------------------------------------------------------------------------- */
+void detector_configura(Detector *detector, const DetectorConfig *config)
+{
+    DetectorLimiares *l = &detector->limiares;
+    float sa = detector->sensibilidade_accel;
+    float sg = detector->sensibilidade_gyro;
+
+    detector->config = *config;
+
+    l->saturados = 0;
+    l->queda_livre_mag2 = quadrado_lsb(limita_fundo(config->queda_livre_mg / 1000.0f, sa,
+                                                    DETECTOR_LIMIAR_QUEDA_LIVRE, &l->saturados), sa);
+    l->impacto_mag2 = quadrado_lsb(limita_fundo(config->gatilho_impacto_mg / 1000.0f, sa,
+                                                DETECTOR_LIMIAR_IMPACTO, &l->saturados), sa);
+    l->repouso_mag2_min = quadrado_lsb(1.0f - config->repouso_faixa_mg / 1000.0f, sa);
+    l->repouso_mag2_max = quadrado_lsb(limita_fundo(1.0f + config->repouso_faixa_mg / 1000.0f, sa,
+                                                    DETECTOR_LIMIAR_REPOUSO, &l->saturados), sa);
+    l->repouso_gyro2 = quadrado_lsb(limita_fundo(config->repouso_dps, sg,
+                                                 DETECTOR_LIMIAR_REPOUSO_GYRO, &l->saturados), sg);
+    l->janela_impacto_us = (int64_t)config->janela_impacto_ms * 1000;
+    l->janela_pos_impacto_us = (int64_t)config->janela_pos_impacto_ms * 1000;
+    l->imobilidade_us = (int64_t)config->regras[DETECTOR_CRIT_IMOBILIDADE].limiar * 1000;
+    l->bloqueio_us = (int64_t)config->bloqueio_pos_alerta_ms * 1000;
+
+    detector->estado = DETECTOR_MONITORANDO;
+}
+
+void detector_init(Detector *detector, const DetectorConfig *config,
+                   Mpu6050FaixaAccel faixa_accel, Mpu6050FaixaGyro faixa_gyro)
+{
+    memset(detector, 0, sizeof(*detector));
+    detector->faixa_accel = (uint8_t)faixa_accel;
+    detector->faixa_gyro = (uint8_t)faixa_gyro;
+    detector->sensibilidade_accel = mpu6050_lsb_por_g(faixa_accel);
+    detector->sensibilidade_gyro = mpu6050_lsb_por_dps(faixa_gyro);
+    orientacao_init(&detector->orientacao, detector->sensibilidade_accel, detector->sensibilidade_gyro,
+                    ORIENTACAO_KP_PADRAO, ORIENTACAO_KI_PADRAO);
+    detector_configura(detector, config);
+}
+
+/* Faixa do sensor trocada em tempo de execução: limiares e atitude na nova escala */
+static void detector_troca_faixa(Detector *detector, const Mpu6050Data *amostra)
+{
+    detector->faixa_accel = amostra->faixa_accel;
+    detector->faixa_gyro = amostra->faixa_gyro;
+    detector->sensibilidade_accel = mpu6050_lsb_por_g(amostra->faixa_accel);
+    detector->sensibilidade_gyro = mpu6050_lsb_por_dps(amostra->faixa_gyro);
+    orientacao_define_escala(&detector->orientacao, detector->sensibilidade_accel, detector->sensibilidade_gyro);
+    detector_configura(detector, &detector->config);
+}
+
+static bool detector_imovel(const Detector *detector, uint32_t mag2, uint32_t gyro2)
+{
+    const DetectorLimiares *l = &detector->limiares;
+    return mag2 >= l->repouso_mag2_min && mag2 <= l->repouso_mag2_max && gyro2 <= l->repouso_gyro2;
+}
+
+static void detector_abre_evento(Detector *detector, int64_t agora)
+{
+    detector->estado = DETECTOR_PRE_IMPACTO;
+    detector->inicio_us = agora;
+    detector->impacto_us = 0;
+    detector->queda_livre_us = 0;
+    detector->pico_mag2 = 0;
+    detector->pico_gyro2 = 0;
+    detector->imovel_desde_us = -1;
+    orientacao_gravidade(&detector->orientacao, detector->gravidade_antes);
+}
+
+/* Ângulo entre a vertical na abertura do evento e a estimativa atual */
+static float detector_mudanca_orientacao(const Detector *detector)
+{
+    float depois[3];
+    orientacao_gravidade(&detector->orientacao, depois);
+    return orientacao_angulo_graus(detector->gravidade_antes, depois);
+}
+
+/* Etapa de decisão: características em unidades físicas e soma dos pesos */
+static DetectorResultado detector_decide(Detector *detector, int64_t agora)
+{
+    DetectorCaracteristicas *c = &detector->ultimo_evento;
+    int64_t imovel_us = detector->imovel_desde_us >= 0 ? agora - detector->imovel_desde_us : 0;
+
+    c->valores[DETECTOR_CRIT_QUEDA_LIVRE] = satura_u16(detector->queda_livre_us / 1000.0f);
+    c->valores[DETECTOR_CRIT_IMPACTO] =
+        satura_u16(sqrtf((float)detector->pico_mag2) * 1000.0f / detector->sensibilidade_accel);
+    c->valores[DETECTOR_CRIT_ROTACAO] =
+        satura_u16(sqrtf((float)detector->pico_gyro2) / detector->sensibilidade_gyro);
+    c->valores[DETECTOR_CRIT_ORIENTACAO] = satura_u16(detector_mudanca_orientacao(detector));
+    c->valores[DETECTOR_CRIT_IMOBILIDADE] = satura_u16(imovel_us / 1000.0f);
+
+    c->pontuacao = 0;
+    for (int i = 0; i < DETECTOR_NUM_CRITERIOS; i++)
+    {
+        if (c->valores[i] >= detector->config.regras[i].limiar)
+        {
+            c->pontuacao += detector->config.regras[i].peso;
+        }
+    }
+    c->inicio_us = detector->inicio_us;
+    c->impacto_us = detector->impacto_us;
+    c->decisao_us = agora;
+
+    detector->estado = DETECTOR_MONITORANDO;
+
+    if (c->pontuacao < detector->config.pontuacao_minima)
+    {
+        return DETECTOR_EVENTO_DESCARTADO;
+    }
+
+    detector->bloqueado_ate_us = agora + detector->limiares.bloqueio_us;
+    return DETECTOR_QUEDA_CONFIRMADA;
+}
+
+/* --------------------------------------------------------------------------
+ *  Processa uma amostra. Fora de evento o custo é |a|^2, |ω|^2, quatro
+ *  comparações e a atualização da atitude; em evento, alguns máximos e somas.
+ * -------------------------------------------------------------------------- */
+DetectorResultado detector_processa(Detector *detector, const Mpu6050Data *amostra)
+{
+    const DetectorLimiares *l = &detector->limiares;
+    uint32_t mag2 = detector_magnitude2(amostra);
+    uint32_t gyro2 = detector_rotacao2(amostra);
+    int64_t agora = amostra->timestamp_us;
+
+    if (amostra->faixa_accel != detector->faixa_accel || amostra->faixa_gyro != detector->faixa_gyro)
+    {
+        detector_troca_faixa(detector, amostra);
+    }
+
+    /* A atitude acompanha o sensor mesmo durante o bloqueio pós-alerta */
+    orientacao_atualiza(&detector->orientacao, amostra);
+
+    /* Após um alerta as amostras são ignoradas */
+    if (detector_bloqueado(detector, agora))
+    {
+        return DETECTOR_NADA;
+    }
+
+    int64_t dt = detector->ultima_us != 0 ? agora - detector->ultima_us : 0;
+    detector->ultima_us = agora;
+    detector->ultima_amostra = *amostra;
+
+    switch (detector->estado)
+    {
+    case DETECTOR_MONITORANDO:
+        if (mag2 >= l->queda_livre_mag2 && mag2 <= l->impacto_mag2)
+        {
+            return DETECTOR_NADA;
+        }
+
+        detector_abre_evento(detector, agora);
+        dt = 0;
+        /* A amostra que abriu o evento também é acumulada */
+        /* fall through */
+
+    case DETECTOR_PRE_IMPACTO:
+        if (mag2 > detector->pico_mag2) detector->pico_mag2 = mag2;
+        if (gyro2 > detector->pico_gyro2) detector->pico_gyro2 = gyro2;
+
+        if (mag2 < l->queda_livre_mag2)
+        {
+            detector->queda_livre_us += dt;
+        }
+        else if (mag2 > l->impacto_mag2)
+        {
+            detector->impacto_us = agora;
+            detector->estado = DETECTOR_POS_IMPACTO;
+        }
+        else if ((agora - detector->inicio_us) > l->janela_impacto_us)
+        {
+            /* Queda livre sem impacto: tropeço recuperado, aparelho largado no colo... */
+            return detector_decide(detector, agora);
+        }
+
+        return detector->inicio_us == agora ? DETECTOR_EVENTO_INICIADO : DETECTOR_NADA;
+
+    case DETECTOR_POS_IMPACTO:
+        if (mag2 > detector->pico_mag2) detector->pico_mag2 = mag2;
+        if (gyro2 > detector->pico_gyro2) detector->pico_gyro2 = gyro2;
+
+        if (detector_imovel(detector, mag2, gyro2))
+        {
+            if (detector->imovel_desde_us < 0)
+            {
+                detector->imovel_desde_us = agora;
+            }
+
+            /* Imóvel pelo tempo da regra: decide sem esperar o fim da janela */
+            if ((agora - detector->imovel_desde_us) >= l->imobilidade_us)
+            {
+                return detector_decide(detector, agora);
+            }
+        }
+        else
+        {
+            detector->imovel_desde_us = -1;
+        }
+
+        if ((agora - detector->impacto_us) > l->janela_pos_impacto_us)
+        {
+            return detector_decide(detector, agora);
+        }
+        return DETECTOR_NADA;
+    }
+
+    return DETECTOR_NADA;
+}
+
+DetectorResultado detector_verifica_prazo(Detector *detector, int64_t agora_us)
+{
+    const DetectorLimiares *l = &detector->limiares;
+    int64_t prazo;
+
+    switch (detector->estado)
+    {
+    case DETECTOR_PRE_IMPACTO:
+        prazo = detector->inicio_us + l->janela_impacto_us;
+        break;
+    case DETECTOR_POS_IMPACTO:
+        prazo = detector->impacto_us + l->janela_pos_impacto_us;
+        break;
+    default:
+        return DETECTOR_NADA;
+    }
+
+    if (agora_us <= prazo)
+    {
+        return DETECTOR_NADA;
+    }
+
+    /* Decide com o que foi acumulado até a última amostra */
+    return detector_decide(detector, agora_us);
+}
+
+size_t detector_executa(Detector *detector, const DetectorEntrada *entrada,
+                        const DetectorObservador *observador, Mpu6050Data *buffer, size_t max)
+{
+    size_t total = 0;
+    size_t lidas;
+    DetectorResultado resultado;
+
+    while ((lidas = entrada->le_lote(entrada->ctx, buffer, max)) > 0)
+    {
+        for (size_t i = 0; i < lidas; i++)
+        {
+            if (observador != NULL && observador->amostra != NULL)
+            {
+                observador->amostra(observador->ctx, &buffer[i], detector_magnitude2(&buffer[i]));
+            }
+
+            resultado = detector_processa(detector, &buffer[i]);
+            if (resultado != DETECTOR_NADA && observador != NULL && observador->resultado != NULL)
+            {
+                observador->resultado(observador->ctx, detector, resultado);
+            }
+        }
+        total += lidas;
+        if (entrada->agora_us != NULL)
+        {
+            detector->ultima_chegada_us = entrada->agora_us(entrada->ctx);
+        }
+    }
+
+    /* Relógio da entrada e do sensor derivam: só o tempo decorrido desde a
+     * última amostra vem do relógio, a base é o timestamp dela */
+    if (entrada->agora_us != NULL && detector->ultima_us != 0)
+    {
+        int64_t decorrido = entrada->agora_us(entrada->ctx) - detector->ultima_chegada_us;
+        resultado = detector_verifica_prazo(detector, detector->ultima_us + decorrido);
+        if (resultado != DETECTOR_NADA && observador != NULL && observador->resultado != NULL)
+        {
+            observador->resultado(observador->ctx, detector, resultado);
+        }
+    }
+
+    return total;
+}
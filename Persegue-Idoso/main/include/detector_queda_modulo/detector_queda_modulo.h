@@ -0,0 +1,228 @@
+#ifndef DETECTOR_QUEDA_MODULO_H
+#define DETECTOR_QUEDA_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "mpu6050_dados.h"
+#include "orientacao_modulo.h"
+
+/*
+ * Classificador de quedas em etapas, uma amostra por vez:
+ *
+ *   MONITORANDO --(|a| < queda livre ou |a| > impacto)--> PRE_IMPACTO
+ *   PRE_IMPACTO --(|a| > impacto)--> POS_IMPACTO
+ *               --(sem impacto na janela)--> descartado
+ *   POS_IMPACTO --(imóvel pelo tempo da regra ou fim da janela)--> decisão
+ *
+ * Durante o evento o kernel só acumula picos e tempos em inteiros, comparando
+ * quadrados (|a|^2, |ω|^2) com limiares ao quadrado. As características em
+ * unidades físicas e a pontuação são calculadas uma vez, na decisão.
+ *
+ * O módulo é C puro (sem FreeRTOS/ESP-IDF): o tempo vem do timestamp das
+ * amostras e de um relógio injetado, e as amostras de uma fonte injetada.
+ * Assim o mesmo código roda no firmware e em replays de gravações no PC.
+ * Os padrões do menuconfig ficam à parte, em detector_queda_config.c.
+ *
+ * A mudança de orientação vem do filtro de atitude (orientacao_modulo), que
+ * roda em toda amostra: a vertical de antes é a estimativa na abertura do
+ * evento e a de depois, a estimativa na decisão. O giroscópio acompanha a
+ * rotação durante a queda, quando o acelerômetro não mede a gravidade.
+ */
+
+/* Características do evento; cada uma tem uma regra na tabela de decisão */
+typedef enum
+{
+    DETECTOR_CRIT_QUEDA_LIVRE, // Duração da queda livre antes do impacto (ms)
+    DETECTOR_CRIT_IMPACTO,     // Pico de |a| (mg)
+    DETECTOR_CRIT_ROTACAO,     // Pico de |ω| (graus/s)
+    DETECTOR_CRIT_ORIENTACAO,  // Ângulo entre a vertical antes e depois (graus)
+    DETECTOR_CRIT_IMOBILIDADE, // Imobilidade contínua após o impacto (ms)
+    DETECTOR_NUM_CRITERIOS
+} DetectorCriterio;
+
+/* Regra: a característica soma `peso` pontos se for >= `limiar` */
+typedef struct
+{
+    uint16_t limiar;
+    uint8_t peso;
+} DetectorRegra;
+
+typedef struct
+{
+    DetectorRegra regras[DETECTOR_NUM_CRITERIOS];
+    uint8_t pontuacao_minima;       // Pontos para confirmar a queda
+
+    /* Segmentação do evento */
+    uint16_t queda_livre_mg;        // |a| abaixo disto é queda livre (e abre o evento)
+    uint16_t gatilho_impacto_mg;    // |a| acima disto é impacto (e abre o evento)
+    uint16_t janela_impacto_ms;     // Prazo entre a abertura e o impacto
+    uint16_t repouso_faixa_mg;      // Imóvel: |a| dentro de 1 g ± faixa...
+    uint16_t repouso_dps;           // ...e |ω| abaixo disto
+    uint16_t janela_pos_impacto_ms; // Prazo máximo para decidir após o impacto
+    uint16_t bloqueio_pos_alerta_ms; // Sem novos eventos após uma queda confirmada
+} DetectorConfig;
+
+typedef enum
+{
+    DETECTOR_NADA,
+    DETECTOR_EVENTO_INICIADO,
+    DETECTOR_QUEDA_CONFIRMADA,
+    DETECTOR_EVENTO_DESCARTADO,
+} DetectorResultado;
+
+typedef struct
+{
+    uint16_t valores[DETECTOR_NUM_CRITERIOS]; // Na unidade de cada critério
+    uint8_t pontuacao;
+    int64_t inicio_us;
+    int64_t impacto_us; // 0 se não houve impacto
+    int64_t decisao_us;
+} DetectorCaracteristicas;
+
+/* Limiares limitados ao fundo de escala da faixa em uso (bits de DetectorLimiares.saturados) */
+enum
+{
+    DETECTOR_LIMIAR_QUEDA_LIVRE = 1 << 0,
+    DETECTOR_LIMIAR_IMPACTO = 1 << 1,
+    DETECTOR_LIMIAR_REPOUSO = 1 << 2,
+    DETECTOR_LIMIAR_REPOUSO_GYRO = 1 << 3,
+};
+
+/* Limiares da configuração já convertidos para LSB^2 / us */
+typedef struct
+{
+    uint32_t queda_livre_mag2;
+    uint32_t impacto_mag2;
+    uint32_t repouso_mag2_min;
+    uint32_t repouso_mag2_max;
+    uint32_t repouso_gyro2;
+    int64_t janela_impacto_us;
+    int64_t janela_pos_impacto_us;
+    int64_t imobilidade_us;
+    int64_t bloqueio_us;
+    uint8_t saturados; // DETECTOR_LIMIAR_*: configurados acima do fundo de escala
+} DetectorLimiares;
+
+typedef enum
+{
+    DETECTOR_MONITORANDO,
+    DETECTOR_PRE_IMPACTO,
+    DETECTOR_POS_IMPACTO,
+} DetectorEstado;
+
+typedef struct
+{
+    DetectorConfig config;
+    DetectorLimiares limiares;
+    uint8_t faixa_accel;       // Mpu6050FaixaAccel das amostras esperadas
+    uint8_t faixa_gyro;        // Mpu6050FaixaGyro
+    float sensibilidade_accel; // LSB/g
+    float sensibilidade_gyro;  // LSB/(graus/s)
+
+    DetectorEstado estado;
+    int64_t ultima_us;
+    int64_t ultima_chegada_us; // Relógio da entrada quando ultima_us foi lida
+    Mpu6050Data ultima_amostra;
+    int64_t bloqueado_ate_us;
+
+    /* Atitude estimada e a vertical (no corpo) na abertura do evento */
+    Orientacao orientacao;
+    float gravidade_antes[3];
+
+    /* Acumuladores do evento em andamento */
+    int64_t inicio_us;
+    int64_t impacto_us;
+    int64_t queda_livre_us;
+    uint32_t pico_mag2;
+    uint32_t pico_gyro2;
+    int64_t imovel_desde_us; // -1 enquanto não está imóvel
+
+    DetectorCaracteristicas ultimo_evento;
+} Detector;
+
+/*
+ * Entrada injetável:
+ *   - le_lote: copia até `max` amostras em ordem de tempo; 0 = nada pendente
+ *   - agora_us: relógio monotônico usado para fechar um evento cujo prazo
+ *     venceu sem chegar amostra (sensor parado). Não precisa estar na base
+ *     dos timestamps: o prazo é conferido contra o timestamp da última
+ *     amostra mais o tempo que passou, neste relógio, desde que ela chegou
+ */
+typedef struct
+{
+    size_t (*le_lote)(void *ctx, Mpu6050Data *amostras, size_t max);
+    int64_t (*agora_us)(void *ctx);
+    void *ctx;
+} DetectorEntrada;
+
+/* Opcionais: cada amostra lida e cada resultado diferente de DETECTOR_NADA */
+typedef struct
+{
+    void (*amostra)(void *ctx, const Mpu6050Data *amostra, uint32_t mag2);
+    void (*resultado)(void *ctx, const Detector *detector, DetectorResultado resultado);
+    void *ctx;
+} DetectorObservador;
+
+/* Valores padrão do menuconfig (Configuração Detector de Quedas); só no firmware */
+void detector_config_padrao(DetectorConfig *config);
+
+/*
+ * As faixas só dão o ponto de partida: uma amostra com faixa diferente
+ * reconverte os limiares (e abandona um evento em andamento)
+ */
+void detector_init(Detector *detector, const DetectorConfig *config,
+                   Mpu6050FaixaAccel faixa_accel, Mpu6050FaixaGyro faixa_gyro);
+/* Troca a tabela em tempo de execução; um evento em andamento é abandonado */
+void detector_configura(Detector *detector, const DetectorConfig *config);
+
+DetectorResultado detector_processa(Detector *detector, const Mpu6050Data *amostra);
+/* Fecha um evento cujo prazo venceu sem amostras novas; agora_us na base dos timestamps */
+DetectorResultado detector_verifica_prazo(Detector *detector, int64_t agora_us);
+
+/*
+ * Drena a fonte em lotes de até `max` (em `buffer`), processa cada amostra e
+ * avisa o observador; depois confere o prazo pelo relógio. Retorna o número
+ * de amostras processadas.
+ */
+size_t detector_executa(Detector *detector, const DetectorEntrada *entrada,
+                        const DetectorObservador *observador, Mpu6050Data *buffer, size_t max);
+
+static inline bool detector_em_evento(const Detector *detector)
+{
+    return detector->estado != DETECTOR_MONITORANDO;
+}
+
+/* Dentro da janela sem novos alertas, a contar do timestamp da confirmação */
+static inline bool detector_bloqueado(const Detector *detector, int64_t agora_us)
+{
+    return agora_us < detector->bloqueado_ate_us;
+}
+
+/* Atitude atualizada pelo detector; o bias do giroscópio é definido por fora */
+static inline Orientacao *detector_orientacao(Detector *detector)
+{
+    return &detector->orientacao;
+}
+
+/* Características do último evento decidido (confirmado ou descartado) */
+static inline const DetectorCaracteristicas *detector_ultimo_evento(const Detector *detector)
+{
+    return &detector->ultimo_evento;
+}
+
+/* |a|^2 em LSB^2 (cabe em 32 bits: 3 * 32768^2 < 2^32) */
+static inline uint32_t detector_magnitude2(const Mpu6050Data *d)
+{
+    int32_t x = d->accel_x, y = d->accel_y, z = d->accel_z;
+    return (uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z);
+}
+
+/* |ω|^2 em LSB^2 */
+static inline uint32_t detector_rotacao2(const Mpu6050Data *d)
+{
+    int32_t x = d->gyro_x, y = d->gyro_y, z = d->gyro_z;
+    return (uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z);
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "energia_modulo.h"
+
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+
+#define TAG "ENERGIA"
+
+#define ENERGIA_LACUNA_MAX_US 500000
+
+/* --------------------------------------------------------------------------
+ *  Estado e contabilidade
+ *   - s_lock_ativo: impede o light sleep enquanto o IMU está em taxa cheia
+ *   - s_desde_us: início do trecho atual; o tempo é somado na troca
+ * -------------------------------------------------------------------------- */
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static EnergiaEstatisticas s_est;
+static int64_t s_desde_us = 0;
+static atomic_bool s_repouso_solicitado = false;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t s_lock_ativo = NULL;
+#endif
+
+esp_err_t energia_init(void)
+{
+    s_est.estado = ENERGIA_ATIVO;
+    s_est.entradas[ENERGIA_ATIVO] = 1;
+    s_desde_us = esp_timer_get_time();
+
+#if CONFIG_PM_ENABLE
+    /* O lock nasce adquirido: nada de light sleep até o primeiro REPOUSO */
+    esp_err_t err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "energia_ativo", &s_lock_ativo);
+    if (err == ESP_OK) {
+        err = esp_pm_lock_acquire(s_lock_ativo);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao criar lock de PM (err=0x%x)", err);
+        return err;
+    }
+
+    /* DFS entre o XTAL e o clock padrão; o Wi-Fi e o I2C seguram o APB quando precisam */
+    esp_pm_config_t pm_cfg = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_XTAL_FREQ,
+        .light_sleep_enable = true,
+    };
+    err = esp_pm_configure(&pm_cfg);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao configurar DFS/light sleep (err=0x%x)", err);
+        return err;
+    }
+
+    /* Pinos com gpio_wakeup_enable() acordam o chip do light sleep */
+    err = esp_sleep_enable_gpio_wakeup();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao habilitar wakeup por GPIO (err=0x%x)", err);
+        return err;
+    }
+
+    ESP_LOGI(TAG, "DFS %d-%d MHz, light sleep automático habilitado",
+             CONFIG_XTAL_FREQ, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#else
+    ESP_LOGW(TAG, "CONFIG_PM_ENABLE desligado: sem DFS nem light sleep");
+#endif
+
+    return ESP_OK;
+}
+
+void energia_define_estado(EnergiaEstado estado)
+{
+    int64_t agora = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_mux);
+    EnergiaEstado anterior = s_est.estado;
+    if (estado != anterior) {
+        s_est.tempo_us[anterior] += agora - s_desde_us;
+        s_est.entradas[estado]++;
+        s_est.estado = estado;
+        s_desde_us = agora;
+    }
+    portEXIT_CRITICAL(&s_mux);
+
+    /* Também descarta um pedido que não pôde ser atendido */
+    if (estado == ENERGIA_ATIVO) {
+        atomic_store(&s_repouso_solicitado, false);
+    }
+
+    if (estado == anterior) {
+        return;
+    }
+
+#if CONFIG_PM_ENABLE
+    if (estado == ENERGIA_REPOUSO) {
+        esp_pm_lock_release(s_lock_ativo);
+    } else {
+        esp_pm_lock_acquire(s_lock_ativo);
+    }
+#endif
+
+    ESP_LOGI(TAG, "Estado de energia: %s", estado == ENERGIA_REPOUSO ? "REPOUSO" : "ATIVO");
+}
+
+EnergiaEstado energia_estado(void)
+{
+    portENTER_CRITICAL(&s_mux);
+    EnergiaEstado estado = s_est.estado;
+    portEXIT_CRITICAL(&s_mux);
+    return estado;
+}
+
+void energia_estatisticas(EnergiaEstatisticas *estatisticas)
+{
+    int64_t agora = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_mux);
+    *estatisticas = s_est;
+    estatisticas->tempo_us[s_est.estado] += agora - s_desde_us;
+    portEXIT_CRITICAL(&s_mux);
+}
+
+void energia_solicita_repouso(void)
+{
+    atomic_store(&s_repouso_solicitado, true);
+}
+
+bool energia_repouso_solicitado(void)
+{
+    return atomic_load(&s_repouso_solicitado);
+}
+
+/* --------------------------------------------------------------------------
+ *  Detecção de "parado"
+ *   Faixa [(1 - limiar)^2, (1 + limiar)^2] g^2 em LSB^2, calculada uma vez;
+ *   por amostra são só duas comparações com o |a|^2 que o detector já tem.
+ * -------------------------------------------------------------------------- */
+void energia_parado_init(EnergiaParado *parado, float limiar_g, float sensibilidade_lsb_g, uint32_t tempo_ms)
+{
+    float min = (1.0f - limiar_g) * sensibilidade_lsb_g;
+    float max = (1.0f + limiar_g) * sensibilidade_lsb_g;
+
+    parado->mag2_min = (uint32_t)(min * min);
+    parado->mag2_max = (uint32_t)(max * max);
+    parado->tempo_necessario_us = (int64_t)tempo_ms * 1000;
+    parado->parado_desde_us = 0;
+    parado->ultima_amostra_us = INT64_MIN / 2;
+}
+
+bool energia_parado_atualiza(EnergiaParado *parado, uint32_t mag2, int64_t timestamp_us)
+{
+    /* Uma lacuna nas amostras (volta do REPOUSO) recomeça a contagem */
+    bool lacuna = (timestamp_us - parado->ultima_amostra_us) > ENERGIA_LACUNA_MAX_US;
+    parado->ultima_amostra_us = timestamp_us;
+
+    if (mag2 < parado->mag2_min || mag2 > parado->mag2_max || lacuna) {
+        parado->parado_desde_us = timestamp_us;
+        return false;
+    }
+
+    return (timestamp_us - parado->parado_desde_us) >= parado->tempo_necessario_us;
+}
+
+void energia_parado_reinicia(EnergiaParado *parado, int64_t timestamp_us)
+{
+    parado->parado_desde_us = timestamp_us;
+}
@@ -0,0 +1,54 @@
+#ifndef ENERGIA_MODULO_H
+#define ENERGIA_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*
+ * Estados de energia do dispositivo:
+ *   ATIVO   - IMU em taxa cheia via FIFO, GPS ligado. Light sleep bloqueado
+ *             (o DATA_RDY não acorda o chip), só o DFS reduz o clock.
+ *   REPOUSO - usuário parado: IMU em ciclo com interrupção de movimento,
+ *             GPS em backup. Light sleep automático liberado; o INT do
+ *             MPU6050 é fonte de wakeup e devolve o sistema para ATIVO.
+ */
+typedef enum {
+    ENERGIA_ATIVO,
+    ENERGIA_REPOUSO,
+    ENERGIA_NUM_ESTADOS
+} EnergiaEstado;
+
+typedef struct {
+    EnergiaEstado estado;
+    int64_t tempo_us[ENERGIA_NUM_ESTADOS]; // Acumulado, inclui o trecho atual
+    uint32_t entradas[ENERGIA_NUM_ESTADOS];
+} EnergiaEstatisticas;
+
+/* Detecção de "parado": |a| dentro de uma faixa em torno de 1 g por um tempo */
+typedef struct {
+    uint32_t mag2_min;
+    uint32_t mag2_max;
+    int64_t tempo_necessario_us;
+    int64_t parado_desde_us;
+    int64_t ultima_amostra_us;
+} EnergiaParado;
+
+/* DFS + light sleep automático + wakeup por GPIO; começa em ATIVO */
+esp_err_t energia_init(void);
+
+/* Só a task que controla o IMU muda o estado */
+void energia_define_estado(EnergiaEstado estado);
+EnergiaEstado energia_estado(void);
+void energia_estatisticas(EnergiaEstatisticas *estatisticas);
+
+/* Pedido do detector para entrar em REPOUSO; consumido pela task do IMU */
+void energia_solicita_repouso(void);
+bool energia_repouso_solicitado(void);
+
+void energia_parado_init(EnergiaParado *parado, float limiar_g, float sensibilidade_lsb_g, uint32_t tempo_ms);
+/* Volta true quando a amostra completa o tempo mínimo parado */
+bool energia_parado_atualiza(EnergiaParado *parado, uint32_t mag2, int64_t timestamp_us);
+void energia_parado_reinicia(EnergiaParado *parado, int64_t timestamp_us);
+
+#endif
@@ -0,0 +1,81 @@
+#include "fila_imu_modulo.h"
+#include <stdatomic.h>
+
+#define FILA_IMU_MASCARA (FILA_IMU_CAPACIDADE - 1)
+
+_Static_assert((FILA_IMU_CAPACIDADE & FILA_IMU_MASCARA) == 0, "FILA_IMU_CAPACIDADE deve ser potencia de 2");
+
+/* --------------------------------------------------------------------------
+ *  Armazenamento estático
+ *   - s_cabeca: próxima posição de escrita (só o produtor altera)
+ *   - s_cauda: próxima posição de leitura (só o consumidor altera)
+ *   Os índices crescem livremente; a posição real é índice & máscara e a
+ *   ocupação é cabeca - cauda (aritmética modular de 32 bits).
+ * -------------------------------------------------------------------------- */
+static Mpu6050Data s_amostras[FILA_IMU_CAPACIDADE];
+static atomic_uint_least32_t s_cabeca = 0;
+static atomic_uint_least32_t s_cauda = 0;
+
+/* Contadores: cada um tem um único escritor, leitura de qualquer core */
+static atomic_uint_least32_t s_overruns = 0;
+static atomic_uint_least32_t s_ocupacao_max = 0;
+
+bool fila_imu_push(const Mpu6050Data *amostra)
+{
+    uint32_t cabeca = atomic_load_explicit(&s_cabeca, memory_order_relaxed);
+    uint32_t cauda = atomic_load_explicit(&s_cauda, memory_order_acquire);
+    uint32_t ocupacao = cabeca - cauda;
+
+    if (ocupacao >= FILA_IMU_CAPACIDADE)
+    {
+        atomic_store_explicit(&s_overruns,
+                              atomic_load_explicit(&s_overruns, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+        return false;
+    }
+
+    s_amostras[cabeca & FILA_IMU_MASCARA] = *amostra;
+
+    /* release: a amostra fica visível antes do novo índice */
+    atomic_store_explicit(&s_cabeca, cabeca + 1, memory_order_release);
+
+    if (ocupacao + 1 > atomic_load_explicit(&s_ocupacao_max, memory_order_relaxed))
+    {
+        atomic_store_explicit(&s_ocupacao_max, ocupacao + 1, memory_order_relaxed);
+    }
+
+    return true;
+}
+
+size_t fila_imu_pop_lote(Mpu6050Data *destino, size_t max_amostras)
+{
+    uint32_t cauda = atomic_load_explicit(&s_cauda, memory_order_relaxed);
+    uint32_t cabeca = atomic_load_explicit(&s_cabeca, memory_order_acquire);
+    size_t disponiveis = cabeca - cauda;
+    size_t n = disponiveis < max_amostras ? disponiveis : max_amostras;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        destino[i] = s_amostras[(cauda + i) & FILA_IMU_MASCARA];
+    }
+
+    /* release: as cópias terminam antes de liberar as posições ao produtor */
+    atomic_store_explicit(&s_cauda, cauda + (uint32_t)n, memory_order_release);
+
+    return n;
+}
+
+size_t fila_imu_ocupacao(void)
+{
+    uint32_t cabeca = atomic_load_explicit(&s_cabeca, memory_order_acquire);
+    uint32_t cauda = atomic_load_explicit(&s_cauda, memory_order_acquire);
+    return cabeca - cauda;
+}
+
+void fila_imu_estatisticas(FilaImuEstatisticas *estatisticas)
+{
+    estatisticas->escritas = atomic_load_explicit(&s_cabeca, memory_order_relaxed);
+    estatisticas->leituras = atomic_load_explicit(&s_cauda, memory_order_relaxed);
+    estatisticas->overruns = atomic_load_explicit(&s_overruns, memory_order_relaxed);
+    estatisticas->ocupacao_max = atomic_load_explicit(&s_ocupacao_max, memory_order_relaxed);
+}
@@ -0,0 +1,30 @@
+#ifndef FILA_IMU_MODULO_H
+#define FILA_IMU_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "mpu6050_dados.h"
+
+/* Capacidade em amostras (potência de 2): ~1 s de folga a 1 kHz */
+#define FILA_IMU_CAPACIDADE 1024
+
+typedef struct
+{
+    uint32_t escritas;      // Amostras aceitas pelo produtor
+    uint32_t leituras;      // Amostras entregues ao consumidor
+    uint32_t overruns;      // Amostras descartadas com a fila cheia
+    uint32_t ocupacao_max;  // Maior ocupação observada pelo produtor
+} FilaImuEstatisticas;
+
+/*
+ * Fila circular lock-free de um produtor e um consumidor (SPSC).
+ * Só a task de aquisição chama fila_imu_push e só a task de detecção
+ * chama fila_imu_pop_lote; nenhuma das duas bloqueia a outra.
+ */
+bool fila_imu_push(const Mpu6050Data *amostra);
+size_t fila_imu_pop_lote(Mpu6050Data *destino, size_t max_amostras);
+size_t fila_imu_ocupacao(void);
+void fila_imu_estatisticas(FilaImuEstatisticas *estatisticas);
+
+#endif
@@ -0,0 +1,421 @@
+#include "geofence_modulo.h"
+#include <string.h>
+#include <math.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "cJSON.h"
+
+#define TAG "GEOFENCE"
+
+#define NVS_NAMESPACE "geofence"
+#define NVS_CHAVE_AREA "area"
+
+#define METROS_POR_GRAU 111320.0
+
+/* Histerese: o estado só muda após CONFIG_GEOFENCE_CONFIRMACAO_MS na nova
+ * condição, e a saída só conta além da margem somada ao erro do fix */
+#define GEOFENCE_CONFIRMACAO_US ((int64_t) CONFIG_GEOFENCE_CONFIRMACAO_MS * 1000)
+#define GEOFENCE_HDOP_MAX (CONFIG_GEOFENCE_HDOP_MAX_DECIMOS / 10.0f)
+
+/* --------------------------------------------------------------------------
+ *  Polígono pré-compilado
+ *   - Coordenadas relativas ao primeiro vértice (origem em double), assim os
+ *     floats guardam só deslocamentos pequenos sem perder precisão
+ *   - Bounding box descarta a maioria dos pontos longe da borda
+ *   - Tabela de arestas já sem as horizontais e com o inverso da inclinação,
+ *     o ray casting vira uma comparação e uma multiplicação por aresta
+ * -------------------------------------------------------------------------- */
+typedef struct {
+    float lat1;
+    float lat2;
+    float lon1;
+    float inv_inclinacao; // (lon2 - lon1) / (lat2 - lat1)
+} GeofenceAresta;
+
+typedef struct {
+    int32_t id;
+    size_t n_arestas;
+    double origem_lat;
+    double origem_lon;
+    float min_lat, max_lat, min_lon, max_lon;
+    GeofenceAresta arestas[GEOFENCE_MAX_VERTICES];
+    /* Vértices em metros (x leste, y norte) para a distância até a borda;
+     * inclui as arestas horizontais que a tabela acima descarta */
+    size_t n_vertices;
+    float metros_por_grau_lon;
+    float vertice_x[GEOFENCE_MAX_VERTICES];
+    float vertice_y[GEOFENCE_MAX_VERTICES];
+} GeofenceCompilada;
+
+/* Formato salvo na NVS: vértices originais, recompilados ao carregar */
+typedef struct {
+    int32_t id;
+    uint32_t n;
+    double latitudes[GEOFENCE_MAX_VERTICES];
+    double longitudes[GEOFENCE_MAX_VERTICES];
+} GeofenceArmazenada;
+
+static GeofenceCompilada s_area;
+static bool s_ativa = false;
+static GeofenceEstado s_estado = GEOFENCE_DESCONHECIDO;
+static int64_t s_transicao_desde_us = 0; // Primeiro fix contrário ao estado (0 = nenhuma transição pendente)
+static SemaphoreHandle_t s_mutex = NULL;
+static StaticSemaphore_t s_mutex_buffer;
+static GeofenceArmazenada s_armazenada;
+
+static void geofence_compila(const GeofenceArmazenada *origem, GeofenceCompilada *area)
+{
+    area->id = origem->id;
+    area->origem_lat = origem->latitudes[0];
+    area->origem_lon = origem->longitudes[0];
+    area->min_lat = area->max_lat = 0.0f;
+    area->min_lon = area->max_lon = 0.0f;
+    area->n_arestas = 0;
+    area->n_vertices = origem->n;
+    area->metros_por_grau_lon = (float)(METROS_POR_GRAU * cos(area->origem_lat * M_PI / 180.0));
+
+    for (uint32_t i = 0; i < origem->n; i++)
+    {
+        uint32_t j = (i + 1) % origem->n;
+        float lat1 = (float)(origem->latitudes[i] - area->origem_lat);
+        float lon1 = (float)(origem->longitudes[i] - area->origem_lon);
+        float lat2 = (float)(origem->latitudes[j] - area->origem_lat);
+        float lon2 = (float)(origem->longitudes[j] - area->origem_lon);
+
+        if (lat1 < area->min_lat) area->min_lat = lat1;
+        if (lat1 > area->max_lat) area->max_lat = lat1;
+        if (lon1 < area->min_lon) area->min_lon = lon1;
+        if (lon1 > area->max_lon) area->max_lon = lon1;
+
+        area->vertice_x[i] = lon1 * area->metros_por_grau_lon;
+        area->vertice_y[i] = lat1 * (float) METROS_POR_GRAU;
+
+        // Aresta horizontal nunca cruza o raio; fica fora da tabela
+        if (lat1 == lat2)
+        {
+            continue;
+        }
+
+        GeofenceAresta *aresta = &area->arestas[area->n_arestas++];
+        aresta->lat1 = lat1;
+        aresta->lat2 = lat2;
+        aresta->lon1 = lon1;
+        aresta->inv_inclinacao = (lon2 - lon1) / (lat2 - lat1);
+    }
+}
+
+/* Ray casting na direção +longitude; chamar com o mutex tomado */
+static bool geofence_dentro(const GeofenceCompilada *area, double latitude, double longitude)
+{
+    float lat = (float)(latitude - area->origem_lat);
+    float lon = (float)(longitude - area->origem_lon);
+
+    if (lat < area->min_lat || lat > area->max_lat || lon < area->min_lon || lon > area->max_lon)
+    {
+        return false;
+    }
+
+    bool dentro = false;
+    for (size_t i = 0; i < area->n_arestas; i++)
+    {
+        const GeofenceAresta *a = &area->arestas[i];
+        if ((a->lat1 > lat) != (a->lat2 > lat) &&
+            lon < a->lon1 + (lat - a->lat1) * a->inv_inclinacao)
+        {
+            dentro = !dentro;
+        }
+    }
+
+    return dentro;
+}
+
+/* Menor distância do ponto a uma aresta, em metros (plano local) */
+static float geofence_distancia_borda_m(const GeofenceCompilada *area, double latitude, double longitude)
+{
+    float px = (float)(longitude - area->origem_lon) * area->metros_por_grau_lon;
+    float py = (float)(latitude - area->origem_lat) * (float) METROS_POR_GRAU;
+    float menor2 = INFINITY;
+
+    for (size_t i = 0; i < area->n_vertices; i++)
+    {
+        size_t j = (i + 1) % area->n_vertices;
+        float ax = area->vertice_x[i], ay = area->vertice_y[i];
+        float dx = area->vertice_x[j] - ax, dy = area->vertice_y[j] - ay;
+        float comprimento2 = dx * dx + dy * dy;
+        float t = comprimento2 > 0.0f ? ((px - ax) * dx + (py - ay) * dy) / comprimento2 : 0.0f;
+        if (t < 0.0f) t = 0.0f;
+        if (t > 1.0f) t = 1.0f;
+        float ex = ax + t * dx - px, ey = ay + t * dy - py;
+        float d2 = ex * ex + ey * ey;
+        if (d2 < menor2) menor2 = d2;
+    }
+
+    return sqrtf(menor2);
+}
+
+static esp_err_t geofence_salva_nvs(const GeofenceArmazenada *area)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (area->n == 0)
+    {
+        err = nvs_erase_key(nvs, NVS_CHAVE_AREA);
+        if (err == ESP_ERR_NVS_NOT_FOUND)
+        {
+            err = ESP_OK;
+        }
+    }
+    else
+    {
+        err = nvs_set_blob(nvs, NVS_CHAVE_AREA, area, sizeof(*area));
+    }
+
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  API pública
+ * -------------------------------------------------------------------------- */
+esp_err_t geofence_init(void)
+{
+    if (s_mutex == NULL)
+    {
+        s_mutex = xSemaphoreCreateMutexStatic(&s_mutex_buffer);
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK)
+    {
+        // Namespace ainda não existe: nenhuma área recebida até agora
+        ESP_LOGI(TAG, "Nenhuma area segura salva");
+        return ESP_OK;
+    }
+
+    size_t tamanho = sizeof(s_armazenada);
+    err = nvs_get_blob(nvs, NVS_CHAVE_AREA, &s_armazenada, &tamanho);
+    nvs_close(nvs);
+
+    if (err != ESP_OK || tamanho != sizeof(s_armazenada) ||
+        s_armazenada.n < 3 || s_armazenada.n > GEOFENCE_MAX_VERTICES)
+    {
+        ESP_LOGI(TAG, "Nenhuma area segura valida na NVS");
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    geofence_compila(&s_armazenada, &s_area);
+    s_ativa = true;
+    s_estado = GEOFENCE_DESCONHECIDO;
+    s_transicao_desde_us = 0;
+    xSemaphoreGive(s_mutex);
+
+    ESP_LOGI(TAG, "Area segura %ld carregada da NVS (%lu vertices)",
+             (long) s_armazenada.id, (unsigned long) s_armazenada.n);
+    return ESP_OK;
+}
+
+/* Mesma área já ativa (ou já desativada): nada a recompilar nem a gravar */
+static bool geofence_area_igual(int32_t id, const double *latitudes, const double *longitudes, size_t n)
+{
+    return s_ativa == (n > 0) && s_armazenada.id == id && s_armazenada.n == n &&
+           memcmp(s_armazenada.latitudes, latitudes, n * sizeof(double)) == 0 &&
+           memcmp(s_armazenada.longitudes, longitudes, n * sizeof(double)) == 0;
+}
+
+/*
+ * Troca a área ativa (n = 0 desativa), recompila e persiste. O tópico é
+ * retido e chega de novo a cada reconexão: a mesma área é ignorada, sem
+ * perder o estado da histerese nem regravar a NVS.
+ */
+esp_err_t geofence_define_area(int32_t id, const double *latitudes, const double *longitudes, size_t n)
+{
+    if ((n != 0 && n < 3) || n > GEOFENCE_MAX_VERTICES)
+    {
+        ESP_LOGE(TAG, "Area segura com %u vertices nao suportada", (unsigned) n);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    if (geofence_area_igual(id, latitudes, longitudes, n))
+    {
+        xSemaphoreGive(s_mutex);
+        ESP_LOGD(TAG, "Area segura %ld inalterada", (long) id);
+        return ESP_OK;
+    }
+
+    memset(&s_armazenada, 0, sizeof(s_armazenada));
+    s_armazenada.id = id;
+    s_armazenada.n = n;
+    memcpy(s_armazenada.latitudes, latitudes, n * sizeof(double));
+    memcpy(s_armazenada.longitudes, longitudes, n * sizeof(double));
+
+    if (n > 0)
+    {
+        geofence_compila(&s_armazenada, &s_area);
+    }
+    s_ativa = n > 0;
+    s_estado = GEOFENCE_DESCONHECIDO;
+    s_transicao_desde_us = 0;
+
+    esp_err_t err = geofence_salva_nvs(&s_armazenada);
+
+    xSemaphoreGive(s_mutex);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Falha ao salvar area segura na NVS (err=0x%x)", err);
+    }
+    ESP_LOGI(TAG, "Area segura %ld definida com %u vertices", (long) id, (unsigned) n);
+    return err;
+}
+
+/*
+ * Payload publicado pelo backend:
+ *   {"id": 3, "pontos": [{"latitude": -22.9, "longitude": -43.1}, ...]}
+ * Lista vazia desativa a verificação local.
+ */
+esp_err_t geofence_recebe_mqtt(const char *dados, int tamanho)
+{
+    static double latitudes[GEOFENCE_MAX_VERTICES];
+    static double longitudes[GEOFENCE_MAX_VERTICES];
+
+    cJSON *raiz = cJSON_ParseWithLength(dados, tamanho);
+    if (raiz == NULL)
+    {
+        ESP_LOGE(TAG, "Payload de area segura invalido");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const cJSON *id = cJSON_GetObjectItem(raiz, "id");
+    const cJSON *pontos = cJSON_GetObjectItem(raiz, "pontos");
+    size_t n = 0;
+    esp_err_t err = ESP_OK;
+
+    if (!cJSON_IsArray(pontos))
+    {
+        err = ESP_ERR_INVALID_ARG;
+    }
+    else
+    {
+        const cJSON *ponto;
+        cJSON_ArrayForEach(ponto, pontos)
+        {
+            const cJSON *lat = cJSON_GetObjectItem(ponto, "latitude");
+            const cJSON *lon = cJSON_GetObjectItem(ponto, "longitude");
+            if (n >= GEOFENCE_MAX_VERTICES || !cJSON_IsNumber(lat) || !cJSON_IsNumber(lon))
+            {
+                err = ESP_ERR_INVALID_ARG;
+                break;
+            }
+            latitudes[n] = lat->valuedouble;
+            longitudes[n] = lon->valuedouble;
+            n++;
+        }
+    }
+
+    if (err == ESP_OK)
+    {
+        err = geofence_define_area(cJSON_IsNumber(id) ? id->valueint : 0, latitudes, longitudes, n);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Area segura rejeitada (pontos ausentes ou mais de %d)", GEOFENCE_MAX_VERTICES);
+    }
+
+    cJSON_Delete(raiz);
+    return err;
+}
+
+bool geofence_ativa(void)
+{
+    return s_ativa;
+}
+
+static GeofenceEstado geofence_classifica(double latitude, double longitude)
+{
+    if (!s_ativa)
+    {
+        return GEOFENCE_DESCONHECIDO;
+    }
+    return geofence_dentro(&s_area, latitude, longitude) ? GEOFENCE_DENTRO : GEOFENCE_FORA;
+}
+
+GeofenceEstado geofence_verifica(double latitude, double longitude)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    GeofenceEstado estado = geofence_classifica(latitude, longitude);
+    xSemaphoreGive(s_mutex);
+
+    return estado;
+}
+
+/*
+ * Atualiza o estado com um fix novo; retorna true só quando o estado muda.
+ *   DENTRO -> FORA: fixes fora por mais que margem + HDOP x erro, mantidos
+ *                   por CONFIG_GEOFENCE_CONFIRMACAO_MS; fixes fora mas dentro
+ *                   da margem não confirmam nem cancelam
+ *   FORA -> DENTRO: fixes dentro pelo mesmo tempo
+ * Qualquer fix do lado do estado atual cancela a transição pendente, e fixes
+ * com HDOP acima do limite são ignorados. Um usuário parado na borda gera no
+ * máximo um evento.
+ */
+bool geofence_atualiza(double latitude, double longitude, float hdop, int64_t timestamp_us,
+                       GeofenceEstado *estado)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+
+    bool mudou = false;
+    if (!s_ativa)
+    {
+        s_estado = GEOFENCE_DESCONHECIDO;
+    }
+    else if (hdop <= GEOFENCE_HDOP_MAX)
+    {
+        bool dentro = geofence_dentro(&s_area, latitude, longitude);
+
+        if (s_estado == (dentro ? GEOFENCE_DENTRO : GEOFENCE_FORA))
+        {
+            s_transicao_desde_us = 0;
+        }
+        else
+        {
+            // HDOP 0: receptor não informou, conta como 1
+            float incerteza_m = CONFIG_GEOFENCE_MARGEM_M + (hdop > 0.0f ? hdop : 1.0f) * CONFIG_GEOFENCE_ERRO_POR_HDOP_M;
+            bool conta = dentro || geofence_distancia_borda_m(&s_area, latitude, longitude) > incerteza_m;
+
+            if (conta)
+            {
+                if (s_transicao_desde_us == 0)
+                {
+                    s_transicao_desde_us = timestamp_us;
+                }
+                if (timestamp_us - s_transicao_desde_us >= GEOFENCE_CONFIRMACAO_US)
+                {
+                    s_estado = dentro ? GEOFENCE_DENTRO : GEOFENCE_FORA;
+                    s_transicao_desde_us = 0;
+                    mudou = true;
+                }
+            }
+        }
+    }
+
+    *estado = s_estado;
+    xSemaphoreGive(s_mutex);
+
+    return mudou;
+}
@@ -0,0 +1,29 @@
+#ifndef GEOFENCE_MODULO_H
+#define GEOFENCE_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define GEOFENCE_MAX_VERTICES 64
+
+#define GEOFENCE_TOPICO "dispositivos/area_segura" // Área ativa (retida) publicada pelo backend
+
+typedef enum {
+    GEOFENCE_DESCONHECIDO,
+    GEOFENCE_DENTRO,
+    GEOFENCE_FORA
+} GeofenceEstado;
+
+esp_err_t geofence_init(void);
+esp_err_t geofence_define_area(int32_t id, const double *latitudes, const double *longitudes, size_t n);
+esp_err_t geofence_recebe_mqtt(const char *dados, int tamanho);
+
+bool geofence_ativa(void);
+GeofenceEstado geofence_verifica(double latitude, double longitude);
+/* Com histerese (margem, HDOP e tempo de confirmação do menuconfig) */
+bool geofence_atualiza(double latitude, double longitude, float hdop, int64_t timestamp_us,
+                       GeofenceEstado *estado);
+
+#endif
@@ -1,8 +1,9 @@
 #include "gps_modulo.h"
 #include "driver/uart.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
-#include "string.h"
-#include "stdlib.h"
+#include "esp_timer.h"
 
 #define TAG_GPS "GPS"
 
@@ -11,68 +12,365 @@
 #define GPS_RX_PIN         16
 #define BUF_SIZE           1024
 
-static float convert_nmea_to_decimal(float nmea_val) {
-    int degrees = (int)(nmea_val / 100);
-    float minutes = nmea_val - (degrees * 100);
-    return degrees + (minutes / 60.0f);
-}
+#define GPS_EVENT_QUEUE_LEN   20
+#define GPS_PATTERN_QUEUE_LEN 20
+#define GPS_LINHA_MAX         (NMEA_MAX_SENTENCA + 8)
+#define GPS_SONDA_MS          1500 // Receptor emite ao menos 1 sentença por segundo
+#define GPS_BYTES_WAKE        8
+
+
+// Buffer de linha e parser estáticos: nada é alocado por leitura
+static uint8_t s_linha[GPS_LINHA_MAX];
+static NmeaParser s_parser;
+static QueueHandle_t s_uart_queue;
+static GpsMetricas s_metricas;
+static bool s_standby = false;
+
+// Um fix por época: a do último entregue e se o receptor emite GGA
+#define GPS_EPOCA_NENHUMA UINT32_MAX
+static uint32_t s_epoca_entregue = GPS_EPOCA_NENHUMA;
+static bool s_gga_visto = false;
+
+#if CONFIG_GPS_CONFIGURA_RECEPTOR
+static void gps_configura_receptor(void);
+#endif
 
 void gps_init(void) {
     uart_config_t uart_config = {
-        .baud_rate = 9600,
+        .baud_rate = CONFIG_GPS_BAUD_INICIAL,
         .data_bits = UART_DATA_8_BITS,
         .parity    = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+#if CONFIG_PM_ENABLE
+        // REF_TICK não muda com o DFS; o APB cai junto com o clock da CPU
+        .source_clk = UART_SCLK_REF_TICK,
+#else
         .source_clk = UART_SCLK_DEFAULT,
+#endif
     };
 
-    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, BUF_SIZE * 2, 0, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, BUF_SIZE * 2, 0, GPS_EVENT_QUEUE_LEN, &s_uart_queue, 0));
     ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
     ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM, GPS_TX_PIN, GPS_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+    // Um evento UART_PATTERN_DET por '\n', ou seja, um por sentença NMEA
+    ESP_ERROR_CHECK(uart_enable_pattern_det_baud_intr(UART_PORT_NUM, '\n', 1, 9, 0, 0));
+    ESP_ERROR_CHECK(uart_pattern_queue_reset(UART_PORT_NUM, GPS_PATTERN_QUEUE_LEN));
+
+    nmea_parser_init(&s_parser);
     
     ESP_LOGI(TAG_GPS, "GPS UART Iniciada");
+
+#if CONFIG_GPS_CONFIGURA_RECEPTOR
+    gps_configura_receptor();
+#endif
 }
 
-bool gps_read(GpsData *data) {
-    uint8_t *buffer = (uint8_t *) malloc(BUF_SIZE);
-    int len = uart_read_bytes(UART_PORT_NUM, buffer, BUF_SIZE - 1, 100 / portTICK_PERIOD_MS);
-    
-    if (len > 0) {
-        buffer[len] = '\0'; // Finaliza string
-        
-        char *start = strstr((char*)buffer, "$GPGGA");
-        if (start != NULL) {
-            
-
-            char lat_str[15] = {0}, lon_str[15] = {0};
-            char ns_ind = 0, ew_ind = 0;
-            int quality = 0, sats = 0;
-            float alt = 0.0;
-            float raw_lat = 0.0, raw_lon = 0.0;
-
-            int count = sscanf(start, "$GPGGA,%*f,%f,%c,%f,%c,%d,%d,%*f,%f", 
-                               &raw_lat, &ns_ind, &raw_lon, &ew_ind, &quality, &sats, &alt);
-
-            if (count >= 5 && quality > 0) { 
-                
-                data->latitude = convert_nmea_to_decimal(raw_lat);
-                if (ns_ind == 'S') data->latitude *= -1;
-
-                data->longitude = convert_nmea_to_decimal(raw_lon);
-                if (ew_ind == 'W') data->longitude *= -1;
-
-                data->altitude = alt;
-                data->satelites = sats;
-                data->valid = true;
-                
-                free(buffer);
-                return true;
+/* Esvazia UART, fila de eventos e fila de posições do padrão */
+static void gps_limpa_entrada(void) {
+    uart_flush_input(UART_PORT_NUM);
+    xQueueReset(s_uart_queue);
+    uart_pattern_queue_reset(UART_PORT_NUM, GPS_PATTERN_QUEUE_LEN);
+}
+
+/* Descarta tudo após um estouro: o parser se ressincroniza no próximo '$' */
+static void gps_descarta_entrada(void) {
+    s_metricas.overflows_uart++;
+    gps_limpa_entrada();
+}
+
+/* Lê até o '\n' detectado em `pos` e entrega ao parser */
+static uint32_t gps_processa_linha(int pos) {
+    uint32_t sentencas = NMEA_NENHUMA;
+    int restante = pos + 1;
+
+    while (restante > 0) {
+        int pedido = restante < GPS_LINHA_MAX ? restante : GPS_LINHA_MAX;
+        int len = uart_read_bytes(UART_PORT_NUM, s_linha, pedido, 0);
+        if (len <= 0) {
+            break;
+        }
+        sentencas |= nmea_parser_processa(&s_parser, s_linha, len);
+        restante -= len;
+    }
+
+    return sentencas;
+}
+
+/*
+ * Espera um evento da UART e trata. Em UART_PATTERN_DET a linha é lida e
+ * interpretada; `sentencas` recebe a máscara das sentenças válidas nela.
+ * Retorna false se nenhum evento chegar dentro de `timeout`.
+ */
+static bool gps_processa_evento(TickType_t timeout, uint32_t *sentencas, int64_t *recebido_us) {
+    uart_event_t evento;
+
+    *sentencas = NMEA_NENHUMA;
+
+    if (xQueueReceive(s_uart_queue, &evento, timeout) != pdTRUE) {
+        return false;
+    }
+
+    *recebido_us = esp_timer_get_time();
+
+    switch (evento.type) {
+        case UART_PATTERN_DET: {
+            int pos = uart_pattern_pop_pos(UART_PORT_NUM);
+            if (pos < 0) {
+                // Fila de posições estourou: não dá mais para alinhar as linhas
+                gps_descarta_entrada();
+                break;
             }
+            *sentencas = gps_processa_linha(pos);
+            break;
         }
+
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            ESP_LOGW(TAG_GPS, "Estouro na UART do GPS, descartando entrada");
+            gps_descarta_entrada();
+            break;
+
+        default:
+            // UART_DATA sem '\n' ainda: a linha é lida quando o padrão chegar
+            break;
     }
-    
-    data->valid = false;
-    free(buffer);
+
+    return true;
+}
+
+/* Horário UTC do fix em ms desde a meia-noite: identifica a época de navegação */
+static uint32_t gps_epoca(const GpsData *fix) {
+    return ((fix->hora * 60u + fix->minuto) * 60u + fix->segundo) * 1000u + fix->milissegundo;
+}
+
+/*
+ * Bloqueia na fila de eventos da UART e processa cada linha assim que o '\n'
+ * chega. Retorna true uma vez por época de navegação, quando a sentença que
+ * fecha a época termina com fix válido: a GGA (posição, altitude e satélites
+ * da época; a RMC da mesma época vem antes) ou, se o receptor não emite GGA,
+ * a RMC. Uma segunda sentença com o mesmo horário UTC não gera outro fix.
+ * Retorna false se `timeout` expirar sem fix novo (`data` não é alterado).
+ */
+bool gps_read(GpsData *data, TickType_t timeout) {
+    TickType_t inicio = xTaskGetTickCount();
+    TickType_t decorrido = 0;
+    uint32_t sentencas;
+    int64_t recebido_us = 0;
+
+    while (decorrido <= timeout) {
+        if (!gps_processa_evento(timeout - decorrido, &sentencas, &recebido_us)) {
+            break;
+        }
+
+        if (sentencas & NMEA_GGA) {
+            s_gga_visto = true;
+        }
+        uint32_t fecha_epoca = s_gga_visto ? NMEA_GGA : NMEA_RMC;
+
+        if ((sentencas & fecha_epoca) && s_parser.fix.valid && gps_epoca(&s_parser.fix) != s_epoca_entregue) {
+            s_epoca_entregue = gps_epoca(&s_parser.fix);
+            s_parser.fix.timestamp_us = recebido_us;
+            *data = s_parser.fix;
+
+            uint32_t latencia = (uint32_t)(esp_timer_get_time() - recebido_us);
+            if (latencia > s_metricas.latencia_max_us) {
+                s_metricas.latencia_max_us = latencia;
+            }
+            s_metricas.fixes++;
+            return true;
+        }
+
+        decorrido = xTaskGetTickCount() - inicio;
+    }
+
     return false;
-}
\ No newline at end of file
+}
+
+#if CONFIG_GPS_CONFIGURA_RECEPTOR
+/* --------------------------------------------------------------------------
+ *  Configuração do receptor (protocolo UBX, módulos u-blox NEO-6M/7M/M8N)
+ *   Quadro: 0xB5 0x62 | classe | id | tamanho (LE) | payload | CK_A CK_B
+ * -------------------------------------------------------------------------- */
+#define UBX_CLASSE_CFG 0x06
+#define UBX_CFG_PRT    0x00
+#define UBX_CFG_MSG    0x01
+#define UBX_CFG_RATE   0x08
+#define UBX_CLASSE_NMEA 0xF0
+#define UBX_CLASSE_RXM 0x02
+#define UBX_RXM_PMREQ  0x41
+
+static void ubx_envia(uint8_t classe, uint8_t id, const uint8_t *payload, uint16_t tamanho) {
+    uint8_t cabecalho[6] = {0xB5, 0x62, classe, id, (uint8_t)(tamanho & 0xFF), (uint8_t)(tamanho >> 8)};
+    uint8_t ck_a = 0, ck_b = 0;
+
+    // Checksum de Fletcher de 8 bits sobre classe, id, tamanho e payload
+    for (int i = 2; i < 6; i++) {
+        ck_a += cabecalho[i];
+        ck_b += ck_a;
+    }
+    for (uint16_t i = 0; i < tamanho; i++) {
+        ck_a += payload[i];
+        ck_b += ck_a;
+    }
+
+    uint8_t checksum[2] = {ck_a, ck_b};
+    uart_write_bytes(UART_PORT_NUM, cabecalho, sizeof(cabecalho));
+    uart_write_bytes(UART_PORT_NUM, payload, tamanho);
+    uart_write_bytes(UART_PORT_NUM, checksum, sizeof(checksum));
+    uart_wait_tx_done(UART_PORT_NUM, pdMS_TO_TICKS(100));
+}
+
+/* CFG-PRT na UART1 do receptor: 8N1, entrada UBX+NMEA, saída só NMEA */
+static void ubx_configura_baud(uint32_t baud) {
+    uint8_t payload[20] = {
+        0x01, 0x00,             // portID = UART1, reservado
+        0x00, 0x00,             // txReady desabilitado
+        0xD0, 0x08, 0x00, 0x00, // mode: 8 bits, sem paridade, 1 stop
+        (uint8_t)baud, (uint8_t)(baud >> 8), (uint8_t)(baud >> 16), (uint8_t)(baud >> 24),
+        0x03, 0x00,             // inProtoMask: UBX + NMEA
+        0x02, 0x00,             // outProtoMask: NMEA
+        0x00, 0x00, 0x00, 0x00, // flags, reservado
+    };
+    ubx_envia(UBX_CLASSE_CFG, UBX_CFG_PRT, payload, sizeof(payload));
+}
+
+/* CFG-MSG (forma curta): taxa da sentença na porta atual, 0 = desligada */
+static void ubx_configura_sentenca(uint8_t id_nmea, uint8_t taxa) {
+    uint8_t payload[3] = {UBX_CLASSE_NMEA, id_nmea, taxa};
+    ubx_envia(UBX_CLASSE_CFG, UBX_CFG_MSG, payload, sizeof(payload));
+}
+
+/* CFG-RATE: período de medição em ms, 1 solução por medição, tempo GPS */
+static void ubx_configura_taxa(uint16_t periodo_ms) {
+    uint8_t payload[6] = {(uint8_t)periodo_ms, (uint8_t)(periodo_ms >> 8), 0x01, 0x00, 0x01, 0x00};
+    ubx_envia(UBX_CLASSE_CFG, UBX_CFG_RATE, payload, sizeof(payload));
+}
+
+/* Troca o baud local e espera uma sentença com checksum válido */
+static bool gps_sonda_baud(uint32_t baud) {
+    uint32_t ok_antes = s_parser.estatisticas.sentencas_ok;
+    TickType_t inicio = xTaskGetTickCount();
+    TickType_t decorrido = 0;
+    uint32_t sentencas;
+    int64_t recebido_us;
+
+    uart_set_baudrate(UART_PORT_NUM, baud);
+    gps_limpa_entrada();
+
+    while (decorrido <= pdMS_TO_TICKS(GPS_SONDA_MS)) {
+        if (!gps_processa_evento(pdMS_TO_TICKS(GPS_SONDA_MS) - decorrido, &sentencas, &recebido_us)) {
+            break;
+        }
+        if (s_parser.estatisticas.sentencas_ok != ok_antes) {
+            return true;
+        }
+        decorrido = xTaskGetTickCount() - inicio;
+    }
+
+    return false;
+}
+
+/*
+ * 1) Descobre o baud atual do receptor (auto-baud: tenta uma lista)
+ * 2) Sobe para CONFIG_GPS_BAUD_ALVO e confirma recebendo NMEA válido
+ * 3) Deixa só GGA e RMC e ajusta a taxa de navegação
+ */
+static void gps_configura_receptor(void) {
+    static const uint32_t bauds[] = {
+        CONFIG_GPS_BAUD_INICIAL, CONFIG_GPS_BAUD_ALVO, 9600, 38400, 57600, 115200, 4800, 19200,
+    };
+    uint32_t baud_atual = 0;
+
+    for (size_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]) && baud_atual == 0; i++) {
+        if (gps_sonda_baud(bauds[i])) {
+            baud_atual = bauds[i];
+        }
+    }
+
+    if (baud_atual == 0) {
+        ESP_LOGW(TAG_GPS, "Receptor nao respondeu em nenhum baud, mantendo %d", CONFIG_GPS_BAUD_INICIAL);
+        uart_set_baudrate(UART_PORT_NUM, CONFIG_GPS_BAUD_INICIAL);
+        return;
+    }
+
+    if (baud_atual != CONFIG_GPS_BAUD_ALVO) {
+        ubx_configura_baud(CONFIG_GPS_BAUD_ALVO);
+        vTaskDelay(pdMS_TO_TICKS(100));
+
+        if (gps_sonda_baud(CONFIG_GPS_BAUD_ALVO)) {
+            baud_atual = CONFIG_GPS_BAUD_ALVO;
+        } else {
+            ESP_LOGW(TAG_GPS, "Receptor nao aceitou %d baud, voltando para %lu",
+                     CONFIG_GPS_BAUD_ALVO, (unsigned long) baud_atual);
+            gps_sonda_baud(baud_atual);
+        }
+    }
+
+    // IDs NMEA na classe 0xF0: GGA=0 GLL=1 GSA=2 GSV=3 RMC=4 VTG=5
+    ubx_configura_sentenca(0x00, 1);
+    ubx_configura_sentenca(0x01, 0);
+    ubx_configura_sentenca(0x02, 0);
+    ubx_configura_sentenca(0x03, 0);
+    ubx_configura_sentenca(0x04, 1);
+    ubx_configura_sentenca(0x05, 0);
+    ubx_configura_taxa(1000 / CONFIG_GPS_TAXA_ATUALIZACAO_HZ);
+
+    gps_limpa_entrada();
+
+    ESP_LOGI(TAG_GPS, "Receptor configurado: %lu baud, %d Hz, apenas GGA/RMC",
+             (unsigned long) baud_atual, CONFIG_GPS_TAXA_ATUALIZACAO_HZ);
+}
+
+/*
+ * RXM-PMREQ com duração 0: backup por tempo indeterminado. A RAM de backup
+ * mantém configuração e efemérides (hot start). Qualquer borda no RX do
+ * receptor o acorda, então a volta é só mandar alguns bytes 0xFF.
+ */
+esp_err_t gps_standby(bool entrar) {
+    if (entrar == s_standby) {
+        return ESP_OK;
+    }
+
+    if (entrar) {
+        uint8_t payload[8] = {
+            0x00, 0x00, 0x00, 0x00, // duration = 0 (até acordar)
+            0x02, 0x00, 0x00, 0x00, // flags: backup
+        };
+        ubx_envia(UBX_CLASSE_RXM, UBX_RXM_PMREQ, payload, sizeof(payload));
+    } else {
+        static const uint8_t acorda[GPS_BYTES_WAKE] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        uart_write_bytes(UART_PORT_NUM, acorda, sizeof(acorda));
+        uart_wait_tx_done(UART_PORT_NUM, pdMS_TO_TICKS(100));
+    }
+
+    // Descarta a sentença cortada; o parser se ressincroniza no próximo '$'
+    gps_limpa_entrada();
+    s_standby = entrar;
+
+    ESP_LOGI(TAG_GPS, "Receptor %s", entrar ? "em backup" : "acordado");
+    return ESP_OK;
+}
+#else
+esp_err_t gps_standby(bool entrar) {
+    // Sem UBX não há como pôr o receptor em backup
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
+
+void gps_registra_idade_fix(int64_t idade_us) {
+    static const int64_t limites_ms[GPS_HIST_FAIXAS - 1] = {100, 200, 500, 1000, 2000, 5000};
+    int64_t idade_ms = idade_us / 1000;
+    int faixa = 0;
+
+    while (faixa < GPS_HIST_FAIXAS - 1 && idade_ms >= limites_ms[faixa]) {
+        faixa++;
+    }
+
+    s_metricas.idade_histograma[faixa]++;
+}
+
+void gps_metricas(GpsMetricas *metricas) {
+    *metricas = s_metricas;
+}
@@ -4,16 +4,26 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "nmea_modulo.h"
+
+/* Faixas do histograma de idade do fix: <100, <200, <500, <1000, <2000, <5000, >=5000 ms */
+#define GPS_HIST_FAIXAS 7
 
 typedef struct {
-    float latitude;
-    float longitude;
-    float altitude;
-    int satelites;
-    bool valid; 
-} GpsData;
+    uint32_t fixes;                              // Sentenças GGA/RMC com fix válido
+    uint32_t overflows_uart;                     // Vezes que o buffer/FIFO da UART estourou
+    uint32_t latencia_max_us;                    // Fim da sentença -> fix entregue, pior caso
+    uint32_t idade_histograma[GPS_HIST_FAIXAS];  // Idade do fix quando foi usado
+} GpsMetricas;
 
 void gps_init(void);
-bool gps_read(GpsData *data);
+bool gps_read(GpsData *data, TickType_t timeout);
+
+/* Backup do receptor (UBX); ESP_ERR_NOT_SUPPORTED sem CONFIG_GPS_CONFIGURA_RECEPTOR */
+esp_err_t gps_standby(bool entrar);
+
+void gps_registra_idade_fix(int64_t idade_us);
+void gps_metricas(GpsMetricas *metricas);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,113 @@
+#include "identidade_modulo.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "nvs.h"
+
+#define TAG "IDENTIDADE"
+
+#define IDENTIDADE_CHAVE_ID "id"
+#define IDENTIDADE_CHAVE_USUARIO "usuario"
+#define IDENTIDADE_CHAVE_BROKER "broker"
+#define IDENTIDADE_TOPICO_MAX (sizeof(IDENTIDADE_PREFIXO) + IDENTIDADE_ID_MAX + 16)
+
+static const char *const s_sufixos[IDENTIDADE_NUM_TOPICOS] = {
+    [IDENTIDADE_TOPICO_GPS] = "gps",
+    [IDENTIDADE_TOPICO_QUEDA] = "queda",
+    [IDENTIDADE_TOPICO_AREA_SEGURA] = "area_segura",
+    [IDENTIDADE_TOPICO_METRICAS] = "metricas",
+};
+
+static char s_id[IDENTIDADE_ID_MAX + 1];
+static uint16_t s_usuario = CONFIG_TELEMETRIA_USUARIO_ID;
+static char s_broker[IDENTIDADE_BROKER_MAX + 1] = CONFIG_MQTT_BROKER_URI;
+static char s_topicos[IDENTIDADE_NUM_TOPICOS][IDENTIDADE_TOPICO_MAX];
+
+/* MAC de fábrica em hex minúsculo: único por chip e estável entre firmwares */
+static esp_err_t identidade_id_do_mac(void) {
+    uint8_t mac[6];
+    esp_err_t err = esp_efuse_mac_get_default(mac);
+    if (err != ESP_OK) {
+        return err;
+    }
+    snprintf(s_id, sizeof(s_id), "%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return ESP_OK;
+}
+
+/* Só caracteres que não quebram um tópico MQTT nem o path no backend */
+static bool identidade_id_valido(const char *id) {
+    if (id[0] == '\0') {
+        return false;
+    }
+    for (const char *c = id; *c; c++) {
+        bool ok = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+                  *c == '-' || *c == '_';
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t identidade_init(void) {
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(IDENTIDADE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao abrir o NVS (err=0x%x); usando o MAC sem gravar", err);
+    }
+
+    size_t tamanho = sizeof(s_id);
+    if (err != ESP_OK || nvs_get_str(nvs, IDENTIDADE_CHAVE_ID, s_id, &tamanho) != ESP_OK ||
+        !identidade_id_valido(s_id)) {
+        esp_err_t err_mac = identidade_id_do_mac();
+        if (err_mac != ESP_OK) {
+            ESP_LOGE(TAG, "Falha ao ler o MAC de fábrica (err=0x%x)", err_mac);
+            if (err == ESP_OK) {
+                nvs_close(nvs);
+            }
+            return err_mac;
+        }
+        if (err == ESP_OK && nvs_set_str(nvs, IDENTIDADE_CHAVE_ID, s_id) == ESP_OK) {
+            nvs_commit(nvs);
+            ESP_LOGI(TAG, "Id do dispositivo criado a partir do MAC: %s", s_id);
+        }
+    }
+
+    if (err == ESP_OK) {
+        uint16_t usuario;
+        if (nvs_get_u16(nvs, IDENTIDADE_CHAVE_USUARIO, &usuario) == ESP_OK) {
+            s_usuario = usuario;
+        }
+        tamanho = sizeof(s_broker);
+        if (nvs_get_str(nvs, IDENTIDADE_CHAVE_BROKER, s_broker, &tamanho) != ESP_OK) {
+            snprintf(s_broker, sizeof(s_broker), "%s", CONFIG_MQTT_BROKER_URI);
+        }
+        nvs_close(nvs);
+    }
+
+    for (int i = 0; i < IDENTIDADE_NUM_TOPICOS; i++) {
+        snprintf(s_topicos[i], sizeof(s_topicos[i]), IDENTIDADE_PREFIXO "%s/%s", s_id, s_sufixos[i]);
+    }
+
+    ESP_LOGI(TAG, "Dispositivo %s, usuário %u, broker %s", s_id, s_usuario, s_broker);
+    return ESP_OK;
+}
+
+const char *identidade_id(void) {
+    return s_id;
+}
+
+uint16_t identidade_usuario(void) {
+    return s_usuario;
+}
+
+const char *identidade_broker_uri(void) {
+    return s_broker;
+}
+
+const char *identidade_topico(IdentidadeTopico topico) {
+    return s_topicos[topico];
+}
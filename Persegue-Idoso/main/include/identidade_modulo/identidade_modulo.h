@@ -0,0 +1,39 @@
+#ifndef IDENTIDADE_MODULO_H
+#define IDENTIDADE_MODULO_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Identidade do dispositivo na frota. O id nasce do MAC de fábrica (eFuse)
+ * no primeiro boot e fica no NVS; a partir daí o NVS manda, então um id
+ * provisionado sobrevive à troca de placa. Tudo que o dispositivo publica
+ * fica em dispositivos/<id>/<tipo>, e o backend tira o id do tópico.
+ *
+ * Usuário monitorado e endereço do broker também podem ser gravados no
+ * NVS (namespace IDENTIDADE_NVS_NAMESPACE); sem eles valem os do Kconfig.
+ */
+#define IDENTIDADE_NVS_NAMESPACE "dispositivo"
+#define IDENTIDADE_PREFIXO "dispositivos/"
+#define IDENTIDADE_ID_MAX 32
+#define IDENTIDADE_BROKER_MAX 128
+
+typedef enum {
+    IDENTIDADE_TOPICO_GPS,         // Posição (JSON) e lotes de telemetria
+    IDENTIDADE_TOPICO_QUEDA,       // Alerta de queda (prioritário no outbox)
+    IDENTIDADE_TOPICO_AREA_SEGURA, // Transição de área segura
+    IDENTIDADE_TOPICO_METRICAS,    // Saúde do dispositivo
+    IDENTIDADE_NUM_TOPICOS
+} IdentidadeTopico;
+
+/* Depois do nvs_flash_init e antes de qualquer publicação */
+esp_err_t identidade_init(void);
+
+const char *identidade_id(void);
+uint16_t identidade_usuario(void);
+const char *identidade_broker_uri(void);
+
+/* String estática montada no init: pode ir direto para o publicador */
+const char *identidade_topico(IdentidadeTopico topico);
+
+#endif
@@ -0,0 +1,138 @@
+#include "metricas_esp.h"
+#include "metricas_modulo.h"
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "mqtt_modulo.h"
+#include "wifi_modulo.h"
+
+#define TAG "METRICAS"
+
+static portMUX_TYPE s_jitter_mux = portMUX_INITIALIZER_UNLOCKED;
+static MetricasJitter s_jitter_imu;
+static int64_t s_ultima_coleta_us = 0;
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+/* Leitura anterior: a CPU de cada tarefa é a diferença entre as duas */
+static TaskStatus_t s_status[METRICAS_MAX_TAREFAS];
+static MetricasTarefaBruta s_tarefas[2][METRICAS_MAX_TAREFAS];
+static size_t s_num_tarefas[2];
+static uint32_t s_total[2];
+static int s_atual = 0;
+#endif
+
+void metricas_init(int64_t periodo_lote_imu_us)
+{
+    metricas_jitter_init(&s_jitter_imu, periodo_lote_imu_us);
+    s_ultima_coleta_us = esp_timer_get_time();
+}
+
+void metricas_registra_lote_imu(int64_t agora_us)
+{
+    portENTER_CRITICAL(&s_jitter_mux);
+    metricas_jitter_registra(&s_jitter_imu, agora_us);
+    portEXIT_CRITICAL(&s_jitter_mux);
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static void metricas_coleta_tarefas(MetricasSaude *m)
+{
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(s_status, METRICAS_MAX_TAREFAS, &total);
+    if (n == 0) {
+        ESP_LOGW(TAG, "Mais de %d tarefas, CPU por tarefa omitida", METRICAS_MAX_TAREFAS);
+        m->num_tarefas = 0;
+        return;
+    }
+
+    int anterior = s_atual;
+    int atual = 1 - s_atual;
+    for (UBaseType_t i = 0; i < n; i++) {
+        MetricasTarefaBruta *t = &s_tarefas[atual][i];
+        t->id = s_status[i].xHandle;
+        strncpy(t->nome, s_status[i].pcTaskName, METRICAS_NOME_TAREFA);
+        t->nome[METRICAS_NOME_TAREFA] = '\0';
+        t->tempo_execucao = s_status[i].ulRunTimeCounter;
+        // No ESP-IDF a pilha é contada em bytes (StackType_t de 8 bits)
+        t->pilha_livre = s_status[i].usStackHighWaterMark;
+    }
+    s_num_tarefas[atual] = n;
+    s_total[atual] = total;
+
+    m->num_tarefas = metricas_cpu_calcula(s_tarefas[anterior], s_num_tarefas[anterior], s_total[anterior],
+                                          s_tarefas[atual], n, total, m->tarefas);
+    s_atual = atual;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    m->flags |= METRICAS_FLAG_CPU;
+#endif
+}
+#endif
+
+void metricas_coleta(MetricasSaude *m)
+{
+    int64_t agora = esp_timer_get_time();
+    memset(m, 0, sizeof(*m));
+
+    m->uptime_s = (uint32_t)(agora / 1000000);
+    m->janela_s = (uint16_t)((agora - s_ultima_coleta_us) / 1000000);
+    s_ultima_coleta_us = agora;
+
+    m->heap_livre = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    m->heap_min_livre = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    m->heap_maior_bloco = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    m->idade_fix_ms = METRICAS_SEM_FIX;
+
+    if (wifi_rssi(&m->rssi_dbm)) {
+        m->flags |= METRICAS_FLAG_WIFI;
+    }
+
+    MqttMetricas mqtt;
+    mqtt_metricas_janela(&mqtt);
+    m->publicacoes = mqtt.confirmadas;
+    m->latencia_media_ms = mqtt.latencia_media_us / 1000;
+    m->latencia_max_ms = mqtt.latencia_max_us / 1000;
+    m->fila_mqtt_bytes = mqtt.fila_bytes;
+    if (mqtt.conectado) {
+        m->flags |= METRICAS_FLAG_MQTT;
+    }
+
+    OutboxEstatisticas outbox;
+    mqtt_outbox_estatisticas(&outbox);
+    m->outbox_pendentes = outbox.pendentes;
+
+    portENTER_CRITICAL(&s_jitter_mux);
+    m->jitter_imu = s_jitter_imu;
+    metricas_jitter_zera(&s_jitter_imu);
+    portEXIT_CRITICAL(&s_jitter_mux);
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    metricas_coleta_tarefas(m);
+#endif
+}
+
+void metricas_loga(const MetricasSaude *m)
+{
+    uint32_t fragmentacao = m->heap_livre ? 100 - (uint32_t)((uint64_t)m->heap_maior_bloco * 100 / m->heap_livre) : 0;
+    ESP_LOGI(TAG, "Heap: %lu livres (min %lu), maior bloco %lu, fragmentacao %lu%%",
+             (unsigned long) m->heap_livre, (unsigned long) m->heap_min_livre,
+             (unsigned long) m->heap_maior_bloco, (unsigned long) fragmentacao);
+    ESP_LOGI(TAG, "MQTT: %lu confirmadas, latencia media %lu ms, max %lu ms, fila %lu bytes, outbox %lu; RSSI %d dBm",
+             (unsigned long) m->publicacoes, (unsigned long) m->latencia_media_ms,
+             (unsigned long) m->latencia_max_ms, (unsigned long) m->fila_mqtt_bytes,
+             (unsigned long) m->outbox_pendentes, (m->flags & METRICAS_FLAG_WIFI) ? m->rssi_dbm : 0);
+    const uint32_t *h = m->jitter_imu.histograma;
+    ESP_LOGI(TAG, "Jitter IMU (us) <100:%lu <250:%lu <500:%lu <1000:%lu <2000:%lu <5000:%lu >=5000:%lu, "
+             "max %lu, lacunas %lu",
+             (unsigned long) h[0], (unsigned long) h[1], (unsigned long) h[2], (unsigned long) h[3],
+             (unsigned long) h[4], (unsigned long) h[5], (unsigned long) h[6],
+             (unsigned long) m->jitter_imu.max_us, (unsigned long) m->jitter_imu.lacunas);
+    for (size_t i = 0; i < m->num_tarefas; i++) {
+        ESP_LOGI(TAG, "  %-12s CPU %3u.%u%%  pilha livre %u bytes", m->tarefas[i].nome,
+                 m->tarefas[i].cpu_permil / 10, m->tarefas[i].cpu_permil % 10, m->tarefas[i].pilha_livre);
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef METRICAS_ESP_H
+#define METRICAS_ESP_H
+
+#include <stdint.h>
+#include "metricas_modulo.h"
+
+/*
+ * Coleta das métricas no ESP-IDF: tarefas (uxTaskGetSystemState), heap,
+ * Wi-Fi, MQTT e o jitter do laço do IMU. CPU por tarefa precisa de
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (selecionado por CONFIG_METRICAS).
+ */
+
+/* `periodo_lote_imu_us`: intervalo esperado entre lotes do IMU */
+void metricas_init(int64_t periodo_lote_imu_us);
+
+/* Tarefa do IMU, a cada lote entregue; só um spinlock */
+void metricas_registra_lote_imu(int64_t agora_us);
+
+/*
+ * Preenche `m` com a janela desde a coleta anterior e começa outra.
+ * idade_fix_ms fica em METRICAS_SEM_FIX: o GPS é de quem chama.
+ */
+void metricas_coleta(MetricasSaude *m);
+
+void metricas_loga(const MetricasSaude *m);
+
+#endif
@@ -0,0 +1,159 @@
+#include "metricas_modulo.h"
+#include <string.h>
+
+static const uint32_t s_limites_jitter_us[METRICAS_HIST_FAIXAS - 1] = {100, 250, 500, 1000, 2000, 5000};
+
+/* --------------------------------------------------------------------------
+ *  Escrita little-endian byte a byte (mesmo formato de telemetria_modulo.c)
+ * -------------------------------------------------------------------------- */
+static uint8_t *escreve_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *escreve_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint16_t satura_u16(uint32_t valor)
+{
+    return valor > UINT16_MAX ? UINT16_MAX : (uint16_t)valor;
+}
+
+/* --------------------------------------------------------------------------
+ *  Jitter
+ * -------------------------------------------------------------------------- */
+void metricas_jitter_init(MetricasJitter *j, int64_t periodo_us)
+{
+    memset(j, 0, sizeof(*j));
+    j->periodo_us = periodo_us;
+}
+
+void metricas_jitter_registra(MetricasJitter *j, int64_t agora_us)
+{
+    int64_t intervalo = agora_us - j->ultimo_us;
+    bool primeira = j->ultimo_us == 0;
+    j->ultimo_us = agora_us;
+
+    if (primeira || j->periodo_us <= 0)
+    {
+        return;
+    }
+    if (intervalo <= 0 || intervalo > METRICAS_JITTER_LACUNA * j->periodo_us)
+    {
+        j->lacunas++;
+        return;
+    }
+
+    int64_t desvio = intervalo - j->periodo_us;
+    uint32_t jitter = (uint32_t)(desvio < 0 ? -desvio : desvio);
+
+    int faixa = 0;
+    while (faixa < METRICAS_HIST_FAIXAS - 1 && jitter >= s_limites_jitter_us[faixa])
+    {
+        faixa++;
+    }
+    j->histograma[faixa]++;
+    if (jitter > j->max_us)
+    {
+        j->max_us = jitter;
+    }
+}
+
+void metricas_jitter_zera(MetricasJitter *j)
+{
+    memset(j->histograma, 0, sizeof(j->histograma));
+    j->max_us = 0;
+    j->lacunas = 0;
+}
+
+/* --------------------------------------------------------------------------
+ *  CPU por tarefa. As listas têm poucas dezenas de entradas: a busca
+ *  linear pelo mesmo id é mais barata que qualquer índice.
+ * -------------------------------------------------------------------------- */
+size_t metricas_cpu_calcula(const MetricasTarefaBruta *anterior, size_t n_anterior, uint32_t total_anterior,
+                            const MetricasTarefaBruta *atual, size_t n_atual, uint32_t total_atual,
+                            MetricasTarefa *saida)
+{
+    uint32_t janela = total_atual - total_anterior;
+
+    for (size_t i = 0; i < n_atual; i++)
+    {
+        uint32_t inicio = 0;
+        for (size_t k = 0; k < n_anterior; k++)
+        {
+            if (anterior[k].id == atual[i].id)
+            {
+                inicio = anterior[k].tempo_execucao;
+                break;
+            }
+        }
+
+        uint32_t usado = atual[i].tempo_execucao - inicio;
+        uint32_t permil = janela == 0 ? 0 : (uint32_t)((uint64_t)usado * 1000 / janela);
+
+        memcpy(saida[i].nome, atual[i].nome, sizeof(saida[i].nome));
+        saida[i].nome[METRICAS_NOME_TAREFA] = '\0';
+        saida[i].cpu_permil = satura_u16(permil);
+        saida[i].pilha_livre = satura_u16(atual[i].pilha_livre);
+    }
+    return n_atual;
+}
+
+/* --------------------------------------------------------------------------
+ *  Frame de saúde (layout em metricas_modulo.h)
+ * -------------------------------------------------------------------------- */
+size_t metricas_codifica(const MetricasSaude *m, uint16_t usuario_id, uint16_t sequencia,
+                         uint8_t *buffer, size_t tamanho)
+{
+    size_t tarefas = m->num_tarefas > METRICAS_MAX_TAREFAS ? METRICAS_MAX_TAREFAS : m->num_tarefas;
+    size_t total = METRICAS_TAMANHO_CABECALHO + tarefas * METRICAS_TAMANHO_TAREFA;
+    if (tamanho < total)
+    {
+        return 0;
+    }
+
+    uint8_t *p = buffer;
+    *p++ = METRICAS_VERSAO;
+    *p++ = METRICAS_TIPO_SAUDE;
+    p = escreve_u16(p, sequencia);
+    p = escreve_u16(p, usuario_id);
+    *p++ = (uint8_t)tarefas;
+    *p++ = m->flags;
+    p = escreve_u32(p, m->uptime_s);
+    p = escreve_u32(p, m->heap_livre);
+    p = escreve_u32(p, m->heap_min_livre);
+    p = escreve_u32(p, m->heap_maior_bloco);
+    p = escreve_u32(p, m->idade_fix_ms);
+    p = escreve_u16(p, m->janela_s);
+    *p++ = (uint8_t)m->rssi_dbm;
+    *p++ = 0;
+    p = escreve_u16(p, satura_u16(m->publicacoes));
+    p = escreve_u16(p, satura_u16(m->latencia_media_ms));
+    p = escreve_u16(p, satura_u16(m->latencia_max_ms));
+    p = escreve_u16(p, satura_u16(m->fila_mqtt_bytes));
+    p = escreve_u16(p, satura_u16(m->outbox_pendentes));
+    p = escreve_u16(p, satura_u16(m->jitter_imu.max_us));
+    for (int i = 0; i < METRICAS_HIST_FAIXAS; i++)
+    {
+        p = escreve_u16(p, satura_u16(m->jitter_imu.histograma[i]));
+    }
+
+    for (size_t i = 0; i < tarefas; i++)
+    {
+        memset(p, 0, METRICAS_NOME_TAREFA);
+        memcpy(p, m->tarefas[i].nome, strnlen(m->tarefas[i].nome, METRICAS_NOME_TAREFA));
+        p += METRICAS_NOME_TAREFA;
+        p = escreve_u16(p, m->tarefas[i].cpu_permil);
+        p = escreve_u16(p, m->tarefas[i].pilha_livre);
+    }
+
+    return (size_t)(p - buffer);
+}
@@ -0,0 +1,135 @@
+#ifndef METRICAS_MODULO_H
+#define METRICAS_MODULO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Métricas de saúde do dispositivo. Esta parte é C puro (histograma de
+ * jitter, CPU por tarefa e o frame); a coleta em FreeRTOS fica em
+ * metricas_esp.c.
+ *
+ * Frame de saúde, versão 1 (little-endian), no tópico dispositivos/<id>/metricas:
+ *
+ *   cabeçalho (58 bytes)
+ *    0    1   versão (METRICAS_VERSAO)
+ *    1    1   tipo (METRICAS_TIPO_SAUDE)
+ *    2    2   sequência
+ *    4    2   id do usuário
+ *    6    1   quantidade de tarefas
+ *    7    1   flags (METRICAS_FLAG_*)
+ *    8    4   uptime em segundos
+ *   12    4   heap livre em bytes
+ *   16    4   menor heap livre desde o boot
+ *   20    4   maior bloco livre (fragmentação = 1 - bloco / livre)
+ *   24    4   idade do último fix em ms (METRICAS_SEM_FIX se nunca houve)
+ *   28    2   duração da janela em segundos
+ *   30    1   RSSI do AP em dBm (int8, válido com METRICAS_FLAG_WIFI)
+ *   31    1   reservado (0)
+ *   32    2   publicações MQTT confirmadas na janela
+ *   34    2   latência média publish -> PUBACK (ms)
+ *   36    2   latência máxima (ms)
+ *   38    2   bytes na fila do cliente MQTT aguardando envio/PUBACK
+ *   40    2   mensagens pendentes no outbox
+ *   42    2   jitter máximo do laço do IMU (us)
+ *   44   14   histograma do jitter, METRICAS_HIST_FAIXAS x u16
+ *
+ *   tarefas (16 bytes cada): nome (12 bytes, ASCII, completado com 0),
+ *   CPU na janela em por mil de um núcleo (u16), menor pilha livre em bytes (u16)
+ *
+ * Tudo em u16 satura em 65535. O tipo continua a numeração de
+ * telemetria_modulo.h, então um frame no tópico errado é rejeitado.
+ */
+#define METRICAS_VERSAO 1
+#define METRICAS_TIPO_SAUDE 0x03
+
+#define METRICAS_TAMANHO_CABECALHO 58
+#define METRICAS_TAMANHO_TAREFA 16
+#define METRICAS_NOME_TAREFA 12
+#define METRICAS_MAX_TAREFAS 24
+#define METRICAS_TAMANHO_MAX (METRICAS_TAMANHO_CABECALHO + METRICAS_MAX_TAREFAS * METRICAS_TAMANHO_TAREFA)
+
+#define METRICAS_FLAG_WIFI 0x01     // Associado; RSSI válido
+#define METRICAS_FLAG_MQTT 0x02     // Conectado ao broker
+#define METRICAS_FLAG_CPU 0x04      // Contadores de tempo de execução disponíveis
+
+#define METRICAS_SEM_FIX UINT32_MAX
+
+/* Faixas do jitter: <100, <250, <500, <1000, <2000, <5000, >=5000 us */
+#define METRICAS_HIST_FAIXAS 7
+
+/* --------------------------------------------------------------------------
+ *  Jitter de um laço periódico: |intervalo - período esperado|. Intervalos
+ *  maiores que METRICAS_JITTER_LACUNA períodos (repouso, tarefa parada)
+ *  contam como lacuna e ficam fora do histograma.
+ * -------------------------------------------------------------------------- */
+#define METRICAS_JITTER_LACUNA 10
+
+typedef struct
+{
+    int64_t periodo_us;
+    int64_t ultimo_us;
+    uint32_t histograma[METRICAS_HIST_FAIXAS];
+    uint32_t max_us;
+    uint32_t lacunas;
+} MetricasJitter;
+
+void metricas_jitter_init(MetricasJitter *j, int64_t periodo_us);
+void metricas_jitter_registra(MetricasJitter *j, int64_t agora_us);
+/* Começa uma nova janela; o instante da última passagem é mantido */
+void metricas_jitter_zera(MetricasJitter *j);
+
+/* --------------------------------------------------------------------------
+ *  CPU por tarefa: diferença dos contadores de tempo de execução entre duas
+ *  leituras. `id` identifica a tarefa entre leituras (o handle no firmware).
+ * -------------------------------------------------------------------------- */
+typedef struct
+{
+    const void *id;
+    char nome[METRICAS_NOME_TAREFA + 1];
+    uint32_t tempo_execucao; // Contador livre; a diferença tolera uma volta
+    uint32_t pilha_livre;    // Em bytes
+} MetricasTarefaBruta;
+
+typedef struct
+{
+    char nome[METRICAS_NOME_TAREFA + 1];
+    uint16_t cpu_permil;
+    uint16_t pilha_livre;
+} MetricasTarefa;
+
+/*
+ * Por mil de um núcleo: com dois núcleos a soma chega a 2000 (as tarefas
+ * IDLE incluídas). Tarefas novas contam o tempo todo desde a criação.
+ * Devolve quantas entradas foram escritas em `saida` (até `n_atual`).
+ */
+size_t metricas_cpu_calcula(const MetricasTarefaBruta *anterior, size_t n_anterior, uint32_t total_anterior,
+                            const MetricasTarefaBruta *atual, size_t n_atual, uint32_t total_atual,
+                            MetricasTarefa *saida);
+
+typedef struct
+{
+    uint8_t flags;
+    uint32_t uptime_s;
+    uint32_t heap_livre;
+    uint32_t heap_min_livre;
+    uint32_t heap_maior_bloco;
+    uint32_t idade_fix_ms;
+    uint16_t janela_s;
+    int8_t rssi_dbm;
+    uint32_t publicacoes;
+    uint32_t latencia_media_ms;
+    uint32_t latencia_max_ms;
+    uint32_t fila_mqtt_bytes;
+    uint32_t outbox_pendentes;
+    MetricasJitter jitter_imu;
+    size_t num_tarefas;
+    MetricasTarefa tarefas[METRICAS_MAX_TAREFAS];
+} MetricasSaude;
+
+/* 0 se não couber em `tamanho` */
+size_t metricas_codifica(const MetricasSaude *m, uint16_t usuario_id, uint16_t sequencia,
+                         uint8_t *buffer, size_t tamanho);
+
+#endif
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_system.h"
 #include "esp_event.h"
@@ -16,14 +17,65 @@
 #include "lwip/netdb.h"
 
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "mqtt_client.h"
 
 #include "mqtt_modulo.h"
+#include "outbox_modulo.h"
+#include "conexao_modulo.h"
+#include "perfil_boot_modulo.h"
+#include "identidade_modulo.h"
 
 #define TAG "MQTT"
 
-extern SemaphoreHandle_t conexaoMQTTSemaphore;
-esp_mqtt_client_handle_t client;
+#define MQTT_MAX_INSCRICOES 4
+#define MQTT_TOPICO_MAX 64
+#define MQTT_RX_MAX 4096
+
+#define MQTT_OUTBOX_MENSAGEM_MAX 4096
+
+// Publicações QoS 1 acompanhadas até o PUBACK (as mais antigas saem primeiro)
+#define MQTT_PUBLICACOES_EM_VOO 8
+
+esp_mqtt_client_handle_t client = NULL;
+
+/* Tópicos recebidos tratados por outros módulos */
+typedef struct
+{
+    const char *topico;
+    mqtt_callback_t callback;
+} MqttInscricao;
+
+static MqttInscricao s_inscricoes[MQTT_MAX_INSCRICOES];
+static int s_num_inscricoes = 0;
+
+/* Remontagem de mensagens maiores que o buffer do cliente (chegam em fragmentos) */
+static char s_rx_topico[MQTT_TOPICO_MAX];
+static char s_rx_buffer[MQTT_RX_MAX];
+static bool s_rx_descartar = false;
+
+/* Outbox em flash: guarda o que não pôde ser publicado enquanto desconectado */
+static Outbox s_outbox;
+static bool s_outbox_ativo = false;
+static SemaphoreHandle_t s_outbox_mutex;
+static uint8_t s_outbox_buffer[OUTBOX_TOPICO_MAX + 1 + MQTT_OUTBOX_MENSAGEM_MAX];
+static volatile bool s_conectado = false;
+
+/* Latência publish -> PUBACK. Publicações vêm de várias tarefas e o PUBACK
+   do evento do cliente, então a tabela fica sob s_metricas_mux. */
+typedef struct
+{
+    int msg_id;
+    int64_t inicio_us;
+} MqttEmVoo;
+
+static MqttEmVoo s_em_voo[MQTT_PUBLICACOES_EM_VOO];
+static int s_em_voo_proximo = 0;
+static uint32_t s_confirmadas = 0;
+static uint64_t s_latencia_total_us = 0;
+static uint32_t s_latencia_max_us = 0;
+static uint32_t s_sem_confirmacao = 0;
+static portMUX_TYPE s_metricas_mux = portMUX_INITIALIZER_UNLOCKED;
 
 static void log_error_if_nonzero(const char *message, int error_code)
 {
@@ -33,6 +85,107 @@ static void log_error_if_nonzero(const char *message, int error_code)
     }
 }
 
+static void mqtt_metricas_publicou(int msg_id)
+{
+    if (msg_id <= 0)
+    {
+        return; // QoS 0 ou erro: não há PUBACK
+    }
+
+    portENTER_CRITICAL(&s_metricas_mux);
+    MqttEmVoo *entrada = &s_em_voo[s_em_voo_proximo];
+    if (entrada->msg_id != 0)
+    {
+        s_sem_confirmacao++;
+    }
+    entrada->msg_id = msg_id;
+    entrada->inicio_us = esp_timer_get_time();
+    s_em_voo_proximo = (s_em_voo_proximo + 1) % MQTT_PUBLICACOES_EM_VOO;
+    portEXIT_CRITICAL(&s_metricas_mux);
+}
+
+static void mqtt_metricas_confirmou(int msg_id)
+{
+    int64_t agora = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_metricas_mux);
+    for (int i = 0; i < MQTT_PUBLICACOES_EM_VOO; i++)
+    {
+        if (s_em_voo[i].msg_id == msg_id)
+        {
+            uint32_t latencia = (uint32_t)(agora - s_em_voo[i].inicio_us);
+            s_em_voo[i].msg_id = 0;
+            s_confirmadas++;
+            s_latencia_total_us += latencia;
+            if (latencia > s_latencia_max_us)
+            {
+                s_latencia_max_us = latencia;
+            }
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_metricas_mux);
+}
+
+/* Na queda da conexão os msg_id pendentes não voltam mais */
+static void mqtt_metricas_descarta_em_voo(void)
+{
+    portENTER_CRITICAL(&s_metricas_mux);
+    for (int i = 0; i < MQTT_PUBLICACOES_EM_VOO; i++)
+    {
+        if (s_em_voo[i].msg_id != 0)
+        {
+            s_em_voo[i].msg_id = 0;
+            s_sem_confirmacao++;
+        }
+    }
+    portEXIT_CRITICAL(&s_metricas_mux);
+}
+
+static void mqtt_despacha(const char *topico, const char *dados, int tamanho)
+{
+    for (int i = 0; i < s_num_inscricoes; i++)
+    {
+        if (strcmp(s_inscricoes[i].topico, topico) == 0)
+        {
+            esp_err_t err = s_inscricoes[i].callback(dados, tamanho);
+            if (err != ESP_OK)
+            {
+                ESP_LOGW(TAG, "Falha ao tratar mensagem de %s (err=0x%x)", topico, err);
+            }
+        }
+    }
+}
+
+static void mqtt_recebe_dados(esp_mqtt_event_handle_t event)
+{
+    // O tópico só vem no primeiro fragmento
+    if (event->current_data_offset == 0)
+    {
+        int tamanho_topico = event->topic_len < MQTT_TOPICO_MAX - 1 ? event->topic_len : MQTT_TOPICO_MAX - 1;
+        memcpy(s_rx_topico, event->topic, tamanho_topico);
+        s_rx_topico[tamanho_topico] = '\0';
+
+        s_rx_descartar = event->total_data_len > MQTT_RX_MAX;
+        if (s_rx_descartar)
+        {
+            ESP_LOGW(TAG, "Mensagem de %d bytes em %s descartada", event->total_data_len, s_rx_topico);
+        }
+    }
+
+    if (s_rx_descartar)
+    {
+        return;
+    }
+
+    memcpy(s_rx_buffer + event->current_data_offset, event->data, event->data_len);
+
+    if (event->current_data_offset + event->data_len == event->total_data_len)
+    {
+        mqtt_despacha(s_rx_topico, s_rx_buffer, event->total_data_len);
+    }
+}
+
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
     ESP_LOGD(TAG, "Event dispatched from event loop base=%s, event_id=%d", base, (int)event_id);
@@ -43,28 +196,35 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     {
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
-        xSemaphoreGive(conexaoMQTTSemaphore);
-        msg_id = esp_mqtt_client_subscribe(client, "dispositivos/#", 0);
+        s_conectado = true;
+        conexao_notifica(CONEXAO_EVT_MQTT_CONECTADO);
+        // Só os tópicos tratados: um curinga receberia o tráfego da frota inteira
+        for (int i = 0; i < s_num_inscricoes; i++)
+        {
+            msg_id = esp_mqtt_client_subscribe(client, s_inscricoes[i].topico, 0);
+            ESP_LOGD(TAG, "Inscrito em %s, msg_id=%d", s_inscricoes[i].topico, msg_id);
+        }
         break;
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+        s_conectado = false;
+        mqtt_metricas_descarta_em_voo();
+        conexao_notifica(CONEXAO_EVT_MQTT_DESCONECTADO);
         break;
 
     case MQTT_EVENT_SUBSCRIBED:
         ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
-        msg_id = esp_mqtt_client_publish(client, "/topic/qos0", "data", 0, 0, 0);
-        ESP_LOGI(TAG, "sent publish successful, msg_id=%d", msg_id);
         break;
     case MQTT_EVENT_UNSUBSCRIBED:
         ESP_LOGI(TAG, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
         break;
     case MQTT_EVENT_PUBLISHED:
-        ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        ESP_LOGD(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        mqtt_metricas_confirmou(event->msg_id);
         break;
     case MQTT_EVENT_DATA:
-        ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-        printf("TOPIC=%.*s\r\n", event->topic_len, event->topic);
-        printf("DATA=%.*s\r\n", event->data_len, event->data);
+        ESP_LOGD(TAG, "MQTT_EVENT_DATA, topico=%.*s, %d bytes", event->topic_len, event->topic, event->data_len);
+        mqtt_recebe_dados(event);
         break;
     case MQTT_EVENT_ERROR:
         ESP_LOGI(TAG, "MQTT_EVENT_ERROR");
@@ -82,18 +242,220 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
     }
 }
 
-void mqtt_start()
+/*
+ * Um único cliente durante toda a execução: criado na primeira chamada e
+ * reconectado nas seguintes. A reconexão automática do esp-mqtt fica
+ * desligada; quem decide quando tentar é o supervisor (conexao_modulo).
+ */
+esp_err_t mqtt_conecta(void)
 {
+    if (client != NULL)
+    {
+        return esp_mqtt_client_reconnect(client);
+    }
+
     esp_mqtt_client_config_t mqtt_config = {
-        .broker.address.uri = "mqtt://10.232.90.177:1883",
+        .broker.address.uri = identidade_broker_uri(),
+        .credentials.client_id = identidade_id(),
+        .network.disable_auto_reconnect = true,
+        // Cópias dos publishes QoS 1 no heap até o PUBACK: limitadas, o excesso vai para a flash
+        .outbox.limit = CONFIG_MQTT_OUTBOX_LIMITE_KB * 1024,
     };
     client = esp_mqtt_client_init(&mqtt_config);
+    if (client == NULL)
+    {
+        return ESP_FAIL;
+    }
     esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
-    esp_mqtt_client_start(client);
+    return esp_mqtt_client_start(client);
+}
+
+void mqtt_registra_callback(const char *topico, mqtt_callback_t callback)
+{
+    if (s_num_inscricoes >= MQTT_MAX_INSCRICOES)
+    {
+        ESP_LOGE(TAG, "Limite de callbacks MQTT atingido, %s ignorado", topico);
+        return;
+    }
+
+    s_inscricoes[s_num_inscricoes].topico = topico;
+    s_inscricoes[s_num_inscricoes].callback = callback;
+    s_num_inscricoes++;
+}
+
+/* --------------------------------------------------------------------------
+ *  Outbox: partição "outbox" na flash; sem ela, flash simulada em RAM
+ *  (não sobrevive a reboot, mas cobre quedas curtas de Wi-Fi)
+ * -------------------------------------------------------------------------- */
+void mqtt_outbox_init(void)
+{
+    static OutboxFlash flash;
+    static OutboxFlashSim sim;
+
+    s_outbox_mutex = xSemaphoreCreateMutex();
+
+    if (outbox_flash_particao(&flash) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Partição do outbox não encontrada, usando %d KB de RAM", CONFIG_OUTBOX_RAM_KB);
+        size_t tamanho = CONFIG_OUTBOX_RAM_KB * 1024;
+        uint8_t *memoria = malloc(tamanho);
+        if (memoria == NULL)
+        {
+            ESP_LOGE(TAG, "Sem memória para o outbox; mensagens offline serão perdidas");
+            return;
+        }
+        outbox_flash_sim_init(&sim, memoria, tamanho, 4096, &flash);
+    }
+
+    esp_err_t err = outbox_abre(&s_outbox, &flash);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao abrir o outbox (err=0x%x)", err);
+        return;
+    }
+    s_outbox_ativo = true;
+
+    OutboxEstatisticas est;
+    outbox_estatisticas(&s_outbox, &est);
+    ESP_LOGI(TAG, "Outbox: %lu mensagens pendentes (%lu prioritárias), %lu/%lu bytes",
+             (unsigned long)est.pendentes, (unsigned long)est.pendentes_prioritarios,
+             (unsigned long)est.bytes_usados, (unsigned long)est.bytes_total);
+}
+
+static MqttEnvio mqtt_guarda_outbox(const char *topico, const uint8_t *dados, int tamanho, bool prioritaria)
+{
+    if (!s_outbox_ativo)
+    {
+        ESP_LOGW(TAG, "Desconectado, mensagem em %s perdida", topico);
+        return MQTT_ENVIO_FALHOU;
+    }
+
+    xSemaphoreTake(s_outbox_mutex, portMAX_DELAY);
+    esp_err_t err = outbox_grava(&s_outbox, topico, dados, tamanho, prioritaria);
+    xSemaphoreGive(s_outbox_mutex);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Falha ao guardar mensagem de %s no outbox (err=0x%x)", topico, err);
+        return MQTT_ENVIO_FALHOU;
+    }
+    return MQTT_ENVIO_OUTBOX;
 }
 
-void mqtt_envia_mensagem(char *topico, char *mensagem)
+/* O reenvio (task_outbox) consome o outbox sob o mesmo mutex */
+static bool mqtt_outbox_pendente(void)
 {
-    int message_id = esp_mqtt_client_publish(client, topico, mensagem, 0, 1, 0);
-    ESP_LOGI(TAG, "Mesnagem enviada, ID: %d", message_id);
+    if (!s_outbox_ativo)
+    {
+        return false;
+    }
+
+    xSemaphoreTake(s_outbox_mutex, portMAX_DELAY);
+    bool pendente = !outbox_vazia(&s_outbox);
+    xSemaphoreGive(s_outbox_mutex);
+    return pendente;
+}
+
+/*
+ * Publica direto quando conectado. Desconectado, ou com fila pendente no
+ * outbox (para não passar na frente do que já está guardado), vai para o
+ * outbox; alertas prioritários nunca esperam a fila. Sem `guarda_se_falhar`
+ * a mensagem nunca toca o outbox: o que não sai direto é perdido.
+ */
+MqttEnvio mqtt_envia(const char *topico, const uint8_t *dados, int tamanho, int qos, bool guarda_se_falhar)
+{
+    // Alertas de queda passam na frente no reenvio do outbox
+    bool prioritaria = strcmp(topico, identidade_topico(IDENTIDADE_TOPICO_QUEDA)) == 0;
+    bool direto = client != NULL && s_conectado && (prioritaria || !mqtt_outbox_pendente());
+
+    // Métricas descartáveis não podem encher o anel da flash e expulsar alertas
+    if (!direto && !guarda_se_falhar)
+    {
+        return MQTT_ENVIO_FALHOU;
+    }
+
+    if (direto)
+    {
+        int message_id = esp_mqtt_client_publish(client, topico, (const char *)dados, tamanho, qos, 0);
+        if (message_id >= 0)
+        {
+            mqtt_metricas_publicou(message_id);
+            ESP_LOGD(TAG, "Mensagem de %d bytes enviada em %s, ID: %d", tamanho, topico, message_id);
+            perfil_boot_marca(BOOT_PRIMEIRO_PUBLISH);
+            return MQTT_ENVIO_PUBLICADO;
+        }
+        if (!guarda_se_falhar)
+        {
+            return MQTT_ENVIO_FALHOU;
+        }
+    }
+
+    return mqtt_guarda_outbox(topico, dados, tamanho, prioritaria);
+}
+
+bool mqtt_conectado(void)
+{
+    return s_conectado;
+}
+
+/* Reenvia até max_mensagens do outbox; quem chama controla a taxa */
+int mqtt_reenvia_outbox(int max_mensagens)
+{
+    if (!s_outbox_ativo || !s_conectado)
+    {
+        return 0;
+    }
+
+    int enviadas = 0;
+    OutboxMensagem mensagem;
+
+    xSemaphoreTake(s_outbox_mutex, portMAX_DELAY);
+    while (enviadas < max_mensagens && s_conectado &&
+           outbox_proxima(&s_outbox, &mensagem, s_outbox_buffer, sizeof(s_outbox_buffer)) == ESP_OK)
+    {
+        int message_id = esp_mqtt_client_publish(client, mensagem.topico, (const char *)mensagem.dados,
+                                                 mensagem.tamanho, 1, 0);
+        if (message_id < 0)
+        {
+            break;
+        }
+        mqtt_metricas_publicou(message_id);
+        outbox_confirma(&s_outbox, &mensagem);
+        perfil_boot_marca(BOOT_PRIMEIRO_PUBLISH);
+        enviadas++;
+    }
+    xSemaphoreGive(s_outbox_mutex);
+
+    return enviadas;
+}
+
+void mqtt_outbox_estatisticas(OutboxEstatisticas *estatisticas)
+{
+    if (!s_outbox_ativo)
+    {
+        memset(estatisticas, 0, sizeof(*estatisticas));
+        return;
+    }
+
+    xSemaphoreTake(s_outbox_mutex, portMAX_DELAY);
+    outbox_estatisticas(&s_outbox, estatisticas);
+    xSemaphoreGive(s_outbox_mutex);
+}
+
+void mqtt_metricas_janela(MqttMetricas *metricas)
+{
+    portENTER_CRITICAL(&s_metricas_mux);
+    metricas->confirmadas = s_confirmadas;
+    metricas->latencia_media_us = s_confirmadas ? (uint32_t)(s_latencia_total_us / s_confirmadas) : 0;
+    metricas->latencia_max_us = s_latencia_max_us;
+    metricas->sem_confirmacao = s_sem_confirmacao;
+    s_confirmadas = 0;
+    s_latencia_total_us = 0;
+    s_latencia_max_us = 0;
+    s_sem_confirmacao = 0;
+    portEXIT_CRITICAL(&s_metricas_mux);
+
+    int fila = client != NULL ? esp_mqtt_client_get_outbox_size(client) : 0;
+    metricas->fila_bytes = fila > 0 ? (uint32_t)fila : 0;
+    metricas->conectado = s_conectado;
 }
\ No newline at end of file
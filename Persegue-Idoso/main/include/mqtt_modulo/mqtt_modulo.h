@@ -1,8 +1,54 @@
 #ifndef MQTT_H
 #define MQTT_H
 
-void mqtt_start();
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "outbox_modulo.h"
 
-void mqtt_envia_mensagem(char * topico, char * mensagem);
+/* Chamado com a mensagem completa (já remontada) de um tópico inscrito */
+typedef esp_err_t (*mqtt_callback_t)(const char *dados, int tamanho);
+
+/* Cria o cliente na primeira chamada; depois só reconecta o mesmo cliente */
+esp_err_t mqtt_conecta(void);
+
+/* Registrar antes de mqtt_conecta(); cada tópico registrado é inscrito a cada conexão */
+void mqtt_registra_callback(const char *topico, mqtt_callback_t callback);
+
+typedef enum
+{
+    MQTT_ENVIO_PUBLICADO, // Entregue ao cliente (QoS 1: ele retransmite até o PUBACK)
+    MQTT_ENVIO_OUTBOX,    // Guardada no outbox em flash para reenvio
+    MQTT_ENVIO_FALHOU,
+} MqttEnvio;
+
+/*
+ * Conectado, publica na hora (alertas não esperam o outbox esvaziar).
+ * Desconectado, com o outbox ainda pendente ou se o publish falhar, vai
+ * para o outbox só com `guarda_se_falhar`; sem ele retorna
+ * MQTT_ENVIO_FALHOU sem tocar a flash.
+ * Pode bloquear na rede: chamado só pela tarefa do publicador.
+ */
+MqttEnvio mqtt_envia(const char *topico, const uint8_t *dados, int tamanho, int qos, bool guarda_se_falhar);
+bool mqtt_conectado(void);
+
+/* Chamar uma vez no boot, antes de qualquer envio */
+void mqtt_outbox_init(void);
+int mqtt_reenvia_outbox(int max_mensagens);
+void mqtt_outbox_estatisticas(OutboxEstatisticas *estatisticas);
+
+/* Publish -> PUBACK (QoS 1) na janela desde a última leitura */
+typedef struct
+{
+    uint32_t confirmadas;
+    uint32_t latencia_media_us;
+    uint32_t latencia_max_us;
+    uint32_t sem_confirmacao;  // Saíram da tabela antes do PUBACK (reconexão, tabela cheia)
+    uint32_t fila_bytes;       // Outbox interno do cliente: ainda não enviadas ou sem PUBACK
+    bool conectado;
+} MqttMetricas;
+
+/* Lê e começa uma nova janela */
+void mqtt_metricas_janela(MqttMetricas *metricas);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include "nmea_modulo.h"
+#include <string.h>
+
+#define NMEA_MAX_CAMPOS 24
+
+typedef enum {
+    ESTADO_AGUARDA_INICIO,
+    ESTADO_CORPO,
+    ESTADO_CHECKSUM_1,
+    ESTADO_CHECKSUM_2,
+} EstadoParser;
+
+/* --------------------------------------------------------------------------
+ *  Conversões de campos (sem sscanf/strtod: tudo em cima do texto já
+ *  separado, sem locale e sem alocação)
+ * -------------------------------------------------------------------------- */
+static int valor_hex(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static bool eh_digito(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static double campo_decimal(const char *campo)
+{
+    double sinal = 1.0;
+    double valor = 0.0;
+    double escala = 1.0;
+
+    if (*campo == '-')
+    {
+        sinal = -1.0;
+        campo++;
+    }
+
+    while (eh_digito(*campo))
+    {
+        valor = valor * 10.0 + (*campo++ - '0');
+    }
+
+    if (*campo == '.')
+    {
+        campo++;
+        while (eh_digito(*campo))
+        {
+            valor = valor * 10.0 + (*campo++ - '0');
+            escala *= 10.0;
+        }
+    }
+
+    return sinal * valor / escala;
+}
+
+static int campo_inteiro(const char *campo)
+{
+    int valor = 0;
+    while (eh_digito(*campo))
+    {
+        valor = valor * 10 + (*campo++ - '0');
+    }
+    return valor;
+}
+
+static int dois_digitos(const char *c)
+{
+    return (c[0] - '0') * 10 + (c[1] - '0');
+}
+
+/* "ddmm.mmmm" / "dddmm.mmmm" + hemisfério -> graus decimais */
+static float campo_coordenada(const char *valor, const char *hemisferio)
+{
+    double nmea = campo_decimal(valor);
+    int graus = (int)(nmea / 100.0);
+    double minutos = nmea - graus * 100.0;
+    double decimal = graus + minutos / 60.0;
+
+    if (hemisferio[0] == 'S' || hemisferio[0] == 'W')
+    {
+        decimal = -decimal;
+    }
+
+    return (float)decimal;
+}
+
+/* "hhmmss.sss" -> horário UTC */
+static void campo_horario(const char *campo, GpsData *fix)
+{
+    if (strlen(campo) < 6)
+    {
+        return;
+    }
+
+    fix->hora = dois_digitos(campo);
+    fix->minuto = dois_digitos(campo + 2);
+    fix->segundo = dois_digitos(campo + 4);
+    fix->milissegundo = 0;
+
+    if (campo[6] == '.')
+    {
+        int ms = 0, casas = 0;
+        for (const char *c = campo + 7; eh_digito(*c) && casas < 3; c++, casas++)
+        {
+            ms = ms * 10 + (*c - '0');
+        }
+        for (; casas < 3; casas++)
+        {
+            ms *= 10;
+        }
+        fix->milissegundo = ms;
+    }
+}
+
+/* "ddmmyy" -> data UTC */
+static void campo_data(const char *campo, GpsData *fix)
+{
+    if (strlen(campo) < 6)
+    {
+        return;
+    }
+
+    fix->dia = dois_digitos(campo);
+    fix->mes = dois_digitos(campo + 2);
+    fix->ano = 2000 + dois_digitos(campo + 4);
+}
+
+/* --------------------------------------------------------------------------
+ *  Tratadores por tipo de sentença. campos[0] é o endereço ("GPGGA"),
+ *  campos vazios chegam como "" e mantêm o valor anterior.
+ * -------------------------------------------------------------------------- */
+static void trata_gga(char **campos, int n, GpsData *fix)
+{
+    // $--GGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,q,nn,hdop,alt,M,...
+    if (n < 10)
+    {
+        return;
+    }
+
+    campo_horario(campos[1], fix);
+
+    fix->qualidade_fix = campo_inteiro(campos[6]);
+    fix->valid = fix->qualidade_fix > 0 && campos[2][0] != '\0' && campos[4][0] != '\0';
+
+    if (fix->valid)
+    {
+        fix->latitude = campo_coordenada(campos[2], campos[3]);
+        fix->longitude = campo_coordenada(campos[4], campos[5]);
+    }
+
+    fix->satelites = campo_inteiro(campos[7]);
+    if (campos[8][0] != '\0') fix->hdop = campo_decimal(campos[8]);
+    if (campos[9][0] != '\0') fix->altitude = campo_decimal(campos[9]);
+}
+
+static void trata_rmc(char **campos, int n, GpsData *fix)
+{
+    // $--RMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,nós,curso,ddmmyy,...
+    if (n < 10)
+    {
+        return;
+    }
+
+    campo_horario(campos[1], fix);
+    campo_data(campos[9], fix);
+
+    fix->valid = campos[2][0] == 'A' && campos[3][0] != '\0' && campos[5][0] != '\0';
+
+    if (fix->valid)
+    {
+        fix->latitude = campo_coordenada(campos[3], campos[4]);
+        fix->longitude = campo_coordenada(campos[5], campos[6]);
+    }
+
+    if (campos[7][0] != '\0') fix->velocidade_kmh = campo_decimal(campos[7]) * 1.852f;
+    if (campos[8][0] != '\0') fix->curso_graus = campo_decimal(campos[8]);
+}
+
+static void trata_vtg(char **campos, int n, GpsData *fix)
+{
+    // $--VTG,curso,T,curso_mag,M,nós,N,kmh,K,...
+    if (n < 9)
+    {
+        return;
+    }
+
+    if (campos[1][0] != '\0') fix->curso_graus = campo_decimal(campos[1]);
+    if (campos[7][0] != '\0') fix->velocidade_kmh = campo_decimal(campos[7]);
+}
+
+static void trata_gsa(char **campos, int n, GpsData *fix)
+{
+    // $--GSA,modo,tipo,sv1..sv12,pdop,hdop,vdop[,sistema]
+    if (n < 18)
+    {
+        return;
+    }
+
+    if (campos[2][0] != '\0') fix->tipo_fix = campo_inteiro(campos[2]);
+    if (campos[15][0] != '\0') fix->pdop = campo_decimal(campos[15]);
+    if (campos[16][0] != '\0') fix->hdop = campo_decimal(campos[16]);
+    if (campos[17][0] != '\0') fix->vdop = campo_decimal(campos[17]);
+}
+
+/* Separa a sentença em campos (in-place) e despacha pelo tipo. O talker
+   (GP, GN, GL, GA, ...) é ignorado: só os 3 caracteres do tipo importam. */
+static NmeaSentenca interpreta_sentenca(NmeaParser *parser)
+{
+    char *campos[NMEA_MAX_CAMPOS];
+    int n = 0;
+
+    campos[n++] = parser->linha;
+    for (char *c = parser->linha; *c != '\0'; c++)
+    {
+        if (*c == ',')
+        {
+            *c = '\0';
+            if (n < NMEA_MAX_CAMPOS)
+            {
+                campos[n++] = c + 1;
+            }
+        }
+    }
+
+    const char *endereco = campos[0];
+    if (strlen(endereco) != 5 || endereco[0] == 'P')
+    {
+        return NMEA_OUTRA;
+    }
+
+    const char *tipo = endereco + 2;
+    if (strcmp(tipo, "GGA") == 0)
+    {
+        trata_gga(campos, n, &parser->fix);
+        return NMEA_GGA;
+    }
+    if (strcmp(tipo, "RMC") == 0)
+    {
+        trata_rmc(campos, n, &parser->fix);
+        return NMEA_RMC;
+    }
+    if (strcmp(tipo, "VTG") == 0)
+    {
+        trata_vtg(campos, n, &parser->fix);
+        return NMEA_VTG;
+    }
+    if (strcmp(tipo, "GSA") == 0)
+    {
+        trata_gsa(campos, n, &parser->fix);
+        return NMEA_GSA;
+    }
+
+    return NMEA_OUTRA;
+}
+
+/* --------------------------------------------------------------------------
+ *  API pública
+ * -------------------------------------------------------------------------- */
+void nmea_parser_init(NmeaParser *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->estado = ESTADO_AGUARDA_INICIO;
+}
+
+/*
+ * Máquina de estados:
+ *   AGUARDA_INICIO --'$'--> CORPO --'*'--> CHECKSUM_1 --hex--> CHECKSUM_2 --hex--> valida
+ * Um '$' no meio de qualquer estado reinicia a sentença (linha truncada).
+ */
+NmeaSentenca nmea_parser_byte(NmeaParser *parser, char c)
+{
+    if (c == '$')
+    {
+        if (parser->estado != ESTADO_AGUARDA_INICIO)
+        {
+            parser->estatisticas.descartadas++;
+        }
+        parser->estado = ESTADO_CORPO;
+        parser->tamanho = 0;
+        parser->checksum_calculado = 0;
+        return NMEA_NENHUMA;
+    }
+
+    switch (parser->estado)
+    {
+    case ESTADO_CORPO:
+        if (c == '*')
+        {
+            parser->linha[parser->tamanho] = '\0';
+            parser->estado = ESTADO_CHECKSUM_1;
+        }
+        else if (c == '\r' || c == '\n' || parser->tamanho >= NMEA_MAX_SENTENCA)
+        {
+            parser->estatisticas.descartadas++;
+            parser->estado = ESTADO_AGUARDA_INICIO;
+        }
+        else
+        {
+            parser->linha[parser->tamanho++] = c;
+            parser->checksum_calculado ^= (uint8_t)c;
+        }
+        break;
+
+    case ESTADO_CHECKSUM_1:
+    {
+        int alto = valor_hex(c);
+        if (alto < 0)
+        {
+            parser->estatisticas.descartadas++;
+            parser->estado = ESTADO_AGUARDA_INICIO;
+            break;
+        }
+        parser->checksum_lido = (uint8_t)(alto << 4);
+        parser->estado = ESTADO_CHECKSUM_2;
+        break;
+    }
+
+    case ESTADO_CHECKSUM_2:
+    {
+        int baixo = valor_hex(c);
+        parser->estado = ESTADO_AGUARDA_INICIO;
+
+        if (baixo < 0)
+        {
+            parser->estatisticas.descartadas++;
+            break;
+        }
+
+        parser->checksum_lido |= (uint8_t)baixo;
+        if (parser->checksum_lido != parser->checksum_calculado)
+        {
+            parser->estatisticas.erros_checksum++;
+            break;
+        }
+
+        parser->estatisticas.sentencas_ok++;
+        return interpreta_sentenca(parser);
+    }
+
+    default:
+        break;
+    }
+
+    return NMEA_NENHUMA;
+}
+
+uint32_t nmea_parser_processa(NmeaParser *parser, const uint8_t *dados, size_t tamanho)
+{
+    uint32_t sentencas = NMEA_NENHUMA;
+
+    for (size_t i = 0; i < tamanho; i++)
+    {
+        sentencas |= nmea_parser_byte(parser, (char)dados[i]);
+    }
+
+    return sentencas;
+}
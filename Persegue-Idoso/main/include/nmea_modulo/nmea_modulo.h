@@ -0,0 +1,69 @@
+#ifndef NMEA_MODULO_H
+#define NMEA_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Sentença NMEA 0183 tem no máximo 82 caracteres; folga para receptores fora do padrão */
+#define NMEA_MAX_SENTENCA 120
+
+typedef struct {
+    float latitude;
+    float longitude;
+    float altitude;
+    int satelites;
+    bool valid;
+    float velocidade_kmh;  // RMC/VTG
+    float curso_graus;     // RMC/VTG, em relação ao norte verdadeiro
+    float hdop;            // GGA/GSA
+    float pdop;            // GSA
+    float vdop;            // GSA
+    uint8_t qualidade_fix; // GGA: 0 = sem fix, 1 = GPS, 2 = DGPS...
+    uint8_t tipo_fix;      // GSA: 1 = sem fix, 2 = 2D, 3 = 3D
+    uint8_t hora;          // Horário UTC do último fix
+    uint8_t minuto;
+    uint8_t segundo;
+    uint16_t milissegundo;
+    uint8_t dia;           // Data UTC (RMC)
+    uint8_t mes;
+    uint16_t ano;
+    int64_t timestamp_us;  // Instante em que a sentença terminou de chegar (preenchido por quem lê a UART)
+} GpsData;
+
+/* Tipos de sentença reconhecidos (máscara de bits) */
+typedef enum {
+    NMEA_NENHUMA = 0,
+    NMEA_GGA = 1 << 0,
+    NMEA_RMC = 1 << 1,
+    NMEA_VTG = 1 << 2,
+    NMEA_GSA = 1 << 3,
+    NMEA_OUTRA = 1 << 4, // Checksum válido, tipo não tratado (GSV, GLL, ...)
+} NmeaSentenca;
+
+typedef struct {
+    uint32_t sentencas_ok;
+    uint32_t erros_checksum;
+    uint32_t descartadas;  // Sentenças maiores que o buffer ou malformadas
+} NmeaEstatisticas;
+
+/*
+ * Parser incremental, um byte por vez. Todo o estado (inclusive o buffer da
+ * sentença) fica na struct, então sentenças divididas entre leituras da UART
+ * são remontadas naturalmente e nada é alocado.
+ */
+typedef struct {
+    char linha[NMEA_MAX_SENTENCA + 1];
+    uint8_t tamanho;
+    uint8_t estado;
+    uint8_t checksum_calculado;
+    uint8_t checksum_lido;
+    GpsData fix;
+    NmeaEstatisticas estatisticas;
+} NmeaParser;
+
+void nmea_parser_init(NmeaParser *parser);
+NmeaSentenca nmea_parser_byte(NmeaParser *parser, char c);
+uint32_t nmea_parser_processa(NmeaParser *parser, const uint8_t *dados, size_t tamanho);
+
+#endif
@@ -0,0 +1,146 @@
+#include "orientacao_esp.h"
+#include "orientacao_modulo.h"
+
+#include <math.h>
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#define TAG "ORIENTACAO"
+
+#define ORIENTACAO_NVS_NAMESPACE "imu"
+#define ORIENTACAO_NVS_CHAVE_BIAS "gyro_bias_dps"
+#define ORIENTACAO_BIAS_DELTA_SALVAR_LSB 2.0f              // Abaixo disto não vale gastar a flash
+#define ORIENTACAO_BIAS_INTERVALO_SALVAR_US (30LL * 60 * 1000000) // Uma gravação por meia hora, no máximo
+
+/* --------------------------------------------------------------------------
+ *  Último bias gravado (ou lido) da NVS, para comparar sem abrir a NVS a
+ *  cada trecho parado; s_ultima_gravacao_us = 0 até a primeira gravação
+ *  do boot, que não espera o intervalo.
+ * -------------------------------------------------------------------------- */
+static float s_salvo_dps[3];
+static bool s_salvo_valido = false;
+static bool s_salvo_consultado = false;
+static int64_t s_ultima_gravacao_us = 0;
+
+static esp_err_t orientacao_bias_le_dps(float bias_dps[3])
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(ORIENTACAO_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t tamanho = sizeof(float) * 3;
+    err = nvs_get_blob(nvs, ORIENTACAO_NVS_CHAVE_BIAS, bias_dps, &tamanho);
+    nvs_close(nvs);
+    if (err == ESP_OK && tamanho != sizeof(float) * 3) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return err;
+}
+
+esp_err_t orientacao_bias_carrega(float bias_lsb[3], float sensibilidade_gyro_lsb_dps)
+{
+    float bias_dps[3];
+    esp_err_t err = orientacao_bias_le_dps(bias_dps);
+    s_salvo_consultado = true;
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        s_salvo_dps[i] = bias_dps[i];
+        bias_lsb[i] = bias_dps[i] * sensibilidade_gyro_lsb_dps;
+    }
+    s_salvo_valido = true;
+    return ESP_OK;
+}
+
+esp_err_t orientacao_bias_salva(const float bias_lsb[3], float sensibilidade_gyro_lsb_dps)
+{
+    float bias_dps[3];
+    for (int i = 0; i < 3; i++) {
+        bias_dps[i] = bias_lsb[i] / sensibilidade_gyro_lsb_dps;
+    }
+
+    if (!s_salvo_consultado) {
+        s_salvo_valido = orientacao_bias_le_dps(s_salvo_dps) == ESP_OK;
+        s_salvo_consultado = true;
+    }
+    if (s_salvo_valido) {
+        bool mudou = false;
+        for (int i = 0; i < 3; i++) {
+            if (fabsf(s_salvo_dps[i] - bias_dps[i]) * sensibilidade_gyro_lsb_dps > ORIENTACAO_BIAS_DELTA_SALVAR_LSB) {
+                mudou = true;
+            }
+        }
+        // Recalibrações em repouso repetem quase o mesmo valor
+        if (!mudou) {
+            return ESP_OK;
+        }
+    }
+
+    // O bias segue a temperatura devagar: a RAM já tem o novo, a flash pode esperar
+    int64_t agora = esp_timer_get_time();
+    if (s_ultima_gravacao_us != 0 && agora - s_ultima_gravacao_us < ORIENTACAO_BIAS_INTERVALO_SALVAR_US) {
+        return ESP_OK;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(ORIENTACAO_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, ORIENTACAO_NVS_CHAVE_BIAS, bias_dps, sizeof(bias_dps));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (err == ESP_OK) {
+        for (int i = 0; i < 3; i++) {
+            s_salvo_dps[i] = bias_dps[i];
+        }
+        s_salvo_valido = true;
+        s_ultima_gravacao_us = agora;
+        ESP_LOGI(TAG, "Bias do giroscópio salvo: %.3f %.3f %.3f graus/s", bias_dps[0], bias_dps[1], bias_dps[2]);
+    }
+    return err;
+}
+
+/* --------------------------------------------------------------------------
+ *  Benchmark do filtro no próprio ESP32: amostras sintéticas com rotação
+ *  lenta e |a| = 1 g, para passar pelo ramo com correção do acelerômetro
+ *  (o mais caro). Roda numa instância local, sem afetar o estado da task.
+ * -------------------------------------------------------------------------- */
+uint32_t orientacao_mede_ciclos(uint32_t atualizacoes)
+{
+    if (atualizacoes == 0) {
+        return 0;
+    }
+
+    Orientacao o;
+    orientacao_init(&o, mpu6050_lsb_por_g(MPU6050_ACCEL_2G), mpu6050_lsb_por_dps(MPU6050_GYRO_250DPS),
+                    ORIENTACAO_KP_PADRAO, ORIENTACAO_KI_PADRAO);
+
+    Mpu6050Data amostra = {
+        .accel_z = 16384,
+        .gyro_x = 131,
+        .gyro_y = -65,
+        .timestamp_us = 1000,
+    };
+    orientacao_atualiza(&o, &amostra);
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < atualizacoes; i++) {
+        amostra.timestamp_us += 1000;
+        amostra.accel_x = (int16_t)((i & 0xFF) - 128);
+        uint32_t inicio = esp_cpu_get_cycle_count();
+        orientacao_atualiza(&o, &amostra);
+        total += esp_cpu_get_cycle_count() - inicio;
+    }
+
+    return total / atualizacoes;
+}
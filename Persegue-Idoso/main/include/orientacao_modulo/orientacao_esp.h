@@ -0,0 +1,24 @@
+#ifndef ORIENTACAO_ESP_H
+#define ORIENTACAO_ESP_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Parte do módulo que depende do ESP-IDF: bias em NVS e medição de ciclos.
+ * O bias é guardado em graus/s e convertido para LSB da faixa em uso.
+ */
+
+/* ESP_ERR_NVS_NOT_FOUND se ainda não houve calibração */
+esp_err_t orientacao_bias_carrega(float bias_lsb[3], float sensibilidade_gyro_lsb_dps);
+/*
+ * Só grava se mudou mais que ORIENTACAO_BIAS_DELTA_SALVAR_LSB em algum eixo
+ * e, depois da primeira gravação do boot, no máximo uma vez por
+ * ORIENTACAO_BIAS_INTERVALO_SALVAR_US. A comparação é com o valor em RAM.
+ */
+esp_err_t orientacao_bias_salva(const float bias_lsb[3], float sensibilidade_gyro_lsb_dps);
+
+/* Ciclos de CPU por orientacao_atualiza(), média de `atualizacoes` chamadas */
+uint32_t orientacao_mede_ciclos(uint32_t atualizacoes);
+
+#endif
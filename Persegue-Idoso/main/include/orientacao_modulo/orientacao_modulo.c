@@ -0,0 +1,260 @@
+#include "orientacao_modulo.h"
+#include <math.h>
+#include <string.h>
+
+#define GRAUS_PARA_RAD (3.14159265f / 180.0f)
+#define RAD_PARA_GRAUS (180.0f / 3.14159265f)
+#define ORIENTACAO_LACUNA_MAX_US 500000 // Acima disto o giroscópio não é integrado
+#define CALIBRACAO_VARIACAO_MAX_DPS 2.0f // Pico-a-pico por eixo aceito como "parado"
+
+static void faixa_mag2(float faixa_g, float sensibilidade, uint32_t *min, uint32_t *max)
+{
+    float lo = (1.0f - faixa_g) * sensibilidade;
+    float hi = (1.0f + faixa_g) * sensibilidade;
+    *min = (uint32_t)(lo * lo);
+    *max = (uint32_t)(hi * hi);
+}
+
+static uint32_t magnitude2(const Mpu6050Data *d)
+{
+    int32_t x = d->accel_x, y = d->accel_y, z = d->accel_z;
+    return (uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z);
+}
+
+void orientacao_init(Orientacao *o, float sensibilidade_accel_lsb_g, float sensibilidade_gyro_lsb_dps,
+                     float kp, float ki)
+{
+    memset(o, 0, sizeof(*o));
+    o->q[0] = 1.0f;
+    o->kp = kp;
+    o->ki = ki;
+    o->rad_por_lsb = GRAUS_PARA_RAD / sensibilidade_gyro_lsb_dps;
+    faixa_mag2(ORIENTACAO_FAIXA_CONFIANCA_G, sensibilidade_accel_lsb_g, &o->mag2_min, &o->mag2_max);
+}
+
+void orientacao_define_bias(Orientacao *o, const float bias_lsb[3])
+{
+    memcpy(o->bias_lsb, bias_lsb, sizeof(o->bias_lsb));
+    memset(o->integral, 0, sizeof(o->integral));
+}
+
+void orientacao_define_escala(Orientacao *o, float sensibilidade_accel_lsb_g, float sensibilidade_gyro_lsb_dps)
+{
+    float sensibilidade_anterior = GRAUS_PARA_RAD / o->rad_por_lsb;
+    for (int i = 0; i < 3; i++)
+    {
+        o->bias_lsb[i] *= sensibilidade_gyro_lsb_dps / sensibilidade_anterior;
+    }
+    o->rad_por_lsb = GRAUS_PARA_RAD / sensibilidade_gyro_lsb_dps;
+    faixa_mag2(ORIENTACAO_FAIXA_CONFIANCA_G, sensibilidade_accel_lsb_g, &o->mag2_min, &o->mag2_max);
+}
+
+/* --------------------------------------------------------------------------
+ *  Quatérnio a partir só do acelerômetro (yaw = 0): rotação mínima que leva
+ *  a gravidade medida a (0, 0, 1). Usado na primeira amostra e após lacunas.
+ * -------------------------------------------------------------------------- */
+static void orientacao_reinicia(Orientacao *o, const Mpu6050Data *amostra)
+{
+    float ax = amostra->accel_x, ay = amostra->accel_y, az = amostra->accel_z;
+    float norma = sqrtf(ax * ax + ay * ay + az * az);
+
+    memset(o->integral, 0, sizeof(o->integral));
+    if (norma <= 0.0f)
+    {
+        o->q[0] = 1.0f;
+        o->q[1] = o->q[2] = o->q[3] = 0.0f;
+        return;
+    }
+    ax /= norma;
+    ay /= norma;
+    az /= norma;
+
+    /* q = (1 + a·z, a × z) normalizado; a = -z fica com rotação de 180 graus em x */
+    float w = 1.0f + az;
+    if (w < 1e-6f)
+    {
+        o->q[0] = 0.0f;
+        o->q[1] = 1.0f;
+        o->q[2] = o->q[3] = 0.0f;
+        return;
+    }
+    float inv = 1.0f / sqrtf(w * w + ay * ay + ax * ax);
+    o->q[0] = w * inv;
+    o->q[1] = ay * inv;
+    o->q[2] = -ax * inv;
+    o->q[3] = 0.0f;
+}
+
+/* --------------------------------------------------------------------------
+ *  Atualização de Mahony:
+ *   - v = gravidade estimada no corpo (terceira linha de R^T)
+ *   - e = â × v, só com |a| dentro da faixa de confiança
+ *   - ω' = ω - bias + kp·e + integral
+ *   - q += 0.5 · q ⊗ (0, ω') · dt, e normaliza
+ * -------------------------------------------------------------------------- */
+void orientacao_atualiza(Orientacao *o, const Mpu6050Data *amostra)
+{
+    int64_t agora = amostra->timestamp_us;
+    int64_t dt_us = agora - o->ultima_us;
+    o->ultima_us = agora;
+
+    if (!o->inicializado || dt_us <= 0 || dt_us > ORIENTACAO_LACUNA_MAX_US)
+    {
+        orientacao_reinicia(o, amostra);
+        o->inicializado = true;
+        return;
+    }
+
+    float dt = dt_us * 1e-6f;
+    float q0 = o->q[0], q1 = o->q[1], q2 = o->q[2], q3 = o->q[3];
+
+    float gx = (amostra->gyro_x - o->bias_lsb[0]) * o->rad_por_lsb;
+    float gy = (amostra->gyro_y - o->bias_lsb[1]) * o->rad_por_lsb;
+    float gz = (amostra->gyro_z - o->bias_lsb[2]) * o->rad_por_lsb;
+
+    uint32_t mag2 = magnitude2(amostra);
+    if (mag2 >= o->mag2_min && mag2 <= o->mag2_max)
+    {
+        float inv = 1.0f / sqrtf((float)mag2);
+        float ax = amostra->accel_x * inv;
+        float ay = amostra->accel_y * inv;
+        float az = amostra->accel_z * inv;
+
+        float vx = 2.0f * (q1 * q3 - q0 * q2);
+        float vy = 2.0f * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        if (o->ki > 0.0f)
+        {
+            o->integral[0] += o->ki * ex * dt;
+            o->integral[1] += o->ki * ey * dt;
+            o->integral[2] += o->ki * ez * dt;
+        }
+        gx += o->kp * ex;
+        gy += o->kp * ey;
+        gz += o->kp * ez;
+    }
+    gx += o->integral[0];
+    gy += o->integral[1];
+    gz += o->integral[2];
+
+    float h = 0.5f * dt;
+    gx *= h;
+    gy *= h;
+    gz *= h;
+    o->q[0] = q0 - q1 * gx - q2 * gy - q3 * gz;
+    o->q[1] = q1 + q0 * gx + q2 * gz - q3 * gy;
+    o->q[2] = q2 + q0 * gy - q1 * gz + q3 * gx;
+    o->q[3] = q3 + q0 * gz + q1 * gy - q2 * gx;
+
+    float norma = o->q[0] * o->q[0] + o->q[1] * o->q[1] + o->q[2] * o->q[2] + o->q[3] * o->q[3];
+    float inv = 1.0f / sqrtf(norma);
+    for (int i = 0; i < 4; i++)
+    {
+        o->q[i] *= inv;
+    }
+}
+
+void orientacao_gravidade(const Orientacao *o, float g[3])
+{
+    float q0 = o->q[0], q1 = o->q[1], q2 = o->q[2], q3 = o->q[3];
+    g[0] = 2.0f * (q1 * q3 - q0 * q2);
+    g[1] = 2.0f * (q0 * q1 + q2 * q3);
+    g[2] = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+}
+
+void orientacao_roll_pitch(const Orientacao *o, float *roll_graus, float *pitch_graus)
+{
+    float g[3];
+    orientacao_gravidade(o, g);
+    *roll_graus = atan2f(g[1], g[2]) * RAD_PARA_GRAUS;
+    *pitch_graus = atan2f(-g[0], sqrtf(g[1] * g[1] + g[2] * g[2])) * RAD_PARA_GRAUS;
+}
+
+float orientacao_angulo_graus(const float a[3], const float b[3])
+{
+    float cosseno = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    if (cosseno > 1.0f) cosseno = 1.0f;
+    if (cosseno < -1.0f) cosseno = -1.0f;
+    return acosf(cosseno) * RAD_PARA_GRAUS;
+}
+
+/* --------------------------------------------------------------------------
+ *  Calibração do bias: média do giroscópio em `alvo` amostras seguidas com
+ *  |a| perto de 1 g e variação pico-a-pico pequena em cada eixo. Qualquer
+ *  movimento recomeça a contagem.
+ * -------------------------------------------------------------------------- */
+static void calibracao_recomeca(OrientacaoCalibracao *c)
+{
+    memset(c->soma, 0, sizeof(c->soma));
+    c->amostras = 0;
+}
+
+void orientacao_calibracao_init(OrientacaoCalibracao *c, uint32_t amostras,
+                                float sensibilidade_accel_lsb_g, float sensibilidade_gyro_lsb_dps)
+{
+    memset(c, 0, sizeof(*c));
+    c->alvo = amostras;
+    c->variacao_max_lsb = (int32_t)(CALIBRACAO_VARIACAO_MAX_DPS * sensibilidade_gyro_lsb_dps);
+    faixa_mag2(ORIENTACAO_FAIXA_CONFIANCA_G, sensibilidade_accel_lsb_g, &c->mag2_min, &c->mag2_max);
+}
+
+bool orientacao_calibracao_adiciona(OrientacaoCalibracao *c, const Mpu6050Data *amostra, float bias_lsb[3])
+{
+    uint32_t mag2 = magnitude2(amostra);
+    int16_t g[3] = {amostra->gyro_x, amostra->gyro_y, amostra->gyro_z};
+
+    if (mag2 < c->mag2_min || mag2 > c->mag2_max)
+    {
+        calibracao_recomeca(c);
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        if (c->amostras == 0)
+        {
+            c->min[i] = c->max[i] = g[i];
+        }
+        else
+        {
+            if (g[i] < c->min[i]) c->min[i] = g[i];
+            if (g[i] > c->max[i]) c->max[i] = g[i];
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        if ((int32_t)c->max[i] - c->min[i] > c->variacao_max_lsb)
+        {
+            /* Recomeça a partir desta amostra */
+            calibracao_recomeca(c);
+            c->min[0] = c->max[0] = g[0];
+            c->min[1] = c->max[1] = g[1];
+            c->min[2] = c->max[2] = g[2];
+            break;
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        c->soma[i] += g[i];
+    }
+    c->amostras++;
+
+    if (c->amostras < c->alvo)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        bias_lsb[i] = (float)c->soma[i] / (float)c->amostras;
+    }
+    calibracao_recomeca(c);
+    return true;
+}
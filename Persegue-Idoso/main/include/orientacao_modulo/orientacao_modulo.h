@@ -0,0 +1,71 @@
+#ifndef ORIENTACAO_MODULO_H
+#define ORIENTACAO_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mpu6050_dados.h"
+
+/*
+ * Atitude por filtro complementar em quatérnio (Mahony): o giroscópio
+ * integra a rotação e o acelerômetro corrige a deriva de roll/pitch só
+ * quando |a| está perto de 1 g. Durante a queda livre e o impacto a
+ * estimativa segue apenas o giroscópio, em vez de ler a inclinação de uma
+ * aceleração que não é a gravidade.
+ *
+ * C puro e float de precisão simples (FPU do ESP32): sem trigonometria por
+ * amostra, uma raiz para normalizar |a| e outra para o quatérnio.
+ */
+
+#define ORIENTACAO_KP_PADRAO 1.0f        // Ganho proporcional da correção (rad/s por rad)
+#define ORIENTACAO_KI_PADRAO 0.02f       // Ganho integral: absorve deriva residual do bias
+#define ORIENTACAO_FAIXA_CONFIANCA_G 0.15f // Acelerômetro só corrige com |a| em 1 g ± faixa
+#define ORIENTACAO_ORCAMENTO_CICLOS 2000 // Orçamento por atualização no ESP32
+
+typedef struct
+{
+    float q[4];        // w, x, y, z: rotação do corpo para o referencial da Terra
+    float integral[3]; // Termo integral (rad/s)
+    float kp;
+    float ki;
+    float bias_lsb[3]; // Bias do giroscópio subtraído de cada amostra
+    float rad_por_lsb;
+    uint32_t mag2_min; // Faixa de |a|^2 (LSB^2) em que o acelerômetro corrige
+    uint32_t mag2_max;
+    int64_t ultima_us;
+    bool inicializado;
+} Orientacao;
+
+/* Média do giroscópio em trechos parados; recomeça se houver movimento */
+typedef struct
+{
+    int64_t soma[3];
+    int16_t min[3];
+    int16_t max[3];
+    uint32_t amostras;
+    uint32_t alvo;
+    uint32_t mag2_min;
+    uint32_t mag2_max;
+    int32_t variacao_max_lsb;
+} OrientacaoCalibracao;
+
+void orientacao_init(Orientacao *o, float sensibilidade_accel_lsb_g, float sensibilidade_gyro_lsb_dps,
+                     float kp, float ki);
+void orientacao_define_bias(Orientacao *o, const float bias_lsb[3]);
+/* Troca de faixa do sensor: o bias é convertido para a nova escala */
+void orientacao_define_escala(Orientacao *o, float sensibilidade_accel_lsb_g, float sensibilidade_gyro_lsb_dps);
+
+/* Uma amostra; o dt vem dos timestamps. Lacunas grandes reiniciam pelo acelerômetro */
+void orientacao_atualiza(Orientacao *o, const Mpu6050Data *amostra);
+
+/* Direção da gravidade no referencial do corpo (vetor unitário) */
+void orientacao_gravidade(const Orientacao *o, float g[3]);
+void orientacao_roll_pitch(const Orientacao *o, float *roll_graus, float *pitch_graus);
+/* Ângulo entre dois vetores unitários, em graus */
+float orientacao_angulo_graus(const float a[3], const float b[3]);
+
+void orientacao_calibracao_init(OrientacaoCalibracao *c, uint32_t amostras,
+                                float sensibilidade_accel_lsb_g, float sensibilidade_gyro_lsb_dps);
+/* Volta true quando `amostras` seguidas parado completam; `bias_lsb` recebe a média */
+bool orientacao_calibracao_adiciona(OrientacaoCalibracao *c, const Mpu6050Data *amostra, float bias_lsb[3]);
+
+#endif
@@ -0,0 +1,41 @@
+#include "esp_partition.h"
+#include "outbox_modulo.h"
+
+/* Subtipo de dados livre para uso da aplicação (0x40-0xFE) */
+#define OUTBOX_SUBTIPO_PARTICAO 0x40
+#define OUTBOX_NOME_PARTICAO "outbox"
+
+static esp_err_t particao_le(void *ctx, size_t endereco, void *destino, size_t tamanho)
+{
+    return esp_partition_read((const esp_partition_t *)ctx, endereco, destino, tamanho);
+}
+
+static esp_err_t particao_escreve(void *ctx, size_t endereco, const void *origem, size_t tamanho)
+{
+    return esp_partition_write((const esp_partition_t *)ctx, endereco, origem, tamanho);
+}
+
+static esp_err_t particao_apaga_setor(void *ctx, size_t endereco)
+{
+    const esp_partition_t *particao = ctx;
+    return esp_partition_erase_range(particao, endereco, particao->erase_size);
+}
+
+esp_err_t outbox_flash_particao(OutboxFlash *flash)
+{
+    const esp_partition_t *particao = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                               OUTBOX_SUBTIPO_PARTICAO,
+                                                               OUTBOX_NOME_PARTICAO);
+    if (particao == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    flash->le = particao_le;
+    flash->escreve = particao_escreve;
+    flash->apaga_setor = particao_apaga_setor;
+    flash->tamanho = particao->size;
+    flash->tamanho_setor = particao->erase_size;
+    flash->ctx = (void *)particao;
+    return ESP_OK;
+}
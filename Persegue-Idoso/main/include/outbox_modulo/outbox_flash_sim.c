@@ -0,0 +1,67 @@
+#include <string.h>
+#include "outbox_modulo.h"
+
+/* --------------------------------------------------------------------------
+ *  Flash simulada em RAM com a semântica de NOR: escrever só leva bits de
+ *  1 para 0 e apagar coloca o setor inteiro em 0xFF. Usada como reserva
+ *  quando a partição não existe e para exercitar o outbox no host.
+ * -------------------------------------------------------------------------- */
+static esp_err_t sim_le(void *ctx, size_t endereco, void *destino, size_t tamanho)
+{
+    OutboxFlashSim *sim = ctx;
+    if (endereco + tamanho > sim->tamanho)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(destino, sim->memoria + endereco, tamanho);
+    return ESP_OK;
+}
+
+static esp_err_t sim_escreve(void *ctx, size_t endereco, const void *origem, size_t tamanho)
+{
+    OutboxFlashSim *sim = ctx;
+    const uint8_t *bytes = origem;
+    if (endereco + tamanho > sim->tamanho)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < tamanho; i++)
+    {
+        if (bytes[i] & ~sim->memoria[endereco + i])
+        {
+            sim->escritas_invalidas++;
+        }
+        sim->memoria[endereco + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_apaga_setor(void *ctx, size_t endereco)
+{
+    OutboxFlashSim *sim = ctx;
+    if (endereco % sim->tamanho_setor != 0 || endereco + sim->tamanho_setor > sim->tamanho)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(sim->memoria + endereco, 0xFF, sim->tamanho_setor);
+    sim->apagamentos++;
+    return ESP_OK;
+}
+
+/* A memória começa apagada; para simular um reboot, chame de novo só outbox_abre */
+void outbox_flash_sim_init(OutboxFlashSim *sim, uint8_t *memoria, size_t tamanho, size_t tamanho_setor,
+                           OutboxFlash *flash)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->memoria = memoria;
+    sim->tamanho = tamanho;
+    sim->tamanho_setor = tamanho_setor;
+    memset(memoria, 0xFF, tamanho);
+
+    flash->le = sim_le;
+    flash->escreve = sim_escreve;
+    flash->apaga_setor = sim_apaga_setor;
+    flash->tamanho = tamanho;
+    flash->tamanho_setor = tamanho_setor;
+    flash->ctx = sim;
+}
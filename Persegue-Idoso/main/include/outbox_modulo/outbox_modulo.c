@@ -0,0 +1,597 @@
+#include <string.h>
+#include "outbox_modulo.h"
+
+#define SEG_MAGICO 0x3158424FU  // "OBX1"
+#define SEG_LIVRE 0xFFFFFFFFU
+
+/* Estados do registro: cada transição só zera bits */
+#define REG_LIVRE 0xFFFFFFFFU
+#define REG_GRAVANDO 0x0000FFFFU
+#define REG_VALIDO 0x000000FFU
+#define REG_ENVIADO 0x00000000U
+
+typedef struct {
+    uint32_t magico;
+    uint32_t seq;
+    uint32_t apagamentos;
+    uint32_t reservado;
+} SegmentoCabecalho;
+
+typedef struct {
+    uint32_t estado;
+    uint16_t tamanho;
+    uint8_t topico_len;
+    uint8_t prioridade;
+    uint32_t crc;
+} RegistroCabecalho;
+
+#define SEG_CABECALHO ((uint32_t)sizeof(SegmentoCabecalho))
+#define REG_CABECALHO ((uint32_t)sizeof(RegistroCabecalho))
+
+/* Resultado da leitura de um registro */
+typedef enum {
+    REGISTRO_OK,
+    REGISTRO_FIM,       // Fim dos dados do segmento
+} RegistroLeitura;
+
+static uint32_t alinha4(uint32_t v)
+{
+    return (v + 3) & ~3U;
+}
+
+static uint32_t crc32_atualiza(uint32_t crc, const uint8_t *dados, size_t tamanho)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < tamanho; i++)
+    {
+        crc ^= dados[i];
+        for (int b = 0; b < 8; b++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static size_t endereco(const Outbox *o, uint32_t seg, uint32_t off)
+{
+    return (size_t)seg * o->flash.tamanho_setor + off;
+}
+
+static uint32_t proximo_seg(const Outbox *o, uint32_t seg)
+{
+    return (seg + 1) % o->n_segmentos;
+}
+
+static esp_err_t le_segmento(const Outbox *o, uint32_t seg, SegmentoCabecalho *cab)
+{
+    return o->flash.le(o->flash.ctx, endereco(o, seg, 0), cab, sizeof(*cab));
+}
+
+static uint32_t tamanho_registro(const RegistroCabecalho *cab)
+{
+    return alinha4(REG_CABECALHO + cab->topico_len + cab->tamanho);
+}
+
+static RegistroLeitura le_registro(const Outbox *o, uint32_t seg, uint32_t off, RegistroCabecalho *cab)
+{
+    if (off + REG_CABECALHO > o->flash.tamanho_setor)
+    {
+        return REGISTRO_FIM;
+    }
+    if (o->flash.le(o->flash.ctx, endereco(o, seg, off), cab, sizeof(*cab)) != ESP_OK)
+    {
+        return REGISTRO_FIM;
+    }
+    if (cab->estado == REG_LIVRE)
+    {
+        return REGISTRO_FIM;
+    }
+    // Estado desconhecido ou tamanho fora do setor: resto do segmento é ilegível
+    if ((cab->estado != REG_GRAVANDO && cab->estado != REG_VALIDO && cab->estado != REG_ENVIADO) ||
+        cab->topico_len > OUTBOX_TOPICO_MAX || off + tamanho_registro(cab) > o->flash.tamanho_setor)
+    {
+        return REGISTRO_FIM;
+    }
+    return REGISTRO_OK;
+}
+
+static esp_err_t escreve_estado(Outbox *o, uint32_t seg, uint32_t off, uint32_t estado)
+{
+    return o->flash.escreve(o->flash.ctx, endereco(o, seg, off), &estado, sizeof(estado));
+}
+
+static bool setor_em_branco(const Outbox *o, uint32_t seg)
+{
+    uint32_t bloco[32];
+    for (uint32_t off = 0; off < o->flash.tamanho_setor; off += sizeof(bloco))
+    {
+        uint32_t resto = o->flash.tamanho_setor - off;
+        size_t tamanho = resto < sizeof(bloco) ? resto : sizeof(bloco);
+        if (o->flash.le(o->flash.ctx, endereco(o, seg, off), bloco, tamanho) != ESP_OK)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < tamanho / sizeof(bloco[0]); i++)
+        {
+            if (bloco[i] != 0xFFFFFFFFU)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Conta os registros ainda pendentes de um segmento */
+static void conta_pendentes(Outbox *o, uint32_t seg, uint32_t *pendentes, uint32_t *prioritarios)
+{
+    RegistroCabecalho cab;
+    uint32_t off = SEG_CABECALHO;
+    *pendentes = 0;
+    *prioritarios = 0;
+
+    while (le_registro(o, seg, off, &cab) == REGISTRO_OK)
+    {
+        if (cab.estado == REG_VALIDO)
+        {
+            (*pendentes)++;
+            if (cab.prioridade)
+            {
+                (*prioritarios)++;
+            }
+        }
+        off += tamanho_registro(&cab);
+    }
+}
+
+/*
+ * Prepara o segmento para escrita: descarta o que ainda estiver pendente
+ * nele (partição cheia), apaga se preciso e grava o cabeçalho com a
+ * próxima sequência. O contador de apagamentos sobrevive ao apagamento.
+ */
+static esp_err_t abre_segmento(Outbox *o, uint32_t seg)
+{
+    SegmentoCabecalho cab;
+    esp_err_t err = le_segmento(o, seg, &cab);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    uint32_t apagamentos = 0;
+    bool apagar = true;
+
+    if (cab.magico == SEG_MAGICO)
+    {
+        uint32_t pendentes, prioritarios;
+        conta_pendentes(o, seg, &pendentes, &prioritarios);
+        o->estatisticas.descartados += pendentes;
+        o->estatisticas.pendentes -= pendentes;
+        o->estatisticas.pendentes_prioritarios -= prioritarios;
+        apagamentos = cab.apagamentos;
+
+        // O mais antigo foi descartado: a leitura continua no seguinte
+        if (o->seg_leitura == seg)
+        {
+            o->seg_leitura = proximo_seg(o, seg);
+            o->off_leitura = SEG_CABECALHO;
+        }
+    }
+    else if (cab.magico == SEG_LIVRE)
+    {
+        apagar = !setor_em_branco(o, seg);
+    }
+
+    if (apagar)
+    {
+        err = o->flash.apaga_setor(o->flash.ctx, endereco(o, seg, 0));
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        apagamentos++;
+    }
+
+    SegmentoCabecalho novo = {
+        .magico = SEG_MAGICO,
+        .seq = o->seq_escrita + 1,
+        .apagamentos = apagamentos,
+        .reservado = 0xFFFFFFFFU,
+    };
+    err = o->flash.escreve(o->flash.ctx, endereco(o, seg, 0), &novo, sizeof(novo));
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    if (apagamentos > o->estatisticas.apagamentos_max)
+    {
+        o->estatisticas.apagamentos_max = apagamentos;
+    }
+    o->seq_escrita = novo.seq;
+    o->seg_escrita = seg;
+    o->off_escrita = SEG_CABECALHO;
+    o->escrita_aberta = true;
+    return ESP_OK;
+}
+
+/* --------------------------------------------------------------------------
+ *  Abertura: reconstrói cabeças de escrita/leitura e contadores a partir
+ *  da flash. Segmentos em uso formam uma sequência contínua no anel.
+ * -------------------------------------------------------------------------- */
+esp_err_t outbox_abre(Outbox *outbox, const OutboxFlash *flash)
+{
+    memset(outbox, 0, sizeof(*outbox));
+    outbox->flash = *flash;
+
+    if (flash->tamanho_setor < 256 || flash->tamanho_setor % sizeof(uint32_t) != 0)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    outbox->n_segmentos = flash->tamanho / flash->tamanho_setor;
+    if (outbox->n_segmentos < 2)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    bool algum_usado = false;
+    uint32_t seg_antigo = 0, seq_antiga = 0;
+    uint32_t seg_recente = 0, seq_recente = 0;
+
+    for (uint32_t seg = 0; seg < outbox->n_segmentos; seg++)
+    {
+        SegmentoCabecalho cab;
+        esp_err_t err = le_segmento(outbox, seg, &cab);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+
+        if (cab.magico == SEG_MAGICO)
+        {
+            if (!algum_usado || cab.seq < seq_antiga)
+            {
+                seg_antigo = seg;
+                seq_antiga = cab.seq;
+            }
+            if (!algum_usado || cab.seq > seq_recente)
+            {
+                seg_recente = seg;
+                seq_recente = cab.seq;
+            }
+            if (cab.apagamentos > outbox->estatisticas.apagamentos_max)
+            {
+                outbox->estatisticas.apagamentos_max = cab.apagamentos;
+            }
+            algum_usado = true;
+        }
+        else if (cab.magico != SEG_LIVRE)
+        {
+            // Cabeçalho corrompido (apagamento interrompido): volta a ser livre
+            err = flash->apaga_setor(flash->ctx, endereco(outbox, seg, 0));
+            if (err != ESP_OK)
+            {
+                return err;
+            }
+        }
+    }
+
+    if (!algum_usado)
+    {
+        outbox->seg_escrita = 0;
+        outbox->off_escrita = SEG_CABECALHO;
+        outbox->seg_leitura = 0;
+        outbox->off_leitura = SEG_CABECALHO;
+        return ESP_OK;
+    }
+
+    outbox->seg_escrita = seg_recente;
+    outbox->seq_escrita = seq_recente;
+    outbox->escrita_aberta = true;
+    outbox->seg_leitura = seg_antigo;
+    outbox->off_leitura = SEG_CABECALHO;
+
+    RegistroCabecalho reg;
+    uint32_t off = SEG_CABECALHO;
+    while (le_registro(outbox, seg_recente, off, &reg) == REGISTRO_OK)
+    {
+        off += tamanho_registro(&reg);
+    }
+    outbox->off_escrita = off;
+
+    // Lixo depois do último registro (cabeçalho gravado pela metade): não escreve por cima
+    if (off + REG_CABECALHO <= flash->tamanho_setor)
+    {
+        const uint8_t *bytes = (const uint8_t *)&reg;
+        flash->le(flash->ctx, endereco(outbox, seg_recente, off), &reg, sizeof(reg));
+        for (size_t i = 0; i < sizeof(reg); i++)
+        {
+            if (bytes[i] != 0xFF)
+            {
+                outbox->off_escrita = flash->tamanho_setor;
+                break;
+            }
+        }
+    }
+
+    // Percorre do mais antigo ao mais recente contando pendentes
+    uint32_t seg = seg_antigo;
+    uint32_t seq_esperada = seq_antiga;
+    bool leitura_definida = false;
+    while (true)
+    {
+        SegmentoCabecalho cab;
+        le_segmento(outbox, seg, &cab);
+        if (cab.magico != SEG_MAGICO || cab.seq != seq_esperada)
+        {
+            break;
+        }
+
+        off = SEG_CABECALHO;
+        while (le_registro(outbox, seg, off, &reg) == REGISTRO_OK)
+        {
+            if (reg.estado == REG_VALIDO)
+            {
+                outbox->estatisticas.pendentes++;
+                if (reg.prioridade)
+                {
+                    outbox->estatisticas.pendentes_prioritarios++;
+                }
+                if (!leitura_definida)
+                {
+                    outbox->seg_leitura = seg;
+                    outbox->off_leitura = off;
+                    leitura_definida = true;
+                }
+            }
+            else if (reg.estado == REG_GRAVANDO)
+            {
+                outbox->estatisticas.corrompidos++;
+            }
+            off += tamanho_registro(&reg);
+        }
+
+        if (seg == seg_recente)
+        {
+            break;
+        }
+        seg = proximo_seg(outbox, seg);
+        seq_esperada++;
+    }
+
+    if (!leitura_definida)
+    {
+        outbox->seg_leitura = outbox->seg_escrita;
+        outbox->off_leitura = outbox->off_escrita;
+    }
+    return ESP_OK;
+}
+
+esp_err_t outbox_grava(Outbox *outbox, const char *topico, const uint8_t *dados, size_t tamanho, bool prioritaria)
+{
+    size_t topico_len = strlen(topico);
+    if (topico_len > OUTBOX_TOPICO_MAX || tamanho > UINT16_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    RegistroCabecalho cab = {
+        .estado = REG_GRAVANDO,
+        .tamanho = (uint16_t)tamanho,
+        .topico_len = (uint8_t)topico_len,
+        .prioridade = prioritaria ? 1 : 0,
+    };
+    uint32_t total = tamanho_registro(&cab);
+    if (total > outbox->flash.tamanho_setor - SEG_CABECALHO)
+    {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t err;
+    if (!outbox->escrita_aberta)
+    {
+        err = abre_segmento(outbox, outbox->seg_escrita);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    if (outbox->off_escrita + total > outbox->flash.tamanho_setor)
+    {
+        err = abre_segmento(outbox, proximo_seg(outbox, outbox->seg_escrita));
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+
+    cab.crc = crc32_atualiza(crc32_atualiza(0, (const uint8_t *)topico, topico_len), dados, tamanho);
+
+    // Cabeçalho, tópico e dados; só então o registro passa a válido
+    size_t base = endereco(outbox, outbox->seg_escrita, outbox->off_escrita);
+    err = outbox->flash.escreve(outbox->flash.ctx, base, &cab, sizeof(cab));
+    if (err == ESP_OK && topico_len > 0)
+    {
+        err = outbox->flash.escreve(outbox->flash.ctx, base + REG_CABECALHO, topico, topico_len);
+    }
+    if (err == ESP_OK && tamanho > 0)
+    {
+        err = outbox->flash.escreve(outbox->flash.ctx, base + REG_CABECALHO + topico_len, dados, tamanho);
+    }
+    if (err == ESP_OK)
+    {
+        err = escreve_estado(outbox, outbox->seg_escrita, outbox->off_escrita, REG_VALIDO);
+    }
+
+    // Mesmo com erro o espaço foi consumido; o registro fica como gravação interrompida
+    outbox->off_escrita += total;
+    if (err != ESP_OK)
+    {
+        outbox->estatisticas.corrompidos++;
+        return err;
+    }
+
+    outbox->estatisticas.pendentes++;
+    if (prioritaria)
+    {
+        outbox->estatisticas.pendentes_prioritarios++;
+    }
+    return ESP_OK;
+}
+
+/*
+ * Próxima mensagem a reenviar: alertas prioritários primeiro, depois o
+ * restante na ordem de gravação. A mensagem só sai da fila com
+ * outbox_confirma, depois que o envio deu certo.
+ */
+esp_err_t outbox_proxima(Outbox *outbox, OutboxMensagem *mensagem, uint8_t *buffer, size_t tamanho)
+{
+    while (outbox->estatisticas.pendentes > 0)
+    {
+        bool so_prioritarias = outbox->estatisticas.pendentes_prioritarios > 0;
+        bool em_ordem = true;   // Nada pendente visto ainda: a cabeça de leitura acompanha
+        bool achou = false;
+        uint32_t seg = outbox->seg_leitura;
+        uint32_t off = outbox->off_leitura;
+        uint32_t saltos = 0;
+        RegistroCabecalho cab;
+
+        while (!(seg == outbox->seg_escrita && off >= outbox->off_escrita))
+        {
+            if (le_registro(outbox, seg, off, &cab) != REGISTRO_OK)
+            {
+                if (seg == outbox->seg_escrita || ++saltos > outbox->n_segmentos)
+                {
+                    break;
+                }
+                seg = proximo_seg(outbox, seg);
+                off = SEG_CABECALHO;
+            }
+            else if (cab.estado == REG_VALIDO && (!so_prioritarias || cab.prioridade))
+            {
+                achou = true;
+                break;
+            }
+            else
+            {
+                if (cab.estado == REG_VALIDO)
+                {
+                    em_ordem = false;
+                }
+                off += tamanho_registro(&cab);
+            }
+
+            if (em_ordem)
+            {
+                outbox->seg_leitura = seg;
+                outbox->off_leitura = off;
+            }
+        }
+
+        if (!achou)
+        {
+            // Contadores divergentes da flash: corrige e tenta de novo sem prioridade
+            if (so_prioritarias)
+            {
+                outbox->estatisticas.pendentes_prioritarios = 0;
+                continue;
+            }
+            outbox->estatisticas.pendentes = 0;
+            break;
+        }
+
+        if ((size_t)cab.topico_len + 1 + cab.tamanho > tamanho)
+        {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        size_t base = endereco(outbox, seg, off) + REG_CABECALHO;
+        esp_err_t err = outbox->flash.le(outbox->flash.ctx, base, buffer, cab.topico_len);
+        if (err == ESP_OK)
+        {
+            err = outbox->flash.le(outbox->flash.ctx, base + cab.topico_len, buffer + cab.topico_len + 1, cab.tamanho);
+        }
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        buffer[cab.topico_len] = '\0';
+
+        uint32_t crc = crc32_atualiza(crc32_atualiza(0, buffer, cab.topico_len), buffer + cab.topico_len + 1, cab.tamanho);
+        if (crc != cab.crc)
+        {
+            escreve_estado(outbox, seg, off, REG_ENVIADO);
+            outbox->estatisticas.corrompidos++;
+            outbox->estatisticas.pendentes--;
+            if (cab.prioridade)
+            {
+                outbox->estatisticas.pendentes_prioritarios--;
+            }
+            continue;
+        }
+
+        mensagem->topico = (const char *)buffer;
+        mensagem->dados = buffer + cab.topico_len + 1;
+        mensagem->tamanho = cab.tamanho;
+        mensagem->prioritaria = cab.prioridade != 0;
+        mensagem->segmento = seg;
+        mensagem->offset = off;
+        return ESP_OK;
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t outbox_confirma(Outbox *outbox, const OutboxMensagem *mensagem)
+{
+    RegistroCabecalho cab;
+    if (le_registro(outbox, mensagem->segmento, mensagem->offset, &cab) != REGISTRO_OK || cab.estado != REG_VALIDO)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = escreve_estado(outbox, mensagem->segmento, mensagem->offset, REG_ENVIADO);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    outbox->estatisticas.pendentes--;
+    if (cab.prioridade)
+    {
+        outbox->estatisticas.pendentes_prioritarios--;
+    }
+    return ESP_OK;
+}
+
+bool outbox_vazia(const Outbox *outbox)
+{
+    return outbox->estatisticas.pendentes == 0;
+}
+
+/* Ocupação = do primeiro pendente até a cabeça de escrita (inclui enviados intercalados) */
+void outbox_estatisticas(const Outbox *outbox, OutboxEstatisticas *estatisticas)
+{
+    *estatisticas = outbox->estatisticas;
+    estatisticas->bytes_total = outbox->n_segmentos * outbox->flash.tamanho_setor;
+
+    if (outbox->estatisticas.pendentes == 0)
+    {
+        estatisticas->bytes_usados = 0;
+    }
+    else if (outbox->seg_leitura == outbox->seg_escrita && outbox->off_leitura <= outbox->off_escrita)
+    {
+        estatisticas->bytes_usados = outbox->off_escrita - outbox->off_leitura;
+    }
+    else
+    {
+        uint32_t distancia = (outbox->seg_escrita + outbox->n_segmentos - outbox->seg_leitura) % outbox->n_segmentos;
+        if (distancia == 0)
+        {
+            distancia = outbox->n_segmentos;
+        }
+        estatisticas->bytes_usados = (outbox->flash.tamanho_setor - outbox->off_leitura) +
+                                     (distancia - 1) * outbox->flash.tamanho_setor + outbox->off_escrita;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef OUTBOX_MODULO_H
+#define OUTBOX_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/*
+ * Fila persistente de mensagens de saída (store-and-forward).
+ *
+ * Log circular em flash dividido em segmentos do tamanho de um setor.
+ * Cada segmento começa com um cabeçalho (número de sequência e contador
+ * de apagamentos); os registros só são acrescentados. O estado de cada
+ * registro evolui apenas zerando bits (gravando -> válido -> enviado),
+ * então marcar como enviado não apaga nada. Um segmento só é apagado
+ * quando o escritor precisa dele de novo, e os segmentos são usados em
+ * rodízio, o que distribui o desgaste por toda a partição.
+ *
+ * Com a partição cheia o segmento mais antigo é descartado.
+ *
+ * O módulo não conhece ESP-IDF além de esp_err_t: o acesso à flash é
+ * feito pela interface OutboxFlash, implementada para a partição real
+ * (outbox_flash_particao) e para uma flash simulada em RAM
+ * (outbox_flash_sim), que também serve para rodar no host.
+ * Não é thread-safe; quem usa serializa as chamadas.
+ */
+
+#define OUTBOX_TOPICO_MAX 63
+
+typedef struct {
+    esp_err_t (*le)(void *ctx, size_t endereco, void *destino, size_t tamanho);
+    esp_err_t (*escreve)(void *ctx, size_t endereco, const void *origem, size_t tamanho);
+    esp_err_t (*apaga_setor)(void *ctx, size_t endereco);
+    size_t tamanho;
+    size_t tamanho_setor;
+    void *ctx;
+} OutboxFlash;
+
+typedef struct {
+    uint32_t bytes_usados;      // Segmentos ocupados, em bytes
+    uint32_t bytes_total;
+    uint32_t pendentes;
+    uint32_t pendentes_prioritarios;
+    uint32_t descartados;       // Perdidos por falta de espaço
+    uint32_t corrompidos;       // CRC inválido ou gravação interrompida
+    uint32_t apagamentos_max;   // Maior contador de apagamentos entre os segmentos
+} OutboxEstatisticas;
+
+typedef struct {
+    OutboxFlash flash;
+    uint32_t n_segmentos;
+    uint32_t seg_escrita;
+    uint32_t off_escrita;
+    uint32_t seq_escrita;
+    bool escrita_aberta;        // Segmento de escrita já tem cabeçalho
+    uint32_t seg_leitura;       // Primeiro registro possivelmente pendente, em ordem
+    uint32_t off_leitura;
+    OutboxEstatisticas estatisticas;
+} Outbox;
+
+/* Mensagem lida por outbox_proxima; topico e dados apontam para o buffer do chamador */
+typedef struct {
+    const char *topico;
+    const uint8_t *dados;
+    size_t tamanho;
+    bool prioritaria;
+    uint32_t segmento;
+    uint32_t offset;
+} OutboxMensagem;
+
+esp_err_t outbox_abre(Outbox *outbox, const OutboxFlash *flash);
+esp_err_t outbox_grava(Outbox *outbox, const char *topico, const uint8_t *dados, size_t tamanho, bool prioritaria);
+esp_err_t outbox_proxima(Outbox *outbox, OutboxMensagem *mensagem, uint8_t *buffer, size_t tamanho);
+esp_err_t outbox_confirma(Outbox *outbox, const OutboxMensagem *mensagem);
+bool outbox_vazia(const Outbox *outbox);
+void outbox_estatisticas(const Outbox *outbox, OutboxEstatisticas *estatisticas);
+
+/* Flash simulada em RAM: só zera bits na escrita, apaga por setor */
+typedef struct {
+    uint8_t *memoria;
+    size_t tamanho;
+    size_t tamanho_setor;
+    uint32_t apagamentos;
+    uint32_t escritas_invalidas;  // Tentativas de levar bit 0 -> 1
+} OutboxFlashSim;
+
+void outbox_flash_sim_init(OutboxFlashSim *sim, uint8_t *memoria, size_t tamanho, size_t tamanho_setor,
+                           OutboxFlash *flash);
+
+/* Partição de dados "outbox" (partitions.csv) */
+esp_err_t outbox_flash_particao(OutboxFlash *flash);
+
+#endif
@@ -0,0 +1,61 @@
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "perfil_boot_modulo.h"
+
+#define TAG "BOOT"
+
+static const char *s_nomes[BOOT_NUM_FASES] = {
+    [BOOT_APP_MAIN] = "app_main",
+    [BOOT_NVS_PRONTO] = "NVS pronto",
+    [BOOT_TASKS_SENSORES] = "tasks dos sensores criadas",
+    [BOOT_WIFI_INICIADO] = "Wi-Fi iniciado",
+    [BOOT_IMU_PRONTO] = "MPU6050 pronto",
+    [BOOT_PRIMEIRA_AMOSTRA] = "primeira amostra do IMU",
+    [BOOT_GPS_PRONTO] = "GPS pronto",
+    [BOOT_PRIMEIRO_FIX] = "primeiro fix",
+    [BOOT_IP_OBTIDO] = "IP obtido",
+    [BOOT_MQTT_CONECTADO] = "MQTT conectado",
+    [BOOT_PRIMEIRO_PUBLISH] = "primeiro publish",
+};
+
+// 0 = fase ainda não ocorreu (esp_timer já está acima de 0 quando app_main roda)
+static _Atomic int64_t s_instantes[BOOT_NUM_FASES];
+
+void perfil_boot_marca(BootFase fase)
+{
+    int64_t esperado = 0;
+    if (atomic_load_explicit(&s_instantes[fase], memory_order_relaxed) != 0)
+    {
+        return;
+    }
+    if (atomic_compare_exchange_strong(&s_instantes[fase], &esperado, esp_timer_get_time()) &&
+        fase == BOOT_PRIMEIRO_PUBLISH)
+    {
+        // Última fase relevante: o perfil completo sai uma vez no log
+        perfil_boot_loga();
+    }
+}
+
+int64_t perfil_boot_instante(BootFase fase)
+{
+    int64_t instante = atomic_load(&s_instantes[fase]);
+    return instante != 0 ? instante : -1;
+}
+
+void perfil_boot_loga(void)
+{
+    ESP_LOGI(TAG, "Perfil de boot (ms desde o reset):");
+    for (int fase = 0; fase < BOOT_NUM_FASES; fase++)
+    {
+        int64_t instante = perfil_boot_instante(fase);
+        if (instante < 0)
+        {
+            ESP_LOGI(TAG, "  %-28s      -", s_nomes[fase]);
+        }
+        else
+        {
+            ESP_LOGI(TAG, "  %-28s %6lld", s_nomes[fase], (long long)(instante / 1000));
+        }
+    }
+}
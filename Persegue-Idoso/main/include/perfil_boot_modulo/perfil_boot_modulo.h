@@ -0,0 +1,28 @@
+#ifndef PERFIL_BOOT_MODULO_H
+#define PERFIL_BOOT_MODULO_H
+
+#include <stdint.h>
+
+/* Fases da inicialização; cada uma guarda o instante da primeira vez que ocorre */
+typedef enum {
+    BOOT_APP_MAIN,
+    BOOT_NVS_PRONTO,
+    BOOT_TASKS_SENSORES,
+    BOOT_WIFI_INICIADO,
+    BOOT_IMU_PRONTO,
+    BOOT_PRIMEIRA_AMOSTRA,
+    BOOT_GPS_PRONTO,
+    BOOT_PRIMEIRO_FIX,
+    BOOT_IP_OBTIDO,
+    BOOT_MQTT_CONECTADO,
+    BOOT_PRIMEIRO_PUBLISH,
+    BOOT_NUM_FASES
+} BootFase;
+
+/* Barata e segura de qualquer task; só a primeira marcação de cada fase conta */
+void perfil_boot_marca(BootFase fase);
+/* Instante da fase em us desde o boot, ou -1 se ainda não ocorreu */
+int64_t perfil_boot_instante(BootFase fase);
+void perfil_boot_loga(void);
+
+#endif
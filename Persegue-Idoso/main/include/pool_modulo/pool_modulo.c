@@ -0,0 +1,206 @@
+#include "pool_modulo.h"
+#include <string.h>
+
+#define POOL_FIM_LISTA(pool) ((pool)->quantidade)
+
+#ifdef CONFIG_POOL_DEPURACAO
+#define POOL_PADRAO_LIVRE 0xA5
+static const uint8_t s_sentinela[POOL_SENTINELA_BYTES] = {0xDE, 0xC0, 0xAD, 0x0B};
+#endif
+
+static uint8_t *pool_endereco(const Pool *pool, uint16_t indice)
+{
+    return pool->memoria + (size_t)indice * pool->passo;
+}
+
+/* Índice do bloco ou quantidade se o ponteiro não for início de um bloco do pool */
+static uint16_t pool_indice(const Pool *pool, const void *bloco)
+{
+    const uint8_t *p = bloco;
+    if (p < pool->memoria || p >= pool_endereco(pool, pool->quantidade))
+    {
+        return POOL_FIM_LISTA(pool);
+    }
+    size_t deslocamento = (size_t)(p - pool->memoria);
+    if (deslocamento % pool->passo != 0)
+    {
+        return POOL_FIM_LISTA(pool);
+    }
+    return (uint16_t)(deslocamento / pool->passo);
+}
+
+/* --------------------------------------------------------------------------
+ *  Depuração: sentinela depois dos dados e padrão nos blocos livres
+ * -------------------------------------------------------------------------- */
+#ifdef CONFIG_POOL_DEPURACAO
+static bool pool_sentinela_ok(const Pool *pool, uint16_t indice)
+{
+    return memcmp(pool_endereco(pool, indice) + pool->tamanho_bloco, s_sentinela, POOL_SENTINELA_BYTES) == 0;
+}
+
+static bool pool_padrao_ok(const Pool *pool, uint16_t indice)
+{
+    const uint8_t *p = pool_endereco(pool, indice);
+    for (size_t i = 0; i < pool->tamanho_bloco; i++)
+    {
+        if (p[i] != POOL_PADRAO_LIVRE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+static void pool_marca_livre(Pool *pool, uint16_t indice)
+{
+#ifdef CONFIG_POOL_DEPURACAO
+    uint8_t *p = pool_endereco(pool, indice);
+    memset(p, POOL_PADRAO_LIVRE, pool->tamanho_bloco);
+    memcpy(p + pool->tamanho_bloco, s_sentinela, POOL_SENTINELA_BYTES);
+#endif
+    pool->blocos[indice].dono = POOL_LIVRE;
+    pool->blocos[indice].proximo = pool->livre;
+    pool->livre = indice;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void pool_init(Pool *pool, uint8_t *memoria, PoolBloco *blocos, size_t tamanho_bloco, uint16_t quantidade)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->memoria = memoria;
+    pool->blocos = blocos;
+    pool->tamanho_bloco = tamanho_bloco;
+    pool->passo = POOL_PASSO(tamanho_bloco);
+    pool->quantidade = quantidade;
+    pool->livre = POOL_FIM_LISTA(pool);
+
+    // De trás para frente: a primeira alocação pega o bloco 0
+    for (uint16_t i = quantidade; i > 0; i--)
+    {
+        pool_marca_livre(pool, (uint16_t)(i - 1));
+    }
+}
+
+void *pool_aloca(Pool *pool, uint8_t dono)
+{
+    if (pool->livre == POOL_FIM_LISTA(pool))
+    {
+        pool->estatisticas.sem_bloco++;
+        return NULL;
+    }
+
+    uint16_t indice = pool->livre;
+    PoolBloco *b = &pool->blocos[indice];
+    pool->livre = b->proximo;
+
+#ifdef CONFIG_POOL_DEPURACAO
+    if (!pool_padrao_ok(pool, indice) || !pool_sentinela_ok(pool, indice))
+    {
+        // Alguém escreveu no bloco depois de liberar; o bloco serve mesmo assim
+        pool->estatisticas.estouros++;
+        memcpy(pool_endereco(pool, indice) + pool->tamanho_bloco, s_sentinela, POOL_SENTINELA_BYTES);
+    }
+#endif
+
+    b->dono = dono;
+    b->geracao = ++pool->estatisticas.alocacoes;
+    pool->estatisticas.em_uso++;
+    if (pool->estatisticas.em_uso > pool->estatisticas.em_uso_max)
+    {
+        pool->estatisticas.em_uso_max = pool->estatisticas.em_uso;
+    }
+    return pool_endereco(pool, indice);
+}
+
+esp_err_t pool_transfere(Pool *pool, void *bloco, uint8_t de, uint8_t para)
+{
+    uint16_t indice = pool_indice(pool, bloco);
+    if (indice == POOL_FIM_LISTA(pool) || pool->blocos[indice].dono != de || de == POOL_LIVRE)
+    {
+        pool->estatisticas.violacoes++;
+        return indice == POOL_FIM_LISTA(pool) ? ESP_ERR_INVALID_ARG : ESP_ERR_INVALID_STATE;
+    }
+#ifdef CONFIG_POOL_DEPURACAO
+    if (!pool_sentinela_ok(pool, indice))
+    {
+        pool->estatisticas.estouros++;
+    }
+#endif
+    pool->blocos[indice].dono = para;
+    return ESP_OK;
+}
+
+esp_err_t pool_libera(Pool *pool, void *bloco, uint8_t dono)
+{
+    uint16_t indice = pool_indice(pool, bloco);
+    if (indice == POOL_FIM_LISTA(pool))
+    {
+        pool->estatisticas.violacoes++;
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pool->blocos[indice].dono == POOL_LIVRE || pool->blocos[indice].dono != dono)
+    {
+        pool->estatisticas.violacoes++;
+        return ESP_ERR_INVALID_STATE;
+    }
+#ifdef CONFIG_POOL_DEPURACAO
+    if (!pool_sentinela_ok(pool, indice))
+    {
+        pool->estatisticas.estouros++;
+    }
+#endif
+    pool->estatisticas.em_uso--;
+    pool_marca_livre(pool, indice);
+    return ESP_OK;
+}
+
+uint8_t pool_dono(const Pool *pool, const void *bloco)
+{
+    uint16_t indice = pool_indice(pool, bloco);
+    return indice == POOL_FIM_LISTA(pool) ? POOL_LIVRE : pool->blocos[indice].dono;
+}
+
+uint16_t pool_livres(const Pool *pool)
+{
+    return (uint16_t)(pool->quantidade - pool->estatisticas.em_uso);
+}
+
+size_t pool_verifica(Pool *pool, uint32_t idade_max, pool_suspeito_t suspeito, void *ctx)
+{
+    size_t problemas = 0;
+
+    for (uint16_t i = 0; i < pool->quantidade; i++)
+    {
+        const PoolBloco *b = &pool->blocos[i];
+        if (b->dono == POOL_LIVRE)
+        {
+            continue;
+        }
+#ifdef CONFIG_POOL_DEPURACAO
+        if (!pool_sentinela_ok(pool, i))
+        {
+            // Conta uma vez: a sentinela é refeita e o próximo estouro aparece de novo
+            pool->estatisticas.estouros++;
+            memcpy(pool_endereco(pool, i) + pool->tamanho_bloco, s_sentinela, POOL_SENTINELA_BYTES);
+            problemas++;
+        }
+#endif
+        uint32_t idade = pool->estatisticas.alocacoes - b->geracao;
+        if (idade > idade_max)
+        {
+            if (suspeito != NULL)
+            {
+                suspeito(ctx, i, b->dono, idade);
+            }
+            problemas++;
+        }
+    }
+    return problemas;
+}
+
+void pool_estatisticas(const Pool *pool, PoolEstatisticas *estatisticas)
+{
+    *estatisticas = pool->estatisticas;
+}
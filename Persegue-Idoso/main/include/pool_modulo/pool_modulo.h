@@ -0,0 +1,102 @@
+#ifndef POOL_MODULO_H
+#define POOL_MODULO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+/*
+ * Pool de blocos de tamanho fixo sobre memória estática: alocar e liberar
+ * são O(1), nunca tocam o heap e não fragmentam. A memória é declarada
+ * com POOL_DEFINE no módulo dono e dimensionada pelo Kconfig.
+ *
+ * Cada bloco tem um dono (tag definida por quem usa, POOL_LIVRE = livre).
+ * Passar um bloco entre tarefas é um pool_transfere(de, para): com a tag
+ * errada a transferência é recusada, o que pega bloco usado depois de
+ * entregue e liberação dupla.
+ *
+ * Com CONFIG_POOL_DEPURACAO cada bloco ganha uma sentinela depois dos
+ * dados (estouro) e os blocos livres são preenchidos com um padrão
+ * conferido na alocação (escrita depois de liberar). pool_verifica()
+ * aponta blocos presos enquanto muitos outros giraram (vazamento).
+ *
+ * Não é thread-safe; quem usa serializa as chamadas.
+ */
+
+#define POOL_LIVRE 0
+
+#ifdef CONFIG_POOL_DEPURACAO
+#define POOL_SENTINELA_BYTES 4
+#else
+#define POOL_SENTINELA_BYTES 0
+#endif
+
+#define POOL_ALINHAMENTO 8
+#define POOL_PASSO(tamanho) \
+    ((((tamanho) + POOL_SENTINELA_BYTES) + POOL_ALINHAMENTO - 1) / POOL_ALINHAMENTO * POOL_ALINHAMENTO)
+
+typedef struct
+{
+    uint16_t proximo;    // Próximo livre (índice); só vale com dono == POOL_LIVRE
+    uint8_t dono;
+    uint8_t reservado;
+    uint32_t geracao;    // Número da alocação que pegou o bloco
+} PoolBloco;
+
+typedef struct
+{
+    uint32_t alocacoes;
+    uint32_t sem_bloco;       // Alocações recusadas: pool vazio
+    uint32_t violacoes;       // Dono errado, ponteiro de fora, liberação dupla
+    uint32_t estouros;        // Sentinela ou padrão de livre alterados (só na depuração)
+    uint16_t em_uso;
+    uint16_t em_uso_max;
+} PoolEstatisticas;
+
+typedef struct
+{
+    uint8_t *memoria;
+    PoolBloco *blocos;
+    size_t tamanho_bloco;
+    size_t passo;
+    uint16_t quantidade;
+    uint16_t livre;         // Cabeça da lista de livres; quantidade = vazia
+    PoolEstatisticas estatisticas;
+} Pool;
+
+/* Memória estática de `quantidade` blocos de `tamanho` bytes */
+#define POOL_DEFINE(nome, tamanho, quantidade)                                                    \
+    static uint8_t nome##_memoria[(quantidade) * POOL_PASSO(tamanho)]                             \
+        __attribute__((aligned(POOL_ALINHAMENTO)));                                               \
+    static PoolBloco nome##_blocos[(quantidade)]
+
+#define POOL_INIT(pool, nome, tamanho, quantidade) \
+    pool_init((pool), nome##_memoria, nome##_blocos, (tamanho), (quantidade))
+
+void pool_init(Pool *pool, uint8_t *memoria, PoolBloco *blocos, size_t tamanho_bloco, uint16_t quantidade);
+
+/* NULL com o pool vazio (conta em sem_bloco); nunca espera */
+void *pool_aloca(Pool *pool, uint8_t dono);
+
+/* ESP_ERR_INVALID_STATE se o bloco não for de `de`; nada muda nesse caso */
+esp_err_t pool_transfere(Pool *pool, void *bloco, uint8_t de, uint8_t para);
+
+/* ESP_ERR_INVALID_ARG fora do pool, ESP_ERR_INVALID_STATE se já livre ou de outro dono */
+esp_err_t pool_libera(Pool *pool, void *bloco, uint8_t dono);
+
+uint8_t pool_dono(const Pool *pool, const void *bloco);
+uint16_t pool_livres(const Pool *pool);
+
+/*
+ * Confere as sentinelas dos blocos em uso e chama `suspeito` para os que
+ * estão presos há mais de `idade_max` alocações. Devolve quantos
+ * problemas achou (suspeitos + estouros novos).
+ */
+typedef void (*pool_suspeito_t)(void *ctx, uint16_t indice, uint8_t dono, uint32_t idade);
+size_t pool_verifica(Pool *pool, uint32_t idade_max, pool_suspeito_t suspeito, void *ctx);
+
+void pool_estatisticas(const Pool *pool, PoolEstatisticas *estatisticas);
+
+#endif
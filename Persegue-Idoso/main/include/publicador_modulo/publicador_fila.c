@@ -0,0 +1,118 @@
+#include "publicador_fila.h"
+#include <string.h>
+
+void publicador_fila_init(PublicadorFila *f, Pool *pool, const bool coalescente[PUBLICADOR_NUM_CLASSES])
+{
+    memset(f, 0, sizeof(*f));
+    f->pool = pool;
+    memcpy(f->coalescente, coalescente, sizeof(f->coalescente));
+}
+
+PublicadorMensagem *publicador_fila_reserva(PublicadorFila *f, PublicadorClasse classe)
+{
+    uint16_t minimo = classe == PUBLICADOR_ALERTA ? 1 : PUBLICADOR_RESERVA_ALERTA + 1;
+    PublicadorMensagem *m = pool_livres(f->pool) < minimo ? NULL : pool_aloca(f->pool, PUBLICADOR_DONO_PRODUTOR);
+    if (m == NULL)
+    {
+        f->estatisticas[classe].sem_bloco++;
+        return NULL;
+    }
+
+    m->classe = (uint8_t)classe;
+    m->tentativas = 0;
+    m->tamanho = 0;
+    m->topico = NULL;
+    return m;
+}
+
+esp_err_t publicador_fila_cancela(PublicadorFila *f, PublicadorMensagem *m)
+{
+    return pool_libera(f->pool, m, PUBLICADOR_DONO_PRODUTOR);
+}
+
+esp_err_t publicador_fila_conclui(PublicadorFila *f, PublicadorMensagem *m)
+{
+    return pool_libera(f->pool, m, PUBLICADOR_DONO_ENVIO);
+}
+
+static void anel_atualiza_max(PublicadorFila *f, PublicadorClasse classe)
+{
+    PublicadorClasseEstatisticas *e = &f->estatisticas[classe];
+    e->na_fila = f->filas[classe].qtd;
+    if (e->na_fila > e->na_fila_max)
+    {
+        e->na_fila_max = e->na_fila;
+    }
+}
+
+esp_err_t publicador_fila_insere(PublicadorFila *f, PublicadorMensagem *m)
+{
+    esp_err_t err = pool_transfere(f->pool, m, PUBLICADOR_DONO_PRODUTOR, PUBLICADOR_DONO_FILA);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    PublicadorClasse classe = (PublicadorClasse)m->classe;
+    PublicadorAnel *a = &f->filas[classe];
+
+    f->estatisticas[classe].enfileiradas++;
+
+    /* Só uma espera por classe coalescente: a nova fica no lugar da antiga */
+    if (f->coalescente[classe] && a->qtd > 0)
+    {
+        size_t ultima = (a->inicio + a->qtd - 1) % PUBLICADOR_MENSAGENS;
+        pool_libera(f->pool, a->itens[ultima], PUBLICADOR_DONO_FILA);
+        a->itens[ultima] = m;
+        f->estatisticas[classe].coalescidas++;
+        return ESP_OK;
+    }
+
+    /* Cabe sempre: a fila de cada classe tem um lugar por bloco */
+    a->itens[(a->inicio + a->qtd) % PUBLICADOR_MENSAGENS] = m;
+    a->qtd++;
+    anel_atualiza_max(f, classe);
+    return ESP_OK;
+}
+
+PublicadorMensagem *publicador_fila_retira(PublicadorFila *f)
+{
+    for (int classe = 0; classe < PUBLICADOR_NUM_CLASSES; classe++)
+    {
+        PublicadorAnel *a = &f->filas[classe];
+        if (a->qtd == 0)
+        {
+            continue;
+        }
+        PublicadorMensagem *m = a->itens[a->inicio];
+        a->inicio = (uint8_t)((a->inicio + 1) % PUBLICADOR_MENSAGENS);
+        a->qtd--;
+        f->estatisticas[classe].na_fila = a->qtd;
+        pool_transfere(f->pool, m, PUBLICADOR_DONO_FILA, PUBLICADOR_DONO_ENVIO);
+        return m;
+    }
+    return NULL;
+}
+
+esp_err_t publicador_fila_devolve(PublicadorFila *f, PublicadorMensagem *m)
+{
+    esp_err_t err = pool_transfere(f->pool, m, PUBLICADOR_DONO_ENVIO, PUBLICADOR_DONO_FILA);
+    if (err != ESP_OK)
+    {
+        return err;
+    }
+
+    PublicadorClasse classe = (PublicadorClasse)m->classe;
+    PublicadorAnel *a = &f->filas[classe];
+
+    a->inicio = (uint8_t)((a->inicio + PUBLICADOR_MENSAGENS - 1) % PUBLICADOR_MENSAGENS);
+    a->itens[a->inicio] = m;
+    a->qtd++;
+    anel_atualiza_max(f, classe);
+    return ESP_OK;
+}
+
+size_t publicador_fila_ocupacao(const PublicadorFila *f)
+{
+    return (size_t)(f->pool->quantidade - pool_livres(f->pool));
+}
@@ -0,0 +1,100 @@
+#ifndef PUBLICADOR_FILA_H
+#define PUBLICADOR_FILA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "pool_modulo.h"
+
+/*
+ * Fila de saída do publicador: mensagens em blocos de um Pool, uma fila
+ * FIFO por classe e retirada por prioridade estrita (menor classe
+ * primeiro). O produtor escreve direto no bloco reservado e passa a posse
+ * para a fila; nada é copiado até o cliente MQTT. A posse anda pelas tags
+ * PUBLICADOR_DONO_*: produtor -> fila -> envio -> livre.
+ *
+ * C puro e sem trava: quem usa de várias tarefas protege as chamadas
+ * (publicador_modulo.c usa uma seção crítica curta).
+ */
+
+/* Em ordem de prioridade */
+typedef enum
+{
+    PUBLICADOR_ALERTA,   // Queda: QoS 1, tentativas repetidas
+    PUBLICADOR_EVENTO,   // Transição de área segura: QoS 1
+    PUBLICADOR_POSICAO,  // Fix avulso: QoS 0, só o mais recente importa
+    PUBLICADOR_LOTE,     // Lote de telemetria: QoS 0, em ordem
+    PUBLICADOR_METRICAS, // Saúde do dispositivo: QoS 0
+    PUBLICADOR_NUM_CLASSES
+} PublicadorClasse;
+
+#define PUBLICADOR_MENSAGENS CONFIG_PUBLICADOR_MENSAGENS
+#define PUBLICADOR_DADOS_MAX CONFIG_PUBLICADOR_TAMANHO_MENSAGEM
+/* Blocos que só um alerta pode usar: métricas e GPS nunca esgotam a vez da queda */
+#define PUBLICADOR_RESERVA_ALERTA 2
+
+typedef struct
+{
+    const char *topico;   // Literal ou estático: vive até o envio
+    uint16_t tamanho;
+    uint8_t classe;       // PublicadorClasse
+    uint8_t tentativas;
+    uint8_t dados[PUBLICADOR_DADOS_MAX];
+} PublicadorMensagem;
+
+typedef struct
+{
+    uint32_t enfileiradas;
+    uint32_t enviadas;     // Publicadas direto no broker
+    uint32_t outbox;       // Desviadas para o outbox (desconectado)
+    uint32_t coalescidas;  // Substituídas por uma mais nova antes do envio
+    uint32_t sem_bloco;    // Reserva recusada: nenhum bloco livre
+    uint32_t descartadas;  // Falharam e não couberam no outbox
+    uint16_t na_fila;
+    uint16_t na_fila_max;
+} PublicadorClasseEstatisticas;
+
+/* Donos dos blocos no Pool */
+#define PUBLICADOR_DONO_PRODUTOR 1
+#define PUBLICADOR_DONO_FILA 2
+#define PUBLICADOR_DONO_ENVIO 3
+
+typedef struct
+{
+    PublicadorMensagem *itens[PUBLICADOR_MENSAGENS];
+    uint8_t inicio;
+    uint8_t qtd;
+} PublicadorAnel;
+
+typedef struct
+{
+    Pool *pool;
+    PublicadorAnel filas[PUBLICADOR_NUM_CLASSES];
+    bool coalescente[PUBLICADOR_NUM_CLASSES];
+    PublicadorClasseEstatisticas estatisticas[PUBLICADOR_NUM_CLASSES];
+} PublicadorFila;
+
+/*
+ * `pool`: blocos de sizeof(PublicadorMensagem), no máximo PUBLICADOR_MENSAGENS.
+ * `coalescente[c]`: uma mensagem nova da classe substitui a que ainda espera.
+ */
+void publicador_fila_init(PublicadorFila *f, Pool *pool, const bool coalescente[PUBLICADOR_NUM_CLASSES]);
+
+/* NULL sem bloco livre (conta em sem_bloco); nunca espera */
+PublicadorMensagem *publicador_fila_reserva(PublicadorFila *f, PublicadorClasse classe);
+/* Produtor desistiu de um bloco reservado */
+esp_err_t publicador_fila_cancela(PublicadorFila *f, PublicadorMensagem *m);
+
+/* Posse do produtor para a fila; ESP_ERR_INVALID_STATE se o bloco não for do produtor */
+esp_err_t publicador_fila_insere(PublicadorFila *f, PublicadorMensagem *m);
+/* A mais prioritária, agora do envio; NULL com a fila vazia */
+PublicadorMensagem *publicador_fila_retira(PublicadorFila *f);
+/* Recoloca na frente da sua classe (nova tentativa) */
+esp_err_t publicador_fila_devolve(PublicadorFila *f, PublicadorMensagem *m);
+/* Envio terminado (publicada, no outbox ou descartada): o bloco volta ao pool */
+esp_err_t publicador_fila_conclui(PublicadorFila *f, PublicadorMensagem *m);
+
+size_t publicador_fila_ocupacao(const PublicadorFila *f);
+
+#endif
@@ -0,0 +1,224 @@
+#include "publicador_modulo.h"
+#include "mqtt_modulo.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#define TAG "PUBLICADOR"
+
+#define PUBLICADOR_PILHA 4096
+#define PUBLICADOR_PRIORIDADE 4 // Acima do outbox (3) e do GPS (2), abaixo da detecção
+
+typedef struct
+{
+    uint8_t qos;
+    uint8_t tentativas;   // Publicações conectadas que falharam antes de desistir
+    bool outbox;          // Falhou na última tentativa (ou desconectado): vai para a flash
+    bool coalescente;
+} PublicadorPolitica;
+
+static const PublicadorPolitica s_politicas[PUBLICADOR_NUM_CLASSES] = {
+    [PUBLICADOR_ALERTA] = {.qos = 1, .tentativas = PUBLICADOR_TENTATIVAS_ALERTA, .outbox = true},
+    [PUBLICADOR_EVENTO] = {.qos = 1, .tentativas = 1, .outbox = true},
+    [PUBLICADOR_POSICAO] = {.qos = 0, .tentativas = 1, .outbox = true, .coalescente = true},
+    [PUBLICADOR_LOTE] = {.qos = 0, .tentativas = 1, .outbox = true},
+    [PUBLICADOR_METRICAS] = {.qos = 0, .tentativas = 1, .outbox = false},
+};
+
+/* --------------------------------------------------------------------------
+ *  Estado. A fila só é tocada dentro de s_mux: as operações são O(classes)
+ *  e nunca esperam, então a seção crítica cabe na tarefa do detector.
+ * -------------------------------------------------------------------------- */
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+POOL_DEFINE(s_mensagens, sizeof(PublicadorMensagem), PUBLICADOR_MENSAGENS);
+static Pool s_pool;
+static PublicadorFila s_fila;
+static TaskHandle_t s_tarefa = NULL;
+
+static void publicador_conta(PublicadorMensagem *m, MqttEnvio resultado)
+{
+    taskENTER_CRITICAL(&s_mux);
+    PublicadorClasseEstatisticas *e = &s_fila.estatisticas[m->classe];
+    if (resultado == MQTT_ENVIO_PUBLICADO)
+    {
+        e->enviadas++;
+    }
+    else if (resultado == MQTT_ENVIO_OUTBOX)
+    {
+        e->outbox++;
+    }
+    else
+    {
+        e->descartadas++;
+    }
+    publicador_fila_conclui(&s_fila, m);
+    taskEXIT_CRITICAL(&s_mux);
+}
+
+static void task_publicador(void *params)
+{
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (true)
+        {
+            taskENTER_CRITICAL(&s_mux);
+            PublicadorMensagem *m = publicador_fila_retira(&s_fila);
+            taskEXIT_CRITICAL(&s_mux);
+            if (m == NULL)
+            {
+                break;
+            }
+
+            const PublicadorPolitica *p = &s_politicas[m->classe];
+            m->tentativas++;
+            bool ultima = m->tentativas >= p->tentativas;
+
+            MqttEnvio resultado = mqtt_envia(m->topico, m->dados, m->tamanho, p->qos, ultima && p->outbox);
+            if (resultado == MQTT_ENVIO_FALHOU && !ultima && mqtt_conectado())
+            {
+                // Cliente sem espaço ou reconectando: o alerta volta para a frente e tenta de novo
+                ESP_LOGW(TAG, "Falha ao publicar em %s (tentativa %u), repetindo", m->topico, m->tentativas);
+                taskENTER_CRITICAL(&s_mux);
+                publicador_fila_devolve(&s_fila, m);
+                taskEXIT_CRITICAL(&s_mux);
+                vTaskDelay(pdMS_TO_TICKS(PUBLICADOR_ESPERA_TENTATIVA_MS));
+                continue;
+            }
+            if (resultado == MQTT_ENVIO_FALHOU && !ultima && p->outbox)
+            {
+                // Desconectado: não adianta repetir, a flash reenvia depois
+                resultado = mqtt_envia(m->topico, m->dados, m->tamanho, p->qos, true);
+            }
+            if (resultado == MQTT_ENVIO_FALHOU)
+            {
+                ESP_LOGW(TAG, "Mensagem de %u bytes em %s descartada", m->tamanho, m->topico);
+            }
+            publicador_conta(m, resultado);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void publicador_init(void)
+{
+    bool coalescente[PUBLICADOR_NUM_CLASSES];
+    for (int i = 0; i < PUBLICADOR_NUM_CLASSES; i++)
+    {
+        coalescente[i] = s_politicas[i].coalescente;
+    }
+    POOL_INIT(&s_pool, s_mensagens, sizeof(PublicadorMensagem), PUBLICADOR_MENSAGENS);
+    publicador_fila_init(&s_fila, &s_pool, coalescente);
+
+    xTaskCreate(task_publicador, "PublicadorTask", PUBLICADOR_PILHA, NULL, PUBLICADOR_PRIORIDADE, &s_tarefa);
+}
+
+PublicadorMensagem *publicador_reserva(PublicadorClasse classe)
+{
+    taskENTER_CRITICAL(&s_mux);
+    PublicadorMensagem *m = publicador_fila_reserva(&s_fila, classe);
+    taskEXIT_CRITICAL(&s_mux);
+
+    if (m == NULL)
+    {
+        ESP_LOGW(TAG, "Sem bloco livre para a classe %d, mensagem descartada", classe);
+    }
+    return m;
+}
+
+void publicador_envia(PublicadorMensagem *m, const char *topico, size_t tamanho)
+{
+    if (tamanho > PUBLICADOR_DADOS_MAX)
+    {
+        ESP_LOGE(TAG, "Mensagem de %u bytes em %s maior que o bloco", (unsigned)tamanho, topico);
+        publicador_cancela(m);
+        return;
+    }
+    m->topico = topico;
+    m->tamanho = (uint16_t)tamanho;
+
+    taskENTER_CRITICAL(&s_mux);
+    esp_err_t err = publicador_fila_insere(&s_fila, m);
+    taskEXIT_CRITICAL(&s_mux);
+
+    if (err != ESP_OK)
+    {
+        // Bloco já entregue ou de outro dono: erro de quem chama, a mensagem não entra
+        ESP_LOGE(TAG, "Mensagem em %s recusada: bloco não pertence ao produtor", topico);
+        return;
+    }
+    xTaskNotifyGive(s_tarefa);
+}
+
+void publicador_cancela(PublicadorMensagem *m)
+{
+    taskENTER_CRITICAL(&s_mux);
+    esp_err_t err = publicador_fila_cancela(&s_fila, m);
+    taskEXIT_CRITICAL(&s_mux);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Cancelamento de um bloco que não pertence ao produtor");
+    }
+}
+
+void publicador_estatisticas(PublicadorEstatisticas *e)
+{
+    taskENTER_CRITICAL(&s_mux);
+    for (int i = 0; i < PUBLICADOR_NUM_CLASSES; i++)
+    {
+        e->classes[i] = s_fila.estatisticas[i];
+    }
+    pool_estatisticas(&s_pool, &e->pool);
+    taskEXIT_CRITICAL(&s_mux);
+}
+
+#ifdef CONFIG_POOL_DEPURACAO
+typedef struct
+{
+    size_t qtd;
+    struct { uint16_t indice; uint8_t dono; uint32_t idade; } itens[PUBLICADOR_MENSAGENS];
+} PublicadorSuspeitos;
+
+/* Chamado dentro da seção crítica: só anota, o log vem depois */
+static void publicador_anota_suspeito(void *ctx, uint16_t indice, uint8_t dono, uint32_t idade)
+{
+    PublicadorSuspeitos *s = ctx;
+    if (s->qtd < PUBLICADOR_MENSAGENS)
+    {
+        s->itens[s->qtd].indice = indice;
+        s->itens[s->qtd].dono = dono;
+        s->itens[s->qtd].idade = idade;
+        s->qtd++;
+    }
+}
+#endif
+
+size_t publicador_verifica(void)
+{
+#ifdef CONFIG_POOL_DEPURACAO
+    PublicadorSuspeitos suspeitos = {0};
+
+    taskENTER_CRITICAL(&s_mux);
+    uint32_t estouros = s_pool.estatisticas.estouros;
+    size_t problemas = pool_verifica(&s_pool, PUBLICADOR_IDADE_VAZAMENTO, publicador_anota_suspeito, &suspeitos);
+    estouros = s_pool.estatisticas.estouros - estouros;
+    taskEXIT_CRITICAL(&s_mux);
+
+    if (estouros > 0)
+    {
+        ESP_LOGE(TAG, "Pool de mensagens: %lu blocos escritos além do fim", (unsigned long)estouros);
+    }
+    for (size_t i = 0; i < suspeitos.qtd; i++)
+    {
+        ESP_LOGW(TAG, "Bloco %u preso há %lu alocações (dono %u): possível vazamento",
+                 suspeitos.itens[i].indice, (unsigned long)suspeitos.itens[i].idade, suspeitos.itens[i].dono);
+    }
+    return problemas;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,54 @@
+#ifndef PUBLICADOR_MODULO_H
+#define PUBLICADOR_MODULO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "publicador_fila.h"
+
+/*
+ * Publicador: único ponto de saída para o MQTT. As tarefas reservam um
+ * bloco do pool estático (pool_modulo), escrevem a mensagem direto nele e
+ * passam a posse com publicador_envia(); uma tarefa própria publica por
+ * prioridade de classe.
+ * Assim a detecção de quedas e o GPS nunca esperam a rede, e um alerta
+ * passa na frente de lotes e métricas acumulados.
+ *
+ * Política por classe (publicador_modulo.c):
+ *   ALERTA    QoS 1, até PUBLICADOR_TENTATIVAS_ALERTA tentativas, depois outbox
+ *   EVENTO    QoS 1, outbox se falhar
+ *   POSICAO   QoS 0, coalescente: só o fix mais recente espera
+ *   LOTE      QoS 0, em ordem, outbox se falhar
+ *   METRICAS  QoS 0, descartada se falhar
+ * Desconectado, tudo que tem outbox vai para a flash como antes.
+ */
+#define PUBLICADOR_TENTATIVAS_ALERTA 5
+#define PUBLICADOR_ESPERA_TENTATIVA_MS 200
+/* Alocações que um bloco pode ficar preso até virar suspeito de vazamento */
+#define PUBLICADOR_IDADE_VAZAMENTO (64 * PUBLICADOR_MENSAGENS)
+
+typedef struct
+{
+    PublicadorClasseEstatisticas classes[PUBLICADOR_NUM_CLASSES];
+    PoolEstatisticas pool;
+} PublicadorEstatisticas;
+
+void publicador_init(void);
+
+/* Bloco para escrever a mensagem; NULL sem bloco livre (descarte, nunca bloqueia) */
+PublicadorMensagem *publicador_reserva(PublicadorClasse classe);
+
+/* Passa a posse do bloco para o publicador. `topico` precisa viver até o envio */
+void publicador_envia(PublicadorMensagem *m, const char *topico, size_t tamanho);
+
+/* Devolve um bloco reservado que não vai ser enviado */
+void publicador_cancela(PublicadorMensagem *m);
+
+void publicador_estatisticas(PublicadorEstatisticas *e);
+
+/*
+ * Com CONFIG_POOL_DEPURACAO confere sentinelas e blocos presos e loga o que
+ * achar; devolve quantos problemas. Sem a depuração não faz nada.
+ */
+size_t publicador_verifica(void);
+
+#endif
@@ -0,0 +1,321 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "telemetria_modulo.h"
+
+// Maior intervalo representável em dt (u16 em unidades de 10 ms)
+#define LOTE_DT_MAX 65535
+#define LOTE_UNIDADE_DT_US 10000
+
+typedef struct
+{
+    int64_t timestamp_us;
+    int32_t lat_e7;
+    int32_t lon_e7;
+    uint16_t hdop_c;
+    uint16_t vel_c;
+} FixLote;
+
+static FixLote fixes[CONFIG_TELEMETRIA_LOTE_MAX_FIXES];
+static TelemetriaResumoImu resumos[CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS];
+static size_t fixes_inicio, fixes_qtd;
+static size_t resumos_inicio, resumos_qtd;
+static bool urgente;
+
+// Último fix com data: amarra o relógio monotônico ao UTC
+static int64_t referencia_epoch_ms;
+static int64_t referencia_us;
+
+static TelemetriaLoteEstatisticas estatisticas_lote;
+static SemaphoreHandle_t lote_mutex;
+
+/* --------------------------------------------------------------------------
+ *  Escrita little-endian byte a byte: independe de alinhamento e do
+ *  layout de structs do compilador, e não usa heap nem printf
+ * -------------------------------------------------------------------------- */
+static uint8_t *escreve_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *escreve_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static int32_t graus_para_e7(float graus)
+{
+    float escalado = graus * 1e7f;
+    return (int32_t)(escalado < 0 ? escalado - 0.5f : escalado + 0.5f);
+}
+
+static uint8_t satura_u8(float valor)
+{
+    if (valor <= 0.0f) return 0;
+    if (valor >= 255.0f) return 255;
+    return (uint8_t)(valor + 0.5f);
+}
+
+static uint16_t satura_u16(float valor)
+{
+    if (valor <= 0.0f) return 0;
+    if (valor >= 65535.0f) return 65535;
+    return (uint16_t)(valor + 0.5f);
+}
+
+/* Dias desde 1970-01-01 (algoritmo days_from_civil, calendário gregoriano) */
+static int32_t dias_desde_epoch(int32_t ano, uint32_t mes, uint32_t dia)
+{
+    ano -= mes <= 2;
+    int32_t era = (ano >= 0 ? ano : ano - 399) / 400;
+    uint32_t ano_da_era = (uint32_t)(ano - era * 400);
+    uint32_t dia_do_ano = (153 * (mes + (mes > 2 ? -3 : 9)) + 2) / 5 + dia - 1;
+    uint32_t dia_da_era = ano_da_era * 365 + ano_da_era / 4 - ano_da_era / 100 + dia_do_ano;
+    return era * 146097 + (int32_t)dia_da_era - 719468;
+}
+
+uint32_t telemetria_epoch_utc(const GpsData *fix)
+{
+    if (fix->ano == 0 || fix->mes == 0 || fix->dia == 0)
+    {
+        return 0;
+    }
+
+    int32_t dias = dias_desde_epoch(fix->ano, fix->mes, fix->dia);
+    return (uint32_t)dias * 86400u + fix->hora * 3600u + fix->minuto * 60u + fix->segundo;
+}
+
+/* --------------------------------------------------------------------------
+ *  Lote: acumula fixes e resumos do IMU e envia tudo em um publish.
+ *  Com o lote cheio o item mais antigo é sobrescrito.
+ * -------------------------------------------------------------------------- */
+void telemetria_lote_init(void)
+{
+    lote_mutex = xSemaphoreCreateMutex();
+}
+
+void telemetria_lote_adiciona_fix(const GpsData *fix)
+{
+    FixLote item = {
+        .timestamp_us = fix->timestamp_us,
+        .lat_e7 = graus_para_e7(fix->latitude),
+        .lon_e7 = graus_para_e7(fix->longitude),
+        .hdop_c = satura_u16(fix->hdop * 100.0f),
+        .vel_c = satura_u16(fix->velocidade_kmh * 100.0f),
+    };
+    uint32_t epoch = telemetria_epoch_utc(fix);
+
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+    if (fixes_qtd == CONFIG_TELEMETRIA_LOTE_MAX_FIXES)
+    {
+        fixes_inicio = (fixes_inicio + 1) % CONFIG_TELEMETRIA_LOTE_MAX_FIXES;
+        fixes_qtd--;
+        estatisticas_lote.descartados++;
+    }
+    fixes[(fixes_inicio + fixes_qtd) % CONFIG_TELEMETRIA_LOTE_MAX_FIXES] = item;
+    fixes_qtd++;
+
+    if (epoch != 0)
+    {
+        referencia_epoch_ms = (int64_t)epoch * 1000 + fix->milissegundo;
+        referencia_us = fix->timestamp_us;
+    }
+    xSemaphoreGive(lote_mutex);
+}
+
+void telemetria_lote_adiciona_resumo(const TelemetriaResumoImu *resumo)
+{
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+    if (resumos_qtd == CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS)
+    {
+        resumos_inicio = (resumos_inicio + 1) % CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS;
+        resumos_qtd--;
+        estatisticas_lote.descartados++;
+    }
+    resumos[(resumos_inicio + resumos_qtd) % CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS] = *resumo;
+    resumos_qtd++;
+    xSemaphoreGive(lote_mutex);
+}
+
+/* Pede o envio do lote na próxima verificação (ex.: logo depois de um alerta) */
+void telemetria_lote_urgente(void)
+{
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+    urgente = true;
+    xSemaphoreGive(lote_mutex);
+}
+
+/* Envia ao encher, quando o item mais antigo passa da idade máxima ou se urgente */
+bool telemetria_lote_deve_enviar(int64_t agora_us)
+{
+    bool enviar;
+
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+    if (fixes_qtd == 0 && resumos_qtd == 0)
+    {
+        urgente = false;
+        enviar = false;
+    }
+    else if (urgente || fixes_qtd == CONFIG_TELEMETRIA_LOTE_MAX_FIXES ||
+             resumos_qtd == CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS)
+    {
+        enviar = true;
+    }
+    else
+    {
+        int64_t mais_antigo = INT64_MAX;
+        if (fixes_qtd > 0) mais_antigo = fixes[fixes_inicio].timestamp_us;
+        if (resumos_qtd > 0 && resumos[resumos_inicio].timestamp_us < mais_antigo)
+        {
+            mais_antigo = resumos[resumos_inicio].timestamp_us;
+        }
+        enviar = (agora_us - mais_antigo) >= (int64_t)CONFIG_TELEMETRIA_LOTE_IDADE_MAX_MS * 1000;
+    }
+    xSemaphoreGive(lote_mutex);
+
+    return enviar;
+}
+
+bool telemetria_lote_pendente(void)
+{
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+    bool pendente = fixes_qtd > 0 || resumos_qtd > 0;
+    xSemaphoreGive(lote_mutex);
+    return pendente;
+}
+
+static bool cabe_i16(int32_t v)
+{
+    return v >= INT16_MIN && v <= INT16_MAX;
+}
+
+/*
+ * Codifica o lote e remove os itens codificados. Itens que não cabem no
+ * frame (dt ou delta fora da faixa) ficam para o próximo: chame de novo
+ * enquanto telemetria_lote_pendente(). Retorna 0 se o buffer não comporta
+ * o cabeçalho ou o lote está vazio.
+ */
+size_t telemetria_lote_codifica(uint16_t usuario_id, uint16_t sequencia, uint8_t bateria,
+                                uint8_t *buffer, size_t tamanho)
+{
+    if (tamanho < TELEMETRIA_TAMANHO_CABECALHO_LOTE + TELEMETRIA_TAMANHO_FIX_ABSOLUTO)
+    {
+        return 0;
+    }
+
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+
+    if (fixes_qtd == 0 && resumos_qtd == 0)
+    {
+        urgente = false;
+        xSemaphoreGive(lote_mutex);
+        return 0;
+    }
+
+    int64_t base_us = INT64_MAX;
+    if (fixes_qtd > 0) base_us = fixes[fixes_inicio].timestamp_us;
+    if (resumos_qtd > 0 && resumos[resumos_inicio].timestamp_us < base_us)
+    {
+        base_us = resumos[resumos_inicio].timestamp_us;
+    }
+
+    uint8_t *fim = buffer + tamanho;
+    uint8_t *p = buffer + TELEMETRIA_TAMANHO_CABECALHO_LOTE;
+
+    size_t n_fixes = 0;
+    const FixLote *anterior = NULL;
+    while (n_fixes < fixes_qtd)
+    {
+        const FixLote *f = &fixes[(fixes_inicio + n_fixes) % CONFIG_TELEMETRIA_LOTE_MAX_FIXES];
+        int64_t dt = (f->timestamp_us - base_us) / LOTE_UNIDADE_DT_US;
+        if (dt > LOTE_DT_MAX) break;
+
+        if (anterior == NULL)
+        {
+            p = escreve_u16(p, (uint16_t)dt);
+            p = escreve_u32(p, (uint32_t)f->lat_e7);
+            p = escreve_u32(p, (uint32_t)f->lon_e7);
+            p = escreve_u16(p, f->hdop_c);
+            p = escreve_u16(p, f->vel_c);
+        }
+        else
+        {
+            int32_t dlat = f->lat_e7 - anterior->lat_e7;
+            int32_t dlon = f->lon_e7 - anterior->lon_e7;
+            if (!cabe_i16(dlat) || !cabe_i16(dlon) || fim - p < TELEMETRIA_TAMANHO_FIX_DELTA) break;
+
+            p = escreve_u16(p, (uint16_t)dt);
+            p = escreve_u16(p, (uint16_t)(int16_t)dlat);
+            p = escreve_u16(p, (uint16_t)(int16_t)dlon);
+            *p++ = satura_u8(f->hdop_c / 10.0f);
+            *p++ = satura_u8(f->vel_c / 100.0f);
+        }
+        anterior = f;
+        n_fixes++;
+    }
+
+    size_t n_resumos = 0;
+    while (n_resumos < resumos_qtd && fim - p >= TELEMETRIA_TAMANHO_RESUMO_IMU)
+    {
+        const TelemetriaResumoImu *r = &resumos[(resumos_inicio + n_resumos) % CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS];
+        int64_t dt = (r->timestamp_us - base_us) / LOTE_UNIDADE_DT_US;
+        if (dt > LOTE_DT_MAX) break;
+
+        p = escreve_u16(p, (uint16_t)dt);
+        p = escreve_u16(p, r->amostras);
+        p = escreve_u16(p, r->mag_min_mg);
+        p = escreve_u16(p, r->mag_max_mg);
+        n_resumos++;
+    }
+
+    // Base em UTC a partir do último fix com data; sem data vai 0
+    uint32_t epoch_s = 0;
+    uint16_t epoch_ms = 0;
+    if (referencia_epoch_ms != 0)
+    {
+        int64_t base_ms = referencia_epoch_ms - (referencia_us - base_us) / 1000;
+        epoch_s = (uint32_t)(base_ms / 1000);
+        epoch_ms = (uint16_t)(base_ms % 1000);
+    }
+
+    uint8_t *h = buffer;
+    *h++ = TELEMETRIA_VERSAO;
+    *h++ = TELEMETRIA_TIPO_LOTE;
+    h = escreve_u16(h, sequencia);
+    h = escreve_u16(h, usuario_id);
+    *h++ = bateria;
+    *h++ = (uint8_t)n_fixes;
+    *h++ = (uint8_t)n_resumos;
+    *h++ = 0;
+    h = escreve_u32(h, epoch_s);
+    escreve_u16(h, epoch_ms);
+
+    fixes_inicio = (fixes_inicio + n_fixes) % CONFIG_TELEMETRIA_LOTE_MAX_FIXES;
+    fixes_qtd -= n_fixes;
+    resumos_inicio = (resumos_inicio + n_resumos) % CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS;
+    resumos_qtd -= n_resumos;
+    if (fixes_qtd == 0 && resumos_qtd == 0)
+    {
+        urgente = false;
+    }
+
+    estatisticas_lote.lotes_enviados++;
+    estatisticas_lote.fixes_enviados += n_fixes;
+    estatisticas_lote.resumos_enviados += n_resumos;
+
+    xSemaphoreGive(lote_mutex);
+
+    return (size_t)(p - buffer);
+}
+
+void telemetria_lote_estatisticas(TelemetriaLoteEstatisticas *estatisticas)
+{
+    xSemaphoreTake(lote_mutex, portMAX_DELAY);
+    *estatisticas = estatisticas_lote;
+    xSemaphoreGive(lote_mutex);
+}
@@ -0,0 +1,102 @@
+#ifndef TELEMETRIA_MODULO_H
+#define TELEMETRIA_MODULO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "nmea_modulo.h"
+
+/*
+ * Frame de posição avulsa, versão 1 (little-endian, 24 bytes). O firmware
+ * atual só envia lotes; o formato fica documentado porque o backend ainda
+ * decodifica este tipo, vindo de aparelhos com firmware antigo:
+ *
+ *   off  tam  campo
+ *    0    1   versão (TELEMETRIA_VERSAO)
+ *    1    1   tipo (TELEMETRIA_TIPO_*)
+ *    2    2   sequência (incrementa a cada frame, detecta perdas)
+ *    4    2   id do usuário
+ *    6    1   bateria em % (TELEMETRIA_BATERIA_DESCONHECIDA se não medida)
+ *    7    1   flags (TELEMETRIA_FLAG_*)
+ *    8    4   timestamp Unix UTC do fix, em segundos (0 se sem data)
+ *   12    4   latitude  em graus * 1e7 (int32)
+ *   16    4   longitude em graus * 1e7 (int32)
+ *   20    2   HDOP * 100
+ *   22    2   velocidade em km/h * 100
+ *
+ * O primeiro byte nunca é '{', então o backend distingue do JSON legado.
+ */
+#define TELEMETRIA_VERSAO 1
+#define TELEMETRIA_TAMANHO_POSICAO 24
+
+#define TELEMETRIA_TIPO_POSICAO 0x01
+#define TELEMETRIA_TIPO_LOTE 0x02
+
+#define TELEMETRIA_FLAG_FIX_VALIDO 0x01
+
+#define TELEMETRIA_BATERIA_DESCONHECIDA 0xFF
+
+/*
+ * Frame de lote, versão 1 (little-endian). Tempos em unidades de 10 ms
+ * relativos à base do lote; posições delta em relação ao fix anterior.
+ *
+ *   cabeçalho (16 bytes)
+ *    0    1   versão
+ *    1    1   tipo (TELEMETRIA_TIPO_LOTE)
+ *    2    2   sequência
+ *    4    2   id do usuário
+ *    6    1   bateria em %
+ *    7    1   quantidade de fixes
+ *    8    1   quantidade de resumos do IMU
+ *    9    1   reservado (0)
+ *   10    4   timestamp Unix UTC da base, em segundos (0 se sem data)
+ *   14    2   milissegundos da base
+ *
+ *   primeiro fix (14 bytes): dt u16, latitude i32 e longitude i32 em
+ *   graus * 1e7, HDOP * 100 u16, km/h * 100 u16
+ *
+ *   demais fixes (8 bytes): dt u16, dlat i16, dlon i16 (graus * 1e7),
+ *   HDOP * 10 u8, km/h u8
+ *
+ *   resumos do IMU (8 bytes): dt u16, amostras u16, módulo mínimo e
+ *   máximo da aceleração em mg (u16 cada)
+ */
+#define TELEMETRIA_TAMANHO_CABECALHO_LOTE 16
+#define TELEMETRIA_TAMANHO_FIX_ABSOLUTO 14
+#define TELEMETRIA_TAMANHO_FIX_DELTA 8
+#define TELEMETRIA_TAMANHO_RESUMO_IMU 8
+
+#define TELEMETRIA_TAMANHO_MAX_LOTE (TELEMETRIA_TAMANHO_CABECALHO_LOTE + TELEMETRIA_TAMANHO_FIX_ABSOLUTO + \
+                                     (CONFIG_TELEMETRIA_LOTE_MAX_FIXES - 1) * TELEMETRIA_TAMANHO_FIX_DELTA + \
+                                     CONFIG_TELEMETRIA_LOTE_MAX_RESUMOS * TELEMETRIA_TAMANHO_RESUMO_IMU)
+
+typedef struct
+{
+    int64_t timestamp_us;   // início da janela
+    uint16_t amostras;
+    uint16_t mag_min_mg;
+    uint16_t mag_max_mg;
+} TelemetriaResumoImu;
+
+typedef struct
+{
+    uint32_t lotes_enviados;
+    uint32_t fixes_enviados;
+    uint32_t resumos_enviados;
+    uint32_t descartados;   // itens sobrescritos com o lote cheio
+} TelemetriaLoteEstatisticas;
+
+uint32_t telemetria_epoch_utc(const GpsData *fix);
+
+void telemetria_lote_init(void);
+void telemetria_lote_adiciona_fix(const GpsData *fix);
+void telemetria_lote_adiciona_resumo(const TelemetriaResumoImu *resumo);
+void telemetria_lote_urgente(void);
+bool telemetria_lote_deve_enviar(int64_t agora_us);
+bool telemetria_lote_pendente(void);
+size_t telemetria_lote_codifica(uint16_t usuario_id, uint16_t sequencia, uint8_t bateria,
+                                uint8_t *buffer, size_t tamanho);
+void telemetria_lote_estatisticas(TelemetriaLoteEstatisticas *estatisticas);
+
+#endif
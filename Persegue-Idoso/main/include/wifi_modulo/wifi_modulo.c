@@ -3,57 +3,73 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
+#include "esp_mac.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
+#include "conexao_modulo.h"
+
 #define WIFI_SSID      CONFIG_ESP_WIFI_SSID
 #define WIFI_PASS      CONFIG_ESP_WIFI_PASSWORD
-#define WIFI_MAXIMUM_RETRY  CONFIG_ESP_MAXIMUM_RETRY
 
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
+#define WIFI_NVS_NAMESPACE "conexao"
+#define WIFI_NVS_CHAVE_AP "ap"
 
 #define TAG "Wifi"
 
-static EventGroupHandle_t s_wifi_event_group;
+/* Último AP em que houve IP: reconexão direta no canal, sem varrer todos */
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t canal;
+} WifiApSalvo;
+
+static WifiApSalvo s_ap_salvo;
+static bool s_ap_salvo_valido = false;
+
+static void wifi_carrega_ap_salvo(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;
+    }
+
+    size_t tamanho = sizeof(s_ap_salvo);
+    s_ap_salvo_valido = nvs_get_blob(nvs, WIFI_NVS_CHAVE_AP, &s_ap_salvo, &tamanho) == ESP_OK &&
+                        tamanho == sizeof(s_ap_salvo) && s_ap_salvo.canal != 0;
+    nvs_close(nvs);
 
-static int s_retry_num = 0;
-extern SemaphoreHandle_t conexaoWifiSemaphore;
+    if (s_ap_salvo_valido) {
+        ESP_LOGI(TAG, "AP salvo: " MACSTR ", canal %d", MAC2STR(s_ap_salvo.bssid), s_ap_salvo.canal);
+    }
+}
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
+        conexao_notifica(CONEXAO_EVT_WIFI_INICIADO);
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < WIFI_MAXIMUM_RETRY) {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "retry to connect to the AP");
-        } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-        }
-        ESP_LOGI(TAG,"connect to the AP fail");
+        wifi_event_sta_disconnected_t* event = (wifi_event_sta_disconnected_t*) event_data;
+        ESP_LOGI(TAG, "Desconectado do AP (motivo %d)", event->reason);
+        conexao_notifica(CONEXAO_EVT_WIFI_DESCONECTADO);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Endereço IP recebido:" IPSTR, IP2STR(&event->ip_info.ip));
-        s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
-        xSemaphoreGive(conexaoWifiSemaphore);
+        conexao_notifica(CONEXAO_EVT_IP_OBTIDO);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_LOST_IP) {
+        conexao_notifica(CONEXAO_EVT_IP_PERDIDO);
     }
 }
 
 void wifi_start(){
 
-    s_wifi_event_group = xEventGroupCreate();
-
     ESP_ERROR_CHECK(esp_netif_init());
 
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -62,49 +78,98 @@ void wifi_start(){
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, &instance_got_ip));
+    ESP_ERROR_CHECK(esp_event_handler_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler, NULL));
+    ESP_ERROR_CHECK(esp_event_handler_register(IP_EVENT, IP_EVENT_STA_LOST_IP, &event_handler, NULL));
+
+    wifi_carrega_ap_salvo();
 
     wifi_config_t wifi_config = {
         .sta = {
             .ssid = WIFI_SSID,
-            .password = WIFI_PASS
+            .password = WIFI_PASS,
+            .listen_interval = CONFIG_ENERGIA_WIFI_LISTEN_INTERVAL,
         },
     };
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config) );
     ESP_ERROR_CHECK(esp_wifi_start() );
 
+    // Modem sleep: o rádio acorda só nos beacons (a cada DTIM ou a cada listen_interval)
+    ESP_ERROR_CHECK(esp_wifi_set_ps(CONFIG_ENERGIA_WIFI_LISTEN_INTERVAL > 0 ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM));
+
+    // Não espera a conexão: STA_START chega ao supervisor, que chama wifi_conecta()
     ESP_LOGI(TAG, "wifi_init_sta finished.");
+}
 
-    /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-     * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-            pdFALSE,
-            pdFALSE,
-            portMAX_DELAY);
-
-    /* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
-     * happened. */
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "connected to ap SSID:%s password:%s",
-                 WIFI_SSID, WIFI_PASS);
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGI(TAG, "Failed to connect to SSID:%s, password:%s",
-                 WIFI_SSID, WIFI_PASS);
+void wifi_conecta(bool rapido)
+{
+    wifi_config_t wifi_config;
+    esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
+
+    if (rapido && s_ap_salvo_valido) {
+        // Vai direto ao AP conhecido no canal conhecido
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_ap_salvo.bssid, sizeof(s_ap_salvo.bssid));
+        wifi_config.sta.channel = s_ap_salvo.canal;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
     } else {
-        ESP_LOGE(TAG, "UNEXPECTED EVENT");
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel = 0;
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+
+    esp_err_t err = esp_wifi_connect();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_connect falhou (err=0x%x)", err);
     }
+}
 
-    //ESP_ERROR_CHECK(esp_event_handler_unregister(IP_EVENT, IP_EVENT_STA_GOT_IP, &event_handler));
-    //ESP_ERROR_CHECK(esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID, &event_handler));
-    vEventGroupDelete(s_wifi_event_group);
+bool wifi_tem_ap_salvo(void)
+{
+    return s_ap_salvo_valido;
+}
+
+void wifi_salva_ap_atual(void)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+
+    WifiApSalvo atual = { .canal = ap.primary };
+    memcpy(atual.bssid, ap.bssid, sizeof(atual.bssid));
+
+    // Só grava quando muda, para não gastar a flash a cada reconexão
+    if (s_ap_salvo_valido && memcmp(&atual, &s_ap_salvo, sizeof(atual)) == 0) {
+        return;
+    }
+
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(nvs, WIFI_NVS_CHAVE_AP, &atual, sizeof(atual)) == ESP_OK) {
+        nvs_commit(nvs);
+        s_ap_salvo = atual;
+        s_ap_salvo_valido = true;
+        ESP_LOGI(TAG, "AP salvo para reconexão rápida: " MACSTR ", canal %d", MAC2STR(atual.bssid), atual.canal);
+    }
+    nvs_close(nvs);
+}
+
+bool wifi_rssi(int8_t *rssi)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return false;
+    }
+    *rssi = ap.rssi;
+    return true;
 }
 
 void wifi_stop()
 {
     esp_wifi_stop();
-};
\ No newline at end of file
+};
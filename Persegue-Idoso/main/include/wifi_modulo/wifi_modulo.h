@@ -1,7 +1,19 @@
 #ifndef WIFI_H
 #define WIFI_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Inicia o Wi-Fi sem bloquear; a conexão é conduzida pelo conexao_modulo */
 void wifi_start();
 void wifi_stop();
 
-#endif
\ No newline at end of file
+/* Tenta associar; com rapido=true usa BSSID/canal do último AP (NVS), sem varredura completa */
+void wifi_conecta(bool rapido);
+bool wifi_tem_ap_salvo(void);
+/* Grava no NVS o AP atual para a próxima reconexão rápida */
+void wifi_salva_ap_atual(void);
+/* RSSI do AP associado; false se não está associado */
+bool wifi_rssi(int8_t *rssi);
+
+#endif
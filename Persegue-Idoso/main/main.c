@@ -6,178 +6,712 @@
 #include "freertos/semphr.h"
 #include "nvs_flash.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 
 #include "wifi_modulo.h"
+#include "conexao_modulo.h"
+#include "perfil_boot_modulo.h"
 #include "mqtt_modulo.h"
 #include "gps_modulo.h"
 #include "acelerometro_modulo.h"
+#include "fila_imu_modulo.h"
+#include "detector_queda_modulo.h"
+#include "orientacao_esp.h"
+#include "geofence_modulo.h"
+#include "telemetria_modulo.h"
+#include "energia_modulo.h"
+#include "metricas_esp.h"
+#include "publicador_modulo.h"
+#include "identidade_modulo.h"
 
 #define TAG "SYSTEM"
 
-#define MPU_SENSITIVITY 16384.0 
-#define THRESHOLD_FALL_LOW 0.5
-#define THRESHOLD_ANGLE 60.0    
-#define PI 3.14159265
+// Faixas do menuconfig; cada amostra também carrega a sua
+#define MPU_FAIXA_ACCEL ((Mpu6050FaixaAccel) CONFIG_MPU6050_FAIXA_ACCEL)
+#define MPU_FAIXA_GYRO ((Mpu6050FaixaGyro) CONFIG_MPU6050_FAIXA_GYRO)
+#define MPU_SENSITIVITY mpu6050_lsb_por_g(MPU_FAIXA_ACCEL)     // LSB/g
+#define GYRO_SENSITIVITY mpu6050_lsb_por_dps(MPU_FAIXA_GYRO)   // LSB/(graus/s)
+
+// Amostras drenadas da FIFO por vez (folga para lotes atrasados)
+#define MPU_LOTE_MAX (2 * CONFIG_MPU6050_AMOSTRAS_POR_LOTE)
+#define RELATORIO_FILA_MS 10000
+// Trecho parado usado para (re)calibrar o bias do giroscópio
+#define CALIBRACAO_GYRO_MS 2000
+#define BENCH_ORIENTACAO_ATUALIZACOES 1000
+
+#define GPS_ESPERA_FIX_MS 200
+#define GPS_ESPERA_REPOUSO_MS 1000
+#define GPS_AVISO_SEM_FIX_MS 5000
+#define RELATORIO_GPS_MS 60000
+
+#define OUTBOX_PERIODO_MS 100
+#define OUTBOX_OCIOSO_MS 1000
+#define RELATORIO_OUTBOX_MS 60000
+
+#if CONFIG_TELEMETRIA_FORMATO_BINARIO
+_Static_assert(TELEMETRIA_TAMANHO_MAX_LOTE <= PUBLICADOR_DADOS_MAX, "lote não cabe num bloco do publicador");
+#endif
+#if CONFIG_METRICAS
+_Static_assert(METRICAS_TAMANHO_MAX <= PUBLICADOR_DADOS_MAX, "métricas não cabem num bloco do publicador");
+#endif
+
+// Intervalo esperado entre lotes da FIFO, referência do jitter
+#define MPU_PERIODO_LOTE_US ((int64_t) CONFIG_MPU6050_AMOSTRAS_POR_LOTE * 1000000 / CONFIG_MPU6050_TAXA_AMOSTRAGEM_HZ)
+
+// Interrupção de movimento do MPU6050 no REPOUSO
+#define MPU_MOVIMENTO_DURACAO_MS 2
+#define MPU_MOVIMENTO_WAKE MPU6050_WAKE_20HZ
+
+#define RESUMO_IMU_HABILITADO (CONFIG_TELEMETRIA_FORMATO_BINARIO && CONFIG_TELEMETRIA_RESUMO_IMU_MS > 0)
+
+// Aquisição isolada no APP CPU; detecção e rede no PRO CPU
+#if CONFIG_FREERTOS_UNICORE
+#define CORE_AQUISICAO 0
+#else
+#define CORE_AQUISICAO 1
+#endif
+#define CORE_DETECCAO 0
 
 
-typedef enum {
-    MONITORING,
-    FALL_DETECTED_WAIT,
-    CHECK_ORIENTATION
-} State_t;
-
 // Semáforos e Mutexes
-SemaphoreHandle_t conexaoWifiSemaphore;
-SemaphoreHandle_t conexaoMQTTSemaphore;
 SemaphoreHandle_t gpsDataMutex;
 
 GpsData last_known_position = {0}; 
 
-void task_conexao_manager(void * params)
+// Estado dos alertas ao lado da última posição (o da área segura fica no geofence_modulo)
+typedef struct {
+    int64_t ultima_queda_us;     // Último alerta de queda enviado (0 = nenhum)
+    uint32_t quedas_suprimidas;  // Confirmadas dentro do intervalo de realerta, só no log
+} EstadoAlertas;
+
+static EstadoAlertas estado_alertas = {0};
+
+// Reenvia o que ficou no outbox durante a desconexão, com taxa limitada
+void task_outbox(void * params)
 {
+    int por_periodo = CONFIG_OUTBOX_REENVIO_POR_SEGUNDO * OUTBOX_PERIODO_MS / 1000;
+    if (por_periodo < 1) {
+        por_periodo = 1;
+    }
+    TickType_t periodo = pdMS_TO_TICKS(1000) * por_periodo / CONFIG_OUTBOX_REENVIO_POR_SEGUNDO;
+    TickType_t ultimo_relatorio = xTaskGetTickCount();
+    TickType_t espera = periodo;
+
     while(true) {
-        if(xSemaphoreTake(conexaoWifiSemaphore, portMAX_DELAY)) {
-            ESP_LOGI(TAG, "Wi-Fi OK. Iniciando MQTT...");
-            mqtt_start();
+        vTaskDelay(espera);
+        // Outbox drenado (ou sem conexão): acorda menos para não encurtar o light sleep
+        espera = mqtt_reenvia_outbox(por_periodo) >= por_periodo ? periodo : pdMS_TO_TICKS(OUTBOX_OCIOSO_MS);
+
+        if ((xTaskGetTickCount() - ultimo_relatorio) > pdMS_TO_TICKS(RELATORIO_OUTBOX_MS)) {
+            OutboxEstatisticas est;
+            mqtt_outbox_estatisticas(&est);
+            ESP_LOGI("OUTBOX_TASK", "Outbox: %lu pendentes (%lu prioritárias), %lu/%lu bytes, "
+                     "%lu descartadas, %lu corrompidas, apagamentos max %lu",
+                     (unsigned long) est.pendentes, (unsigned long) est.pendentes_prioritarios,
+                     (unsigned long) est.bytes_usados, (unsigned long) est.bytes_total,
+                     (unsigned long) est.descartados, (unsigned long) est.corrompidos,
+                     (unsigned long) est.apagamentos_max);
+
+            PublicadorEstatisticas pub;
+            publicador_estatisticas(&pub);
+            for (int c = 0; c < PUBLICADOR_NUM_CLASSES; c++) {
+                const PublicadorClasseEstatisticas *e = &pub.classes[c];
+                ESP_LOGI("OUTBOX_TASK", "Publicador classe %d: %lu enfileiradas, %lu enviadas, %lu no outbox, "
+                         "%lu coalescidas, %lu sem bloco, %lu descartadas, fila max %u",
+                         c, (unsigned long) e->enfileiradas, (unsigned long) e->enviadas,
+                         (unsigned long) e->outbox, (unsigned long) e->coalescidas,
+                         (unsigned long) e->sem_bloco, (unsigned long) e->descartadas, e->na_fila_max);
+            }
+            ESP_LOGI("OUTBOX_TASK", "Pool de mensagens: %u/%d em uso (max %u), %lu alocações, %lu violações",
+                     pub.pool.em_uso, PUBLICADOR_MENSAGENS, pub.pool.em_uso_max,
+                     (unsigned long) pub.pool.alocacoes, (unsigned long) pub.pool.violacoes);
+            publicador_verifica();
+            ultimo_relatorio = xTaskGetTickCount();
         }
     }
 }
 
 
-void task_gps(void * params)
+#if CONFIG_METRICAS
+// Saúde do dispositivo em baixa taxa; cada publicação fecha uma janela
+void task_metricas(void * params)
 {
-    xSemaphoreTake(conexaoMQTTSemaphore, portMAX_DELAY);
-    xSemaphoreGive(conexaoMQTTSemaphore);
+    static MetricasSaude metricas;
+    uint16_t sequencia = 0;
+    TickType_t ultimo = xTaskGetTickCount();
+
+    while(true) {
+        vTaskDelayUntil(&ultimo, pdMS_TO_TICKS(CONFIG_METRICAS_PERIODO_S * 1000));
+
+        metricas_coleta(&metricas);
+
+        xSemaphoreTake(gpsDataMutex, portMAX_DELAY);
+        int64_t fix_us = last_known_position.timestamp_us;
+        xSemaphoreGive(gpsDataMutex);
+        if (fix_us > 0) {
+            metricas.idade_fix_ms = (uint32_t) ((esp_timer_get_time() - fix_us) / 1000);
+        }
+
+        metricas_loga(&metricas);
+
+        // Menor prioridade: sem bloco livre a janela é perdida, a próxima cobre
+        PublicadorMensagem *msg = publicador_reserva(PUBLICADOR_METRICAS);
+        if (msg == NULL) continue;
+        size_t tamanho = metricas_codifica(&metricas, identidade_usuario(), sequencia++,
+                                           msg->dados, sizeof(msg->dados));
+        if (tamanho > 0) {
+            publicador_envia(msg, identidade_topico(IDENTIDADE_TOPICO_METRICAS), tamanho);
+        } else {
+            publicador_cancela(msg);
+        }
+    }
+}
+#endif
 
-    char mqtt_payload[256];
 
+void task_gps(void * params)
+{
+    // Não espera a rede: sem conexão as mensagens vão para o outbox
     ESP_LOGI("GPS_TASK", "Iniciando GPS...");
     gps_init();
+    perfil_boot_marca(BOOT_GPS_PRONTO);
+
+    GpsData current_reading = {0};
+    bool fix_novo = false;
+    uint16_t sequencia_gps = 0;
+    TickType_t ultima_publicacao = 0;
+    TickType_t ultimo_fix = xTaskGetTickCount();
+    TickType_t ultimo_relatorio = xTaskGetTickCount();
+    bool gps_em_backup = false;
 
     while(true) {
-        GpsData current_reading;
-        bool valid = gps_read(&current_reading);
+        // Usuário parado: receptor em backup até o IMU detectar movimento
+        bool repouso = energia_estado() == ENERGIA_REPOUSO;
+        if (repouso != gps_em_backup) {
+            gps_standby(repouso); // Sem UBX o receptor segue ligado
+            gps_em_backup = repouso;
+            ultimo_fix = xTaskGetTickCount();
+        }
 
-        if (valid && current_reading.valid) {
+        // Acorda a cada sentença recebida; o timeout só limita a espera pelo próximo fix
+        if (gps_read(&current_reading, pdMS_TO_TICKS(gps_em_backup ? GPS_ESPERA_REPOUSO_MS : GPS_ESPERA_FIX_MS))) {
             xSemaphoreTake(gpsDataMutex, portMAX_DELAY);
             last_known_position = current_reading;
             xSemaphoreGive(gpsDataMutex);
+            perfil_boot_marca(BOOT_PRIMEIRO_FIX);
 
             ESP_LOGD("GPS_TASK", "Posição atualizada: %.6f, %.6f", current_reading.latitude, current_reading.longitude);
+            fix_novo = true;
+
+            // Área segura verificada localmente; só a mudança de estado vai para a rede
+            GeofenceEstado estado_area;
+            if (geofence_atualiza(current_reading.latitude, current_reading.longitude, current_reading.hdop,
+                                  current_reading.timestamp_us, &estado_area)) {
+                ESP_LOGW("GPS_TASK", "Usuário %s da área segura", estado_area == GEOFENCE_DENTRO ? "entrou" : "saiu");
+
+                PublicadorMensagem *msg = publicador_reserva(PUBLICADOR_EVENTO);
+                if (msg != NULL) {
+                    int tamanho = snprintf((char *) msg->dados, sizeof(msg->dados),
+                                    "{"
+                                      "\"usuarioId\": \"%d\","
+                                      "\"dentro\": %s,"
+                                      "\"latitude\": \"%f\","
+                                      "\"longitude\": \"%f\""
+                                    "}",
+                                    identidade_usuario(),
+                                    estado_area == GEOFENCE_DENTRO ? "true" : "false",
+                                    current_reading.latitude,
+                                    current_reading.longitude);
+                    publicador_envia(msg, identidade_topico(IDENTIDADE_TOPICO_AREA_SEGURA), tamanho);
+                }
+                // O backend recebe o trajeto até a transição sem esperar o lote
+                telemetria_lote_urgente();
+            }
+            ultimo_fix = xTaskGetTickCount();
+        } else if (!gps_em_backup && (xTaskGetTickCount() - ultimo_fix) > pdMS_TO_TICKS(GPS_AVISO_SEM_FIX_MS)) {
+            ESP_LOGW("GPS_TASK", "Sem sinal de satélite...");
+            ultimo_fix = xTaskGetTickCount();
+        }
 
-            sprintf(mqtt_payload, 
+        // Registra sempre o fix mais recente, no máximo uma vez por intervalo
+        if (fix_novo && (xTaskGetTickCount() - ultima_publicacao) >= pdMS_TO_TICKS(CONFIG_GPS_INTERVALO_PUBLICACAO_MS)) {
+            gps_registra_idade_fix(esp_timer_get_time() - current_reading.timestamp_us);
+
+#if CONFIG_TELEMETRIA_FORMATO_BINARIO
+            // Vai para o lote; o envio é decidido abaixo
+            telemetria_lote_adiciona_fix(&current_reading);
+#else
+            // Coalescente: com a rede lenta, só o fix mais novo espera na fila
+            PublicadorMensagem *msg = publicador_reserva(PUBLICADOR_POSICAO);
+            if (msg != NULL) {
+                int tamanho = snprintf((char *) msg->dados, sizeof(msg->dados),
                                 "{"
-                                  "\"usuarioId\": \"1\","
+                                  "\"usuarioId\": \"%d\","
                                   "\"latitude\": \"%f\","
                                   "\"longitude\": \"%f\""
                                 "}",
+                                identidade_usuario(),
                                 current_reading.latitude, 
                                 current_reading.longitude);
+                publicador_envia(msg, identidade_topico(IDENTIDADE_TOPICO_GPS), tamanho);
+            }
+#endif
+            ultima_publicacao = xTaskGetTickCount();
+            fix_novo = false;
+        }
 
+#if CONFIG_TELEMETRIA_FORMATO_BINARIO
+        // Um publish por lote: cheio, velho demais ou pedido urgente
+        if (telemetria_lote_deve_enviar(esp_timer_get_time())) {
+            do {
+                // Sem bloco livre o lote fica acumulado para a próxima volta
+                PublicadorMensagem *msg = publicador_reserva(PUBLICADOR_LOTE);
+                if (msg == NULL) break;
+                size_t tamanho = telemetria_lote_codifica(identidade_usuario(), sequencia_gps++,
+                                                          TELEMETRIA_BATERIA_DESCONHECIDA,
+                                                          msg->dados, sizeof(msg->dados));
+                if (tamanho == 0) {
+                    publicador_cancela(msg);
+                    break;
+                }
+                publicador_envia(msg, identidade_topico(IDENTIDADE_TOPICO_GPS), tamanho);
+            } while (telemetria_lote_pendente());
+        }
+#endif
+
+        if ((xTaskGetTickCount() - ultimo_relatorio) > pdMS_TO_TICKS(RELATORIO_GPS_MS)) {
+            GpsMetricas m;
+            gps_metricas(&m);
+            ESP_LOGI("GPS_TASK", "Fixes: %lu, overflows UART: %lu, latencia max: %lu us, idade do fix (ms) "
+                     "<100:%lu <200:%lu <500:%lu <1000:%lu <2000:%lu <5000:%lu >=5000:%lu",
+                     (unsigned long) m.fixes, (unsigned long) m.overflows_uart, (unsigned long) m.latencia_max_us,
+                     (unsigned long) m.idade_histograma[0], (unsigned long) m.idade_histograma[1],
+                     (unsigned long) m.idade_histograma[2], (unsigned long) m.idade_histograma[3],
+                     (unsigned long) m.idade_histograma[4], (unsigned long) m.idade_histograma[5],
+                     (unsigned long) m.idade_histograma[6]);
+#if CONFIG_TELEMETRIA_FORMATO_BINARIO
+            TelemetriaLoteEstatisticas lote_est;
+            telemetria_lote_estatisticas(&lote_est);
+            ESP_LOGI("GPS_TASK", "Lotes: %lu enviados, %lu fixes, %lu resumos IMU, %lu descartados",
+                     (unsigned long) lote_est.lotes_enviados, (unsigned long) lote_est.fixes_enviados,
+                     (unsigned long) lote_est.resumos_enviados, (unsigned long) lote_est.descartados);
+#endif
+            EnergiaEstatisticas energia;
+            energia_estatisticas(&energia);
+            ESP_LOGI("GPS_TASK", "Energia: ativo %lld s (%lu entradas), repouso %lld s (%lu entradas)",
+                     (long long) (energia.tempo_us[ENERGIA_ATIVO] / 1000000), (unsigned long) energia.entradas[ENERGIA_ATIVO],
+                     (long long) (energia.tempo_us[ENERGIA_REPOUSO] / 1000000), (unsigned long) energia.entradas[ENERGIA_REPOUSO]);
+            ultimo_relatorio = xTaskGetTickCount();
+        }
+    }
+}
 
-            mqtt_envia_mensagem("usuario/gps", mqtt_payload);
 
-        } else {
-            ESP_LOGW("GPS_TASK", "Sem sinal de satélite...");
+void task_aquisicao_imu(void * params)
+{
+    TaskHandle_t tarefa_detector = (TaskHandle_t) params;
+
+    ESP_LOGI("IMU_TASK", "Iniciando MPU6050...");
+    Mpu6050BarramentoConfig barramento_cfg = {
+        .freq_hz = CONFIG_MPU6050_I2C_FREQ_HZ,
+#if CONFIG_MPU6050_I2C_ASSINCRONO
+        .assincrono = true,
+#endif
+    };
+    if (mpu6050_init(&barramento_cfg) != ESP_OK) {
+        ESP_LOGE("IMU_TASK", "Erro crítico: Acelerômetro não iniciou!");
+        vTaskDelete(NULL);
+    }
+
+    // Faixa larga o bastante para o pico do impacto; a calibração é aplicada na leitura
+    mpu6050_configura_faixa(MPU_FAIXA_ACCEL, MPU_FAIXA_GYRO);
+    if (mpu6050_calibracao_carrega() != ESP_OK) {
+        ESP_LOGW("IMU_TASK", "Acelerômetro sem calibração de seis posições");
+    }
+
+    Mpu6050FifoConfig fifo_cfg = {
+        .taxa_hz = CONFIG_MPU6050_TAXA_AMOSTRAGEM_HZ,
+        .dlpf_cfg = CONFIG_MPU6050_DLPF_CFG,
+        .amostras_por_lote = CONFIG_MPU6050_AMOSTRAS_POR_LOTE,
+        .pino_int = CONFIG_MPU6050_PINO_INT,
+        .perfil = (Mpu6050PerfilLeitura) CONFIG_MPU6050_PERFIL,
+    };
+    if (mpu6050_fifo_iniciar(&fifo_cfg, xTaskGetCurrentTaskHandle()) != ESP_OK) {
+        ESP_LOGE("IMU_TASK", "Erro crítico: FIFO do acelerômetro não iniciou!");
+        vTaskDelete(NULL);
+    }
+    perfil_boot_marca(BOOT_IMU_PRONTO);
+
+    Mpu6050Data lote[MPU_LOTE_MAX];
+    size_t lidas = 0;
+
+#if CONFIG_ENERGIA_REPOUSO
+    Mpu6050MovimentoConfig movimento_cfg = {
+        .limiar_mg = CONFIG_ENERGIA_LIMIAR_MOVIMENTO_MG,
+        .duracao_ms = MPU_MOVIMENTO_DURACAO_MS,
+        .frequencia_wake = MPU_MOVIMENTO_WAKE,
+    };
+#endif
+
+    while(true) {
+#if CONFIG_ENERGIA_REPOUSO
+        // Pedido do detector: só esta task mexe no MPU6050
+        if (energia_repouso_solicitado()) {
+            if (mpu6050_modo_movimento(&movimento_cfg) == ESP_OK) {
+                energia_define_estado(ENERGIA_REPOUSO);
+                // Sem timeout: o INT de movimento fica travado e também tira o chip do light sleep
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                ESP_LOGI("IMU_TASK", "Movimento detectado, retomando amostragem");
+            }
+            mpu6050_fifo_retoma();
+            energia_define_estado(ENERGIA_ATIVO);
+            continue;
         }
+#endif
+
+        // Acorda a cada lote completo na FIFO e no fim de cada burst; o timeout só cobre um INT perdido
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
 
-        vTaskDelay(5000 / portTICK_PERIOD_MS);
+        // Burst ainda no barramento: o callback acorda de novo
+        if (mpu6050_fifo_conclui_lote(lote, &lidas) == ESP_ERR_NOT_FINISHED) {
+            continue;
+        }
+        // Já enfileira o próximo; frames que chegaram durante o burst saem nele
+        mpu6050_fifo_inicia_lote(MPU_LOTE_MAX);
+        if (lidas == 0) {
+            continue;
+        }
+
+        perfil_boot_marca(BOOT_PRIMEIRA_AMOSTRA);
+#if CONFIG_METRICAS
+        metricas_registra_lote_imu(esp_timer_get_time());
+#endif
+
+        // Amostras que não couberem entram no contador de overruns da fila
+        for (size_t i = 0; i < lidas; i++) {
+            fila_imu_push(&lote[i]);
+        }
+
+        xTaskNotifyGive(tarefa_detector);
     }
 }
 
 
-void task_detector_quedas(void * params)
+// Estado da task do detector usado pelos observadores (resumo IMU e repouso)
+typedef struct {
+    Detector *detector;
+    OrientacaoCalibracao calibracao;
+#if CONFIG_MPU6050_CALIBRACAO_SEIS_POSICOES
+    Mpu6050CalibracaoSeisPosicoes seis_posicoes;
+    bool seis_posicoes_concluida;
+#endif
+#if CONFIG_ENERGIA_REPOUSO
+    EnergiaParado parado;
+#endif
+#if RESUMO_IMU_HABILITADO
+    // Janela do resumo enviado no lote de telemetria (min/max de |a|^2)
+    int64_t resumo_inicio_us;
+    uint32_t resumo_mag2_min;
+    uint32_t resumo_mag2_max;
+    uint32_t resumo_amostras;
+#endif
+} DetectorTarefa;
+
+static size_t detector_le_fila(void *ctx, Mpu6050Data *amostras, size_t max)
 {
-    xSemaphoreTake(conexaoMQTTSemaphore, portMAX_DELAY);
-    xSemaphoreGive(conexaoMQTTSemaphore);
+    return fila_imu_pop_lote(amostras, max);
+}
 
-    ESP_LOGI("FALL_TASK", "Iniciando MPU6050...");
-    if (mpu6050_init() != ESP_OK) {
-        ESP_LOGE("FALL_TASK", "Erro crítico: Acelerômetro não iniciou!");
-        vTaskDelete(NULL);
+static int64_t detector_relogio(void *ctx)
+{
+    return esp_timer_get_time();
+}
+
+#if CONFIG_MPU6050_CALIBRACAO_SEIS_POSICOES
+static void detector_calibra_seis_posicoes(DetectorTarefa *t, const Mpu6050Data *dados_mpu)
+{
+    static const char *const faces[MPU6050_NUM_FACES] = {"+X", "-X", "+Y", "-Y", "+Z", "-Z"};
+
+    switch (mpu6050_seis_posicoes_adiciona(&t->seis_posicoes, dados_mpu)) {
+        case MPU6050_CAL_FACE_CAPTURADA: {
+            char faltam[3 * MPU6050_NUM_FACES + 1] = "";
+            for (int f = 0; f < MPU6050_NUM_FACES; f++) {
+                if (!mpu6050_seis_posicoes_tem_face(&t->seis_posicoes, (Mpu6050Face) f)) {
+                    strcat(faltam, faces[f]);
+                    strcat(faltam, " ");
+                }
+            }
+            ESP_LOGI("FALL_TASK", "Calibração: face capturada. Faltam: %s", faltam);
+            break;
+        }
+
+        case MPU6050_CAL_COMPLETA: {
+            // Medida sobre amostras já corrigidas pela calibração atual: compõe as duas
+            Mpu6050Calibracao atual, nova;
+            mpu6050_calibracao_atual(&atual);
+            mpu6050_seis_posicoes_resultado(&t->seis_posicoes, &nova);
+            mpu6050_calibracao_compoe(&atual, &nova, &nova);
+            t->seis_posicoes_concluida = true;
+
+            if (mpu6050_calibracao_salva(&nova) != ESP_OK) {
+                ESP_LOGE("FALL_TASK", "Calibração rejeitada (offset %.3f %.3f %.3f g, ganho %.4f %.4f %.4f)",
+                         nova.offset_g[0], nova.offset_g[1], nova.offset_g[2],
+                         nova.ganho[0], nova.ganho[1], nova.ganho[2]);
+                break;
+            }
+            mpu6050_define_calibracao(&nova);
+            ESP_LOGI("FALL_TASK", "Calibração salva: offset %.3f %.3f %.3f g, ganho %.4f %.4f %.4f",
+                     nova.offset_g[0], nova.offset_g[1], nova.offset_g[2],
+                     nova.ganho[0], nova.ganho[1], nova.ganho[2]);
+            break;
+        }
+
+        default:
+            break;
     }
+}
+#endif
+
+static void detector_observa_amostra(void *ctx, const Mpu6050Data *dados_mpu, uint32_t mag2)
+{
+    DetectorTarefa *t = (DetectorTarefa *) ctx;
 
-    State_t current_state = MONITORING;
-    TickType_t fall_timer_start = 0;
-    char mqtt_payload[256];
-    Mpu6050Data dados_mpu;
+    // Todo trecho parado fora de evento refina o bias; a NVS só é gravada se ele mudou, e sem pressa
+    float bias[3];
+    if (!detector_em_evento(t->detector) && orientacao_calibracao_adiciona(&t->calibracao, dados_mpu, bias)) {
+        orientacao_define_bias(detector_orientacao(t->detector), bias);
+        orientacao_bias_salva(bias, GYRO_SENSITIVITY);
+    }
 
-    while(true) {
-        if (mpu6050_read(&dados_mpu) == ESP_OK) {
-            
-            float ax_g = dados_mpu.accel_x / MPU_SENSITIVITY;
-            float ay_g = dados_mpu.accel_y / MPU_SENSITIVITY;
-            float az_g = dados_mpu.accel_z / MPU_SENSITIVITY;
-
-            float a_net = sqrt(pow(ax_g, 2) + pow(ay_g, 2) + pow(az_g, 2));
-
-            float roll = atan(ay_g / (sqrt(pow(ax_g, 2) + pow(az_g, 2)) + 0.001)) * 180.0 / PI;
-            float pitch = atan(-ax_g / (sqrt(pow(ay_g, 2) + pow(az_g, 2)) + 0.001)) * 180.0 / PI;
-
-            switch (current_state) {
-                case MONITORING:
-                    if (a_net < THRESHOLD_FALL_LOW) {
-                        ESP_LOGW("FALL_TASK", "Queda livre detectada! (%.2fg). Monitorando impacto...", a_net);
-                        fall_timer_start = xTaskGetTickCount();
-                        current_state = FALL_DETECTED_WAIT;
-                    }
-                    break;
+#if CONFIG_MPU6050_CALIBRACAO_SEIS_POSICOES
+    if (!t->seis_posicoes_concluida) {
+        detector_calibra_seis_posicoes(t, dados_mpu);
+    }
+#endif
 
-                case FALL_DETECTED_WAIT:
-                    if ((xTaskGetTickCount() - fall_timer_start) > pdMS_TO_TICKS(2000)) {
-                        current_state = CHECK_ORIENTATION;
-                    }
-                    break;
+#if RESUMO_IMU_HABILITADO
+    if (t->resumo_amostras == 0) {
+        t->resumo_inicio_us = dados_mpu->timestamp_us;
+        t->resumo_mag2_min = UINT32_MAX;
+        t->resumo_mag2_max = 0;
+    }
+    if (mag2 < t->resumo_mag2_min) t->resumo_mag2_min = mag2;
+    if (mag2 > t->resumo_mag2_max) t->resumo_mag2_max = mag2;
+    t->resumo_amostras++;
+
+    if ((dados_mpu->timestamp_us - t->resumo_inicio_us) >= (int64_t)CONFIG_TELEMETRIA_RESUMO_IMU_MS * 1000) {
+        // Duas raízes por janela, fora do caminho por amostra
+        TelemetriaResumoImu resumo = {
+            .timestamp_us = t->resumo_inicio_us,
+            .amostras = t->resumo_amostras > UINT16_MAX ? UINT16_MAX : (uint16_t) t->resumo_amostras,
+            .mag_min_mg = (uint16_t)(sqrtf((float) t->resumo_mag2_min) * 1000.0f / MPU_SENSITIVITY),
+            .mag_max_mg = (uint16_t)(sqrtf((float) t->resumo_mag2_max) * 1000.0f / MPU_SENSITIVITY),
+        };
+        telemetria_lote_adiciona_resumo(&resumo);
+        t->resumo_amostras = 0;
+    }
+#endif
+
+#if CONFIG_ENERGIA_REPOUSO
+    // Parado por tempo suficiente fora de uma queda: IMU e GPS vão para o REPOUSO
+    if (energia_parado_atualiza(&t->parado, mag2, dados_mpu->timestamp_us) &&
+        !detector_em_evento(t->detector) && !detector_bloqueado(t->detector, dados_mpu->timestamp_us)) {
+        energia_solicita_repouso();
+        energia_parado_reinicia(&t->parado, dados_mpu->timestamp_us);
+    }
+#endif
+}
 
-                case CHECK_ORIENTATION:
-                    if (fabs(pitch) > THRESHOLD_ANGLE || fabs(roll) > THRESHOLD_ANGLE) {
-                        
-                        ESP_LOGE("FALL_TASK", "QUEDA CONFIRMADA! Pitch: %.2f, Roll: %.2f", pitch, roll);
-                        
-                        GpsData loc_snapshot = {0};
-                        xSemaphoreTake(gpsDataMutex, portMAX_DELAY);
-                        loc_snapshot = last_known_position;
-                        xSemaphoreGive(gpsDataMutex);
-
-                        sprintf(mqtt_payload, "ALERTA QUEDA");
-
-                        mqtt_envia_mensagem("/usuario/queda", mqtt_payload);
-                        
-                        vTaskDelay(pdMS_TO_TICKS(10000));
-
-                    } else {
-                        ESP_LOGI("FALL_TASK", "Usuário se recuperou ou foi alarme falso.");
-                    }
-                    
-                    current_state = MONITORING;
-                    break;
+static void detector_observa_resultado(void *ctx, const Detector *detector, DetectorResultado resultado)
+{
+    const DetectorCaracteristicas *evento = detector_ultimo_evento(detector);
+
+    switch (resultado) {
+        case DETECTOR_EVENTO_INICIADO:
+            ESP_LOGW("FALL_TASK", "Possível queda (%.2fg). Acompanhando impacto e imobilidade...",
+                     sqrtf((float) detector_magnitude2(&detector->ultima_amostra)) / detector->sensibilidade_accel);
+            break;
+
+        case DETECTOR_QUEDA_CONFIRMADA: {
+            float roll, pitch;
+            orientacao_roll_pitch(&detector->orientacao, &roll, &pitch);
+            ESP_LOGE("FALL_TASK", "QUEDA CONFIRMADA em %lld ms! Pontos %d, queda livre %d ms, impacto %d mg, "
+                     "rotação %d dps, orientação %d graus, imóvel %d ms",
+                     (long long) ((evento->decisao_us - evento->inicio_us) / 1000), evento->pontuacao,
+                     evento->valores[DETECTOR_CRIT_QUEDA_LIVRE], evento->valores[DETECTOR_CRIT_IMPACTO],
+                     evento->valores[DETECTOR_CRIT_ROTACAO], evento->valores[DETECTOR_CRIT_ORIENTACAO],
+                     evento->valores[DETECTOR_CRIT_IMOBILIDADE]);
+            ESP_LOGW("FALL_TASK", "Atitude final: roll %.0f graus, pitch %.0f graus", roll, pitch);
+
+            GpsData loc_snapshot = {0};
+            xSemaphoreTake(gpsDataMutex, portMAX_DELAY);
+            loc_snapshot = last_known_position;
+            xSemaphoreGive(gpsDataMutex);
+
+            // Usuário caído que se debate confirma de novo a cada bloqueio do detector: um alerta basta
+            if (estado_alertas.ultima_queda_us != 0 &&
+                evento->decisao_us - estado_alertas.ultima_queda_us < (int64_t) CONFIG_DETECTOR_INTERVALO_REALERTA_S * 1000000) {
+                estado_alertas.quedas_suprimidas++;
+                ESP_LOGW("FALL_TASK", "Queda repetida dentro do intervalo de realerta, não enviada (%lu suprimidas)",
+                         (unsigned long) estado_alertas.quedas_suprimidas);
+                telemetria_lote_urgente();
+                break;
+            }
+            estado_alertas.ultima_queda_us = evento->decisao_us;
+
+            // Nunca bloqueia: o alerta passa na frente de tudo na tarefa do publicador
+            PublicadorMensagem *msg = publicador_reserva(PUBLICADOR_ALERTA);
+            if (msg != NULL) {
+                int tamanho = snprintf((char *) msg->dados, sizeof(msg->dados), "ALERTA QUEDA");
+                publicador_envia(msg, identidade_topico(IDENTIDADE_TOPICO_QUEDA), tamanho);
             }
+            telemetria_lote_urgente();
+            break;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(100)); 
+        case DETECTOR_EVENTO_DESCARTADO:
+            ESP_LOGI("FALL_TASK", "Usuário se recuperou ou foi alarme falso (pontos %d, impacto %d mg, "
+                     "orientação %d graus, imóvel %d ms).",
+                     evento->pontuacao, evento->valores[DETECTOR_CRIT_IMPACTO],
+                     evento->valores[DETECTOR_CRIT_ORIENTACAO], evento->valores[DETECTOR_CRIT_IMOBILIDADE]);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void task_detector_quedas(void * params)
+{
+    static Mpu6050Data lote[MPU_LOTE_MAX];
+    TickType_t ultimo_relatorio = xTaskGetTickCount();
+
+    // Tabela de limiares/pesos do menuconfig; pode ser trocada com detector_configura()
+    static Detector detector;
+    DetectorConfig detector_cfg;
+    detector_config_padrao(&detector_cfg);
+    detector_init(&detector, &detector_cfg, MPU_FAIXA_ACCEL, MPU_FAIXA_GYRO);
+    if (detector.limiares.saturados != 0) {
+        ESP_LOGW("FALL_TASK", "Limiares acima do fundo de escala (máscara 0x%x): limitados a %.1f g / %.0f graus/s",
+                 detector.limiares.saturados, 32767.0f / MPU_SENSITIVITY, 32767.0f / GYRO_SENSITIVITY);
+    }
+
+    // Bias da última calibração; sem ele o filtro começa com zero e calibra no primeiro trecho parado
+    float bias[3];
+    if (orientacao_bias_carrega(bias, GYRO_SENSITIVITY) == ESP_OK) {
+        orientacao_define_bias(detector_orientacao(&detector), bias);
+        ESP_LOGI("FALL_TASK", "Bias do giroscópio da NVS: %.1f %.1f %.1f LSB", bias[0], bias[1], bias[2]);
+    }
+
+    uint32_t ciclos = orientacao_mede_ciclos(BENCH_ORIENTACAO_ATUALIZACOES);
+    if (ciclos > ORIENTACAO_ORCAMENTO_CICLOS) {
+        ESP_LOGW("FALL_TASK", "Filtro de atitude: %lu ciclos/amostra, acima do orçamento de %d",
+                 (unsigned long) ciclos, ORIENTACAO_ORCAMENTO_CICLOS);
+    } else {
+        ESP_LOGI("FALL_TASK", "Filtro de atitude: %lu ciclos/amostra (orçamento %d)",
+                 (unsigned long) ciclos, ORIENTACAO_ORCAMENTO_CICLOS);
+    }
+
+    static DetectorTarefa tarefa = { .detector = &detector };
+    orientacao_calibracao_init(&tarefa.calibracao,
+                               CONFIG_MPU6050_TAXA_AMOSTRAGEM_HZ * CALIBRACAO_GYRO_MS / 1000,
+                               MPU_SENSITIVITY, GYRO_SENSITIVITY);
+#if CONFIG_MPU6050_CALIBRACAO_SEIS_POSICOES
+    mpu6050_seis_posicoes_init(&tarefa.seis_posicoes, CONFIG_MPU6050_CALIBRACAO_AMOSTRAS_FACE);
+    ESP_LOGW("FALL_TASK", "Calibração de seis posições: deixe cada face (+X -X +Y -Y +Z -Z) para cima, parada");
+#endif
+#if CONFIG_ENERGIA_REPOUSO
+    energia_parado_init(&tarefa.parado, CONFIG_ENERGIA_LIMIAR_PARADO_MG / 1000.0f, MPU_SENSITIVITY,
+                        CONFIG_ENERGIA_TEMPO_PARADO_S * 1000);
+#endif
+
+    // O classificador não conhece FreeRTOS: amostras vêm da fila do IMU e o relógio do esp_timer
+    const DetectorEntrada entrada = {
+        .le_lote = detector_le_fila,
+        .agora_us = detector_relogio,
+        .ctx = NULL,
+    };
+    const DetectorObservador observador = {
+        .amostra = detector_observa_amostra,
+        .resultado = detector_observa_resultado,
+        .ctx = &tarefa,
+    };
+
+    while(true) {
+        // Acordada pela task de aquisição a cada lote colocado na fila; no REPOUSO, só pelo relatório
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RELATORIO_FILA_MS));
+
+        detector_executa(&detector, &entrada, &observador, lote, MPU_LOTE_MAX);
+
+        if ((xTaskGetTickCount() - ultimo_relatorio) > pdMS_TO_TICKS(RELATORIO_FILA_MS)) {
+            FilaImuEstatisticas est;
+            fila_imu_estatisticas(&est);
+            ESP_LOGI("FALL_TASK", "Fila IMU: %lu escritas, %lu lidas, %lu overruns, ocupacao max %lu, overflows FIFO %lu",
+                     (unsigned long) est.escritas, (unsigned long) est.leituras,
+                     (unsigned long) est.overruns, (unsigned long) est.ocupacao_max,
+                     (unsigned long) mpu6050_fifo_overflows());
+            Mpu6050EstatisticasI2c i2c = mpu6050_i2c_estatisticas();
+            ESP_LOGI("FALL_TASK", "I2C %lu kHz: %lu transacoes, %lu erros, %llu bytes, media %llu us, max %lu us",
+                     (unsigned long) (i2c.freq_hz / 1000), (unsigned long) i2c.transacoes,
+                     (unsigned long) i2c.erros, (unsigned long long) i2c.bytes,
+                     (unsigned long long) (i2c.transacoes ? i2c.tempo_total_us / i2c.transacoes : 0),
+                     (unsigned long) i2c.tempo_max_us);
+            ultimo_relatorio = xTaskGetTickCount();
+        }
     }
 }
 
 void app_main(void)
 {
+    perfil_boot_marca(BOOT_APP_MAIN);
+
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    perfil_boot_marca(BOOT_NVS_PRONTO);
 
-    conexaoWifiSemaphore = xSemaphoreCreateBinary();
-    conexaoMQTTSemaphore = xSemaphoreCreateBinary();
-    gpsDataMutex = xSemaphoreCreateMutex();
+    // Id, usuário e broker vêm do NVS; os tópicos de publicação dependem deles
+    ESP_ERROR_CHECK(identidade_init());
 
-    wifi_start();
+    // DFS e light sleep automático; começa em ATIVO, com o light sleep bloqueado
+    energia_init();
 
-    // Task de Conexão
-    xTaskCreate(task_conexao_manager, "ConnManager", 4096, NULL, 5, NULL);
+    gpsDataMutex = xSemaphoreCreateMutex();
+#if CONFIG_METRICAS
+    metricas_init(MPU_PERIODO_LOTE_US);
+#endif
+
+    // Tudo que os sensores usam para publicar precisa existir antes das tasks
+    mqtt_outbox_init();
+    publicador_init();
+    geofence_init();
+    telemetria_lote_init();
+    mqtt_registra_callback(GEOFENCE_TOPICO, geofence_recebe_mqtt);
+
+    // Sensores primeiro: detecção não depende de Wi-Fi/MQTT
+    // Task de Queda (Prioridade Alta, 10) - consome a fila IMU no core do Wi-Fi/MQTT
+    TaskHandle_t fall_task_handle = NULL;
+    xTaskCreatePinnedToCore(task_detector_quedas, "FallTask", 4096, NULL, 10, &fall_task_handle, CORE_DETECCAO);
+    // Task de aquisição IMU (Prioridade máxima da aplicação, 20) - sozinha no outro core
+    xTaskCreatePinnedToCore(task_aquisicao_imu, "ImuTask", 4096, fall_task_handle, 20, NULL, CORE_AQUISICAO);
     // Task do GPS (Prioridade baixa, 2)
     xTaskCreate(task_gps, "GpsTask", 4096, NULL, 2, NULL);
-    // Task de Queda (Prioridade Alta, 10)
-    xTaskCreate(task_detector_quedas, "FallTask", 4096, NULL, 10, NULL);
-}
\ No newline at end of file
+    perfil_boot_marca(BOOT_TASKS_SENSORES);
+
+    // Rede em paralelo. Supervisor de Wi-Fi/MQTT (Prioridade 5); wifi_start() não bloqueia
+    conexao_inicia();
+    wifi_start();
+    perfil_boot_marca(BOOT_WIFI_INICIADO);
+
+    // Task de reenvio do outbox (Prioridade baixa, 3)
+    xTaskCreate(task_outbox, "OutboxTask", 4096, NULL, 3, NULL);
+
+#if CONFIG_METRICAS
+    // Métricas de saúde (Prioridade mínima, 1): mede as outras sem atrapalhar
+    xTaskCreate(task_metricas, "MetricasTask", 3072, NULL, 1, NULL);
+#endif
+}
@@ -0,0 +1,101 @@
+"""Gera as gravações sintéticas usadas por replay_detector.
+
+Modelo físico simples: a gravidade no referencial do corpo é girada pelo
+mesmo ω que o giroscópio mede (dG/dt = -ω x G), e o acelerômetro lê a
+gravidade escalada (queda livre < 1, impacto > 1) mais ruído. O giroscópio
+tem um bias residual de poucos LSB, como depois do bias salvo na NVS.
+
+    python3 gera.py    # reescreve os .csv deste diretório
+"""
+import math
+import os
+import random
+
+TAXA_HZ = 100
+LSB_G = 16384.0     # ±2 g
+LSB_DPS = 131.0     # ±250 graus/s
+BIAS_LSB = (3, -2, 1)
+
+
+def sat(v):
+    return max(-32768, min(32767, int(v)))
+
+
+class Trace:
+    def __init__(self, semente):
+        self.rnd = random.Random(semente)
+        self.g = [0.0, 0.0, 1.0]
+        self.t_us = 1000000
+        self.linhas = []
+
+    def seg(self, wx, wy, wz, escala, linear, ms, ruido):
+        dt = 1.0 / TAXA_HZ
+        for _ in range(ms * TAXA_HZ // 1000):
+            w = [math.radians(wx), math.radians(wy), math.radians(wz)]
+            g = self.g
+            c = [w[1] * g[2] - w[2] * g[1], w[2] * g[0] - w[0] * g[2], w[0] * g[1] - w[1] * g[0]]
+            g = [g[k] - c[k] * dt for k in range(3)]
+            n = math.sqrt(sum(v * v for v in g))
+            self.g = [v / n for v in g]
+            a = [sat((self.g[k] * (escala + linear) + (self.rnd.random() - 0.5) * ruido) * LSB_G) for k in range(3)]
+            gy = [sat(wv * LSB_DPS + BIAS_LSB[k] + (self.rnd.random() - 0.5) * 4) for k, wv in enumerate((wx, wy, wz))]
+            self.t_us += 1000000 // TAXA_HZ
+            self.linhas.append((self.t_us, *a, *gy))
+
+    def parado(self, ms):
+        self.seg(0, 0, 0, 1, 0, ms, 0.02)
+
+
+def queda_frente(t):
+    t.seg(0, 200, 0, 0.2, 0, 300, 0.1); t.seg(0, 240, 0, 1, 3.5, 40, 0.3); t.seg(0, 40, 0, 0.7, 0, 200, 0.3)
+
+
+def queda_lado(t):
+    t.seg(-300, 0, 0, 0.3, 0, 250, 0.1); t.seg(-400, 0, 0, 1, 4.0, 40, 0.3)
+
+
+def queda_lenta(t):
+    t.seg(0, 100, 0, 0.45, 0, 600, 0.2); t.seg(0, 240, 0, 1, 1.5, 40, 0.3)
+
+
+def sentar(t):
+    t.seg(0, 10, 0, 0.7, 0, 300, 0.1); t.seg(0, 30, 0, 1, 0.9, 40, 0.2)
+
+
+def andar(t):
+    for _ in range(10):
+        t.seg(10, 0, 0, 1, 0.4, 150, 0.2); t.seg(-10, 0, 0, 0.7, 0, 150, 0.2)
+
+
+def tropeco(t):
+    t.seg(0, 60, 0, 0.3, 0, 100, 0.1); t.seg(0, -150, 0, 1, 1.0, 60, 0.2)
+    for _ in range(4):
+        t.seg(0, 10, 0, 1, 0.3, 150, 0.2); t.seg(0, -10, 0, 0.8, 0, 150, 0.2)
+
+
+def deitar(t):
+    t.seg(0, 40, 0, 1, 0, 1500, 0.05); t.seg(0, 30, 0, 1, 0, 1000, 0.05)
+
+
+CASOS = [
+    ("queda_frente", queda_frente, "queda"),
+    ("queda_lado", queda_lado, "queda"),
+    ("queda_lenta", queda_lenta, "queda"),
+    ("adl_sentar", sentar, "adl"),
+    ("adl_andar", andar, "adl"),
+    ("adl_tropeco", tropeco, "adl"),
+    ("adl_deitar", deitar, "adl"),
+]
+
+if __name__ == "__main__":
+    pasta = os.path.dirname(os.path.abspath(__file__))
+    for i, (nome, gera, rotulo) in enumerate(CASOS):
+        t = Trace(i + 1)
+        t.parado(1000)
+        gera(t)
+        t.parado(3000)
+        with open(os.path.join(pasta, nome + ".csv"), "w") as f:
+            f.write(f"# rotulo={rotulo}\n# faixa_accel=0\n# faixa_gyro=0\n# taxa_hz={TAXA_HZ}\n")
+            f.write("t_us,ax,ay,az,gx,gy,gz\n")
+            for linha in t.linhas:
+                f.write(",".join(str(v) for v in linha) + "\n")
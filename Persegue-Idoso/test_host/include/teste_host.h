@@ -0,0 +1,33 @@
+#ifndef TESTE_HOST_H
+#define TESTE_HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Cada programa de teste é um único .c: o contador é dele */
+static int s_falhas __attribute__((unused)) = 0;
+
+/* Não aborta: conta a falha, imprime e segue para mostrar todas */
+#define CONFERE(cond, ...)                      \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            printf("  FALHA: " __VA_ARGS__);    \
+            printf("\n");                       \
+            s_falhas++;                         \
+        }                                       \
+    } while (0)
+
+/* Benchmarks repetem o trabalho até somar pelo menos isto */
+#define TEMPO_MINIMO_BENCH_NS 200000000LL
+
+static inline int64_t agora_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,383 @@
+/* --------------------------------------------------------------------------
+ *  Reproduz gravações do IMU pelo classificador de quedas do firmware
+ *  (detector_executa com a configuração padrão do sdkconfig) e imprime
+ *  sensibilidade, especificidade e o custo por amostra no host (ns e ciclos
+ *  de TSC no x86) de três versões, nas mesmas amostras:
+ *   - o código antigo, em double, com sqrt/pow/atan por amostra;
+ *   - o kernel em inteiros que o substituiu (|a|^2 e |ω|^2 contra os
+ *     limiares ao quadrado);
+ *   - detector_executa inteiro, com o filtro de atitude e a calibração.
+ *  No host o double tem FPU; no ESP32 não, e a diferença é bem maior.
+ *
+ *    replay_detector gravacoes/queda_frente.csv gravacoes/adl_andar.csv ...
+ *
+ *  Formato da gravação: linhas "# chave=valor" (rotulo=queda|adl,
+ *  faixa_accel, faixa_gyro), um cabeçalho e "t_us,ax,ay,az,gx,gy,gz" em LSB.
+ *  Sai com 1 se alguma gravação for classificada errado.
+ * -------------------------------------------------------------------------- */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "detector_queda_modulo.h"
+#include "orientacao_modulo.h"
+#include "teste_host.h"
+
+#define LOTE_MAX 32              // Como MPU_LOTE_MAX com 16 amostras por lote
+#define CALIBRACAO_GYRO_MS 2000  // Como em main.c
+
+typedef struct
+{
+    char nome[128];
+    bool queda;
+    Mpu6050Data *amostras;
+    size_t n;
+} Gravacao;
+
+typedef struct
+{
+    const Gravacao *gravacao;
+    size_t pos;
+    Detector *detector;
+    OrientacaoCalibracao calibracao;
+    int quedas;
+    uint8_t pontuacao;
+} Reproducao;
+
+static bool carrega(const char *caminho, Gravacao *g)
+{
+    FILE *f = fopen(caminho, "r");
+    if (f == NULL)
+    {
+        perror(caminho);
+        return false;
+    }
+
+    const char *barra = strrchr(caminho, '/');
+    snprintf(g->nome, sizeof(g->nome), "%s", barra ? barra + 1 : caminho);
+    g->queda = false;
+    g->amostras = NULL;
+    g->n = 0;
+
+    size_t capacidade = 0;
+    int faixa_accel = 0;
+    int faixa_gyro = 0;
+    bool rotulada = false;
+    char linha[256];
+    while (fgets(linha, sizeof(linha), f) != NULL)
+    {
+        char rotulo[16];
+        if (linha[0] == '#')
+        {
+            if (sscanf(linha, "# rotulo=%15s", rotulo) == 1)
+            {
+                g->queda = strcmp(rotulo, "queda") == 0;
+                rotulada = true;
+            }
+            sscanf(linha, "# faixa_accel=%d", &faixa_accel);
+            sscanf(linha, "# faixa_gyro=%d", &faixa_gyro);
+            continue;
+        }
+
+        long long t;
+        int v[6];
+        if (sscanf(linha, "%lld,%d,%d,%d,%d,%d,%d", &t, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 7)
+        {
+            continue; // Cabeçalho
+        }
+        if (g->n == capacidade)
+        {
+            capacidade = capacidade ? 2 * capacidade : 1024;
+            g->amostras = realloc(g->amostras, capacidade * sizeof(*g->amostras));
+        }
+        g->amostras[g->n++] = (Mpu6050Data){
+            .accel_x = (int16_t)v[0], .accel_y = (int16_t)v[1], .accel_z = (int16_t)v[2],
+            .gyro_x = (int16_t)v[3], .gyro_y = (int16_t)v[4], .gyro_z = (int16_t)v[5],
+            .faixa_accel = (uint8_t)faixa_accel, .faixa_gyro = (uint8_t)faixa_gyro,
+            .timestamp_us = t,
+        };
+    }
+    fclose(f);
+
+    if (!rotulada || g->n < 2)
+    {
+        fprintf(stderr, "%s: sem rótulo ou sem amostras\n", caminho);
+        return false;
+    }
+    return true;
+}
+
+static size_t le_lote(void *ctx, Mpu6050Data *amostras, size_t max)
+{
+    Reproducao *r = ctx;
+    size_t n = r->gravacao->n - r->pos;
+    if (n > max)
+    {
+        n = max;
+    }
+    memcpy(amostras, &r->gravacao->amostras[r->pos], n * sizeof(*amostras));
+    r->pos += n;
+    return n;
+}
+
+/* Relógio da gravação: o instante da última amostra entregue */
+static int64_t relogio(void *ctx)
+{
+    Reproducao *r = ctx;
+    return r->pos ? r->gravacao->amostras[r->pos - 1].timestamp_us : 0;
+}
+
+/* Como detector_observa_amostra: trechos parados fora de evento calibram o giroscópio */
+static void observa_amostra(void *ctx, const Mpu6050Data *amostra, uint32_t mag2)
+{
+    Reproducao *r = ctx;
+    float bias[3];
+    if (!detector_em_evento(r->detector) && orientacao_calibracao_adiciona(&r->calibracao, amostra, bias))
+    {
+        orientacao_define_bias(detector_orientacao(r->detector), bias);
+    }
+}
+
+static void observa_resultado(void *ctx, const Detector *detector, DetectorResultado resultado)
+{
+    Reproducao *r = ctx;
+    if (resultado == DETECTOR_QUEDA_CONFIRMADA || resultado == DETECTOR_EVENTO_DESCARTADO)
+    {
+        uint8_t pontuacao = detector_ultimo_evento(detector)->pontuacao;
+        if (pontuacao > r->pontuacao)
+        {
+            r->pontuacao = pontuacao;
+        }
+    }
+    if (resultado == DETECTOR_QUEDA_CONFIRMADA)
+    {
+        r->quedas++;
+    }
+}
+
+static void reproduz(const Gravacao *g, const DetectorConfig *config, Reproducao *r)
+{
+    static Detector detector;
+    const Mpu6050Data *primeira = &g->amostras[0];
+    detector_init(&detector, config, (Mpu6050FaixaAccel)primeira->faixa_accel,
+                  (Mpu6050FaixaGyro)primeira->faixa_gyro);
+
+    int64_t periodo_us = g->amostras[1].timestamp_us - primeira->timestamp_us;
+    *r = (Reproducao){ .gravacao = g, .detector = &detector };
+    orientacao_calibracao_init(&r->calibracao, (uint32_t)(CALIBRACAO_GYRO_MS * 1000 / periodo_us),
+                               mpu6050_lsb_por_g(primeira->faixa_accel),
+                               mpu6050_lsb_por_dps(primeira->faixa_gyro));
+
+    const DetectorEntrada entrada = { .le_lote = le_lote, .agora_us = relogio, .ctx = r };
+    const DetectorObservador observador = {
+        .amostra = observa_amostra,
+        .resultado = observa_resultado,
+        .ctx = r,
+    };
+    Mpu6050Data lote[LOTE_MAX];
+    detector_executa(&detector, &entrada, &observador, lote, LOTE_MAX);
+}
+
+/* --------------------------------------------------------------------------
+ *  Código antigo de task_detector_quedas (antes do kernel em inteiros), sem
+ *  os logs: ângulos e magnitude em double a cada amostra. Serve só de
+ *  referência de custo; a sensibilidade fixa é a da faixa de ±2 g.
+ * -------------------------------------------------------------------------- */
+#define LEGADO_MPU_SENSITIVITY 16384.0
+#define LEGADO_THRESHOLD_FALL_LOW 0.5
+#define LEGADO_THRESHOLD_ANGLE 60.0
+#define LEGADO_PI 3.14159265
+#define LEGADO_FALL_WAIT_US 2000000LL
+
+static int reproduz_legado(const Gravacao *g)
+{
+    enum { MONITORING, FALL_DETECTED_WAIT, CHECK_ORIENTATION } current_state = MONITORING;
+    int64_t fall_timer_start = 0;
+    int quedas = 0;
+
+    for (size_t i = 0; i < g->n; i++)
+    {
+        const Mpu6050Data *dados_mpu = &g->amostras[i];
+        float ax_g = dados_mpu->accel_x / LEGADO_MPU_SENSITIVITY;
+        float ay_g = dados_mpu->accel_y / LEGADO_MPU_SENSITIVITY;
+        float az_g = dados_mpu->accel_z / LEGADO_MPU_SENSITIVITY;
+
+        float a_net = sqrt(pow(ax_g, 2) + pow(ay_g, 2) + pow(az_g, 2));
+
+        float roll = atan(ay_g / (sqrt(pow(ax_g, 2) + pow(az_g, 2)) + 0.001)) * 180.0 / LEGADO_PI;
+        float pitch = atan(-ax_g / (sqrt(pow(ay_g, 2) + pow(az_g, 2)) + 0.001)) * 180.0 / LEGADO_PI;
+
+        switch (current_state)
+        {
+        case MONITORING:
+            if (a_net < LEGADO_THRESHOLD_FALL_LOW)
+            {
+                fall_timer_start = dados_mpu->timestamp_us;
+                current_state = FALL_DETECTED_WAIT;
+            }
+            break;
+
+        case FALL_DETECTED_WAIT:
+            if ((dados_mpu->timestamp_us - fall_timer_start) > LEGADO_FALL_WAIT_US)
+            {
+                current_state = CHECK_ORIENTATION;
+            }
+            break;
+
+        case CHECK_ORIENTATION:
+            if (fabs(pitch) > LEGADO_THRESHOLD_ANGLE || fabs(roll) > LEGADO_THRESHOLD_ANGLE)
+            {
+                quedas++;
+            }
+            current_state = MONITORING;
+            break;
+        }
+    }
+    return quedas;
+}
+
+/* Contador de ciclos (TSC no x86); 0 onde não há */
+static inline uint64_t ciclos(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/* O que o kernel em inteiros faz por amostra fora de evento */
+static int reproduz_kernel(const Gravacao *g, const DetectorLimiares *l)
+{
+    int fora = 0;
+    for (size_t i = 0; i < g->n; i++)
+    {
+        uint32_t mag2 = detector_magnitude2(&g->amostras[i]);
+        uint32_t gyro2 = detector_rotacao2(&g->amostras[i]);
+        fora += mag2 < l->queda_livre_mag2 || mag2 > l->impacto_mag2 || gyro2 > l->repouso_gyro2;
+    }
+    return fora;
+}
+
+typedef enum
+{
+    MEDE_LEGADO,
+    MEDE_KERNEL,
+    MEDE_DETECTOR,
+} Medicao;
+
+typedef struct
+{
+    double ns_por_amostra;
+    double ciclos_por_amostra;
+} Custo;
+
+/* Repete o conjunto até somar tempo suficiente para medir */
+static Custo mede(const Gravacao *gravacoes, int n, size_t amostras, const DetectorConfig *config, Medicao medicao)
+{
+    static volatile int s_resultado; // Impede que o compilador descarte os laços
+    static Detector detector;
+    detector_init(&detector, config, (Mpu6050FaixaAccel)gravacoes[0].amostras[0].faixa_accel,
+                  (Mpu6050FaixaGyro)gravacoes[0].amostras[0].faixa_gyro);
+
+    int64_t inicio = agora_ns();
+    uint64_t inicio_ciclos = ciclos();
+    int64_t decorrido;
+    size_t repeticoes = 0;
+    do
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if (medicao == MEDE_LEGADO)
+            {
+                s_resultado += reproduz_legado(&gravacoes[i]);
+            }
+            else if (medicao == MEDE_KERNEL)
+            {
+                s_resultado += reproduz_kernel(&gravacoes[i], &detector.limiares);
+            }
+            else
+            {
+                Reproducao r;
+                reproduz(&gravacoes[i], config, &r);
+            }
+        }
+        repeticoes++;
+        decorrido = agora_ns() - inicio;
+    } while (decorrido < TEMPO_MINIMO_BENCH_NS);
+
+    double total = (double)(amostras * repeticoes);
+    return (Custo){
+        .ns_por_amostra = (double)decorrido / total,
+        .ciclos_por_amostra = (double)(ciclos() - inicio_ciclos) / total,
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "uso: %s gravacao.csv...\n", argv[0]);
+        return 2;
+    }
+
+    int n = argc - 1;
+    Gravacao *gravacoes = calloc((size_t)n, sizeof(*gravacoes));
+    for (int i = 0; i < n; i++)
+    {
+        if (!carrega(argv[i + 1], &gravacoes[i]))
+        {
+            return 2;
+        }
+    }
+
+    DetectorConfig config;
+    detector_config_padrao(&config);
+
+    int vp = 0, fn = 0, vn = 0, fp = 0;
+    size_t amostras = 0;
+    for (int i = 0; i < n; i++)
+    {
+        Reproducao r;
+        reproduz(&gravacoes[i], &config, &r);
+        bool detectou = r.quedas > 0;
+        if (gravacoes[i].queda)
+        {
+            detectou ? vp++ : fn++;
+        }
+        else
+        {
+            detectou ? fp++ : vn++;
+        }
+        amostras += gravacoes[i].n;
+        printf("%-24s %-5s -> %-5s pontuacao %u%s\n", gravacoes[i].nome, gravacoes[i].queda ? "queda" : "adl",
+               detectou ? "queda" : "-", r.pontuacao, detectou == gravacoes[i].queda ? "" : "  ERRO");
+    }
+
+    printf("sensibilidade %.1f%% (%d/%d), especificidade %.1f%% (%d/%d)\n",
+           vp + fn ? 100.0 * vp / (vp + fn) : 100.0, vp, vp + fn,
+           vn + fp ? 100.0 * vn / (vn + fp) : 100.0, vn, vn + fp);
+
+    static const char *const nomes[] = {
+        [MEDE_LEGADO] = "código antigo (double)",
+        [MEDE_KERNEL] = "kernel em inteiros",
+        [MEDE_DETECTOR] = "detector_executa",
+    };
+    printf("custo em %zu amostras:\n", amostras);
+    for (Medicao m = MEDE_LEGADO; m <= MEDE_DETECTOR; m++)
+    {
+        Custo c = mede(gravacoes, n, amostras, &config, m);
+        printf("  %6.1f ns/amostra %6.0f ciclos/amostra  %s\n", c.ns_por_amostra, c.ciclos_por_amostra,
+               nomes[m]);
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        free(gravacoes[i].amostras);
+    }
+    free(gravacoes);
+    return fn + fp == 0 ? 0 : 1;
+}
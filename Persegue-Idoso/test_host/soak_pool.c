@@ -0,0 +1,214 @@
+/* --------------------------------------------------------------------------
+ *  Soak do pool de blocos e da fila do publicador: milhões de ciclos de
+ *  produtores (reserva, escreve, insere ou cancela) e de um consumidor
+ *  (retira, devolve alertas para nova tentativa, conclui), com classes e
+ *  quantidades sorteadas. Passa se:
+ *   - nenhuma chamada a malloc/calloc/realloc acontece no laço (ligado com
+ *     -Wl,--wrap) e o heap em uso não muda;
+ *   - no fim todo bloco voltou ao pool, sem violação nem estouro;
+ *   - posse inválida (conclui sem retirar, insere duas vezes, ponteiro de
+ *     fora) é recusada sem corromper a lista de livres.
+ *  Com -DCONFIG_POOL_DEPURACAO=1 também confere que estouro, escrita depois
+ *  de liberar e blocos presos são detectados.
+ *
+ *    soak_pool [ciclos]
+ * -------------------------------------------------------------------------- */
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pool_modulo.h"
+#include "publicador_fila.h"
+#include "teste_host.h"
+
+#define CICLOS_PADRAO 5000000L
+#define TENTATIVAS_ALERTA 3
+
+/* Contagem de chamadas ao heap: o linker troca malloc por __wrap_malloc */
+static unsigned long s_chamadas_heap = 0;
+void *__real_malloc(size_t tamanho);
+void *__real_calloc(size_t n, size_t tamanho);
+void *__real_realloc(void *p, size_t tamanho);
+
+void *__wrap_malloc(size_t tamanho)
+{
+    s_chamadas_heap++;
+    return __real_malloc(tamanho);
+}
+
+void *__wrap_calloc(size_t n, size_t tamanho)
+{
+    s_chamadas_heap++;
+    return __real_calloc(n, tamanho);
+}
+
+void *__wrap_realloc(void *p, size_t tamanho)
+{
+    s_chamadas_heap++;
+    return __real_realloc(p, tamanho);
+}
+
+POOL_DEFINE(s_mensagens, sizeof(PublicadorMensagem), PUBLICADOR_MENSAGENS);
+static Pool s_pool;
+static PublicadorFila s_fila;
+
+/* xorshift32: determinístico entre execuções */
+static uint32_t s_semente = 12345;
+static uint32_t aleatorio(void)
+{
+    s_semente ^= s_semente << 13;
+    s_semente ^= s_semente >> 17;
+    s_semente ^= s_semente << 5;
+    return s_semente;
+}
+
+static void produz(long ciclo, long *recusadas)
+{
+    int n = (int)(aleatorio() % 4);
+    for (int i = 0; i < n; i++)
+    {
+        PublicadorClasse classe = (PublicadorClasse)(aleatorio() % PUBLICADOR_NUM_CLASSES);
+        PublicadorMensagem *m = publicador_fila_reserva(&s_fila, classe);
+        if (m == NULL)
+        {
+            (*recusadas)++;
+            continue;
+        }
+
+        m->topico = "soak";
+        m->tamanho = (uint16_t)(aleatorio() % PUBLICADOR_DADOS_MAX);
+        memset(m->dados, (int)ciclo, m->tamanho);
+
+        if (aleatorio() % 50 == 0)
+        {
+            CONFERE(publicador_fila_cancela(&s_fila, m) == ESP_OK, "cancela no ciclo %ld", ciclo);
+            continue;
+        }
+        CONFERE(publicador_fila_insere(&s_fila, m) == ESP_OK, "insere no ciclo %ld", ciclo);
+    }
+}
+
+/* Um pouco mais rápido que os produtores: o pool enche e esvazia */
+static void consome(long ciclo, long *enviadas)
+{
+    int n = (int)(aleatorio() % 5);
+    for (int i = 0; i < n; i++)
+    {
+        PublicadorMensagem *m = publicador_fila_retira(&s_fila);
+        if (m == NULL)
+        {
+            return;
+        }
+        if (m->classe == PUBLICADOR_ALERTA && ++m->tentativas < TENTATIVAS_ALERTA)
+        {
+            CONFERE(publicador_fila_devolve(&s_fila, m) == ESP_OK, "devolve no ciclo %ld", ciclo);
+            return;
+        }
+        CONFERE(publicador_fila_conclui(&s_fila, m) == ESP_OK, "conclui no ciclo %ld", ciclo);
+        (*enviadas)++;
+    }
+}
+
+/* Usos errados: recusados e contados, e o pool continua íntegro */
+static void confere_posse(void)
+{
+    uint32_t violacoes = s_pool.estatisticas.violacoes;
+
+    PublicadorMensagem *m = publicador_fila_reserva(&s_fila, PUBLICADOR_LOTE);
+    CONFERE(publicador_fila_conclui(&s_fila, m) == ESP_ERR_INVALID_STATE, "conclui sem retirar");
+    CONFERE(publicador_fila_insere(&s_fila, m) == ESP_OK, "insere");
+    CONFERE(publicador_fila_insere(&s_fila, m) == ESP_ERR_INVALID_STATE, "insere duas vezes");
+    m = publicador_fila_retira(&s_fila);
+    CONFERE(publicador_fila_conclui(&s_fila, m) == ESP_OK, "conclui");
+    CONFERE(publicador_fila_conclui(&s_fila, m) == ESP_ERR_INVALID_STATE, "conclui duas vezes");
+    CONFERE(pool_libera(&s_pool, (uint8_t *)m + 1, PUBLICADOR_DONO_ENVIO) == ESP_ERR_INVALID_ARG,
+            "ponteiro no meio do bloco");
+
+    CONFERE(s_pool.estatisticas.violacoes == violacoes + 4, "violações %lu, esperado %lu",
+            (unsigned long)s_pool.estatisticas.violacoes, (unsigned long)violacoes + 4);
+    CONFERE(pool_livres(&s_pool) == PUBLICADOR_MENSAGENS, "%u livres depois dos usos errados",
+            pool_livres(&s_pool));
+}
+
+#ifdef CONFIG_POOL_DEPURACAO
+static void confere_depuracao(void)
+{
+    /* Um byte além do bloco */
+    PublicadorMensagem *m = publicador_fila_reserva(&s_fila, PUBLICADOR_LOTE);
+    ((uint8_t *)m)[s_pool.tamanho_bloco] = 0;
+    CONFERE(pool_verifica(&s_pool, UINT32_MAX, NULL, NULL) == 1, "estouro não detectado");
+    CONFERE(publicador_fila_cancela(&s_fila, m) == ESP_OK, "cancela depois do estouro");
+
+    /* Escrita depois de liberar: aparece quando o bloco volta a ser alocado */
+    uint32_t estouros = s_pool.estatisticas.estouros;
+    ((uint8_t *)m)[10] ^= 1;
+    for (int i = 0; i < PUBLICADOR_MENSAGENS - PUBLICADOR_RESERVA_ALERTA; i++)
+    {
+        CONFERE(publicador_fila_reserva(&s_fila, PUBLICADOR_LOTE) != NULL, "reserva %d", i);
+    }
+    CONFERE(s_pool.estatisticas.estouros == estouros + 1, "escrita depois de liberar não detectada");
+
+    /* Os blocos que ficaram com o produtor aparecem como presos (menos o último, idade 0) */
+    size_t presos = pool_verifica(&s_pool, 0, NULL, NULL);
+    CONFERE(presos == PUBLICADOR_MENSAGENS - PUBLICADOR_RESERVA_ALERTA - 1, "%zu blocos presos", presos);
+    printf("depuração: estouro, escrita depois de liberar e %zu blocos presos detectados\n", presos);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    long ciclos = argc > 1 ? atol(argv[1]) : CICLOS_PADRAO;
+    bool coalescente[PUBLICADOR_NUM_CLASSES] = { [PUBLICADOR_POSICAO] = true };
+
+    POOL_INIT(&s_pool, s_mensagens, sizeof(PublicadorMensagem), PUBLICADOR_MENSAGENS);
+    publicador_fila_init(&s_fila, &s_pool, coalescente);
+    printf("soak: %ld ciclos, pool de %d x %zu bytes\n", ciclos, PUBLICADOR_MENSAGENS, s_pool.passo);
+
+    long enviadas = 0;
+    long recusadas = 0;
+    struct mallinfo2 heap_antes = mallinfo2();
+    unsigned long chamadas_antes = s_chamadas_heap;
+    int64_t inicio = agora_ns();
+
+    for (long c = 0; c < ciclos; c++)
+    {
+        produz(c, &recusadas);
+        consome(c, &enviadas);
+    }
+    PublicadorMensagem *m;
+    while ((m = publicador_fila_retira(&s_fila)) != NULL)
+    {
+        publicador_fila_conclui(&s_fila, m);
+        enviadas++;
+    }
+
+    int64_t decorrido = agora_ns() - inicio;
+    unsigned long chamadas = s_chamadas_heap - chamadas_antes;
+    struct mallinfo2 heap_depois = mallinfo2();
+
+    PoolEstatisticas e;
+    pool_estatisticas(&s_pool, &e);
+    uint32_t coalescidas = s_fila.estatisticas[PUBLICADOR_POSICAO].coalescidas;
+    printf("%lu alocações, %ld enviadas, %lu coalescidas, %ld sem bloco, em uso máx %u\n",
+           (unsigned long)e.alocacoes, enviadas, (unsigned long)coalescidas, recusadas, e.em_uso_max);
+    printf("heap: %lu chamadas no laço, em uso %zu -> %zu bytes; %.1f ns/ciclo\n",
+           chamadas, heap_antes.uordblks, heap_depois.uordblks, (double)decorrido / (double)ciclos);
+
+    CONFERE(chamadas == 0, "%lu chamadas ao heap no laço", chamadas);
+    CONFERE(heap_antes.uordblks == heap_depois.uordblks, "heap em uso cresceu");
+    CONFERE(e.em_uso == 0 && pool_livres(&s_pool) == PUBLICADOR_MENSAGENS, "%u blocos não voltaram", e.em_uso);
+    CONFERE(e.violacoes == 0 && e.estouros == 0, "violações %lu, estouros %lu",
+            (unsigned long)e.violacoes, (unsigned long)e.estouros);
+    CONFERE(e.em_uso_max <= PUBLICADOR_MENSAGENS, "em uso máx %u", e.em_uso_max);
+
+    confere_posse();
+#ifdef CONFIG_POOL_DEPURACAO
+    confere_depuracao();
+#endif
+
+    if (s_falhas != 0)
+    {
+        printf("%d falhas\n", s_falhas);
+        return 1;
+    }
+    return 0;
+}
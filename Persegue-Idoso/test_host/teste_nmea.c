@@ -0,0 +1,202 @@
+/* --------------------------------------------------------------------------
+ *  Parser NMEA contra logs de receptor (pasta nmea/):
+ *   - neo6m_gp.nmea: NEO-6M, só GPS ($GP), partida a frio e três fixes
+ *   - m8n_gnss.nmea: M8N com GPS+GLONASS+Galileo ($GN, $GP, $GL, $GA)
+ *   - ruido_uart.nmea: checksum errado, sentença cortada, lixo UBX, linha
+ *     maior que o buffer, checksum não hexadecimal e em minúsculas
+ *  Cada log é entregue em pedaços de vários tamanhos (sentenças divididas
+ *  entre leituras da UART) e o resultado tem de ser o mesmo. No fim mede
+ *  sentenças/s no host.
+ * -------------------------------------------------------------------------- */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nmea_modulo.h"
+#include "teste_host.h"
+
+
+typedef struct
+{
+    const char *arquivo;
+    uint32_t mascara;
+    NmeaEstatisticas estatisticas;
+    GpsData fix; // Só os campos conferidos; timestamp_us não é usado aqui
+} Caso;
+
+static const Caso s_casos[] = {
+    {
+        .arquivo = "neo6m_gp.nmea",
+        .mascara = NMEA_GGA | NMEA_RMC | NMEA_VTG | NMEA_GSA | NMEA_OUTRA,
+        .estatisticas = { .sentencas_ok = 30 },
+        .fix = {
+            .latitude = -23.552082f, .longitude = -46.642752f, .altitude = 760.3f, .satelites = 8,
+            .valid = true, .velocidade_kmh = 0.948f, .curso_graus = 77.52f,
+            .hdop = 1.01f, .pdop = 1.85f, .vdop = 1.55f, .qualidade_fix = 1, .tipo_fix = 3,
+            .hora = 14, .minuto = 25, .segundo = 12, .dia = 17, .mes = 3, .ano = 2026,
+        },
+    },
+    {
+        .arquivo = "m8n_gnss.nmea",
+        .mascara = NMEA_GGA | NMEA_RMC | NMEA_VTG | NMEA_GSA | NMEA_OUTRA,
+        .estatisticas = { .sentencas_ok = 33 },
+        .fix = {
+            .latitude = -22.558372f, .longitude = -43.204100f, .altitude = 12.4f, .satelites = 14,
+            .valid = true, .velocidade_kmh = 3.897f, .curso_graus = 301.7f,
+            .hdop = 0.78f, .pdop = 1.32f, .vdop = 1.06f, .qualidade_fix = 1, .tipo_fix = 3,
+            .hora = 9, .minuto = 31, .segundo = 42, .dia = 17, .mes = 3, .ano = 2026,
+        },
+    },
+    {
+        .arquivo = "ruido_uart.nmea",
+        .mascara = NMEA_GGA | NMEA_RMC | NMEA_OUTRA,
+        .estatisticas = { .sentencas_ok = 6, .erros_checksum = 1, .descartadas = 3 },
+        .fix = {
+            .latitude = -23.033333f, .longitude = -45.033333f, .altitude = 102.0f, .satelites = 10,
+            .valid = true, .velocidade_kmh = 1.852f, .curso_graus = 90.0f,
+            .hdop = 0.90f, .qualidade_fix = 2,
+            .hora = 10, .minuto = 15, .segundo = 2, .dia = 17, .mes = 3, .ano = 2026,
+        },
+    },
+};
+
+static uint8_t *le_arquivo(const char *caminho, size_t *tamanho)
+{
+    FILE *f = fopen(caminho, "rb");
+    if (f == NULL)
+    {
+        perror(caminho);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    *tamanho = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *dados = malloc(*tamanho);
+    if (fread(dados, 1, *tamanho, f) != *tamanho)
+    {
+        perror(caminho);
+        exit(2);
+    }
+    fclose(f);
+    return dados;
+}
+
+static bool perto(float a, float b, float tolerancia)
+{
+    return fabsf(a - b) <= tolerancia;
+}
+
+static void confere_fix(const GpsData *f, const GpsData *e)
+{
+    CONFERE(f->valid == e->valid, "valid %d, esperado %d", f->valid, e->valid);
+    CONFERE(perto(f->latitude, e->latitude, 1e-5f), "latitude %.6f, esperada %.6f", f->latitude, e->latitude);
+    CONFERE(perto(f->longitude, e->longitude, 1e-5f), "longitude %.6f, esperada %.6f", f->longitude, e->longitude);
+    CONFERE(perto(f->altitude, e->altitude, 1e-3f), "altitude %.2f, esperada %.2f", f->altitude, e->altitude);
+    CONFERE(f->satelites == e->satelites, "satelites %d, esperado %d", f->satelites, e->satelites);
+    CONFERE(perto(f->velocidade_kmh, e->velocidade_kmh, 1e-3f), "velocidade %.3f, esperada %.3f",
+            f->velocidade_kmh, e->velocidade_kmh);
+    CONFERE(perto(f->curso_graus, e->curso_graus, 1e-3f), "curso %.2f, esperado %.2f", f->curso_graus, e->curso_graus);
+    CONFERE(perto(f->hdop, e->hdop, 1e-4f), "hdop %.2f, esperado %.2f", f->hdop, e->hdop);
+    CONFERE(perto(f->pdop, e->pdop, 1e-4f), "pdop %.2f, esperado %.2f", f->pdop, e->pdop);
+    CONFERE(perto(f->vdop, e->vdop, 1e-4f), "vdop %.2f, esperado %.2f", f->vdop, e->vdop);
+    CONFERE(f->qualidade_fix == e->qualidade_fix, "qualidade %u, esperada %u", f->qualidade_fix, e->qualidade_fix);
+    CONFERE(f->tipo_fix == e->tipo_fix, "tipo_fix %u, esperado %u", f->tipo_fix, e->tipo_fix);
+    CONFERE(f->hora == e->hora && f->minuto == e->minuto && f->segundo == e->segundo,
+            "horario %02u:%02u:%02u, esperado %02u:%02u:%02u",
+            f->hora, f->minuto, f->segundo, e->hora, e->minuto, e->segundo);
+    CONFERE(f->dia == e->dia && f->mes == e->mes && f->ano == e->ano, "data %02u/%02u/%u, esperada %02u/%02u/%u",
+            f->dia, f->mes, f->ano, e->dia, e->mes, e->ano);
+}
+
+/* pedaco = 0: tamanhos pseudoaleatórios de 1 a 40 bytes */
+static void confere_caso(const Caso *c, const uint8_t *dados, size_t tamanho, size_t pedaco)
+{
+    NmeaParser parser;
+    nmea_parser_init(&parser);
+
+    uint32_t mascara = 0;
+    uint32_t semente = 12345;
+    for (size_t i = 0; i < tamanho;)
+    {
+        size_t n = pedaco;
+        if (n == 0)
+        {
+            semente = semente * 1103515245u + 12345u;
+            n = 1 + (semente >> 16) % 40;
+        }
+        if (n > tamanho - i)
+        {
+            n = tamanho - i;
+        }
+        mascara |= nmea_parser_processa(&parser, &dados[i], n);
+        i += n;
+    }
+
+    int antes = s_falhas;
+    const NmeaEstatisticas *e = &parser.estatisticas;
+    CONFERE(mascara == c->mascara, "máscara 0x%x, esperada 0x%x", (unsigned)mascara, (unsigned)c->mascara);
+    CONFERE(e->sentencas_ok == c->estatisticas.sentencas_ok && e->erros_checksum == c->estatisticas.erros_checksum &&
+                e->descartadas == c->estatisticas.descartadas,
+            "ok/checksum/descartadas %u/%u/%u, esperado %u/%u/%u",
+            (unsigned)e->sentencas_ok, (unsigned)e->erros_checksum, (unsigned)e->descartadas,
+            (unsigned)c->estatisticas.sentencas_ok, (unsigned)c->estatisticas.erros_checksum,
+            (unsigned)c->estatisticas.descartadas);
+    confere_fix(&parser.fix, &c->fix);
+    if (s_falhas != antes)
+    {
+        printf("  (%s em pedaços de %zu bytes)\n", c->arquivo, pedaco);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *pasta = argc > 1 ? argv[1] : "nmea";
+    static const size_t pedacos[] = { 1, 2, 3, 7, 16, 64, 0, SIZE_MAX };
+    char caminho[256];
+
+    for (size_t i = 0; i < sizeof(s_casos) / sizeof(s_casos[0]); i++)
+    {
+        const Caso *c = &s_casos[i];
+        snprintf(caminho, sizeof(caminho), "%s/%s", pasta, c->arquivo);
+        size_t tamanho;
+        uint8_t *dados = le_arquivo(caminho, &tamanho);
+
+        int antes = s_falhas;
+        for (size_t p = 0; p < sizeof(pedacos) / sizeof(pedacos[0]); p++)
+        {
+            confere_caso(c, dados, tamanho, pedacos[p]);
+        }
+        printf("%-20s %s\n", c->arquivo, s_falhas == antes ? "ok" : "FALHOU");
+        free(dados);
+    }
+
+    /* Vazão: o log multi-GNSS repetido até somar tempo suficiente para medir */
+    snprintf(caminho, sizeof(caminho), "%s/m8n_gnss.nmea", pasta);
+    size_t tamanho;
+    uint8_t *dados = le_arquivo(caminho, &tamanho);
+    NmeaParser parser;
+    nmea_parser_init(&parser);
+    size_t repeticoes = 0;
+    int64_t inicio = agora_ns();
+    int64_t decorrido;
+    do
+    {
+        for (int k = 0; k < 100; k++)
+        {
+            nmea_parser_processa(&parser, dados, tamanho);
+        }
+        repeticoes += 100;
+        decorrido = agora_ns() - inicio;
+    } while (decorrido < TEMPO_MINIMO_BENCH_NS);
+    double segundos = (double)decorrido / 1e9;
+    printf("nmea_parser_processa: %.0f sentenças/s, %.1f MB/s\n",
+           parser.estatisticas.sentencas_ok / segundos, (double)(tamanho * repeticoes) / segundos / 1e6);
+    free(dados);
+
+    if (s_falhas != 0)
+    {
+        printf("%d falhas\n", s_falhas);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+/* --------------------------------------------------------------------------
+ *  Outbox em flash contra a flash simulada (outbox_flash_sim), com um
+ *  intermediário que corta a energia depois de N bytes gravados:
+ *   - ordem e prioridade na drenagem;
+ *   - reboot no meio do reenvio, inclusive entre proxima e confirma;
+ *   - gravação interrompida em cada byte de um registro (e do cabeçalho
+ *     de segmento, quando a gravação abre um segmento novo);
+ *   - confirmação interrompida;
+ *   - CRC: um bit trocado no payload descarta só aquele registro;
+ *   - partição cheia: os mais antigos saem, a ordem se mantém.
+ *  Em todos os casos nenhuma gravação pode tentar levar um bit de 0 a 1.
+ * -------------------------------------------------------------------------- */
+#define _GNU_SOURCE // memmem
+#include <stdlib.h>
+#include <string.h>
+#include "outbox_modulo.h"
+#include "teste_host.h"
+
+#define SETOR 4096
+#define SEGMENTOS 8
+#define TOPICO "dispositivos/teste/lote"
+#define TOPICO_QUEDA "dispositivos/teste/queda"
+#define TAMANHO_MENSAGEM 100
+#define SEM_CORTE SIZE_MAX
+
+static uint8_t s_memoria[SETOR * SEGMENTOS];
+static uint8_t s_imagem[SETOR * SEGMENTOS]; // Cópia da flash antes de um corte
+static OutboxFlashSim s_sim;
+static OutboxFlash s_flash_sim;
+
+/* --------------------------------------------------------------------------
+ *  Corte de energia: cada byte gravado e cada apagamento gastam uma
+ *  unidade. Sem orçamento, a gravação em curso fica pela metade e nada
+ *  mais chega à flash (o firmware continua, mas o que ele faz se perde).
+ * -------------------------------------------------------------------------- */
+typedef struct
+{
+    size_t orcamento;
+    size_t gasto;
+} Corte;
+
+static Corte s_corte;
+
+static esp_err_t corte_le(void *ctx, size_t endereco, void *destino, size_t tamanho)
+{
+    return s_flash_sim.le(s_flash_sim.ctx, endereco, destino, tamanho);
+}
+
+static esp_err_t corte_escreve(void *ctx, size_t endereco, const void *origem, size_t tamanho)
+{
+    Corte *c = ctx;
+    size_t resta = c->orcamento - c->gasto;
+    size_t n = tamanho < resta ? tamanho : resta;
+    c->gasto += n;
+    return n > 0 ? s_flash_sim.escreve(s_flash_sim.ctx, endereco, origem, n) : ESP_OK;
+}
+
+static esp_err_t corte_apaga_setor(void *ctx, size_t endereco)
+{
+    Corte *c = ctx;
+    if (c->gasto >= c->orcamento)
+    {
+        return ESP_OK;
+    }
+    c->gasto++;
+    return s_flash_sim.apaga_setor(s_flash_sim.ctx, endereco);
+}
+
+static OutboxFlash flash_com_corte(size_t orcamento)
+{
+    s_corte = (Corte){ .orcamento = orcamento };
+    OutboxFlash f = s_flash_sim;
+    f.le = corte_le;
+    f.escreve = corte_escreve;
+    f.apaga_setor = corte_apaga_setor;
+    f.ctx = &s_corte;
+    return f;
+}
+
+/* --------------------------------------------------------------------------
+ *  Mensagens numeradas: os 4 primeiros bytes são o número e o resto um
+ *  padrão derivado dele, conferido na leitura
+ * -------------------------------------------------------------------------- */
+static void monta(uint32_t numero, uint8_t *dados, size_t tamanho)
+{
+    memcpy(dados, &numero, sizeof(numero));
+    for (size_t i = sizeof(numero); i < tamanho; i++)
+    {
+        dados[i] = (uint8_t)(numero * 31 + i);
+    }
+}
+
+static bool confere_payload(const OutboxMensagem *m, uint32_t *numero)
+{
+    uint8_t esperado[TAMANHO_MENSAGEM];
+    if (m->tamanho != TAMANHO_MENSAGEM)
+    {
+        return false;
+    }
+    memcpy(numero, m->dados, sizeof(*numero));
+    monta(*numero, esperado, sizeof(esperado));
+    return memcmp(esperado, m->dados, sizeof(esperado)) == 0;
+}
+
+static esp_err_t grava(Outbox *o, uint32_t numero)
+{
+    uint8_t dados[TAMANHO_MENSAGEM];
+    monta(numero, dados, sizeof(dados));
+    return outbox_grava(o, TOPICO, dados, sizeof(dados), false);
+}
+
+static void grava_varias(Outbox *o, uint32_t de, uint32_t ate)
+{
+    for (uint32_t i = de; i < ate; i++)
+    {
+        CONFERE(grava(o, i) == ESP_OK, "grava %u", i);
+    }
+}
+
+/* Drena (e confirma) até `max`; devolve quantas leu, com o primeiro e o último número */
+typedef struct
+{
+    uint32_t lidas;
+    uint32_t primeiro;
+    uint32_t ultimo;
+    bool em_ordem;
+} Drenagem;
+
+static Drenagem drena(Outbox *o, uint32_t max)
+{
+    static uint8_t buffer[512];
+    Drenagem d = { .em_ordem = true };
+    OutboxMensagem m;
+    while (d.lidas < max && outbox_proxima(o, &m, buffer, sizeof(buffer)) == ESP_OK)
+    {
+        uint32_t numero;
+        bool intacta = strcmp(m.topico, TOPICO) == 0 && confere_payload(&m, &numero);
+        CONFERE(intacta, "mensagem corrompida entregue");
+        if (intacta)
+        {
+            if (d.lidas == 0)
+            {
+                d.primeiro = numero;
+            }
+            else if (numero != d.ultimo + 1)
+            {
+                d.em_ordem = false;
+            }
+            d.ultimo = numero;
+        }
+        CONFERE(outbox_confirma(o, &m) == ESP_OK, "confirma");
+        d.lidas++;
+    }
+    return d;
+}
+
+static void flash_nova(Outbox *o)
+{
+    outbox_flash_sim_init(&s_sim, s_memoria, sizeof(s_memoria), SETOR, &s_flash_sim);
+    CONFERE(outbox_abre(o, &s_flash_sim) == ESP_OK, "abre");
+}
+
+static void reboot(Outbox *o)
+{
+    CONFERE(outbox_abre(o, &s_flash_sim) == ESP_OK, "abre depois do reboot");
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void teste_ordem_e_prioridade(void)
+{
+    Outbox o;
+    flash_nova(&o);
+    grava_varias(&o, 0, 100);
+    uint8_t alerta[12] = "queda";
+    CONFERE(outbox_grava(&o, TOPICO_QUEDA, alerta, sizeof(alerta), true) == ESP_OK, "grava alerta");
+
+    static uint8_t buffer[512];
+    OutboxMensagem m;
+    CONFERE(outbox_proxima(&o, &m, buffer, sizeof(buffer)) == ESP_OK && m.prioritaria &&
+                strcmp(m.topico, TOPICO_QUEDA) == 0,
+            "alerta não saiu primeiro");
+    outbox_confirma(&o, &m);
+
+    Drenagem d = drena(&o, UINT32_MAX);
+    CONFERE(d.lidas == 100 && d.primeiro == 0 && d.ultimo == 99 && d.em_ordem, "drenou %u, %u..%u",
+            d.lidas, d.primeiro, d.ultimo);
+    CONFERE(outbox_vazia(&o), "não ficou vazia");
+}
+
+static void teste_reboot_no_reenvio(void)
+{
+    Outbox o;
+    flash_nova(&o);
+    grava_varias(&o, 0, 100);
+
+    Drenagem d = drena(&o, 40);
+    CONFERE(d.lidas == 40 && d.ultimo == 39, "primeira parte %u..%u", d.primeiro, d.ultimo);
+    reboot(&o);
+    CONFERE(o.estatisticas.pendentes == 60, "%u pendentes depois do reboot", o.estatisticas.pendentes);
+
+    /* Lida e não confirmada: o reboot entrega de novo (pelo menos uma vez) */
+    static uint8_t buffer[512];
+    OutboxMensagem m;
+    CONFERE(outbox_proxima(&o, &m, buffer, sizeof(buffer)) == ESP_OK, "proxima");
+    reboot(&o);
+
+    d = drena(&o, UINT32_MAX);
+    CONFERE(d.lidas == 60 && d.primeiro == 40 && d.ultimo == 99 && d.em_ordem, "resto %u, %u..%u",
+            d.lidas, d.primeiro, d.ultimo);
+}
+
+/*
+ * Para cada ocupação inicial (incluindo a que obriga a abrir um segmento
+ * novo e a partição cheia), corta a energia em cada byte da gravação da
+ * mensagem seguinte. Depois do reboot: as anteriores continuam em ordem,
+ * a cortada aparece inteira ou não aparece, e a gravação volta a funcionar.
+ */
+static void teste_gravacao_interrompida(void)
+{
+    uint32_t casos = 0;
+    uint32_t cortada_apareceu = 0;
+    for (uint32_t ja_gravadas = 0; ja_gravadas <= 400; ja_gravadas += (ja_gravadas < 80 ? 1 : 37))
+    {
+        Outbox o;
+        flash_nova(&o);
+        grava_varias(&o, 0, ja_gravadas);
+        memcpy(s_imagem, s_memoria, sizeof(s_memoria));
+
+        /* Quanto a gravação gasta sem corte */
+        OutboxFlash medida = flash_com_corte(SEM_CORTE);
+        Outbox sonda;
+        outbox_abre(&sonda, &medida);
+        grava(&sonda, ja_gravadas);
+        size_t total = s_corte.gasto;
+
+        for (size_t corte = 0; corte < total; corte++)
+        {
+            memcpy(s_memoria, s_imagem, sizeof(s_memoria));
+            OutboxFlash f = flash_com_corte(corte);
+            Outbox antes;
+            outbox_abre(&antes, &f);
+            grava(&antes, ja_gravadas);
+
+            reboot(&o);
+            uint32_t pendentes = o.estatisticas.pendentes;
+            Drenagem d = drena(&o, UINT32_MAX);
+            bool sem_perda = d.lidas == pendentes && d.em_ordem &&
+                             (d.lidas == 0 || d.ultimo == ja_gravadas - 1 || d.ultimo == ja_gravadas);
+            CONFERE(sem_perda, "%u gravadas, corte em %zu de %zu: %u lidas, %u..%u", ja_gravadas, corte, total,
+                    d.lidas, d.primeiro, d.ultimo);
+            if (ja_gravadas * TAMANHO_MENSAGEM < SETOR * 2)
+            {
+                CONFERE(d.lidas == 0 || d.primeiro == 0, "%u gravadas, corte em %zu: começou em %u",
+                        ja_gravadas, corte, d.primeiro);
+            }
+            cortada_apareceu += d.lidas > 0 && d.ultimo == ja_gravadas;
+
+            /* Depois do reboot a próxima gravação vale */
+            CONFERE(grava(&o, 1000000) == ESP_OK, "grava depois do corte");
+            static uint8_t buffer[512];
+            OutboxMensagem m;
+            uint32_t numero = 0;
+            CONFERE(outbox_proxima(&o, &m, buffer, sizeof(buffer)) == ESP_OK && confere_payload(&m, &numero) &&
+                        numero == 1000000,
+                    "%u gravadas, corte em %zu: gravação seguinte perdida", ja_gravadas, corte);
+            casos++;
+        }
+    }
+    printf("  %u cortes de energia, %u com a mensagem cortada já completa\n", casos, cortada_apareceu);
+}
+
+static void teste_confirmacao_interrompida(void)
+{
+    for (size_t corte = 0; corte < 4; corte++)
+    {
+        Outbox o;
+        flash_nova(&o);
+        grava_varias(&o, 0, 10);
+        memcpy(s_imagem, s_memoria, sizeof(s_memoria));
+
+        OutboxFlash f = flash_com_corte(corte);
+        Outbox antes;
+        outbox_abre(&antes, &f);
+        static uint8_t buffer[512];
+        OutboxMensagem m;
+        outbox_proxima(&antes, &m, buffer, sizeof(buffer));
+        outbox_confirma(&antes, &m);
+
+        reboot(&o);
+        Drenagem d = drena(&o, UINT32_MAX);
+        CONFERE(d.em_ordem && d.ultimo == 9 && (d.lidas == 10 || d.lidas == 9),
+                "confirmação cortada em %zu: %u lidas, %u..%u", corte, d.lidas, d.primeiro, d.ultimo);
+    }
+}
+
+static void teste_crc(void)
+{
+    Outbox o;
+    flash_nova(&o);
+    grava_varias(&o, 0, 3);
+
+    /* Um bit do payload da mensagem 1 vai a zero, como numa célula gasta */
+    uint8_t dados[TAMANHO_MENSAGEM];
+    monta(1, dados, sizeof(dados));
+    uint8_t *registro = memmem(s_memoria, sizeof(s_memoria), dados, sizeof(dados));
+    CONFERE(registro != NULL, "payload não achado na flash");
+    if (registro == NULL)
+    {
+        return;
+    }
+    registro[TAMANHO_MENSAGEM / 2] &= 0xFE;
+    if (registro[TAMANHO_MENSAGEM / 2] == dados[TAMANHO_MENSAGEM / 2])
+    {
+        registro[TAMANHO_MENSAGEM / 2] &= 0x7F;
+    }
+
+    reboot(&o);
+    static uint8_t buffer[512];
+    OutboxMensagem m;
+    uint32_t numeros[3];
+    uint32_t lidas = 0;
+    while (lidas < 3 && outbox_proxima(&o, &m, buffer, sizeof(buffer)) == ESP_OK)
+    {
+        CONFERE(confere_payload(&m, &numeros[lidas]), "mensagem corrompida entregue");
+        outbox_confirma(&o, &m);
+        lidas++;
+    }
+    CONFERE(lidas == 2 && numeros[0] == 0 && numeros[1] == 2, "lidas %u", lidas);
+    CONFERE(o.estatisticas.corrompidos == 1, "%u corrompidos", o.estatisticas.corrompidos);
+}
+
+static void teste_particao_cheia(void)
+{
+    Outbox o;
+    flash_nova(&o);
+    const uint32_t total = 1000;
+    grava_varias(&o, 0, total);
+
+    OutboxEstatisticas e;
+    outbox_estatisticas(&o, &e);
+    CONFERE(e.pendentes + e.descartados == total, "%u pendentes + %u descartados", e.pendentes, e.descartados);
+    CONFERE(e.bytes_usados <= e.bytes_total, "%u de %u bytes", e.bytes_usados, e.bytes_total);
+
+    reboot(&o);
+    CONFERE(o.estatisticas.pendentes == e.pendentes, "%u pendentes depois do reboot, antes %u",
+            o.estatisticas.pendentes, e.pendentes);
+    Drenagem d = drena(&o, UINT32_MAX);
+    CONFERE(d.lidas == e.pendentes && d.primeiro == total - e.pendentes && d.ultimo == total - 1 && d.em_ordem,
+            "drenou %u, %u..%u", d.lidas, d.primeiro, d.ultimo);
+
+    uint32_t apagamentos_min = UINT32_MAX, apagamentos_max = 0;
+    for (uint32_t s = 0; s < SEGMENTOS; s++)
+    {
+        uint32_t cabecalho[3];
+        memcpy(cabecalho, &s_memoria[s * SETOR], sizeof(cabecalho));
+        apagamentos_min = cabecalho[2] < apagamentos_min ? cabecalho[2] : apagamentos_min;
+        apagamentos_max = cabecalho[2] > apagamentos_max ? cabecalho[2] : apagamentos_max;
+    }
+    CONFERE(apagamentos_max - apagamentos_min <= 1, "desgaste desigual: %u a %u apagamentos",
+            apagamentos_min, apagamentos_max);
+    printf("  %u mensagens: %u pendentes, %u descartadas, apagamentos por setor %u a %u\n",
+           total, e.pendentes, e.descartados, apagamentos_min, apagamentos_max);
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *nome;
+        void (*teste)(void);
+    } testes[] = {
+        { "ordem e prioridade", teste_ordem_e_prioridade },
+        { "reboot no reenvio", teste_reboot_no_reenvio },
+        { "gravação interrompida", teste_gravacao_interrompida },
+        { "confirmação interrompida", teste_confirmacao_interrompida },
+        { "CRC", teste_crc },
+        { "partição cheia", teste_particao_cheia },
+    };
+
+    for (size_t i = 0; i < sizeof(testes) / sizeof(testes[0]); i++)
+    {
+        int antes = s_falhas;
+        testes[i].teste();
+        CONFERE(s_sim.escritas_invalidas == 0, "%u gravações tentaram levar bit de 0 a 1", s_sim.escritas_invalidas);
+        printf("%s: %s\n", testes[i].nome, s_falhas == antes ? "ok" : "FALHOU");
+    }
+
+    if (s_falhas != 0)
+    {
+        printf("%d falhas\n", s_falhas);
+        return 1;
+    }
+    return 0;
+}
@@ -2,5 +2,60 @@ CREATE TABLE gps_area_segura (
     id SERIAL PRIMARY KEY,
     nome VARCHAR(255) NOT NULL,
     pontos JSONB NOT NULL,
-    ativo BOOLEAN NOT NULL
+    ativo BOOLEAN NOT NULL,
+    -- NULL: área global, vale para todos os usuários
+    "usuarioId" INTEGER
 );
+
+-- Bancos criados antes da coluna "usuarioId":
+-- ALTER TABLE gps_area_segura ADD COLUMN IF NOT EXISTS "usuarioId" INTEGER;
+
+-- Trajeto: só inserção, particionado por mês e, dentro do mês, por hash do
+-- usuário. Consultas por usuário e período tocam uma subpartição por mês, e
+-- apagar um mês antigo é um DROP TABLE. A chave primária precisa conter as
+-- chaves de partição.
+CREATE TABLE posicao_historico (
+    id BIGSERIAL,
+    "usuarioId" INTEGER NOT NULL,
+    latitude DOUBLE PRECISION NOT NULL,
+    longitude DOUBLE PRECISION NOT NULL,
+    hdop DOUBLE PRECISION,
+    "velocidadeKmh" DOUBLE PRECISION,
+    "timestamp" TIMESTAMP WITH TIME ZONE NOT NULL,
+    PRIMARY KEY (id, "timestamp", "usuarioId")
+) PARTITION BY RANGE ("timestamp");
+
+-- Mesmo nome que o sequelize.sync() daria ao índice do modelo
+CREATE INDEX posicao_historico_usuario_id_timestamp ON posicao_historico ("usuarioId", "timestamp");
+
+-- Fora dos meses já criados (relógio errado, lote muito atrasado)
+CREATE TABLE posicao_historico_padrao PARTITION OF posicao_historico DEFAULT;
+
+-- Cria o mês (e suas subpartições) se ainda não existir; o backend chama
+-- todo dia para o mês atual e o próximo
+CREATE OR REPLACE FUNCTION criar_particao_posicao(mes DATE, subparticoes INTEGER DEFAULT 4)
+RETURNS VOID AS $$
+DECLARE
+    inicio DATE := date_trunc('month', mes)::date;
+    nome TEXT := 'posicao_historico_' || to_char(inicio, 'YYYY_MM');
+BEGIN
+    IF to_regclass(nome) IS NOT NULL THEN
+        RETURN;
+    END IF;
+    EXECUTE format('CREATE TABLE %I PARTITION OF posicao_historico FOR VALUES FROM (%L) TO (%L) PARTITION BY HASH ("usuarioId")',
+                   nome, inicio, (inicio + INTERVAL '1 month')::date);
+    FOR i IN 0 .. subparticoes - 1 LOOP
+        EXECUTE format('CREATE TABLE %I PARTITION OF %I FOR VALUES WITH (MODULUS %s, REMAINDER %s)',
+                       nome || '_' || i, nome, subparticoes, i);
+    END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+SELECT criar_particao_posicao(now()::date), criar_particao_posicao((now() + INTERVAL '1 month')::date);
+
+-- Bancos com posicao_historico criada pelo sequelize.sync() (sem partições):
+-- ALTER TABLE posicao_historico RENAME TO posicao_historico_antiga;
+-- ALTER INDEX posicao_historico_usuario_id_timestamp RENAME TO posicao_historico_antiga_usuario_id_timestamp;
+-- (rodar o bloco acima)
+-- INSERT INTO posicao_historico ("usuarioId", latitude, longitude, hdop, "velocidadeKmh", "timestamp")
+--     SELECT "usuarioId", latitude, longitude, hdop, "velocidadeKmh", "timestamp" FROM posicao_historico_antiga;
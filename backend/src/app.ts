@@ -10,6 +10,8 @@ import { startBroker } from './mqtt';
 // Rotas importadas
 import gpsAreaRoutes from './routes/gpsRoutes';
 import alertaRoutes from './routes/alertaRoutes'
+import { sincronizarAreaSeguraDispositivos } from './services/gpsService';
+import { iniciarTrajeto, descarregarTrajeto } from './services/trajetoService';
 
 const app = express();
 const httpPort = 3000; // Express - Servidor web
@@ -34,5 +36,14 @@ app.listen(httpPort, () => {
 
 // Inicia o broker MQTT
 startBroker(1883)
+sincronizarAreaSeguraDispositivos();
+iniciarTrajeto();
+
+// Posições ainda no buffer do escritor em lote vão para o banco antes de sair
+for (const sinal of ['SIGINT', 'SIGTERM'] as const) {
+    process.once(sinal, () => {
+        descarregarTrajeto().finally(() => process.exit(0));
+    });
+}
 
 export default app;
\ No newline at end of file
@@ -1,5 +1,6 @@
 import { Request, Response } from 'express';
 import * as gpsAreaService from '../services/gpsService';
+import { consultarTrajeto, ModoTrajeto } from '../services/trajetoService';
 
 interface Coordenada {
     latitude: number;
@@ -9,13 +10,15 @@ interface Coordenada {
 
 export async function adicionarAreaSeguraController(req: Request, res: Response) {
     try {
-        const { pontos, nome } = req.body;
+        // usuarioId opcional (sem ele a área é global); exclusiva = false mantém as outras ativas
+        const { pontos, nome, usuarioId, exclusiva } = req.body;
 
         if (!pontos || !Array.isArray(pontos) || pontos.length < 3) {
             return res.status(400).json({ message: 'Dados de pontos inválidos.' });
         }
 
-        const novaArea = await gpsAreaService.adicionarAreaSegura(pontos, nome);
+        const novaArea = await gpsAreaService.adicionarAreaSegura(pontos, nome,
+            usuarioId === undefined || usuarioId === null ? null : Number(usuarioId), exclusiva !== false);
 
         res.status(201).json({
             message: 'Área segura adicionada com sucesso!',
@@ -30,14 +33,15 @@ export async function adicionarAreaSeguraController(req: Request, res: Response)
 
 export async function verificarAreaSeguraController(req: Request, res: Response) {
     try {
-        const { latitude, longitude } = req.body;
+        const { latitude, longitude, usuarioId } = req.body;
 
         if (latitude === undefined || longitude === undefined) {
             return res.status(400).json({ message: 'Coordenadas inválidas.' });
         }
 
         const pontoAtual: Coordenada = { latitude, longitude };
-        const dentro = await gpsAreaService.verificarSeDentroAreaSegura(pontoAtual);
+        const dentro = await gpsAreaService.verificarSeDentroAreaSegura(pontoAtual,
+            usuarioId === undefined || usuarioId === null ? null : Number(usuarioId));
 
         res.status(200).json({
             message: dentro ? 'Ponto dentro da área segura.' : 'Ponto fora da área segura.',
@@ -57,7 +61,8 @@ export async function atualizarAreaAtivaController(req: Request, res: Response)
             return res.status(400).json({ message: 'ID da área é obrigatório.' });
         }
 
-        const areaAtualizada = await gpsAreaService.atualizarAreaAtiva(Number(id));
+        // ?exclusiva=false ativa sem desativar as outras áreas do mesmo dono
+        const areaAtualizada = await gpsAreaService.atualizarAreaAtiva(Number(id), req.query.exclusiva !== 'false');
 
         res.status(200).json({
             message: 'Área ativa atualizada com sucesso!',
@@ -124,3 +129,30 @@ export async function posicaoAtualUsuarioController(req: Request, res: Response)
     }
   }
 
+// Trajeto reduzido para o mapa: ?inicio=&fim= (ISO, padrão últimas 24 h),
+// ?modo=dp|tempo|bruto (padrão dp), ?toleranciaM= (dp, 5) e ?intervaloS= (tempo, 60)
+export async function trajetoUsuarioController(req: Request, res: Response) {
+    try {
+      const usuarioId = Number(req.params.id);
+      const fim = req.query.fim ? new Date(String(req.query.fim)) : new Date();
+      const inicio = req.query.inicio ? new Date(String(req.query.inicio)) : new Date(fim.getTime() - 24 * 60 * 60 * 1000);
+      const modo = String(req.query.modo ?? 'dp') as ModoTrajeto;
+      const toleranciaM = Number(req.query.toleranciaM ?? 5);
+      const intervaloS = Number(req.query.intervaloS ?? 60);
+
+      if (!Number.isInteger(usuarioId) || isNaN(inicio.getTime()) || isNaN(fim.getTime()) || inicio >= fim) {
+        return res.status(400).json({ message: "Usuário ou período inválido." });
+      }
+      if (!['dp', 'tempo', 'bruto'].includes(modo) || !(toleranciaM >= 0) || !(intervaloS >= 1)) {
+        return res.status(400).json({ message: "Modo, tolerância ou intervalo inválido." });
+      }
+
+      const pontos = await consultarTrajeto(usuarioId, { inicio, fim, modo, toleranciaM, intervaloS });
+      res.status(200).json(pontos);
+    } catch (error: any) {
+      res.status(500).json({ 
+        message: "Erro interno no servidor.", 
+        error: error.message 
+      });
+    }
+  }
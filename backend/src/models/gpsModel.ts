@@ -6,6 +6,7 @@ export class GpsAreaSegura extends Model {
   declare id: number;
   declare pontos: any[];
   declare ativo: boolean;
+  declare usuarioId: number | null;
 }
 
 GpsAreaSegura.init(
@@ -26,6 +27,11 @@ GpsAreaSegura.init(
     ativo: {
       type: DataTypes.BOOLEAN,
       allowNull: false,
+    },
+    // Dono da área; null vale para todos os usuários (comportamento original)
+    usuarioId: {
+      type: DataTypes.INTEGER,
+      allowNull: true,
     }
   },
   {
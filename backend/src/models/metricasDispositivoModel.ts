@@ -0,0 +1,131 @@
+import { DataTypes, Model } from 'sequelize';
+import { sequelize } from '../config/db';
+
+// Saúde do dispositivo publicada periodicamente em dispositivos/<id>/metricas
+export class MetricasDispositivo extends Model {
+  declare id: number;
+  declare dispositivoId: string | null;
+  declare usuarioId: number;
+  declare sequencia: number;
+  declare uptimeS: number;
+  declare janelaS: number;
+  declare heapLivre: number;
+  declare heapMinLivre: number;
+  declare heapMaiorBloco: number;
+  declare fragmentacaoPct: number;
+  declare idadeFixMs: number | null;
+  declare rssiDbm: number | null;
+  declare mqttConectado: boolean;
+  declare publicacoes: number;
+  declare latenciaMediaMs: number;
+  declare latenciaMaxMs: number;
+  declare filaMqttBytes: number;
+  declare outboxPendentes: number;
+  declare jitterMaxUs: number;
+  declare jitterHistograma: number[];
+  declare tarefas: { nome: string; cpuPct: number | null; pilhaLivreBytes: number }[];
+  declare timestamp: Date;
+}
+
+MetricasDispositivo.init(
+  {
+    id: {
+      type: DataTypes.BIGINT,
+      autoIncrement: true,
+      primaryKey: true
+    },
+    // null para frames vindos do tópico legado usuario/metricas
+    dispositivoId: {
+      type: DataTypes.STRING(32),
+      allowNull: true
+    },
+    usuarioId: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    sequencia: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    uptimeS: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    janelaS: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    heapLivre: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    heapMinLivre: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    heapMaiorBloco: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    fragmentacaoPct: {
+      type: DataTypes.FLOAT,
+      allowNull: false
+    },
+    idadeFixMs: {
+      type: DataTypes.BIGINT,
+      allowNull: true
+    },
+    rssiDbm: {
+      type: DataTypes.INTEGER,
+      allowNull: true
+    },
+    mqttConectado: {
+      type: DataTypes.BOOLEAN,
+      allowNull: false
+    },
+    publicacoes: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    latenciaMediaMs: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    latenciaMaxMs: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    filaMqttBytes: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    outboxPendentes: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    jitterMaxUs: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    jitterHistograma: {
+      type: DataTypes.ARRAY(DataTypes.INTEGER),
+      allowNull: false
+    },
+    // Uma entrada por tarefa: nome, % de um núcleo e menor pilha livre
+    tarefas: {
+      type: DataTypes.JSONB,
+      allowNull: false
+    },
+    timestamp: {
+      type: DataTypes.DATE,
+      allowNull: false
+    }
+  },
+  {
+    sequelize,
+    modelName: 'metricasDispositivoModel',
+    tableName: 'metricas_dispositivo',
+    timestamps: false,
+    indexes: [{ fields: ['usuarioId', 'timestamp'] }, { fields: ['dispositivoId', 'timestamp'] }]
+  }
+);
@@ -0,0 +1,54 @@
+import { DataTypes, Model } from 'sequelize';
+import { sequelize } from '../config/db';
+
+// Trajeto: todas as posições recebidas (gps_usuario guarda só a última)
+export class PosicaoHistorico extends Model {
+  declare id: number;
+  declare usuarioId: number;
+  declare latitude: number;
+  declare longitude: number;
+  declare hdop: number | null;
+  declare velocidadeKmh: number | null;
+  declare timestamp: Date;
+}
+
+PosicaoHistorico.init(
+  {
+    id: {
+      type: DataTypes.BIGINT,
+      autoIncrement: true,
+      primaryKey: true
+    },
+    usuarioId: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    latitude: {
+      type: DataTypes.FLOAT,
+      allowNull: false
+    },
+    longitude: {
+      type: DataTypes.FLOAT,
+      allowNull: false
+    },
+    hdop: {
+      type: DataTypes.FLOAT,
+      allowNull: true
+    },
+    velocidadeKmh: {
+      type: DataTypes.FLOAT,
+      allowNull: true
+    },
+    timestamp: {
+      type: DataTypes.DATE,
+      allowNull: false
+    }
+  },
+  {
+    sequelize,
+    modelName: 'posicaoHistoricoModel',
+    tableName: 'posicao_historico',
+    timestamps: false,
+    indexes: [{ fields: ['usuarioId', 'timestamp'] }]
+  }
+);
@@ -0,0 +1,49 @@
+import { DataTypes, Model } from 'sequelize';
+import { sequelize } from '../config/db';
+
+// Resumo periódico do acelerômetro enviado no lote de telemetria
+export class ResumoImu extends Model {
+  declare id: number;
+  declare usuarioId: number;
+  declare amostras: number;
+  declare magMinMg: number;
+  declare magMaxMg: number;
+  declare timestamp: Date;
+}
+
+ResumoImu.init(
+  {
+    id: {
+      type: DataTypes.BIGINT,
+      autoIncrement: true,
+      primaryKey: true
+    },
+    usuarioId: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    amostras: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    magMinMg: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    magMaxMg: {
+      type: DataTypes.INTEGER,
+      allowNull: false
+    },
+    timestamp: {
+      type: DataTypes.DATE,
+      allowNull: false
+    }
+  },
+  {
+    sequelize,
+    modelName: 'resumoImuModel',
+    tableName: 'resumo_imu',
+    timestamps: false,
+    indexes: [{ fields: ['usuarioId', 'timestamp'] }]
+  }
+);
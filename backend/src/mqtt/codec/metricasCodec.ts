@@ -0,0 +1,120 @@
+// src/mqtt/codec/metricasCodec.ts
+
+// Frame de saúde publicado pelo firmware em dispositivos/<id>/metricas
+// (ver metricas_modulo.h). Little-endian, versão 1.
+export const METRICAS_VERSAO = 1;
+export const METRICAS_TIPO_SAUDE = 0x03;
+export const METRICAS_FLAG_WIFI = 0x01;
+export const METRICAS_FLAG_MQTT = 0x02;
+export const METRICAS_FLAG_CPU = 0x04;
+export const METRICAS_SEM_FIX = 0xffffffff;
+
+const TAMANHO_CABECALHO = 58;
+const TAMANHO_TAREFA = 16;
+const TAMANHO_NOME_TAREFA = 12;
+const FAIXAS_JITTER = 7;
+
+export interface TarefaMetricas {
+    nome: string;
+    // Por cento de um núcleo na janela; null sem contadores de execução
+    cpuPct: number | null;
+    pilhaLivreBytes: number;
+}
+
+export interface MetricasDispositivo {
+    usuarioId: number;
+    sequencia: number;
+    uptimeS: number;
+    janelaS: number;
+    heapLivre: number;
+    heapMinLivre: number;
+    heapMaiorBloco: number;
+    // 1 - maior bloco / livre, em %
+    fragmentacaoPct: number;
+    idadeFixMs: number | null;
+    wifiConectado: boolean;
+    mqttConectado: boolean;
+    rssiDbm: number | null;
+    publicacoes: number;
+    latenciaMediaMs: number;
+    latenciaMaxMs: number;
+    filaMqttBytes: number;
+    outboxPendentes: number;
+    jitterMaxUs: number;
+    // Faixas <100, <250, <500, <1000, <2000, <5000, >=5000 us
+    jitterHistograma: number[];
+    tarefas: TarefaMetricas[];
+}
+
+/**
+ * Decodifica um frame de saúde.
+ * Lança erro se a versão, o tipo ou o tamanho não baterem.
+ */
+export function decodificarMetricas(buffer: Buffer): MetricasDispositivo {
+    if (buffer.length < TAMANHO_CABECALHO) {
+        throw new Error(`Frame de métricas curto: ${buffer.length} bytes`);
+    }
+
+    const versao = buffer.readUInt8(0);
+    if (versao !== METRICAS_VERSAO) {
+        throw new Error(`Versão de métricas não suportada: ${versao}`);
+    }
+    const tipo = buffer.readUInt8(1);
+    if (tipo !== METRICAS_TIPO_SAUDE) {
+        throw new Error(`Tipo de frame inesperado: ${tipo}`);
+    }
+
+    const nTarefas = buffer.readUInt8(6);
+    const esperado = TAMANHO_CABECALHO + nTarefas * TAMANHO_TAREFA;
+    if (buffer.length < esperado) {
+        throw new Error(`Frame de métricas truncado: ${buffer.length} de ${esperado} bytes`);
+    }
+
+    const flags = buffer.readUInt8(7);
+    const heapLivre = buffer.readUInt32LE(12);
+    const heapMaiorBloco = buffer.readUInt32LE(20);
+    const idadeFix = buffer.readUInt32LE(24);
+    const wifiConectado = (flags & METRICAS_FLAG_WIFI) !== 0;
+    const comCpu = (flags & METRICAS_FLAG_CPU) !== 0;
+
+    const jitterHistograma: number[] = [];
+    for (let i = 0; i < FAIXAS_JITTER; i++) {
+        jitterHistograma.push(buffer.readUInt16LE(44 + i * 2));
+    }
+
+    const tarefas: TarefaMetricas[] = [];
+    let off = TAMANHO_CABECALHO;
+    for (let i = 0; i < nTarefas; i++) {
+        const nome = buffer.subarray(off, off + TAMANHO_NOME_TAREFA).toString('latin1').replace(/\0.*$/, '');
+        const permil = buffer.readUInt16LE(off + TAMANHO_NOME_TAREFA);
+        tarefas.push({
+            nome,
+            cpuPct: comCpu ? permil / 10 : null,
+            pilhaLivreBytes: buffer.readUInt16LE(off + TAMANHO_NOME_TAREFA + 2)
+        });
+        off += TAMANHO_TAREFA;
+    }
+
+    return {
+        sequencia: buffer.readUInt16LE(2),
+        usuarioId: buffer.readUInt16LE(4),
+        uptimeS: buffer.readUInt32LE(8),
+        heapLivre,
+        heapMinLivre: buffer.readUInt32LE(16),
+        heapMaiorBloco,
+        fragmentacaoPct: heapLivre ? Math.round((1 - heapMaiorBloco / heapLivre) * 1000) / 10 : 0,
+        idadeFixMs: idadeFix === METRICAS_SEM_FIX ? null : idadeFix,
+        janelaS: buffer.readUInt16LE(28),
+        wifiConectado,
+        mqttConectado: (flags & METRICAS_FLAG_MQTT) !== 0,
+        rssiDbm: wifiConectado ? buffer.readInt8(30) : null,
+        publicacoes: buffer.readUInt16LE(32),
+        latenciaMediaMs: buffer.readUInt16LE(34),
+        latenciaMaxMs: buffer.readUInt16LE(36),
+        filaMqttBytes: buffer.readUInt16LE(38),
+        outboxPendentes: buffer.readUInt16LE(40),
+        jitterMaxUs: buffer.readUInt16LE(42),
+        jitterHistograma,
+        tarefas
+    };
+}
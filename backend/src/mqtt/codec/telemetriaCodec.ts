@@ -0,0 +1,204 @@
+// src/mqtt/codec/telemetriaCodec.ts
+
+// Frames binários enviados pelo firmware (ver telemetria_modulo.h).
+// Little-endian; posição avulsa tem 24 bytes na versão 1.
+export const TELEMETRIA_VERSAO = 1;
+export const TELEMETRIA_TAMANHO_POSICAO = 24;
+export const TELEMETRIA_TIPO_POSICAO = 0x01;
+export const TELEMETRIA_TIPO_LOTE = 0x02;
+export const TELEMETRIA_FLAG_FIX_VALIDO = 0x01;
+export const TELEMETRIA_BATERIA_DESCONHECIDA = 0xff;
+
+export interface PosicaoTelemetria {
+    usuarioId: number;
+    latitude: number;
+    longitude: number;
+    // Horário do fix informado pelo GPS; null quando o módulo ainda não tem data
+    timestamp: Date | null;
+    sequencia?: number;
+    bateria?: number | null;
+    fixValido?: boolean;
+    hdop?: number;
+    velocidadeKmh?: number;
+}
+
+export interface ResumoImuTelemetria {
+    timestamp: Date;
+    amostras: number;
+    magMinMg: number;
+    magMaxMg: number;
+}
+
+// Conteúdo de uma mensagem em dispositivos/<id>/gps, qualquer que seja o formato
+export interface LoteTelemetria {
+    usuarioId: number;
+    sequencia?: number;
+    bateria?: number | null;
+    posicoes: PosicaoTelemetria[];
+    resumosImu: ResumoImuTelemetria[];
+}
+
+const TAMANHO_CABECALHO_LOTE = 16;
+const TAMANHO_FIX_ABSOLUTO = 14;
+const TAMANHO_FIX_DELTA = 8;
+const TAMANHO_RESUMO_IMU = 8;
+// dt do lote em unidades de 10 ms
+const UNIDADE_DT_MS = 10;
+
+/**
+ * Decodifica um frame binário de posição.
+ * Lança erro se a versão, o tipo ou o tamanho não baterem.
+ */
+export function decodificarPosicaoBinaria(buffer: Buffer): PosicaoTelemetria {
+    if (buffer.length < TELEMETRIA_TAMANHO_POSICAO) {
+        throw new Error(`Frame de telemetria curto: ${buffer.length} bytes`);
+    }
+
+    const versao = buffer.readUInt8(0);
+    if (versao !== TELEMETRIA_VERSAO) {
+        throw new Error(`Versão de telemetria não suportada: ${versao}`);
+    }
+
+    const tipo = buffer.readUInt8(1);
+    if (tipo !== TELEMETRIA_TIPO_POSICAO) {
+        throw new Error(`Tipo de frame inesperado: ${tipo}`);
+    }
+
+    const bateria = buffer.readUInt8(6);
+    const epoch = buffer.readUInt32LE(8);
+
+    return {
+        sequencia: buffer.readUInt16LE(2),
+        usuarioId: buffer.readUInt16LE(4),
+        bateria: bateria === TELEMETRIA_BATERIA_DESCONHECIDA ? null : bateria,
+        fixValido: (buffer.readUInt8(7) & TELEMETRIA_FLAG_FIX_VALIDO) !== 0,
+        timestamp: epoch ? new Date(epoch * 1000) : null,
+        latitude: buffer.readInt32LE(12) / 1e7,
+        longitude: buffer.readInt32LE(16) / 1e7,
+        hdop: buffer.readUInt16LE(20) / 100,
+        velocidadeKmh: buffer.readUInt16LE(22) / 100
+    };
+}
+
+/**
+ * Decodifica um lote: fixes delta-codificados e resumos do IMU.
+ * Sem data no dispositivo, o último item do lote é datado com a recepção.
+ */
+export function decodificarLoteBinario(buffer: Buffer): LoteTelemetria {
+    if (buffer.length < TAMANHO_CABECALHO_LOTE) {
+        throw new Error(`Lote de telemetria curto: ${buffer.length} bytes`);
+    }
+
+    const versao = buffer.readUInt8(0);
+    if (versao !== TELEMETRIA_VERSAO) {
+        throw new Error(`Versão de telemetria não suportada: ${versao}`);
+    }
+
+    const nFixes = buffer.readUInt8(7);
+    const nResumos = buffer.readUInt8(8);
+    const esperado = TAMANHO_CABECALHO_LOTE
+        + (nFixes > 0 ? TAMANHO_FIX_ABSOLUTO + (nFixes - 1) * TAMANHO_FIX_DELTA : 0)
+        + nResumos * TAMANHO_RESUMO_IMU;
+    if (buffer.length < esperado) {
+        throw new Error(`Lote truncado: ${buffer.length} de ${esperado} bytes`);
+    }
+
+    const usuarioId = buffer.readUInt16LE(4);
+    const bateria = buffer.readUInt8(6);
+    const epoch = buffer.readUInt32LE(10);
+
+    // Tempos relativos (ms) primeiro; a base só é conhecida no fim se não houver data
+    const fixes: { dtMs: number; latE7: number; lonE7: number; hdop: number; velocidadeKmh: number }[] = [];
+    let off = TAMANHO_CABECALHO_LOTE;
+    let latE7 = 0;
+    let lonE7 = 0;
+    for (let i = 0; i < nFixes; i++) {
+        const dtMs = buffer.readUInt16LE(off) * UNIDADE_DT_MS;
+        if (i === 0) {
+            latE7 = buffer.readInt32LE(off + 2);
+            lonE7 = buffer.readInt32LE(off + 6);
+            fixes.push({ dtMs, latE7, lonE7, hdop: buffer.readUInt16LE(off + 10) / 100, velocidadeKmh: buffer.readUInt16LE(off + 12) / 100 });
+            off += TAMANHO_FIX_ABSOLUTO;
+        } else {
+            latE7 += buffer.readInt16LE(off + 2);
+            lonE7 += buffer.readInt16LE(off + 4);
+            fixes.push({ dtMs, latE7, lonE7, hdop: buffer.readUInt8(off + 6) / 10, velocidadeKmh: buffer.readUInt8(off + 7) });
+            off += TAMANHO_FIX_DELTA;
+        }
+    }
+
+    const resumos: { dtMs: number; amostras: number; magMinMg: number; magMaxMg: number }[] = [];
+    for (let i = 0; i < nResumos; i++) {
+        resumos.push({
+            dtMs: buffer.readUInt16LE(off) * UNIDADE_DT_MS,
+            amostras: buffer.readUInt16LE(off + 2),
+            magMinMg: buffer.readUInt16LE(off + 4),
+            magMaxMg: buffer.readUInt16LE(off + 6)
+        });
+        off += TAMANHO_RESUMO_IMU;
+    }
+
+    let baseMs: number;
+    if (epoch) {
+        baseMs = epoch * 1000 + buffer.readUInt16LE(14);
+    } else {
+        const ultimoDt = Math.max(0, ...fixes.map(f => f.dtMs), ...resumos.map(r => r.dtMs));
+        baseMs = Date.now() - ultimoDt;
+    }
+
+    return {
+        usuarioId,
+        sequencia: buffer.readUInt16LE(2),
+        bateria: bateria === TELEMETRIA_BATERIA_DESCONHECIDA ? null : bateria,
+        posicoes: fixes.map(f => ({
+            usuarioId,
+            latitude: f.latE7 / 1e7,
+            longitude: f.lonE7 / 1e7,
+            timestamp: new Date(baseMs + f.dtMs),
+            fixValido: true,
+            hdop: f.hdop,
+            velocidadeKmh: f.velocidadeKmh
+        })),
+        resumosImu: resumos.map(r => ({
+            timestamp: new Date(baseMs + r.dtMs),
+            amostras: r.amostras,
+            magMinMg: r.magMinMg,
+            magMaxMg: r.magMaxMg
+        }))
+    };
+}
+
+/**
+ * Aceita os formatos publicados em dispositivos/<id>/gps: o JSON legado (primeiro
+ * byte '{'), a posição binária avulsa e o lote. MQTT 3.1.1 não tem
+ * content-type, então o formato é identificado pelo primeiro byte e,
+ * no binário, pelo campo tipo.
+ */
+export function decodificarTelemetria(payload: Buffer): LoteTelemetria {
+    if (payload.length > 0 && payload[0] === 0x7b) {
+        const { usuarioId, latitude, longitude } = JSON.parse(payload.toString());
+        return {
+            usuarioId: Number(usuarioId),
+            posicoes: [{
+                usuarioId: Number(usuarioId),
+                latitude: Number(latitude),
+                longitude: Number(longitude),
+                timestamp: null
+            }],
+            resumosImu: []
+        };
+    }
+
+    if (payload.length > 1 && payload[1] === TELEMETRIA_TIPO_LOTE) {
+        return decodificarLoteBinario(payload);
+    }
+
+    const posicao = decodificarPosicaoBinaria(payload);
+    return {
+        usuarioId: posicao.usuarioId,
+        sequencia: posicao.sequencia,
+        bateria: posicao.bateria,
+        posicoes: [posicao],
+        resumosImu: []
+    };
+}
@@ -0,0 +1,153 @@
+// src/mqtt/filaHandlers.ts
+
+export interface OpcoesFilaHandlers {
+    concorrencia: number;   // Handlers rodando ao mesmo tempo (limita conexões ao banco)
+    maxPendentes: number;   // Acima disto a mensagem é descartada em vez de acumular memória
+    amostrasLatencia?: number;
+}
+
+export interface EstatisticasFilaHandlers {
+    recebidas: number;
+    concluidas: number;
+    descartadas: number;
+    erros: number;
+    pendentes: number;
+    ativas: number;
+    latenciaP50Ms: number;
+    latenciaP99Ms: number;
+    latenciaMaxMs: number;
+}
+
+type Tarefa = { executar: () => Promise<void>; inicio: number };
+
+/**
+ * Pool de handlers com concorrência limitada e ordem por chave: mensagens
+ * do mesmo dispositivo rodam uma de cada vez, na ordem de chegada (a
+ * posição atual e a histerese dos alertas dependem disso); dispositivos
+ * diferentes rodam em paralelo até `concorrencia`.
+ *
+ * Latência = da chegada ao fim do handler, espera na fila incluída.
+ */
+export class FilaHandlers {
+    private porChave = new Map<string, Tarefa[]>();
+    private prontas: string[] = [];     // Chaves com trabalho e nenhum handler rodando
+    private inicioProntas = 0;
+    private ativas = 0;
+    private pendentes = 0;
+
+    private recebidas = 0;
+    private concluidas = 0;
+    private descartadas = 0;
+    private erros = 0;
+    private latencias: Float64Array;
+    private proximaLatencia = 0;
+    private totalLatencias = 0;
+    private latenciaMaxMs = 0;
+
+    constructor(private opcoes: OpcoesFilaHandlers) {
+        this.latencias = new Float64Array(opcoes.amostrasLatencia ?? 8192);
+    }
+
+    // false se descartada por excesso de pendentes
+    enfileirar(chave: string, executar: () => Promise<void>): boolean {
+        this.recebidas++;
+        if (this.pendentes >= this.opcoes.maxPendentes) {
+            this.descartadas++;
+            return false;
+        }
+        this.pendentes++;
+
+        const tarefa: Tarefa = { executar, inicio: performance.now() };
+        const fila = this.porChave.get(chave);
+        if (fila) {
+            // Chave já rodando ou já em prontas: só entra no fim
+            fila.push(tarefa);
+        } else {
+            this.porChave.set(chave, [tarefa]);
+            this.prontas.push(chave);
+        }
+        this.bombear();
+        return true;
+    }
+
+    private bombear() {
+        while (this.ativas < this.opcoes.concorrencia && this.inicioProntas < this.prontas.length) {
+            const chave = this.prontas[this.inicioProntas++];
+            this.executar(chave);
+        }
+        // Compacta de vez em quando em vez de shift() a cada mensagem
+        if (this.inicioProntas > 1024 && this.inicioProntas * 2 > this.prontas.length) {
+            this.prontas = this.prontas.slice(this.inicioProntas);
+            this.inicioProntas = 0;
+        }
+    }
+
+    private executar(chave: string) {
+        const fila = this.porChave.get(chave)!;
+        const tarefa = fila[0];
+        this.ativas++;
+
+        let promessa: Promise<void>;
+        try {
+            promessa = tarefa.executar();
+        } catch (error) {
+            promessa = Promise.reject(error);
+        }
+
+        promessa
+            .catch(() => { this.erros++; })
+            .finally(() => {
+                this.ativas--;
+                this.pendentes--;
+                this.concluidas++;
+                this.registrarLatencia(performance.now() - tarefa.inicio);
+
+                fila.shift();
+                if (fila.length > 0) {
+                    this.prontas.push(chave);
+                } else {
+                    this.porChave.delete(chave);
+                }
+                this.bombear();
+            });
+    }
+
+    private registrarLatencia(ms: number) {
+        this.latencias[this.proximaLatencia] = ms;
+        this.proximaLatencia = (this.proximaLatencia + 1) % this.latencias.length;
+        this.totalLatencias = Math.min(this.totalLatencias + 1, this.latencias.length);
+        if (ms > this.latenciaMaxMs) this.latenciaMaxMs = ms;
+    }
+
+    // Percentis sobre as últimas `amostrasLatencia` mensagens; zera contadores e máximo
+    estatisticas(): EstatisticasFilaHandlers {
+        const amostras = this.latencias.slice(0, this.totalLatencias).sort();
+        const percentil = (p: number) =>
+            amostras.length ? amostras[Math.min(amostras.length - 1, Math.floor(p * amostras.length))] : 0;
+
+        const resultado: EstatisticasFilaHandlers = {
+            recebidas: this.recebidas,
+            concluidas: this.concluidas,
+            descartadas: this.descartadas,
+            erros: this.erros,
+            pendentes: this.pendentes,
+            ativas: this.ativas,
+            latenciaP50Ms: percentil(0.5),
+            latenciaP99Ms: percentil(0.99),
+            latenciaMaxMs: this.latenciaMaxMs
+        };
+
+        this.recebidas = this.concluidas = this.descartadas = this.erros = 0;
+        this.latenciaMaxMs = 0;
+        this.totalLatencias = 0;
+        this.proximaLatencia = 0;
+        return resultado;
+    }
+
+    // Resolve quando tudo que foi aceito terminou (testes de carga e desligamento)
+    async esvaziar(): Promise<void> {
+        while (this.pendentes > 0) {
+            await new Promise(resolve => setTimeout(resolve, 5));
+        }
+    }
+}
@@ -0,0 +1,36 @@
+import { enviarAlertaDeAreaSegura } from "../../bot";
+import { Alerta } from "../../models/alertaModel";
+import { ContextoMensagem } from "../roteador";
+import { estadoAlertas } from "../../services/estadoAlertas";
+import { usuarioPossuiAreaPropria } from "../../services/gpsService";
+
+// Transição de estado já calculada no dispositivo (entrou/saiu da área segura)
+export async function handleAreaSeguraMessage(packet: any, client: any, contexto: ContextoMensagem) {
+    try {
+        const payload = JSON.parse(packet.payload.toString());
+        const usuarioId = payload.usuarioId;
+        const pontoAtual = { latitude: Number(payload.latitude), longitude: Number(payload.longitude) };
+
+        // O dispositivo só conhece a área global: com área própria quem decide são os fixes no backend
+        if (await usuarioPossuiAreaPropria(Number(usuarioId))) return;
+
+        // Mesmo estado dos fixes: a transição que o backend já alertou não alerta de novo
+        const transicao = estadoAlertas.registrarTransicaoDispositivo(Number(usuarioId), Boolean(payload.dentro));
+        if (transicao === null) return;
+
+        if (transicao === 'voltou') {
+            console.log(`Usuário ${usuarioId} voltou para a área segura.`);
+            return;
+        }
+
+        console.log(`Usuário ${usuarioId} saiu da área segura (detectado no dispositivo ${contexto.dispositivoId ?? 'legado'})!`);
+        enviarAlertaDeAreaSegura(pontoAtual);
+        await Alerta.create({
+            tipoAlerta: "Área Segura",
+            timestamp: new Date()
+        });
+
+    } catch (error) {
+        console.error('Erro ao tratar transição de área segura:', error);
+    }
+}
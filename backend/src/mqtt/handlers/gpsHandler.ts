@@ -1,36 +1,66 @@
 import { enviarAlertaDeAreaSegura } from "../../bot";
-import { GpsUsuario } from "../../models/gpsUsuarioModel";
 import { Alerta } from "../../models/alertaModel";
-import { verificarSeDentroAreaSegura } from "../../services/gpsService";
+import { avaliarAreaSegura } from "../../services/gpsService";
+import { estadoAlertas, TransicaoArea } from "../../services/estadoAlertas";
+import { registrarTelemetria } from "../../services/trajetoService";
+import { decodificarTelemetria } from "../codec/telemetriaCodec";
+import { ContextoMensagem } from "../roteador";
 
 interface Coordenada {
     latitude: number;
     longitude: number;
 }
 
-export async function handleGpsMessage(packet: any, client: any) {
+export async function handleGpsMessage(packet: any, client: any, contexto: ContextoMensagem) {
     try {
-        const payload = JSON.parse(packet.payload.toString());
-        const { usuarioId, latitude, longitude } = payload;
+        // JSON legado, posição binária ou lote com vários fixes
+        const lote = decodificarTelemetria(packet.payload);
+        const { usuarioId } = lote;
+        const recebidoEm = new Date();
 
-        // Atualiza ou cria registro do GPS
-        await GpsUsuario.upsert({
+        if (lote.posicoes.length === 0 && lote.resumosImu.length === 0) return;
+
+        // Trajeto, resumos e posição atual vão para o escritor em lote: sem esperar o banco
+        registrarTelemetria(usuarioId, lote.posicoes.map(p => ({
             usuarioId,
-            latitude,
-            longitude,
-            timestamp: new Date()
-        });
+            latitude: p.latitude,
+            longitude: p.longitude,
+            hdop: p.hdop ?? null,
+            velocidadeKmh: p.velocidadeKmh ?? null,
+            timestamp: p.timestamp ?? recebidoEm
+        })), lote.resumosImu.map(r => ({ usuarioId, ...r })));
+
+        if (lote.posicoes.length === 0) return;
 
-        console.log(`Localização do usuário ${usuarioId} salva com sucesso!`);
+        // Última posição do lote é a posição atual
+        const ultima = lote.posicoes[lote.posicoes.length - 1];
+        const { latitude, longitude } = ultima;
 
-        const pontoAtual: Coordenada = { latitude, longitude };
-        const dentroArea = await verificarSeDentroAreaSegura(pontoAtual);
+        // Todos os fixes do lote passam pela histerese, em ordem; só a transição alerta
+        let transicao: TransicaoArea | null = null;
+        let pontoTransicao: Coordenada = { latitude, longitude };
+        for (const p of lote.posicoes) {
+            const pontoAtual: Coordenada = { latitude: p.latitude, longitude: p.longitude };
+            // Índice em memória: sem banco por fix; null quando o usuário não tem área
+            const avaliacao = await avaliarAreaSegura(pontoAtual, usuarioId);
+            if (!avaliacao) break;
+
+            const t = estadoAlertas.registrarFix(usuarioId, {
+                ...avaliacao,
+                hdop: p.hdop,
+                timestampMs: (p.timestamp ?? recebidoEm).getTime()
+            });
+            if (t) {
+                transicao = t;
+                pontoTransicao = pontoAtual;
+            }
+        }
 
-        if (dentroArea) {
-            console.log(`Usuário ${usuarioId} está dentro da área segura.`);
-        } else {
-            console.log(`Usuário ${usuarioId} saiu da área segura!`);
-            enviarAlertaDeAreaSegura(pontoAtual);
+        if (transicao === 'voltou') {
+            console.log(`Usuário ${usuarioId} voltou para a área segura.`);
+        } else if (transicao === 'saiu') {
+            console.log(`Usuário ${usuarioId} saiu da área segura! (dispositivo ${contexto.dispositivoId ?? 'legado'})`);
+            enviarAlertaDeAreaSegura(pontoTransicao);
             // Precisa de refatoração um dia meus amigos, função repetida no sistema para cada tipo diferente de alerta
             await Alerta.create({
             tipoAlerta: "Área Segura",
@@ -0,0 +1,37 @@
+import { MetricasDispositivo } from "../../models/metricasDispositivoModel";
+import { decodificarMetricas } from "../codec/metricasCodec";
+import { ContextoMensagem } from "../roteador";
+
+// Frame de saúde periódico; guardado como chegou, para comparar versões de firmware na frota
+export async function handleMetricasMessage(packet: any, client: any, contexto: ContextoMensagem) {
+    try {
+        const m = decodificarMetricas(packet.payload);
+
+        await MetricasDispositivo.create({
+            dispositivoId: contexto.dispositivoId,
+            usuarioId: m.usuarioId,
+            sequencia: m.sequencia,
+            uptimeS: m.uptimeS,
+            janelaS: m.janelaS,
+            heapLivre: m.heapLivre,
+            heapMinLivre: m.heapMinLivre,
+            heapMaiorBloco: m.heapMaiorBloco,
+            fragmentacaoPct: m.fragmentacaoPct,
+            idadeFixMs: m.idadeFixMs,
+            rssiDbm: m.rssiDbm,
+            mqttConectado: m.mqttConectado,
+            publicacoes: m.publicacoes,
+            latenciaMediaMs: m.latenciaMediaMs,
+            latenciaMaxMs: m.latenciaMaxMs,
+            filaMqttBytes: m.filaMqttBytes,
+            outboxPendentes: m.outboxPendentes,
+            jitterMaxUs: m.jitterMaxUs,
+            jitterHistograma: m.jitterHistograma,
+            tarefas: m.tarefas,
+            timestamp: new Date()
+        });
+
+    } catch (error) {
+        console.error('Erro ao salvar métricas do dispositivo:', error);
+    }
+}
@@ -1,8 +1,16 @@
 import { enviarAlertaDeAreaSegura, enviarAlertaQueda } from "../../bot";
 import { Alerta } from "../../models/alertaModel";
+import { ContextoMensagem } from "../roteador";
+import { estadoAlertas } from "../../services/estadoAlertas";
 
-export async function handleQuedaMessage() {
+export async function handleQuedaMessage(packet: any, client: any, contexto: ContextoMensagem) {
     try {
+        // Reenvio do outbox, QoS 1 duplicado ou queda confirmada de novo: um alerta por janela
+        const chave = contexto.dispositivoId ?? contexto.topico;
+        if (!estadoAlertas.registrarQueda(chave)) {
+            console.log(`Queda repetida do dispositivo ${contexto.dispositivoId ?? 'legado'} dentro da janela, sem novo alerta`);
+            return;
+        }
 
         enviarAlertaQueda();
 
@@ -11,7 +19,7 @@ export async function handleQuedaMessage() {
                     timestamp: new Date()
                     });
 
-        console.log("Salvo alerta!");
+        console.log(`Alerta de queda salvo (dispositivo ${contexto.dispositivoId ?? 'legado'})`);
 
     } catch (error) {
         console.error('Erro no detector de queda', error);
@@ -1,35 +1,30 @@
 // src/mqtt/index.ts
-import aedes from 'aedes';
-import { createServer } from 'net';
 import { handleGpsMessage } from './handlers/gpsHandler';
 import { handleQuedaMessage } from './handlers/quedaHandler';
+import { handleAreaSeguraMessage } from './handlers/areaSeguraHandler';
+import { handleMetricasMessage } from './handlers/metricasHandler';
+import { registrarBroker } from './publisher';
+import { RoteadorMqtt } from './roteador';
+import { iniciarIngestao, opcoesIngestaoDoAmbiente } from './ingestao';
 
-export function startBroker(mqttPort: number) {
-    const broker = new aedes();
-    const server = createServer(broker.handle);
-
-    server.listen(mqttPort, () => {
-        console.log(`MQTT Broker rodando na porta ${mqttPort}`);
-    });
-
-    broker.on('publish', async (packet, client) => {
-        if (!client) return;
-
-        console.log(`Mensagem recebida do cliente ${client.id}:`);
-        console.log(`Tópico: ${packet.topic}`);
-        console.log(`Payload: ${packet.payload.toString()}`);
-
-        // Redireciona para funções específicas por tópico
-        // Informações para o GPS
-        if (packet.topic === 'usuario/gps') {
-            await handleGpsMessage(packet, client);
-        }
-        // Informações para Queda
-        if(packet.topic === '/usuario/queda') {
-            await handleQuedaMessage();
-        }
-
-    });
+export function criarRoteador(): RoteadorMqtt {
+    return new RoteadorMqtt()
+        // Posição: JSON legado, frame binário ou lote
+        .registrarTipo('gps', handleGpsMessage)
+        .registrarTipo('queda', handleQuedaMessage)
+        // Transição de área segura detectada no dispositivo
+        .registrarTipo('area_segura', handleAreaSeguraMessage)
+        // Saúde do dispositivo (CPU, pilhas, heap, MQTT, Wi-Fi)
+        .registrarTipo('metricas', handleMetricasMessage)
+        // Firmware anterior ao id por dispositivo, e o que ficou no outbox dele
+        .registrarExato('usuario/gps', handleGpsMessage)
+        .registrarExato('/usuario/queda', handleQuedaMessage)
+        .registrarExato('usuario/area_segura', handleAreaSeguraMessage)
+        .registrarExato('usuario/metricas', handleMetricasMessage);
+}
 
+export function startBroker(mqttPort: number) {
+    const { broker } = iniciarIngestao(mqttPort, criarRoteador(), opcoesIngestaoDoAmbiente());
+    registrarBroker(broker);
     return broker;
 }
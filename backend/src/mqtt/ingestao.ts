@@ -0,0 +1,70 @@
+// src/mqtt/ingestao.ts
+import aedes from 'aedes';
+import { createServer, Server } from 'net';
+import { RoteadorMqtt } from './roteador';
+import { FilaHandlers, EstatisticasFilaHandlers, OpcoesFilaHandlers } from './filaHandlers';
+
+export interface OpcoesIngestao extends OpcoesFilaHandlers {
+    relatorioMs: number;  // 0 desliga o resumo periódico
+}
+
+export function opcoesIngestaoDoAmbiente(): OpcoesIngestao {
+    return {
+        concorrencia: +(process.env.MQTT_HANDLERS_CONCORRENCIA || 16),
+        maxPendentes: +(process.env.MQTT_HANDLERS_MAX_PENDENTES || 10000),
+        relatorioMs: +(process.env.MQTT_RELATORIO_MS || 60000)
+    };
+}
+
+export interface Ingestao {
+    broker: aedes;
+    server: Server;
+    fila: FilaHandlers;
+}
+
+/**
+ * Broker aedes com roteamento por tabela e handlers num pool limitado.
+ * Nada é logado por mensagem: só um resumo a cada `relatorioMs`.
+ * Não depende do banco; index.ts liga os handlers reais.
+ */
+export function iniciarIngestao(mqttPort: number, roteador: RoteadorMqtt, opcoes: OpcoesIngestao): Ingestao {
+    const broker = new aedes();
+    const server = createServer(broker.handle);
+    const fila = new FilaHandlers(opcoes);
+    let semRota = 0;
+
+    server.listen(mqttPort, () => {
+        console.log(`MQTT Broker rodando na porta ${mqttPort} (handlers: ${opcoes.concorrencia} simultâneos, ` +
+            `até ${opcoes.maxPendentes} pendentes)`);
+    });
+
+    broker.on('publish', (packet, client) => {
+        // Publicações do próprio broker (área segura retida) não têm cliente
+        if (!client) return;
+
+        const rota = roteador.resolver(packet.topic);
+        if (!rota) {
+            semRota++;
+            return;
+        }
+
+        // Mesmo dispositivo em ordem; tópico legado usa a conexão como chave
+        const chave = rota.contexto.dispositivoId ?? client.id;
+        fila.enfileirar(chave, () => rota.handler(packet, client, rota.contexto));
+    });
+
+    if (opcoes.relatorioMs > 0) {
+        setInterval(() => {
+            const e = fila.estatisticas();
+            const semRotaJanela = semRota;
+            semRota = 0;
+            if (e.recebidas === 0 && e.pendentes === 0) return;
+            console.log(`MQTT: ${(e.recebidas * 1000 / opcoes.relatorioMs).toFixed(1)} msg/s, ` +
+                `${e.concluidas} tratadas, ${e.descartadas} descartadas, ${e.erros} erros, ${semRotaJanela} sem rota, ` +
+                `${e.pendentes} pendentes, latência p50 ${e.latenciaP50Ms.toFixed(1)} ms ` +
+                `p99 ${e.latenciaP99Ms.toFixed(1)} ms, max ${e.latenciaMaxMs.toFixed(1)} ms`);
+        }, opcoes.relatorioMs).unref();
+    }
+
+    return { broker, server, fila };
+}
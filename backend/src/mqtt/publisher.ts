@@ -0,0 +1,44 @@
+// src/mqtt/publisher.ts
+
+// Tópico retido com a área segura ativa, consumido pelo firmware (inscrito só em dispositivos/area_segura)
+export const TOPICO_AREA_SEGURA = 'dispositivos/area_segura';
+
+// Só o que usamos do broker aedes
+interface BrokerPublicador {
+    publish(packet: any, callback: (error?: Error | null) => void): void;
+}
+
+let brokerAtivo: BrokerPublicador | null = null;
+
+export function registrarBroker(broker: BrokerPublicador) {
+    brokerAtivo = broker;
+}
+
+interface PontoArea {
+    latitude: number;
+    longitude: number;
+}
+
+/**
+ * Publica (retido) a área segura ativa para os dispositivos.
+ * Sem área ativa publica lista vazia, o que desliga a verificação local.
+ */
+export function publicarAreaSegura(area: { id: number; pontos: PontoArea[] } | null) {
+    if (!brokerAtivo) return;
+
+    const payload = JSON.stringify({
+        id: area ? area.id : 0,
+        pontos: area ? area.pontos.map(p => ({ latitude: Number(p.latitude), longitude: Number(p.longitude) })) : []
+    });
+
+    brokerAtivo.publish({
+        cmd: 'publish',
+        topic: TOPICO_AREA_SEGURA,
+        payload: Buffer.from(payload),
+        qos: 1,
+        retain: true,
+        dup: false
+    }, (error?: Error | null) => {
+        if (error) console.error('Erro ao publicar área segura:', error);
+    });
+}
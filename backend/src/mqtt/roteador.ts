@@ -0,0 +1,56 @@
+// src/mqtt/roteador.ts
+
+// Cada dispositivo publica em dispositivos/<id>/<tipo>; o id é o MAC de fábrica (ou o provisionado no NVS)
+export const PREFIXO_DISPOSITIVOS = 'dispositivos/';
+
+export interface ContextoMensagem {
+    // null nos tópicos legados (usuario/...), publicados por firmware antigo ou guardados no outbox
+    dispositivoId: string | null;
+    topico: string;
+}
+
+export type HandlerMqtt = (packet: any, client: any, contexto: ContextoMensagem) => Promise<void>;
+
+export interface Rota {
+    handler: HandlerMqtt;
+    contexto: ContextoMensagem;
+}
+
+/**
+ * Tabela de rotas por tópico: uma busca em Map por mensagem, sem percorrer
+ * a lista de handlers nem comparar o tópico com cada um.
+ */
+export class RoteadorMqtt {
+    private porTipo = new Map<string, HandlerMqtt>();
+    private exatos = new Map<string, HandlerMqtt>();
+
+    // dispositivos/<id>/<tipo>
+    registrarTipo(tipo: string, handler: HandlerMqtt): this {
+        this.porTipo.set(tipo, handler);
+        return this;
+    }
+
+    // Tópico fixo, sem id de dispositivo
+    registrarExato(topico: string, handler: HandlerMqtt): this {
+        this.exatos.set(topico, handler);
+        return this;
+    }
+
+    resolver(topico: string): Rota | null {
+        if (topico.startsWith(PREFIXO_DISPOSITIVOS)) {
+            const fimId = topico.indexOf('/', PREFIXO_DISPOSITIVOS.length);
+            if (fimId > PREFIXO_DISPOSITIVOS.length) {
+                const handler = this.porTipo.get(topico.slice(fimId + 1));
+                if (handler) {
+                    return {
+                        handler,
+                        contexto: { dispositivoId: topico.slice(PREFIXO_DISPOSITIVOS.length, fimId), topico }
+                    };
+                }
+            }
+        }
+
+        const handler = this.exatos.get(topico);
+        return handler ? { handler, contexto: { dispositivoId: null, topico } } : null;
+    }
+}
@@ -0,0 +1,127 @@
+// src/mqtt/test/cargaDispositivos.ts
+//
+// Gerador de carga: N dispositivos simulados publicando posição em
+// dispositivos/<id>/gps com QoS 1. Mede mensagens por segundo e latência.
+//
+//   npx ts-node src/mqtt/test/cargaDispositivos.ts
+//
+// Sem CARGA_BROKER sobe a ingestão real (roteador + pool de handlers) num
+// broker local, com um handler sintético que decodifica o frame e espera
+// CARGA_HANDLER_MS no lugar do banco; a latência de tratamento (chegada ->
+// fim do handler) vem do próprio pool. Com CARGA_BROKER=mqtt://host:1883
+// só publica: a latência medida é publish -> PUBACK, e a de tratamento
+// aparece no resumo periódico do backend.
+//
+// Variáveis: CARGA_DISPOSITIVOS (1000), CARGA_INTERVALO_MS (1000),
+// CARGA_DURACAO_S (30), CARGA_HANDLER_MS (2), CARGA_PORTA (18830),
+// MQTT_HANDLERS_CONCORRENCIA, MQTT_HANDLERS_MAX_PENDENTES.
+import mqtt, { MqttClient } from 'mqtt';
+import { RoteadorMqtt, ContextoMensagem } from '../roteador';
+import { iniciarIngestao, opcoesIngestaoDoAmbiente } from '../ingestao';
+import { decodificarTelemetria } from '../codec/telemetriaCodec';
+
+const dispositivos = +(process.env.CARGA_DISPOSITIVOS || 1000);
+const intervaloMs = +(process.env.CARGA_INTERVALO_MS || 1000);
+const duracaoS = +(process.env.CARGA_DURACAO_S || 30);
+const handlerMs = +(process.env.CARGA_HANDLER_MS || 2);
+const porta = +(process.env.CARGA_PORTA || 18830);
+const brokerExterno = process.env.CARGA_BROKER;
+
+const espera = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+function percentil(valores: number[], p: number): number {
+    if (valores.length === 0) return 0;
+    const ordenados = [...valores].sort((a, b) => a - b);
+    return ordenados[Math.min(ordenados.length - 1, Math.floor(p * ordenados.length))];
+}
+
+// Id no formato do firmware: MAC em hex
+function idDispositivo(i: number): string {
+    return (0x24a160000000 + i).toString(16).padStart(12, '0');
+}
+
+async function main() {
+    let tratadas = 0;
+    let ingestao: ReturnType<typeof iniciarIngestao> | null = null;
+
+    if (!brokerExterno) {
+        const handlerSintetico = async (packet: any, client: any, contexto: ContextoMensagem) => {
+            decodificarTelemetria(packet.payload);
+            await espera(handlerMs);
+            tratadas++;
+        };
+        const roteador = new RoteadorMqtt()
+            .registrarTipo('gps', handlerSintetico)
+            .registrarTipo('metricas', handlerSintetico);
+        ingestao = iniciarIngestao(porta, roteador, { ...opcoesIngestaoDoAmbiente(), relatorioMs: 0, amostrasLatencia: 1 << 18 });
+        await espera(200);
+    }
+
+    const url = brokerExterno || `mqtt://localhost:${porta}`;
+    const clientes: MqttClient[] = [];
+    for (let i = 0; i < dispositivos; i++) {
+        clientes.push(mqtt.connect(url, { clientId: idDispositivo(i), reconnectPeriod: 0 }));
+        // Conexões escalonadas, como uma frota religando aos poucos
+        if (i % 100 === 99) await espera(50);
+    }
+    await Promise.all(clientes.map(c => c.connected ? Promise.resolve() : new Promise(r => c.once('connect', r))));
+    console.log(`${dispositivos} dispositivos conectados em ${url}`);
+
+    const latenciasPuback: number[] = [];
+    let publicadas = 0;
+    let falhas = 0;
+    const inicio = performance.now();
+    ingestao?.fila.estatisticas();
+
+    // Cada dispositivo publica no seu próprio ritmo, com fase aleatória
+    const timers = clientes.map((cliente, i) => {
+        const topico = `dispositivos/${idDispositivo(i)}/gps`;
+        const publicar = () => {
+            const payload = JSON.stringify({
+                usuarioId: i + 1,
+                latitude: -22.97 + Math.random() * 0.01,
+                longitude: -43.18 + Math.random() * 0.01
+            });
+            const t0 = performance.now();
+            publicadas++;
+            cliente.publish(topico, payload, { qos: 1 }, (erro) => {
+                if (erro) falhas++;
+                else latenciasPuback.push(performance.now() - t0);
+            });
+        };
+        let timer: NodeJS.Timeout | undefined;
+        const fase = setTimeout(() => {
+            publicar();
+            timer = setInterval(publicar, intervaloMs);
+        }, Math.random() * intervaloMs);
+        return () => { clearTimeout(fase); if (timer) clearInterval(timer); };
+    });
+
+    await espera(duracaoS * 1000);
+    timers.forEach(parar => parar());
+    await espera(500);
+    if (ingestao) await ingestao.fila.esvaziar();
+    const decorridoS = (performance.now() - inicio) / 1000;
+
+    console.log(`Publicadas: ${publicadas} (${(publicadas / decorridoS).toFixed(0)} msg/s), falhas ${falhas}`);
+    console.log(`PUBACK: p50 ${percentil(latenciasPuback, 0.5).toFixed(1)} ms, ` +
+        `p99 ${percentil(latenciasPuback, 0.99).toFixed(1)} ms`);
+    if (ingestao) {
+        const e = ingestao.fila.estatisticas();
+        console.log(`Tratadas: ${tratadas} (${(tratadas / decorridoS).toFixed(0)} msg/s), descartadas ${e.descartadas}, ` +
+            `erros ${e.erros}`);
+        console.log(`Tratamento (chegada -> fim do handler): p50 ${e.latenciaP50Ms.toFixed(1)} ms, ` +
+            `p99 ${e.latenciaP99Ms.toFixed(1)} ms, max ${e.latenciaMaxMs.toFixed(1)} ms`);
+    }
+
+    clientes.forEach(c => c.end(true));
+    if (ingestao) {
+        ingestao.server.close();
+        ingestao.broker.close();
+    }
+}
+
+main().catch(erro => {
+    console.error('Erro no gerador de carga:', erro);
+    process.exit(1);
+});
@@ -6,14 +6,14 @@ client.on('connect', () => {
     console.log('Conectado ao broker!');
 
     // Publica no tópico
-    client.publish('usuario/gps', JSON.stringify({
+    client.publish('dispositivos/24a160000002/gps', JSON.stringify({
         usuarioId: 2,
         latitude: -22.9707,
         longitude: -43.1823
     }));
 
     // Se inscreve no tópico
-    client.subscribe('usuario/gps');
+    client.subscribe('dispositivos/24a160000002/gps');
 });
 
 client.on('message', (topic, message) => {
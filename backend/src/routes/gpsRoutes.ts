@@ -6,7 +6,8 @@ import {
     atualizarAreaAtivaController,
     deletarAreaController,
     listarAreasController,
-    posicaoAtualUsuarioController
+    posicaoAtualUsuarioController,
+    trajetoUsuarioController
 
 } from '../controllers/gpsController'; 
 
@@ -24,5 +25,7 @@ router.delete('/deletar/:id', deletarAreaController);
 router.get('/listar', listarAreasController);
 
 router.get('/posicao/:id', posicaoAtualUsuarioController)
+// Trajeto do usuário, reduzido no servidor
+router.get('/trajeto/:id', trajetoUsuarioController)
 
 export default router;
\ No newline at end of file
@@ -0,0 +1,140 @@
+// src/services/escritorEmLote.ts
+//
+// Buffer de escrita: handlers só adicionam linhas (sem await por mensagem)
+// e o banco recebe um INSERT com muitas linhas a cada `maxLinhas` ou
+// `intervaloMs`, o que vier primeiro.
+
+export interface OpcoesEscritor<T> {
+    nome: string;
+    maxLinhas: number;       // Descarrega na hora ao atingir
+    intervaloMs: number;     // Espera máxima de uma linha no buffer
+    maxPendentes: number;    // Com o banco fora, acima disto as linhas mais antigas são descartadas
+    // Com chave, uma linha nova substitui a pendente de mesma chave (ex.: última posição)
+    chave?: (linha: T) => number | string;
+}
+
+export interface EstatisticasEscritor {
+    adicionadas: number;
+    gravadas: number;
+    descartadas: number;
+    falhas: number;
+    lotes: number;
+    pendentes: number;
+    maiorLote: number;
+}
+
+export class EscritorEmLote<T> {
+    private buffer: T[] = [];
+    private indicePorChave = new Map<number | string, number>();
+    private timer: NodeJS.Timeout | null = null;
+    private gravando: Promise<void> | null = null;
+    private retomarEm = 0;   // Depois de uma falha, nenhuma tentativa antes disto (Date.now())
+    private contadores = { adicionadas: 0, gravadas: 0, descartadas: 0, falhas: 0, lotes: 0, maiorLote: 0 };
+
+    constructor(private opcoes: OpcoesEscritor<T>, private gravar: (linhas: T[]) => Promise<void>) {}
+
+    adicionar(linhas: T[]) {
+        const chave = this.opcoes.chave;
+        for (const linha of linhas) {
+            this.contadores.adicionadas++;
+            if (chave) {
+                const k = chave(linha);
+                const i = this.indicePorChave.get(k);
+                if (i !== undefined) {
+                    this.buffer[i] = linha;
+                    continue;
+                }
+                this.indicePorChave.set(k, this.buffer.length);
+            }
+            this.buffer.push(linha);
+        }
+        if (this.buffer.length > this.opcoes.maxPendentes) this.limitar();
+
+        if (this.buffer.length >= this.opcoes.maxLinhas) {
+            this.agendar(0);
+        } else if (this.buffer.length > 0) {
+            this.agendar(this.opcoes.intervaloMs);
+        }
+    }
+
+    private agendar(ms: number) {
+        if (this.gravando) return;   // Ao terminar o lote atual, reavalia
+        ms = Math.max(ms, this.retomarEm - Date.now());
+        if (this.timer) {
+            if (ms > 0) return;
+            clearTimeout(this.timer);
+        }
+        this.timer = setTimeout(() => {
+            this.timer = null;
+            void this.descarregarUmLote();
+        }, ms);
+    }
+
+    private descarregarUmLote(): Promise<void> {
+        if (this.gravando) return this.gravando;
+        if (this.buffer.length === 0) return Promise.resolve();
+
+        const lote = this.buffer.length > this.opcoes.maxLinhas ? this.buffer.splice(0, this.opcoes.maxLinhas) : this.buffer;
+        if (lote === this.buffer) this.buffer = [];
+        this.reindexar();
+
+        this.gravando = this.gravar(lote).then(() => {
+            this.contadores.gravadas += lote.length;
+            this.contadores.lotes++;
+            if (lote.length > this.contadores.maiorLote) this.contadores.maiorLote = lote.length;
+        }, (error) => {
+            this.retomarEm = Date.now() + this.opcoes.intervaloMs;
+            this.contadores.falhas++;
+            console.error(`Escrita em lote (${this.opcoes.nome}) falhou com ${lote.length} linhas:`, error?.message ?? error);
+            this.devolver(lote);
+        }).finally(() => {
+            this.gravando = null;
+            if (this.buffer.length >= this.opcoes.maxLinhas) this.agendar(0);
+            else if (this.buffer.length > 0) this.agendar(this.opcoes.intervaloMs);
+        });
+        return this.gravando;
+    }
+
+    // Lote que falhou volta para a frente; linhas mais novas de mesma chave prevalecem
+    private devolver(lote: T[]) {
+        const chave = this.opcoes.chave;
+        const voltam = chave ? lote.filter(l => !this.indicePorChave.has(chave(l))) : lote;
+        this.buffer = voltam.concat(this.buffer);
+        this.limitar();
+    }
+
+    // Acima de maxPendentes saem as linhas mais antigas
+    private limitar() {
+        const excesso = this.buffer.length - this.opcoes.maxPendentes;
+        if (excesso > 0) {
+            this.buffer.splice(0, excesso);
+            this.contadores.descartadas += excesso;
+        }
+        this.reindexar();
+    }
+
+    private reindexar() {
+        const chave = this.opcoes.chave;
+        if (!chave) return;
+        this.indicePorChave.clear();
+        for (let i = 0; i < this.buffer.length; i++) this.indicePorChave.set(chave(this.buffer[i]), i);
+    }
+
+    /** Grava tudo que está no buffer (encerramento, testes) */
+    async descarregar(): Promise<void> {
+        if (this.timer) {
+            clearTimeout(this.timer);
+            this.timer = null;
+        }
+        // Para no primeiro lote que falhar: as linhas voltaram ao buffer
+        while (this.gravando || this.buffer.length > 0) {
+            const falhasAntes = this.contadores.falhas;
+            await (this.gravando ?? this.descarregarUmLote());
+            if (this.contadores.falhas !== falhasAntes) return;
+        }
+    }
+
+    estatisticas(): EstatisticasEscritor {
+        return { ...this.contadores, pendentes: this.buffer.length };
+    }
+}
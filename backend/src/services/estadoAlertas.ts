@@ -0,0 +1,143 @@
+// src/services/estadoAlertas.ts
+//
+// Estado dos alertas em memória: área segura por usuário, queda por
+// dispositivo. Só transições viram alerta (bot + linha em `alerta`); um
+// usuário parado na borda ou um dispositivo repetindo a queda gera um
+// evento, não um por mensagem.
+//
+// A área segura segue a mesma regra do firmware (geofence_modulo.c):
+//   dentro -> fora: fixes fora por mais que margem + HDOP x erro, mantidos
+//                   por confirmacaoMs; fixes fora mas dentro da margem não
+//                   confirmam nem cancelam
+//   fora -> dentro: fixes dentro pelo mesmo tempo
+// Qualquer fix do lado do estado atual cancela a transição pendente, e fixes
+// com HDOP acima do limite são ignorados.
+//
+// O estado é por processo: depois de reiniciar o backend, um usuário que já
+// estava fora gera um alerta de novo.
+
+export type EstadoArea = 'desconhecido' | 'dentro' | 'fora';
+export type TransicaoArea = 'saiu' | 'voltou';
+
+export interface OpcoesAlertas {
+    margemM: number;
+    erroPorHdopM: number;
+    hdopMax: number;
+    confirmacaoMs: number;
+    janelaQuedaMs: number;   // Quedas repetidas do mesmo dispositivo dentro da janela não alertam
+}
+
+export function opcoesAlertasDoAmbiente(): OpcoesAlertas {
+    return {
+        margemM: +(process.env.ALERTA_AREA_MARGEM_M || 20),
+        erroPorHdopM: +(process.env.ALERTA_AREA_ERRO_POR_HDOP_M || 5),
+        hdopMax: +(process.env.ALERTA_AREA_HDOP_MAX || 5),
+        confirmacaoMs: +(process.env.ALERTA_AREA_CONFIRMACAO_MS || 15000),
+        janelaQuedaMs: +(process.env.ALERTA_QUEDA_JANELA_MS || 120000)
+    };
+}
+
+export interface FixArea {
+    dentro: boolean;
+    distanciaBordaM: number;
+    hdop?: number | null;
+    timestampMs: number;
+}
+
+interface EstadoAreaUsuario {
+    estado: EstadoArea;
+    transicaoDesdeMs: number | null;   // Primeiro fix contrário ao estado
+}
+
+export interface EstatisticasAlertas {
+    transicoesArea: number;
+    fixesIgnoradosHdop: number;
+    quedasAlertadas: number;
+    quedasSuprimidas: number;
+}
+
+export class EstadoAlertas {
+    private areas = new Map<number, EstadoAreaUsuario>();
+    private ultimaQuedaMs = new Map<string, number>();
+    private contadores: EstatisticasAlertas = { transicoesArea: 0, fixesIgnoradosHdop: 0, quedasAlertadas: 0, quedasSuprimidas: 0 };
+
+    constructor(private opcoes: OpcoesAlertas) {}
+
+    private areaDoUsuario(usuarioId: number): EstadoAreaUsuario {
+        let area = this.areas.get(usuarioId);
+        if (!area) {
+            area = { estado: 'desconhecido', transicaoDesdeMs: null };
+            this.areas.set(usuarioId, area);
+        }
+        return area;
+    }
+
+    estadoArea(usuarioId: number): EstadoArea {
+        return this.areas.get(usuarioId)?.estado ?? 'desconhecido';
+    }
+
+    /** Fix avaliado no backend; retorna a transição confirmada, se houver */
+    registrarFix(usuarioId: number, fix: FixArea): TransicaoArea | null {
+        const o = this.opcoes;
+        // HDOP ausente ou 0: receptor não informou, conta como 1
+        const hdop = fix.hdop && fix.hdop > 0 ? fix.hdop : 1;
+        if (hdop > o.hdopMax) {
+            this.contadores.fixesIgnoradosHdop++;
+            return null;
+        }
+
+        const area = this.areaDoUsuario(usuarioId);
+        const lado: EstadoArea = fix.dentro ? 'dentro' : 'fora';
+        if (area.estado === lado) {
+            area.transicaoDesdeMs = null;
+            return null;
+        }
+
+        const conta = fix.dentro || fix.distanciaBordaM > o.margemM + hdop * o.erroPorHdopM;
+        if (!conta) return null;
+
+        if (area.transicaoDesdeMs === null) area.transicaoDesdeMs = fix.timestampMs;
+        if (fix.timestampMs - area.transicaoDesdeMs < o.confirmacaoMs) return null;
+
+        return this.mudarArea(area, lado);
+    }
+
+    /** Transição já confirmada pelo dispositivo (com a histerese dele) */
+    registrarTransicaoDispositivo(usuarioId: number, dentro: boolean): TransicaoArea | null {
+        const area = this.areaDoUsuario(usuarioId);
+        const lado: EstadoArea = dentro ? 'dentro' : 'fora';
+        if (area.estado === lado) {
+            area.transicaoDesdeMs = null;
+            return null;
+        }
+        return this.mudarArea(area, lado);
+    }
+
+    private mudarArea(area: EstadoAreaUsuario, lado: EstadoArea): TransicaoArea | null {
+        const anterior = area.estado;
+        area.estado = lado;
+        area.transicaoDesdeMs = null;
+        // Primeira posição dentro só estabelece o estado
+        if (anterior === 'desconhecido' && lado === 'dentro') return null;
+        this.contadores.transicoesArea++;
+        return lado === 'fora' ? 'saiu' : 'voltou';
+    }
+
+    /** true se a queda deve alertar; repetições dentro da janela retornam false */
+    registrarQueda(chave: string, agoraMs: number = Date.now()): boolean {
+        const ultima = this.ultimaQuedaMs.get(chave);
+        if (ultima !== undefined && agoraMs - ultima < this.opcoes.janelaQuedaMs) {
+            this.contadores.quedasSuprimidas++;
+            return false;
+        }
+        this.ultimaQuedaMs.set(chave, agoraMs);
+        this.contadores.quedasAlertadas++;
+        return true;
+    }
+
+    estatisticas(): EstatisticasAlertas {
+        return { ...this.contadores };
+    }
+}
+
+export const estadoAlertas = new EstadoAlertas(opcoesAlertasDoAmbiente());
@@ -0,0 +1,355 @@
+// src/services/geofenceIndice.ts
+//
+// Áreas seguras compiladas para consulta por fix, sem banco e sem Turf no
+// caminho quente. Mesma semântica do booleanPointInPolygon do Turf: plano
+// em (longitude, latitude), borda conta como dentro.
+
+export interface PontoArea {
+    latitude: number;
+    longitude: number;
+}
+
+export interface AreaDefinicao {
+    id: number;
+    usuarioId: number | null;   // null: vale para todos os usuários
+    pontos: PontoArea[];
+}
+
+// [minLon, minLat, maxLon, maxLat]
+export type Caixa = [number, number, number, number];
+
+const FORA = 0;
+const DENTRO = 1;
+const BORDA = 2;
+
+const METROS_POR_GRAU = 111320;
+
+// Abaixo disto a grade não compensa: as faixas já deixam poucas arestas por
+// consulta, e montar a grade custa mais que o resto da compilação
+const VERTICES_MIN_GRADE = 256;
+const CELULAS_GRADE = 32;
+
+/**
+ * Polígono pronto para consulta:
+ *  - caixa envolvente, que descarta a maioria dos fixes com 4 comparações;
+ *  - arestas em arrays planos, agrupadas por faixas horizontais: o raio de
+ *    um ponto só cruza arestas da faixa dele;
+ *  - com muitos vértices, grade CELULAS_GRADE² marcando células inteiras
+ *    dentro ou fora; só células na borda olham arestas.
+ */
+export class PoligonoCompilado {
+    readonly caixa: Caixa;
+    private xs: Float64Array;
+    private ys: Float64Array;
+    private faixas: Int32Array[];
+    private alturaFaixa: number;
+    private grade: Uint8Array | null = null;
+    private larguraCelula = 0;
+    private alturaCelula = 0;
+
+    constructor(pontos: PontoArea[]) {
+        let n = pontos.length;
+        // Fechamento explícito (primeiro ponto repetido) é implícito aqui
+        if (n > 1 && pontos[0].latitude === pontos[n - 1].latitude && pontos[0].longitude === pontos[n - 1].longitude) {
+            n--;
+        }
+        if (n < 3) {
+            throw new Error('Área segura inválida. É necessário pelo menos 3 pontos.');
+        }
+
+        this.xs = new Float64Array(n);
+        this.ys = new Float64Array(n);
+        const caixa: Caixa = [Infinity, Infinity, -Infinity, -Infinity];
+        for (let i = 0; i < n; i++) {
+            const x = Number(pontos[i].longitude);
+            const y = Number(pontos[i].latitude);
+            this.xs[i] = x;
+            this.ys[i] = y;
+            if (x < caixa[0]) caixa[0] = x;
+            if (y < caixa[1]) caixa[1] = y;
+            if (x > caixa[2]) caixa[2] = x;
+            if (y > caixa[3]) caixa[3] = y;
+        }
+        this.caixa = caixa;
+
+        // Faixas: ~2 arestas por faixa em média num polígono bem comportado
+        const numFaixas = Math.max(1, Math.min(1024, Math.ceil(n / 2)));
+        this.alturaFaixa = (caixa[3] - caixa[1]) / numFaixas || 1;
+        const listas: number[][] = Array.from({ length: numFaixas }, () => []);
+        for (let i = 0; i < n; i++) {
+            const j = (i + 1) % n;
+            const f0 = this.faixaDe(Math.min(this.ys[i], this.ys[j]), numFaixas);
+            const f1 = this.faixaDe(Math.max(this.ys[i], this.ys[j]), numFaixas);
+            for (let f = f0; f <= f1; f++) listas[f].push(i);
+        }
+        this.faixas = listas.map(l => Int32Array.from(l));
+
+        if (n >= VERTICES_MIN_GRADE) {
+            this.montarGrade();
+        }
+    }
+
+    private faixaDe(y: number, numFaixas: number): number {
+        const f = Math.floor((y - this.caixa[1]) / this.alturaFaixa);
+        return f < 0 ? 0 : f >= numFaixas ? numFaixas - 1 : f;
+    }
+
+    private montarGrade() {
+        const [minX, minY, maxX, maxY] = this.caixa;
+        this.larguraCelula = (maxX - minX) / CELULAS_GRADE || 1;
+        this.alturaCelula = (maxY - minY) / CELULAS_GRADE || 1;
+        const grade = new Uint8Array(CELULAS_GRADE * CELULAS_GRADE);
+
+        // Conservador: toda célula tocada pela caixa de uma aresta é borda
+        const n = this.xs.length;
+        for (let i = 0; i < n; i++) {
+            const j = (i + 1) % n;
+            const c0 = this.celulaX(Math.min(this.xs[i], this.xs[j]));
+            const c1 = this.celulaX(Math.max(this.xs[i], this.xs[j]));
+            const l0 = this.celulaY(Math.min(this.ys[i], this.ys[j]));
+            const l1 = this.celulaY(Math.max(this.ys[i], this.ys[j]));
+            for (let l = l0; l <= l1; l++) {
+                for (let c = c0; c <= c1; c++) grade[l * CELULAS_GRADE + c] = BORDA;
+            }
+        }
+
+        // Célula sem aresta está toda de um lado: basta o centro
+        for (let l = 0; l < CELULAS_GRADE; l++) {
+            for (let c = 0; c < CELULAS_GRADE; c++) {
+                const k = l * CELULAS_GRADE + c;
+                if (grade[k] === BORDA) continue;
+                const x = minX + (c + 0.5) * this.larguraCelula;
+                const y = minY + (l + 0.5) * this.alturaCelula;
+                grade[k] = this.contemPorArestas(x, y) ? DENTRO : FORA;
+            }
+        }
+        this.grade = grade;
+    }
+
+    private celulaX(x: number): number {
+        const c = Math.floor((x - this.caixa[0]) / this.larguraCelula);
+        return c < 0 ? 0 : c >= CELULAS_GRADE ? CELULAS_GRADE - 1 : c;
+    }
+
+    private celulaY(y: number): number {
+        const l = Math.floor((y - this.caixa[1]) / this.alturaCelula);
+        return l < 0 ? 0 : l >= CELULAS_GRADE ? CELULAS_GRADE - 1 : l;
+    }
+
+    // Raio para +x contra as arestas da faixa; ponto sobre uma aresta conta como dentro
+    private contemPorArestas(x: number, y: number): boolean {
+        const arestas = this.faixas[this.faixaDe(y, this.faixas.length)];
+        const xs = this.xs, ys = this.ys, n = xs.length;
+        let dentro = false;
+
+        for (let k = 0; k < arestas.length; k++) {
+            const i = arestas[k];
+            const j = i + 1 === n ? 0 : i + 1;
+            const xi = xs[i], yi = ys[i], xj = xs[j], yj = ys[j];
+
+            const cruz = (xj - xi) * (y - yi) - (yj - yi) * (x - xi);
+            if (cruz === 0 && x >= Math.min(xi, xj) && x <= Math.max(xi, xj) &&
+                y >= Math.min(yi, yj) && y <= Math.max(yi, yj)) {
+                return true;
+            }
+            if ((yi > y) !== (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+                dentro = !dentro;
+            }
+        }
+        return dentro;
+    }
+
+    // Menor distância até a borda em metros (plano local em torno do ponto)
+    distanciaBordaM(longitude: number, latitude: number): number {
+        const xs = this.xs, ys = this.ys, n = xs.length;
+        const kx = METROS_POR_GRAU * Math.cos(latitude * Math.PI / 180);
+        let menor2 = Infinity;
+
+        for (let i = 0; i < n; i++) {
+            const j = i + 1 === n ? 0 : i + 1;
+            const ax = (xs[i] - longitude) * kx, ay = (ys[i] - latitude) * METROS_POR_GRAU;
+            const dx = (xs[j] - longitude) * kx - ax, dy = (ys[j] - latitude) * METROS_POR_GRAU - ay;
+            const comprimento2 = dx * dx + dy * dy;
+            let t = comprimento2 > 0 ? -(ax * dx + ay * dy) / comprimento2 : 0;
+            t = t < 0 ? 0 : t > 1 ? 1 : t;
+            const ex = ax + t * dx, ey = ay + t * dy;
+            const d2 = ex * ex + ey * ey;
+            if (d2 < menor2) menor2 = d2;
+        }
+        return Math.sqrt(menor2);
+    }
+
+    contem(longitude: number, latitude: number): boolean {
+        const c = this.caixa;
+        if (longitude < c[0] || longitude > c[2] || latitude < c[1] || latitude > c[3]) {
+            return false;
+        }
+        if (this.grade) {
+            const estado = this.grade[this.celulaY(latitude) * CELULAS_GRADE + this.celulaX(longitude)];
+            if (estado !== BORDA) return estado === DENTRO;
+        }
+        return this.contemPorArestas(longitude, latitude);
+    }
+}
+
+interface NoRTree<T> {
+    caixa: Caixa;
+    filhos: NoRTree<T>[] | null;
+    valor: T | null;
+}
+
+const CAPACIDADE_NO = 16;
+
+function caixaDe<T>(nos: NoRTree<T>[]): Caixa {
+    const caixa: Caixa = [Infinity, Infinity, -Infinity, -Infinity];
+    for (const no of nos) {
+        if (no.caixa[0] < caixa[0]) caixa[0] = no.caixa[0];
+        if (no.caixa[1] < caixa[1]) caixa[1] = no.caixa[1];
+        if (no.caixa[2] > caixa[2]) caixa[2] = no.caixa[2];
+        if (no.caixa[3] > caixa[3]) caixa[3] = no.caixa[3];
+    }
+    return caixa;
+}
+
+/**
+ * R-tree estática montada de uma vez (Sort-Tile-Recursive). As áreas mudam
+ * só pela API, e cada mudança recompila o índice inteiro, então não há
+ * inserção nem remoção.
+ */
+export class RTreeEstatica<T> {
+    private raiz: NoRTree<T> | null;
+
+    constructor(itens: { caixa: Caixa; valor: T }[]) {
+        let nivel: NoRTree<T>[] = itens.map(i => ({ caixa: i.caixa, filhos: null, valor: i.valor }));
+        if (nivel.length === 0) {
+            this.raiz = null;
+            return;
+        }
+        while (nivel.length > 1) {
+            nivel = RTreeEstatica.empacotar(nivel);
+        }
+        this.raiz = nivel[0];
+    }
+
+    private static empacotar<T>(nos: NoRTree<T>[]): NoRTree<T>[] {
+        const centroX = (n: NoRTree<T>) => n.caixa[0] + n.caixa[2];
+        const centroY = (n: NoRTree<T>) => n.caixa[1] + n.caixa[3];
+        const numPais = Math.ceil(nos.length / CAPACIDADE_NO);
+        const porFatia = Math.ceil(Math.sqrt(numPais)) * CAPACIDADE_NO;
+
+        const ordenados = [...nos].sort((a, b) => centroX(a) - centroX(b));
+        const pais: NoRTree<T>[] = [];
+        for (let i = 0; i < ordenados.length; i += porFatia) {
+            const fatia = ordenados.slice(i, i + porFatia).sort((a, b) => centroY(a) - centroY(b));
+            for (let j = 0; j < fatia.length; j += CAPACIDADE_NO) {
+                const filhos = fatia.slice(j, j + CAPACIDADE_NO);
+                pais.push({ caixa: caixaDe(filhos), filhos, valor: null });
+            }
+        }
+        return pais;
+    }
+
+    // Valores cujas caixas contêm o ponto
+    buscar(x: number, y: number, saida: T[]): T[] {
+        if (!this.raiz) return saida;
+        const pilha: NoRTree<T>[] = [this.raiz];
+        while (pilha.length > 0) {
+            const no = pilha.pop()!;
+            const c = no.caixa;
+            if (x < c[0] || x > c[2] || y < c[1] || y > c[3]) continue;
+            if (no.filhos) {
+                for (const filho of no.filhos) pilha.push(filho);
+            } else {
+                saida.push(no.valor as T);
+            }
+        }
+        return saida;
+    }
+}
+
+export interface AvaliacaoArea {
+    dentro: boolean;
+    distanciaBordaM: number;   // Dentro: da borda mais próxima da área que contém; fora: da área mais próxima
+}
+
+export interface AreaCompilada {
+    id: number;
+    usuarioId: number | null;
+    poligono: PoligonoCompilado;
+}
+
+/**
+ * Todas as áreas ativas compiladas. Um usuário pode ter várias áreas ao
+ * mesmo tempo; as globais (usuarioId null) valem para todos. Estar dentro
+ * de qualquer uma conta como dentro da área segura.
+ */
+export class IndiceGeofence {
+    private arvore: RTreeEstatica<AreaCompilada>;
+    private areasPorUsuario = new Map<number | null, AreaCompilada[]>();
+    readonly invalidas: number[] = [];
+
+    constructor(areas: AreaDefinicao[]) {
+        const compiladas: AreaCompilada[] = [];
+        for (const area of areas) {
+            try {
+                const compilada = { id: area.id, usuarioId: area.usuarioId, poligono: new PoligonoCompilado(area.pontos) };
+                compiladas.push(compilada);
+                const doDono = this.areasPorUsuario.get(area.usuarioId);
+                if (doDono) doDono.push(compilada);
+                else this.areasPorUsuario.set(area.usuarioId, [compilada]);
+            } catch {
+                this.invalidas.push(area.id);
+            }
+        }
+        this.arvore = new RTreeEstatica(compiladas.map(a => ({ caixa: a.poligono.caixa, valor: a })));
+    }
+
+    // Há alguma área que valha para o usuário?
+    possuiArea(usuarioId: number | null): boolean {
+        return this.areasPorUsuario.has(null) || (usuarioId !== null && this.areasPorUsuario.has(usuarioId));
+    }
+
+    // O usuário tem área própria (além das globais)?
+    possuiAreaPropria(usuarioId: number | null): boolean {
+        return usuarioId !== null && this.areasPorUsuario.has(usuarioId);
+    }
+
+    // Ids das áreas do usuário (e globais) que contêm o ponto
+    areasQueContem(ponto: PontoArea, usuarioId: number | null): number[] {
+        const x = Number(ponto.longitude), y = Number(ponto.latitude);
+        const candidatas = this.arvore.buscar(x, y, []);
+        const ids: number[] = [];
+        for (const area of candidatas) {
+            if (area.usuarioId !== null && area.usuarioId !== usuarioId) continue;
+            if (area.poligono.contem(x, y)) ids.push(area.id);
+        }
+        return ids;
+    }
+
+    /**
+     * Dentro/fora com a distância até a borda, para a histerese dos alertas.
+     * Fora, percorre as áreas do usuário e as globais (poucas por usuário).
+     * @returns null se nenhuma área vale para o usuário
+     */
+    avaliar(ponto: PontoArea, usuarioId: number | null): AvaliacaoArea | null {
+        const x = Number(ponto.longitude), y = Number(ponto.latitude);
+        const globais = this.areasPorUsuario.get(null) ?? [];
+        const proprias = usuarioId !== null ? this.areasPorUsuario.get(usuarioId) ?? [] : [];
+        if (globais.length === 0 && proprias.length === 0) return null;
+
+        const candidatas = this.arvore.buscar(x, y, []);
+        let profundidade = -1;
+        for (const area of candidatas) {
+            if (area.usuarioId !== null && area.usuarioId !== usuarioId) continue;
+            if (area.poligono.contem(x, y)) {
+                profundidade = Math.max(profundidade, area.poligono.distanciaBordaM(x, y));
+            }
+        }
+        if (profundidade >= 0) return { dentro: true, distanciaBordaM: profundidade };
+
+        let menor = Infinity;
+        for (const area of globais) menor = Math.min(menor, area.poligono.distanciaBordaM(x, y));
+        for (const area of proprias) menor = Math.min(menor, area.poligono.distanciaBordaM(x, y));
+        return { dentro: false, distanciaBordaM: menor };
+    }
+}
@@ -1,49 +1,86 @@
 import { GpsAreaSegura } from '../models/gpsModel';
-import { GpsUsuario } from '../models/gpsUsuarioModel'
-import { point, polygon } from '@turf/helpers';
-import booleanPointInPolygon from '@turf/boolean-point-in-polygon';
+import { obterPosicaoAtual } from './trajetoService';
+import { publicarAreaSegura } from '../mqtt/publisher';
+import { IndiceGeofence, AvaliacaoArea } from './geofenceIndice';
 
 interface Coordenada {
     latitude: number;
     longitude: number;
 }
 
-/**
- * Verifica se uma coordenada está dentro da área segura ativa usando Turf.js
- * @param pontoAtual Coordenada recebida do front (latitude, longitude)
- * @returns true se estiver dentro, false caso contrário
+/*
+ * Índice das áreas ativas em memória. Compilado na primeira consulta e
+ * descartado a cada mudança de área por esta API; o caminho de cada fix
+ * não toca o banco. Mudanças feitas direto no banco só valem após reiniciar.
  */
-export async function verificarSeDentroAreaSegura(pontoAtual: Coordenada): Promise<boolean> {
-    try {
-        // Busca a área ativa
-        const areaAtiva = await GpsAreaSegura.findOne({ where: { ativo: true } });
+let indiceGeofence: Promise<IndiceGeofence> | null = null;
 
-        if (!areaAtiva) {
-            throw new Error('Nenhuma área segura ativa encontrada.');
-        }
+export function invalidarIndiceGeofence() {
+    indiceGeofence = null;
+}
 
-        const pontos = areaAtiva.pontos;
+function obterIndiceGeofence(): Promise<IndiceGeofence> {
+    if (!indiceGeofence) {
+        const carregando = GpsAreaSegura.findAll({ where: { ativo: true } }).then(areas => {
+            const indice = new IndiceGeofence(areas.map(a => ({
+                id: a.id,
+                usuarioId: a.usuarioId ?? null,
+                pontos: a.pontos
+            })));
+            if (indice.invalidas.length > 0) {
+                console.warn(`Áreas seguras ignoradas (menos de 3 pontos): ${indice.invalidas.join(', ')}`);
+            }
+            return indice;
+        });
+        indiceGeofence = carregando;
+        // Falha no banco não fica em cache: a próxima consulta tenta de novo
+        carregando.catch(() => {
+            if (indiceGeofence === carregando) indiceGeofence = null;
+        });
+    }
+    return indiceGeofence;
+}
 
-        if (!pontos || pontos.length < 3) {
-            throw new Error('Área segura inválida. É necessário pelo menos 3 pontos.');
-        }
+/**
+ * Consulta as áreas ativas do usuário (e as globais).
+ * @returns true/false, ou null se nenhuma área vale para o usuário
+ */
+export async function consultarAreaSegura(pontoAtual: Coordenada, usuarioId: number | null = null): Promise<boolean | null> {
+    const indice = await obterIndiceGeofence();
+    if (!indice.possuiArea(usuarioId)) {
+        return null;
+    }
+    return indice.areasQueContem(pontoAtual, usuarioId).length > 0;
+}
 
-        // Converte pontos para [lng, lat]
-        const coords = pontos.map(p => [p.longitude, p.latitude]);
+/**
+ * Dentro/fora com a distância até a borda, para a máquina de estados dos alertas.
+ * @returns null se nenhuma área vale para o usuário
+ */
+export async function avaliarAreaSegura(pontoAtual: Coordenada, usuarioId: number | null): Promise<AvaliacaoArea | null> {
+    const indice = await obterIndiceGeofence();
+    return indice.avaliar(pontoAtual, usuarioId);
+}
 
-        // Fecha o polígono repetindo o primeiro ponto no final se necessário
-        const first = coords[0];
-        const last = coords[coords.length - 1];
-        if (first[0] !== last[0] || first[1] !== last[1]) {
-            coords.push(first);
-        }
+// Com área própria o dispositivo (que só conhece a área global) não decide a transição
+export async function usuarioPossuiAreaPropria(usuarioId: number | null): Promise<boolean> {
+    const indice = await obterIndiceGeofence();
+    return indice.possuiAreaPropria(usuarioId);
+}
 
-        // Cria GeoJSON do polígono e do ponto
-        const poligonoGeoJSON = polygon([coords]);
-        const pontoGeoJSON = point([pontoAtual.longitude, pontoAtual.latitude]);
+/**
+ * Verifica se uma coordenada está dentro de alguma área segura ativa
+ * @param pontoAtual Coordenada recebida do front (latitude, longitude)
+ * @param usuarioId Sem usuário, só as áreas globais contam
+ * @returns true se estiver dentro, false caso contrário
+ */
+export async function verificarSeDentroAreaSegura(pontoAtual: Coordenada, usuarioId: number | null = null): Promise<boolean> {
+    try {
+        const dentro = await consultarAreaSegura(pontoAtual, usuarioId);
 
-        // Verifica se o ponto está dentro do polígono
-        const dentro = booleanPointInPolygon(pontoGeoJSON, poligonoGeoJSON);
+        if (dentro === null) {
+            throw new Error('Nenhuma área segura ativa encontrada.');
+        }
 
         return dentro;
     } catch (error) {
@@ -52,17 +89,26 @@ export async function verificarSeDentroAreaSegura(pontoAtual: Coordenada): Promi
     }
 }
 
-export async function adicionarAreaSegura(pontos: any[], nome: string) {
+/**
+ * Adiciona uma área ativa. Exclusiva (padrão) desativa as outras do mesmo
+ * dono; senão fica ativa junto com elas.
+ */
+export async function adicionarAreaSegura(pontos: any[], nome: string, usuarioId: number | null = null, exclusiva = true) {
     try {
-        // Desativa todas as áreas seguras ativas
-        await GpsAreaSegura.update({ ativo: false }, { where: { ativo: true } });
+        if (exclusiva) {
+            await GpsAreaSegura.update({ ativo: false }, { where: { ativo: true, usuarioId } });
+        }
 
         const novaArea = await GpsAreaSegura.create({
             nome: nome,
             pontos: pontos,
-            ativo: true
+            ativo: true,
+            usuarioId
         });
 
+        invalidarIndiceGeofence();
+        await sincronizarAreaSeguraDispositivos();
+
         return novaArea;
     } catch (error) {
         console.error('Erro ao adicionar área segura:', error);
@@ -70,10 +116,25 @@ export async function adicionarAreaSegura(pontos: any[], nome: string) {
     }
 }
 
+/**
+ * Republica a área ativa para os dispositivos (mensagens retidas do broker
+ * ficam só em memória, então isso roda na subida do servidor). O firmware
+ * guarda um polígono: vai a área global ativa mais recente; as áreas por
+ * usuário são verificadas no backend.
+ */
+export async function sincronizarAreaSeguraDispositivos() {
+    try {
+        const areaAtiva = await GpsAreaSegura.findOne({ where: { ativo: true, usuarioId: null }, order: [['id', 'DESC']] });
+        publicarAreaSegura(areaAtiva);
+    } catch (error) {
+        console.error('Erro ao sincronizar área segura com os dispositivos:', error);
+    }
+}
+
 export async function listarAreas() {
     try {
         const areas = await GpsAreaSegura.findAll({
-            attributes: ["id", "nome", "pontos", "ativo"], // seleciona colunas (opcional)
+            attributes: ["id", "nome", "pontos", "ativo", "usuarioId"], // seleciona colunas (opcional)
             order: [["id", "ASC"]] // ordenação opcional
         });
         return areas;
@@ -83,12 +144,9 @@ export async function listarAreas() {
     }
 }
 
-// Atualizar área ativa (desativa todas e ativa a área passada por parâmetro)
-export async function atualizarAreaAtiva(id: number) {
+// Atualizar área ativa (exclusiva: desativa as outras do mesmo dono e ativa a área passada por parâmetro)
+export async function atualizarAreaAtiva(id: number, exclusiva = true) {
     try {
-        // Desativa todas as áreas seguras
-        await GpsAreaSegura.update({ ativo: false }, { where: { ativo: true } });
-
         // Busca a área pelo id
         const area = await GpsAreaSegura.findByPk(id);
 
@@ -96,9 +154,16 @@ export async function atualizarAreaAtiva(id: number) {
             throw new Error('Área não encontrada.');
         }
 
+        if (exclusiva) {
+            await GpsAreaSegura.update({ ativo: false }, { where: { ativo: true, usuarioId: area.usuarioId ?? null } });
+        }
+
         // Ativa a área informada
         await area.update({ ativo: true });
 
+        invalidarIndiceGeofence();
+        await sincronizarAreaSeguraDispositivos();
+
         return area;
     } catch (error) {
         console.error('Erro ao atualizar área ativa:', error);
@@ -114,8 +179,14 @@ export async function deletarArea(id: number) {
             throw new Error('Área não encontrada.');
         }
 
+        const eraAtiva = area.ativo;
         await area.destroy();
 
+        if (eraAtiva) {
+            invalidarIndiceGeofence();
+            await sincronizarAreaSeguraDispositivos();
+        }
+
         return { mensagem: 'Área deletada com sucesso.' };
     } catch (error) {
         console.error('Erro ao deletar área:', error);
@@ -126,10 +197,8 @@ export async function deletarArea(id: number) {
 
 export async function posicaoAtualUsuario(usuarioId: number) {
     try {
-      const posicao = await GpsUsuario.findOne({
-        where: { usuarioId },
-        order: [['timestamp', 'DESC']],
-      });
+      // Cache em memória alimentado pela ingestão; o banco só na primeira consulta
+      const posicao = await obterPosicaoAtual(usuarioId);
   
       if (!posicao) {
         throw new Error('Posição do usuário não encontrada.');
@@ -0,0 +1,65 @@
+// src/services/simplificacaoTrajeto.ts
+//
+// Simplificação de trajeto para o mapa: Douglas-Peucker com tolerância em
+// metros, num plano local (equirretangular na latitude média). Mantém o
+// primeiro e o último ponto; só remove pontos a menos de `toleranciaM` da
+// linha que sobra.
+
+export interface PontoTrajeto {
+    latitude: number;
+    longitude: number;
+    timestamp: Date;
+}
+
+const METROS_POR_GRAU = 111320;
+
+export function douglasPeucker<T extends PontoTrajeto>(pontos: T[], toleranciaM: number): T[] {
+    const n = pontos.length;
+    if (n <= 2 || toleranciaM <= 0) return pontos.slice();
+
+    // Projeção única para todos os pontos
+    let somaLat = 0;
+    for (const p of pontos) somaLat += p.latitude;
+    const kx = METROS_POR_GRAU * Math.cos((somaLat / n) * Math.PI / 180);
+    const xs = new Float64Array(n), ys = new Float64Array(n);
+    for (let i = 0; i < n; i++) {
+        xs[i] = pontos[i].longitude * kx;
+        ys[i] = pontos[i].latitude * METROS_POR_GRAU;
+    }
+
+    const manter = new Uint8Array(n);
+    manter[0] = manter[n - 1] = 1;
+    const tolerancia2 = toleranciaM * toleranciaM;
+
+    // Pilha explícita: trajetos de um dia têm dezenas de milhares de pontos
+    const pilha: number[] = [0, n - 1];
+    while (pilha.length > 0) {
+        const fim = pilha.pop()!;
+        const inicio = pilha.pop()!;
+        const ax = xs[inicio], ay = ys[inicio];
+        const dx = xs[fim] - ax, dy = ys[fim] - ay;
+        const comprimento2 = dx * dx + dy * dy;
+
+        let maior2 = -1, indiceMaior = -1;
+        for (let i = inicio + 1; i < fim; i++) {
+            const px = xs[i] - ax, py = ys[i] - ay;
+            let t = comprimento2 > 0 ? (px * dx + py * dy) / comprimento2 : 0;
+            t = t < 0 ? 0 : t > 1 ? 1 : t;
+            const ex = px - t * dx, ey = py - t * dy;
+            const d2 = ex * ex + ey * ey;
+            if (d2 > maior2) {
+                maior2 = d2;
+                indiceMaior = i;
+            }
+        }
+
+        if (maior2 > tolerancia2) {
+            manter[indiceMaior] = 1;
+            pilha.push(inicio, indiceMaior, indiceMaior, fim);
+        }
+    }
+
+    const saida: T[] = [];
+    for (let i = 0; i < n; i++) if (manter[i]) saida.push(pontos[i]);
+    return saida;
+}
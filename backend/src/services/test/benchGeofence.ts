@@ -0,0 +1,105 @@
+// src/services/test/benchGeofence.ts
+//
+// Compara a verificação de área segura por fix: o caminho antigo
+// (polígono Turf montado a cada fix) contra o índice compilado, e confere
+// que os dois concordam em todos os pontos.
+//
+//   npx ts-node src/services/test/benchGeofence.ts
+//
+// Variáveis: BENCH_VERTICES (64), BENCH_AREAS (1000), BENCH_FIXES (200000).
+// Com BENCH_DB=1 mede também o findOne que o caminho antigo fazia por fix
+// (precisa do banco do .env).
+import { point, polygon } from '@turf/helpers';
+import booleanPointInPolygon from '@turf/boolean-point-in-polygon';
+import { IndiceGeofence, PoligonoCompilado, PontoArea, AreaDefinicao } from '../geofenceIndice';
+
+const vertices = +(process.env.BENCH_VERTICES || 64);
+const numAreas = +(process.env.BENCH_AREAS || 1000);
+const fixes = +(process.env.BENCH_FIXES || 200000);
+
+// Polígono estrelado (não convexo) em torno de um centro, raio ~500 m
+function areaEstrela(lat: number, lon: number, n: number): PontoArea[] {
+    const pontos: PontoArea[] = [];
+    for (let i = 0; i < n; i++) {
+        const ang = (2 * Math.PI * i) / n;
+        const raio = 0.005 * (i % 2 === 0 ? 1 : 0.6 + 0.3 * Math.random());
+        pontos.push({ latitude: lat + raio * Math.sin(ang), longitude: lon + raio * Math.cos(ang) });
+    }
+    return pontos;
+}
+
+function pontosAoRedor(lat: number, lon: number, qtd: number): PontoArea[] {
+    return Array.from({ length: qtd }, () => ({
+        latitude: lat + (Math.random() - 0.5) * 0.014,
+        longitude: lon + (Math.random() - 0.5) * 0.014
+    }));
+}
+
+// Como o gpsService fazia antes: converte e monta o polígono a cada fix
+function dentroTurf(area: PontoArea[], p: PontoArea): boolean {
+    const coords = area.map(a => [a.longitude, a.latitude]);
+    coords.push(coords[0]);
+    return booleanPointInPolygon(point([p.longitude, p.latitude]), polygon([coords]));
+}
+
+function medir(nome: string, qtd: number, fn: (i: number) => void) {
+    const inicio = process.hrtime.bigint();
+    for (let i = 0; i < qtd; i++) fn(i);
+    const ns = Number(process.hrtime.bigint() - inicio);
+    console.log(`${nome.padEnd(38)} ${(ns / qtd / 1000).toFixed(3)} µs/fix`);
+}
+
+async function main() {
+    const lat = -23.55, lon = -46.63;
+    const area = areaEstrela(lat, lon, vertices);
+    const pontos = pontosAoRedor(lat, lon, 4096);
+
+    // Concordância com o Turf antes de medir
+    const compilado = new PoligonoCompilado(area);
+    let divergencias = 0;
+    for (const p of pontos) {
+        if (compilado.contem(p.longitude, p.latitude) !== dentroTurf(area, p)) divergencias++;
+    }
+    console.log(`Área de ${vertices} vértices, ${pontos.length} pontos: ${divergencias} divergências com o Turf`);
+
+    let dentro = 0;
+    medir('Turf, polígono montado por fix', Math.min(fixes, 50000), i => {
+        if (dentroTurf(area, pontos[i & 4095])) dentro++;
+    });
+    medir('Polígono compilado', fixes, i => {
+        const p = pontos[i & 4095];
+        if (compilado.contem(p.longitude, p.latitude)) dentro++;
+    });
+
+    // Muitos usuários, cada um com sua área espalhada pela cidade
+    const areas: AreaDefinicao[] = [];
+    for (let i = 0; i < numAreas; i++) {
+        const c = { lat: lat + (Math.random() - 0.5) * 0.5, lon: lon + (Math.random() - 0.5) * 0.5 };
+        areas.push({ id: i + 1, usuarioId: i + 1, pontos: areaEstrela(c.lat, c.lon, vertices) });
+    }
+    const t0 = process.hrtime.bigint();
+    const indice = new IndiceGeofence(areas);
+    console.log(`Índice com ${numAreas} áreas compilado em ${(Number(process.hrtime.bigint() - t0) / 1e6).toFixed(1)} ms`);
+    medir(`Índice, ${numAreas} áreas`, fixes, i => {
+        const a = areas[i % numAreas];
+        const p = a.pontos[(i >> 4) % vertices];
+        if (indice.areasQueContem({ latitude: p.latitude * 0.999 + lat * 0.001, longitude: p.longitude }, a.usuarioId).length > 0) dentro++;
+    });
+
+    if (process.env.BENCH_DB) {
+        const { GpsAreaSegura } = await import('../../models/gpsModel');
+        const consultas = 2000;
+        const inicio = process.hrtime.bigint();
+        for (let i = 0; i < consultas; i++) {
+            await GpsAreaSegura.findOne({ where: { ativo: true } });
+        }
+        const ns = Number(process.hrtime.bigint() - inicio);
+        console.log(`${'findOne da área ativa (antigo, por fix)'.padEnd(38)} ${(ns / consultas / 1000).toFixed(3)} µs/fix`);
+    }
+
+    // Evita que o laço seja descartado
+    if (dentro < 0) console.log(dentro);
+    process.exit(0);
+}
+
+main();
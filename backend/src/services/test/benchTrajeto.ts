@@ -0,0 +1,95 @@
+// src/services/test/benchTrajeto.ts
+//
+// Ingestão de trajeto em linhas por segundo contra o banco do .env:
+//  - antigo: por mensagem, bulkCreate do lote + upsert da posição atual,
+//    com await, BENCH_CONCORRENCIA mensagens ao mesmo tempo (como o pool de
+//    handlers MQTT);
+//  - escritor: registrarTelemetria (sem await) e descarregarTrajeto no fim.
+//
+//   npx ts-node src/services/test/benchTrajeto.ts
+//
+// Variáveis: BENCH_DISPOSITIVOS (1000), BENCH_MENSAGENS (20000),
+// BENCH_FIXES_POR_MENSAGEM (10), BENCH_CONCORRENCIA (16),
+// BENCH_USUARIO_BASE (900000; usuários do teste, apagados no fim).
+import { Op } from 'sequelize';
+import { sequelize } from '../../config/db';
+import { PosicaoHistorico } from '../../models/posicaoHistoricoModel';
+import { GpsUsuario } from '../../models/gpsUsuarioModel';
+import { registrarTelemetria, descarregarTrajeto, garantirParticoesTrajeto, estatisticasTrajeto, LinhaPosicao } from '../trajetoService';
+
+const dispositivos = +(process.env.BENCH_DISPOSITIVOS || 1000);
+const mensagens = +(process.env.BENCH_MENSAGENS || 20000);
+const fixesPorMensagem = +(process.env.BENCH_FIXES_POR_MENSAGEM || 10);
+const concorrencia = +(process.env.BENCH_CONCORRENCIA || 16);
+const usuarioBase = +(process.env.BENCH_USUARIO_BASE || 900000);
+
+function lote(i: number, inicioMs: number): LinhaPosicao[] {
+    const usuarioId = usuarioBase + (i % dispositivos);
+    const t = inicioMs + Math.floor(i / dispositivos) * fixesPorMensagem * 1000;
+    return Array.from({ length: fixesPorMensagem }, (_, k) => ({
+        usuarioId,
+        latitude: -23.55 + Math.random() * 0.01,
+        longitude: -46.63 + Math.random() * 0.01,
+        hdop: 1.1,
+        velocidadeKmh: 3.5,
+        timestamp: new Date(t + k * 1000)
+    }));
+}
+
+async function caminhoAntigo(inicioMs: number) {
+    let proxima = 0;
+    const trabalhador = async () => {
+        while (proxima < mensagens) {
+            const linhas = lote(proxima++, inicioMs);
+            await PosicaoHistorico.bulkCreate(linhas as any[]);
+            const ultima = linhas[linhas.length - 1];
+            await GpsUsuario.upsert({ usuarioId: ultima.usuarioId, latitude: ultima.latitude, longitude: ultima.longitude, timestamp: ultima.timestamp });
+        }
+    };
+    await Promise.all(Array.from({ length: concorrencia }, trabalhador));
+}
+
+async function caminhoEscritor(inicioMs: number) {
+    for (let i = 0; i < mensagens; i++) {
+        const linhas = lote(i, inicioMs);
+        registrarTelemetria(linhas[0].usuarioId, linhas, []);
+        // Cede o event loop como chegadas MQTT fariam
+        if (i % 500 === 0) await new Promise(resolve => setImmediate(resolve));
+    }
+    await descarregarTrajeto();
+}
+
+async function medir(nome: string, fn: (inicioMs: number) => Promise<void>) {
+    const inicioMs = Date.now() - 3600 * 1000;
+    const t0 = process.hrtime.bigint();
+    await fn(inicioMs);
+    const s = Number(process.hrtime.bigint() - t0) / 1e9;
+    const linhas = mensagens * fixesPorMensagem;
+    console.log(`${nome.padEnd(10)} ${linhas} linhas em ${s.toFixed(2)} s: ${(linhas / s).toFixed(0)} linhas/s`);
+}
+
+async function limpar() {
+    const where = { usuarioId: { [Op.gte]: usuarioBase, [Op.lt]: usuarioBase + dispositivos } };
+    await PosicaoHistorico.destroy({ where });
+    await GpsUsuario.destroy({ where });
+}
+
+async function main() {
+    await sequelize.sync();
+    await garantirParticoesTrajeto();
+    await limpar();
+
+    console.log(`${dispositivos} dispositivos, ${mensagens} mensagens de ${fixesPorMensagem} fixes`);
+    await medir('antigo', caminhoAntigo);
+    await limpar();
+    await medir('escritor', caminhoEscritor);
+    console.log(JSON.stringify(estatisticasTrajeto().posicao_historico));
+    await limpar();
+
+    await sequelize.close();
+}
+
+main().catch(error => {
+    console.error(error);
+    process.exit(1);
+});
@@ -0,0 +1,192 @@
+// src/services/trajetoService.ts
+//
+// Caminho de escrita e leitura do trajeto:
+//  - posicao_historico é só de inserção, particionada por mês e, dentro do
+//    mês, por hash do usuário (init_scripts.sql); as partições dos próximos
+//    meses são criadas aqui, todo dia;
+//  - handlers MQTT só entregam as linhas ao escritor em lote, sem await;
+//  - a última posição de cada usuário fica em memória e vai para
+//    gps_usuario coalescida (uma linha por usuário por lote);
+//  - o mapa pede o trajeto já reduzido: Douglas-Peucker ou média por
+//    intervalo de tempo, calculada no banco.
+import { Op, QueryTypes } from 'sequelize';
+import { sequelize } from '../config/db';
+import { PosicaoHistorico } from '../models/posicaoHistoricoModel';
+import { GpsUsuario } from '../models/gpsUsuarioModel';
+import { ResumoImu } from '../models/resumoImuModel';
+import { EscritorEmLote, EstatisticasEscritor } from './escritorEmLote';
+import { douglasPeucker, PontoTrajeto } from './simplificacaoTrajeto';
+
+export interface LinhaPosicao {
+    usuarioId: number;
+    latitude: number;
+    longitude: number;
+    hdop: number | null;
+    velocidadeKmh: number | null;
+    timestamp: Date;
+}
+
+export interface LinhaResumoImu {
+    usuarioId: number;
+    amostras: number;
+    magMinMg: number;
+    magMaxMg: number;
+    timestamp: Date;
+}
+
+export interface PosicaoAtual {
+    usuarioId: number;
+    latitude: number;
+    longitude: number;
+    timestamp: Date;
+}
+
+const loteLinhas = +(process.env.TRAJETO_LOTE_LINHAS || 5000);
+const loteMs = +(process.env.TRAJETO_LOTE_MS || 1000);
+const maxPendentes = +(process.env.TRAJETO_MAX_PENDENTES || 200000);
+
+// Trajeto bruto para Douglas-Peucker; acima disto o intervalo pedido é grande demais
+const MAX_PONTOS_CONSULTA = 500000;
+const MANUTENCAO_PARTICOES_MS = 24 * 60 * 60 * 1000;
+const RELATORIO_MS = 60000;
+
+const escritorTrajeto = new EscritorEmLote<LinhaPosicao>(
+    { nome: 'posicao_historico', maxLinhas: loteLinhas, intervaloMs: loteMs, maxPendentes },
+    async linhas => { await PosicaoHistorico.bulkCreate(linhas as any[], { hooks: false }); });
+
+const escritorResumos = new EscritorEmLote<LinhaResumoImu>(
+    { nome: 'resumo_imu', maxLinhas: loteLinhas, intervaloMs: loteMs, maxPendentes },
+    async linhas => { await ResumoImu.bulkCreate(linhas as any[], { hooks: false }); });
+
+const escritorUltimaPosicao = new EscritorEmLote<PosicaoAtual>(
+    { nome: 'gps_usuario', maxLinhas: loteLinhas, intervaloMs: loteMs, maxPendentes, chave: p => p.usuarioId },
+    async linhas => {
+        await GpsUsuario.bulkCreate(linhas as any[], { hooks: false, updateOnDuplicate: ['latitude', 'longitude', 'timestamp'] });
+    });
+
+// Última posição por usuário; gps_usuario só é lido quando o usuário não está aqui
+const ultimaPosicao = new Map<number, PosicaoAtual>();
+
+/** Chamado pelo handler MQTT: não espera o banco */
+export function registrarTelemetria(usuarioId: number, posicoes: LinhaPosicao[], resumos: LinhaResumoImu[]) {
+    if (resumos.length > 0) escritorResumos.adicionar(resumos);
+    if (posicoes.length === 0) return;
+    escritorTrajeto.adicionar(posicoes);
+
+    let maisNova = posicoes[0];
+    for (const p of posicoes) if (p.timestamp > maisNova.timestamp) maisNova = p;
+
+    // Lote atrasado do outbox não volta a posição atual para trás
+    const atual = ultimaPosicao.get(usuarioId);
+    if (atual && atual.timestamp >= maisNova.timestamp) return;
+
+    const nova: PosicaoAtual = { usuarioId, latitude: maisNova.latitude, longitude: maisNova.longitude, timestamp: maisNova.timestamp };
+    ultimaPosicao.set(usuarioId, nova);
+    escritorUltimaPosicao.adicionar([nova]);
+}
+
+export async function obterPosicaoAtual(usuarioId: number): Promise<PosicaoAtual | null> {
+    const emCache = ultimaPosicao.get(usuarioId);
+    if (emCache) return emCache;
+
+    const registro = await GpsUsuario.findByPk(usuarioId);
+    if (!registro) return null;
+
+    const posicao: PosicaoAtual = {
+        usuarioId: registro.usuarioId,
+        latitude: registro.latitude,
+        longitude: registro.longitude,
+        timestamp: registro.timestamp
+    };
+    // Uma posição nova pode ter chegado durante a consulta
+    if (!ultimaPosicao.has(usuarioId)) ultimaPosicao.set(usuarioId, posicao);
+    return ultimaPosicao.get(usuarioId)!;
+}
+
+export type ModoTrajeto = 'bruto' | 'dp' | 'tempo';
+
+export interface ConsultaTrajeto {
+    inicio: Date;
+    fim: Date;
+    modo: ModoTrajeto;
+    toleranciaM: number;   // modo 'dp'
+    intervaloS: number;    // modo 'tempo'
+}
+
+export interface PontoTrajetoAgrupado extends PontoTrajeto {
+    amostras?: number;     // modo 'tempo': fixes no intervalo
+}
+
+/**
+ * Trajeto do usuário entre inicio (inclusive) e fim (exclusive), em ordem.
+ * Posições ainda no buffer do escritor (até TRAJETO_LOTE_MS) não aparecem.
+ */
+export async function consultarTrajeto(usuarioId: number, consulta: ConsultaTrajeto): Promise<PontoTrajetoAgrupado[]> {
+    if (consulta.modo === 'tempo') {
+        // Média por intervalo no próprio banco: só os pontos agrupados saem de lá
+        const linhas = await sequelize.query<{ timestamp: Date; latitude: number; longitude: number; amostras: number }>(
+            `SELECT to_timestamp(floor(extract(epoch FROM "timestamp") / :intervalo) * :intervalo) AS "timestamp",
+                    avg(latitude) AS latitude, avg(longitude) AS longitude, count(*)::int AS amostras
+               FROM posicao_historico
+              WHERE "usuarioId" = :usuarioId AND "timestamp" >= :inicio AND "timestamp" < :fim
+              GROUP BY 1
+              ORDER BY 1`,
+            {
+                replacements: { usuarioId, inicio: consulta.inicio, fim: consulta.fim, intervalo: consulta.intervaloS },
+                type: QueryTypes.SELECT
+            });
+        return linhas.map(l => ({ ...l, latitude: Number(l.latitude), longitude: Number(l.longitude) }));
+    }
+
+    const pontos = await PosicaoHistorico.findAll({
+        attributes: ['latitude', 'longitude', 'timestamp'],
+        where: { usuarioId, timestamp: { [Op.gte]: consulta.inicio, [Op.lt]: consulta.fim } },
+        order: [['timestamp', 'ASC']],
+        limit: MAX_PONTOS_CONSULTA + 1,
+        raw: true
+    }) as unknown as PontoTrajeto[];
+
+    if (pontos.length > MAX_PONTOS_CONSULTA) {
+        throw new Error(`Intervalo com mais de ${MAX_PONTOS_CONSULTA} posições; use o modo 'tempo' ou um intervalo menor.`);
+    }
+
+    return consulta.modo === 'dp' ? douglasPeucker(pontos, consulta.toleranciaM) : pontos;
+}
+
+/* Partições do mês atual e do próximo; sem a função (tabela criada pelo sync, sem partições) só avisa */
+export async function garantirParticoesTrajeto() {
+    try {
+        await sequelize.query(
+            `SELECT criar_particao_posicao(date_trunc('month', now())::date),
+                    criar_particao_posicao((date_trunc('month', now()) + interval '1 month')::date)`);
+    } catch (error: any) {
+        console.warn('Partições de posicao_historico não criadas:', error?.message ?? error);
+    }
+}
+
+export function estatisticasTrajeto(): Record<string, EstatisticasEscritor> {
+    return {
+        posicao_historico: escritorTrajeto.estatisticas(),
+        gps_usuario: escritorUltimaPosicao.estatisticas(),
+        resumo_imu: escritorResumos.estatisticas()
+    };
+}
+
+/** Grava o que está nos buffers (encerramento do processo) */
+export async function descarregarTrajeto() {
+    await Promise.all([escritorTrajeto.descarregar(), escritorUltimaPosicao.descarregar(), escritorResumos.descarregar()]);
+}
+
+export function iniciarTrajeto() {
+    void garantirParticoesTrajeto();
+    setInterval(() => void garantirParticoesTrajeto(), MANUTENCAO_PARTICOES_MS).unref();
+
+    let gravadasAntes = 0;
+    setInterval(() => {
+        const e = escritorTrajeto.estatisticas();
+        if (e.gravadas === gravadasAntes && e.pendentes === 0) return;
+        console.log(`Trajeto: ${((e.gravadas - gravadasAntes) * 1000 / RELATORIO_MS).toFixed(1)} posições/s gravadas, ` +
+            `${e.lotes} lotes (maior ${e.maiorLote}), ${e.pendentes} pendentes, ${e.falhas} falhas, ${e.descartadas} descartadas`);
+        gravadasAntes = e.gravadas;
+    }, RELATORIO_MS).unref();
+}